@@ -1,3 +1,3 @@
-from ._api import DecisionTreeRegressor, DecisionTreeClassifier, RandomForestRegressor, RandomForestClassifier, accuracy
+from ._api import DecisionTreeRegressor, DecisionTreeClassifier, RandomForestRegressor, RandomForestClassifier, OnlineForestClassifier, OnlineForestRegressor, IsolationForest, GradientBoostingClassifier, GradientBoostingRegressor, accuracy
 
-__all__ = ["DecisionTreeRegressor", "DecisionTreeClassifier", "RandomForestRegressor", "RandomForestClassifier", "accuracy"]
+__all__ = ["DecisionTreeRegressor", "DecisionTreeClassifier", "RandomForestRegressor", "RandomForestClassifier", "OnlineForestClassifier", "OnlineForestRegressor", "IsolationForest", "GradientBoostingClassifier", "GradientBoostingRegressor", "accuracy"]
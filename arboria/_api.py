@@ -3,8 +3,12 @@
 from ._arboria import _accuracy
 from ._randomforest import _RandomForest
 from ._decisiontree import _DecisionTree
+from ._onlineforest import _OnlineForest
+from ._isolationforest import _IsolationForest
+from ._gradientboosting import _GradientBoosting
 
 import math
+import numpy as np
 
 
 class RandomForestClassifier(_RandomForest):
@@ -14,7 +18,11 @@ class RandomForestClassifier(_RandomForest):
                  max_samples: float = None,
                  min_sample_split: int = None,
                  n_jobs: int = 1,
-                 seed : int | None = None):
+                 seed : int | None = None,
+                 oob_score : bool = False,
+                 early_stopping_tol : float | None = None,
+                 early_stopping_batch : int | None = None,
+                 honest_fraction : float | None = None):
         """
         Random Forest classifier.
 
@@ -37,6 +45,19 @@ class RandomForestClassifier(_RandomForest):
             use the maximum number of threads. 
         seed : int
             Seed of the tree. Default None will result in a random seed.
+        oob_score : bool
+            Whether to compute out-of-bag predictions during fit, exposed as
+            oob_score_ and oob_prediction_. Default is False.
+        early_stopping_tol : float
+            If set, trees are fitted in batches and the fit stops once a batch
+            improves the out-of-bag score by less than this tolerance. The number
+            of trees kept is n_trees. Default None fits all n_estimators trees.
+        early_stopping_batch : int
+            Number of trees fitted between two out-of-bag checks. Default is 10.
+        honest_fraction : float
+            If set, each tree learns its structure on this fraction of its 
+            distinct bootstrapped rows and its leaf values on the others.
+            Default None uses all rows for both.
         """
         super().__init__(
             n_estimators=n_estimators,
@@ -47,6 +68,10 @@ class RandomForestClassifier(_RandomForest):
             n_jobs=n_jobs,
             seed=seed,
             type="classification",
+            oob_score=oob_score,
+            early_stopping_tol=early_stopping_tol,
+            early_stopping_batch=early_stopping_batch,
+            honest_fraction=honest_fraction,
         )
 
     def fit(self, X, y, criterion= 'gini'):
@@ -56,7 +81,7 @@ class RandomForestClassifier(_RandomForest):
         Parameters
         ----------
         X : ndarray of shape (n_samples, n_features)
-        y : ndarray of shape (n_samples,)
+        y : ndarray of shape (n_samples,) of class labels in {0, ..., K-1}
         criterion : {"gini", "entropy"}, default="gini"
         """
         if not hasattr(X, "__array_interface__"):
@@ -70,6 +95,51 @@ class RandomForestClassifier(_RandomForest):
         if self.mtry == -98:
             self.mtry = max(1, int(math.log2(X.shape[1])))
         return self._fit(X, y, criterion, self.mtry)
+
+    def fit_more(self, X, y, n_new, criterion= 'gini'):
+        """
+        Adds n_new trees to the fitted Random Forest (warm start). Existing
+        trees are kept : the result is identical to a single fit with
+        n_estimators + n_new trees.
+
+        Parameters
+        ----------
+        X : ndarray of samples passed as training data
+        y : ndarray of target values passed as training data
+        n_new : int
+            Number of trees to add
+        criterion : split criterion used in fit
+        """
+        if not hasattr(X, "__array_interface__"):
+            raise TypeError("X must be a NumPy-compatible array")
+
+        if not hasattr(y, "__array_interface__"):
+            raise TypeError("y must be a NumPy-compatible array")
+
+        return self._fit_more(X, y, criterion, self.mtry, n_new)
+
+    def update(self, X, y, k, criterion= 'gini'):
+        """
+        Rolling-window update : fits k new trees on a new batch (X, y) and
+        evicts the k oldest trees, keeping the number of trees fixed. 
+        Predictions made from other threads during the update use either 
+        the previous or the updated forest.
+
+        Parameters
+        ----------
+        X : ndarray of shape (n_samples, n_features) of the new batch
+        y : ndarray of target values of the new batch
+        k : int
+            Number of trees to replace
+        criterion : split criterion used in fit
+        """
+        if not hasattr(X, "__array_interface__"):
+            raise TypeError("X must be a NumPy-compatible array")
+
+        if not hasattr(y, "__array_interface__"):
+            raise TypeError("y must be a NumPy-compatible array")
+
+        return self._update(X, y, criterion, self.mtry, k)
     
     def predict(self, X):
         """
@@ -90,8 +160,8 @@ class RandomForestClassifier(_RandomForest):
     
     def predict_proba(self, X):
         """
-        Returns predicted class for samples X as float as the average
-        of each tree votes. 
+        Returns predicted class probabilities for samples X as the 
+        average of each tree votes. 
 
         Parameters
         ----------
@@ -99,7 +169,9 @@ class RandomForestClassifier(_RandomForest):
 
         Returns
         -------
-        np.ndarray : array of predicted class as float.
+        np.ndarray : for binary classification, array of shape (n_samples,)
+        with the probability of class 1. For K > 2 classes, array of shape
+        (n_samples, K) with the probability of each class.
         """
         if not hasattr(X, "__array_interface__"):
             raise TypeError("X must be a NumPy-compatible array")
@@ -107,7 +179,7 @@ class RandomForestClassifier(_RandomForest):
     
     def out_of_bag(self, X, y):
         """
-        Returns the out-of-bag accuracy of the Random Forest.
+        Returns the out-of-bag score of the Random Forest.
 
         Parameters
         ----------
@@ -141,7 +213,13 @@ class RandomForestRegressor(_RandomForest):
                  max_samples: float = None,
                  min_sample_split: int = None,
                  n_jobs: int = 1,
-                 seed : int | None = None):
+                 seed : int | None = None,
+                 oob_score : bool = False,
+                 early_stopping_tol : float | None = None,
+                 early_stopping_batch : int | None = None,
+                 quantiles : bool = False,
+                 max_leaf_samples : int | None = None,
+                 honest_fraction : float | None = None):
         """
         Random Forest regressor.
 
@@ -164,6 +242,26 @@ class RandomForestRegressor(_RandomForest):
             use the maximum number of threads. 
         seed : int
             Seed of the tree. Default None will result in a random seed.
+        oob_score : bool
+            Whether to compute out-of-bag predictions during fit, exposed as
+            oob_score_ and oob_prediction_. Default is False.
+        early_stopping_tol : float
+            If set, trees are fitted in batches and the fit stops once a batch
+            improves the out-of-bag score by less than this tolerance. The number
+            of trees kept is n_trees. Default None fits all n_estimators trees.
+        early_stopping_batch : int
+            Number of trees fitted between two out-of-bag checks. Default is 10.
+        quantiles : bool
+            Whether leaves store their training targets, enabling
+            predict_quantiles (single target only). Default is False.
+        max_leaf_samples : int
+            If set, leaves holding more targets are summarised into this number
+            of equal-weight bins, bounding the model size ; implies quantiles.
+            Default None keeps all targets.
+        honest_fraction : float
+            If set, each tree learns its structure on this fraction of its 
+            distinct bootstrapped rows and its leaf values on the others.
+            Default None uses all rows for both.
         """
         super().__init__(
             n_estimators=n_estimators,
@@ -174,6 +272,12 @@ class RandomForestRegressor(_RandomForest):
             n_jobs=n_jobs,
             seed=seed,
             type="regression",
+            oob_score=oob_score,
+            early_stopping_tol=early_stopping_tol,
+            early_stopping_batch=early_stopping_batch,
+            quantiles=quantiles,
+            max_leaf_samples=max_leaf_samples,
+            honest_fraction=honest_fraction,
         )
 
     def fit(self, X, y, criterion= 'sse'):
@@ -183,8 +287,9 @@ class RandomForestRegressor(_RandomForest):
         Parameters
         ----------
         X : ndarray of shape (n_samples, n_features)
-        y : ndarray of shape (n_samples,)
-        criterion : {"gini", "entropy"}, default="gini"
+        y : ndarray of shape (n_samples,) or (n_samples, n_targets) for 
+            multi-output regression
+        criterion : {"sse"}, default="sse"
         """
         if not hasattr(X, "__array_interface__"):
             raise TypeError("X must be a NumPy-compatible array")
@@ -197,6 +302,51 @@ class RandomForestRegressor(_RandomForest):
         if self.mtry == -98:
             self.mtry = max(1, int(math.log2(X.shape[1])))
         return self._fit(X, y, criterion, self.mtry)
+
+    def fit_more(self, X, y, n_new, criterion= 'sse'):
+        """
+        Adds n_new trees to the fitted Random Forest (warm start). Existing
+        trees are kept : the result is identical to a single fit with
+        n_estimators + n_new trees.
+
+        Parameters
+        ----------
+        X : ndarray of samples passed as training data
+        y : ndarray of target values passed as training data
+        n_new : int
+            Number of trees to add
+        criterion : split criterion used in fit
+        """
+        if not hasattr(X, "__array_interface__"):
+            raise TypeError("X must be a NumPy-compatible array")
+
+        if not hasattr(y, "__array_interface__"):
+            raise TypeError("y must be a NumPy-compatible array")
+
+        return self._fit_more(X, y, criterion, self.mtry, n_new)
+
+    def update(self, X, y, k, criterion= 'sse'):
+        """
+        Rolling-window update : fits k new trees on a new batch (X, y) and
+        evicts the k oldest trees, keeping the number of trees fixed. 
+        Predictions made from other threads during the update use either 
+        the previous or the updated forest.
+
+        Parameters
+        ----------
+        X : ndarray of shape (n_samples, n_features) of the new batch
+        y : ndarray of target values of the new batch
+        k : int
+            Number of trees to replace
+        criterion : split criterion used in fit
+        """
+        if not hasattr(X, "__array_interface__"):
+            raise TypeError("X must be a NumPy-compatible array")
+
+        if not hasattr(y, "__array_interface__"):
+            raise TypeError("y must be a NumPy-compatible array")
+
+        return self._update(X, y, criterion, self.mtry, k)
     
     def predict(self, X):
         """
@@ -234,7 +384,7 @@ class RandomForestRegressor(_RandomForest):
     
     def out_of_bag(self, X, y):
         """
-        Returns the out-of-bag accuracy of the Random Forest.
+        Returns the out-of-bag score of the Random Forest.
 
         Parameters
         ----------
@@ -243,7 +393,7 @@ class RandomForestRegressor(_RandomForest):
 
         Returns
         -------
-        float : the score of the Random Forest classifier on 
+        float : the R² of the Random Forest regressor on 
         the samples not bootstrapped during training
         """
         if not hasattr(X, "__array_interface__"):
@@ -253,6 +403,30 @@ class RandomForestRegressor(_RandomForest):
             raise TypeError("y must be a NumPy-compatible array")
         
         return self._out_of_bag(X,y)
+
+    def predict_quantiles(self, X, q):
+        """
+        Returns conditional quantiles of the target for samples X 
+        (Quantile Regression Forest). All levels are computed from a 
+        single pass over the forest. Requires quantiles=True.
+
+        Parameters
+        ----------
+        X : ndarray with same shape as training data
+        q : float or sequence of floats in [0, 1]
+
+        Returns
+        -------
+        np.ndarray : array of shape (n_samples,) for a single level, 
+        (n_samples, len(q)) otherwise.
+        """
+        if not hasattr(X, "__array_interface__"):
+            raise TypeError("X must be a NumPy-compatible array")
+        levels = np.atleast_1d(np.asarray(q, dtype=np.float32))
+        out = np.asarray(self._predict_quantiles(X, levels.tolist()))
+        if np.ndim(q) == 0:
+            return out[:, 0]
+        return out
     
     def get_max_samples(self):
 
@@ -265,7 +439,9 @@ class RandomForestRegressor(_RandomForest):
 class DecisionTreeClassifier(_DecisionTree):
     def __init__(self, 
                  max_depth: int | None = None,
-                 min_sample_split: int | None = None):
+                 min_sample_split: int | None = None,
+                 honest_fraction: float | None = None,
+                 n_jobs: int = 1):
         """
         Decision tree classifier.
 
@@ -275,11 +451,21 @@ class DecisionTreeClassifier(_DecisionTree):
             Maximum depth of the tree. Default is None
         min_sample_split : int
             Minimum of samples allowed in a leaf. Default None will set no limit
+        honest_fraction : float
+            If set, the structure of the tree is learned on this fraction of the 
+            rows and the leaf values are estimated on the other rows (honest tree).
+            Default None uses all rows for both.
+        n_jobs : int
+            Number of threads used to route samples to the leaves in apply,
+            predict and predict_proba ; settable after fit with the n_jobs
+            attribute. Default is 1
         """
         
         super().__init__(
             max_depth=max_depth,
             min_sample_split=min_sample_split,
+            honest_fraction=honest_fraction,
+            n_jobs=n_jobs,
             type="classification",
         )
 
@@ -318,12 +504,32 @@ class DecisionTreeClassifier(_DecisionTree):
 
         return self._predict(X)
 
+    def predict_proba(self, X):
+        """
+        Returns the class distribution of the leaf reached by each sample.
+
+        Parameters
+        ----------
+        X : ndarray with same shape as training data
+
+        Returns
+        -------
+        np.ndarray : array of shape (n_samples, n_classes) with the
+        probability of each class.
+        """
+        if not hasattr(X, "__array_interface__"):
+            raise TypeError("X must be a NumPy-compatible array")
+
+        return self._predict_proba(X)
+
 
 
 class DecisionTreeRegressor(_DecisionTree):
     def __init__(self, 
                  max_depth: int | None = None,
-                 min_sample_split: int | None = None):
+                 min_sample_split: int | None = None,
+                 honest_fraction: float | None = None,
+                 n_jobs: int = 1):
         """
         Decision tree classifier.
 
@@ -333,11 +539,21 @@ class DecisionTreeRegressor(_DecisionTree):
             Maximum depth of the tree. Default is None
         min_sample_split : int
             Minimum of samples allowed in a leaf. Default None will set no limit
+        honest_fraction : float
+            If set, the structure of the tree is learned on this fraction of the 
+            rows and the leaf values are estimated on the other rows (honest tree).
+            Default None uses all rows for both.
+        n_jobs : int
+            Number of threads used to route samples to the leaves in apply
+            and predict ; settable after fit with the n_jobs
+            attribute. Default is 1
         """
         
         super().__init__(
             max_depth=max_depth,
             min_sample_split=min_sample_split,
+            honest_fraction=honest_fraction,
+            n_jobs=n_jobs,
             type="regression",
         )
 
@@ -348,8 +564,9 @@ class DecisionTreeRegressor(_DecisionTree):
         Parameters
         ----------
         X : ndarray of shape (n_samples, n_features)
-        y : ndarray of shape (n_samples,)
-        criterion : {"gini", "entropy"}, default="gini"
+        y : ndarray of shape (n_samples,) or (n_samples, n_targets) for 
+            multi-output regression
+        criterion : {"sse"}, default="sse"
         """
         if not hasattr(X, "__array_interface__"):
             raise TypeError("X must be a NumPy-compatible array")
@@ -394,3 +611,148 @@ def accuracy(y_true, y_pred):
     """
 
     return _accuracy(y_true, y_pred)
+
+
+class OnlineForestClassifier(_OnlineForest):
+    def __init__(self, n_estimators: int = 10,
+                 max_features: int | str = "sqrt",
+                 max_depth: int = None,
+                 n_jobs: int = 1,
+                 seed : int | None = None,
+                 grace_period: int = 50,
+                 split_confidence: float = 0.01,
+                 tie_threshold: float = 0.05,
+                 n_candidates: int = 16,
+                 max_nodes: int = 4096,
+                 n_classes: int | None = None):
+        """
+        Random forest classifier learned from mini-batches with partial_fit.
+        See _OnlineForest for the parameters.
+        """
+        super().__init__(
+            n_estimators=n_estimators,
+            max_features=max_features,
+            max_depth=max_depth,
+            n_jobs=n_jobs,
+            seed=seed,
+            type="classification",
+            grace_period=grace_period,
+            split_confidence=split_confidence,
+            tie_threshold=tie_threshold,
+            n_candidates=n_candidates,
+            max_nodes=max_nodes,
+            n_classes=n_classes,
+        )
+
+
+class OnlineForestRegressor(_OnlineForest):
+    def __init__(self, n_estimators: int = 10,
+                 max_features: int | str = "sqrt",
+                 max_depth: int = None,
+                 n_jobs: int = 1,
+                 seed : int | None = None,
+                 grace_period: int = 50,
+                 split_confidence: float = 0.01,
+                 tie_threshold: float = 0.05,
+                 n_candidates: int = 16,
+                 max_nodes: int = 4096):
+        """
+        Random forest regressor learned from mini-batches with partial_fit.
+        See _OnlineForest for the parameters.
+        """
+        super().__init__(
+            n_estimators=n_estimators,
+            max_features=max_features,
+            max_depth=max_depth,
+            n_jobs=n_jobs,
+            seed=seed,
+            type="regression",
+            grace_period=grace_period,
+            split_confidence=split_confidence,
+            tie_threshold=tie_threshold,
+            n_candidates=n_candidates,
+            max_nodes=max_nodes,
+        )
+
+
+class IsolationForest(_IsolationForest):
+    def __init__(self, n_estimators: int = 100,
+                 max_samples: float | None = None,
+                 max_depth: int | None = None,
+                 n_jobs: int = 1,
+                 seed : int | None = None):
+        """
+        Isolation Forest for anomaly detection, trained with fit(X) and
+        scored with score_samples(X). See _IsolationForest for the parameters.
+        """
+        super().__init__(
+            n_estimators=n_estimators,
+            max_samples=max_samples,
+            max_depth=max_depth,
+            n_jobs=n_jobs,
+            seed=seed,
+        )
+
+
+class GradientBoostingClassifier(_GradientBoosting):
+    def __init__(self, n_estimators: int = 100,
+                 learning_rate: float = 0.1,
+                 max_depth: int = 3,
+                 min_sample_split: int | None = None,
+                 subsample: float = 1.0,
+                 colsample: float = 1.0,
+                 reg_lambda: float = 1.0,
+                 n_jobs: int = 1,
+                 seed : int | None = None):
+        """
+        Gradient boosting binary classifier (log loss). See _GradientBoosting
+        for the parameters.
+        """
+        super().__init__(
+            n_estimators=n_estimators,
+            learning_rate=learning_rate,
+            max_depth=max_depth,
+            min_sample_split=min_sample_split,
+            subsample=subsample,
+            colsample=colsample,
+            reg_lambda=reg_lambda,
+            n_jobs=n_jobs,
+            seed=seed,
+            type="classification",
+        )
+
+    def predict_proba(self, X):
+        """
+        Returns the probability of class 1 for samples X.
+        """
+        if not hasattr(X, "__array_interface__"):
+            raise TypeError("X must be a NumPy-compatible array")
+        return np.asarray(self._predict_proba(X))
+
+
+class GradientBoostingRegressor(_GradientBoosting):
+    def __init__(self, n_estimators: int = 100,
+                 learning_rate: float = 0.1,
+                 max_depth: int = 3,
+                 min_sample_split: int | None = None,
+                 subsample: float = 1.0,
+                 colsample: float = 1.0,
+                 reg_lambda: float = 1.0,
+                 n_jobs: int = 1,
+                 seed : int | None = None):
+        """
+        Gradient boosting regressor (squared error). See _GradientBoosting
+        for the parameters.
+        """
+        super().__init__(
+            n_estimators=n_estimators,
+            learning_rate=learning_rate,
+            max_depth=max_depth,
+            min_sample_split=min_sample_split,
+            subsample=subsample,
+            colsample=colsample,
+            reg_lambda=reg_lambda,
+            n_jobs=n_jobs,
+            seed=seed,
+            type="regression",
+        )
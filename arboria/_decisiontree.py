@@ -8,6 +8,8 @@ class _DecisionTree(_DecisionTreeBase):
         max_depth: int | None = None,
         min_sample_split: int | None = None,
         type: str = "classification",
+        honest_fraction: float | None = None,
+        n_jobs: int = 1,
     ):
         """
         Decision tree classifier.
@@ -18,12 +20,23 @@ class _DecisionTree(_DecisionTreeBase):
             Maximum depth of the tree. Default is None
         min_sample_split : int
             Minimum of samples allowed in a leaf. Default None will set no limit
+        honest_fraction : float
+            If set, the structure of the tree is learned on this fraction of the 
+            rows and the leaf values are estimated on the other rows (honest tree).
+            A leaf reached by none of them takes the value of its nearest 
+            ancestor reached by some. Default None uses all rows for both.
+        n_jobs : int
+            Number of threads used to route samples to the leaves in apply,
+            predict and predict_proba ; settable after fit with the n_jobs
+            attribute. Default is 1
         """
 
         super().__init__(
             max_depth=max_depth,
             min_sample_split=min_sample_split,
             type=type,
+            honest_fraction=honest_fraction,
+            n_jobs=n_jobs,
         )
 
     def fit(self, X, y, criterion="gini"):
@@ -60,3 +73,48 @@ class _DecisionTree(_DecisionTreeBase):
             raise TypeError("X must be a NumPy-compatible array")
 
         return self._predict(X)
+
+    def apply(self, X):
+        """
+        Returns the index of the leaf reached by each sample of X.
+
+        Parameters
+        ----------
+        X : ndarray with same shape as training data
+
+        Returns
+        -------
+        np.ndarray : array of shape (n_samples,) of leaf indices.
+        """
+        if not hasattr(X, "__array_interface__"):
+            raise TypeError("X must be a NumPy-compatible array")
+
+        return self._apply(X)
+
+    def save(self, path):
+        """
+        Writes the fitted tree to a binary model file.
+
+        Parameters
+        ----------
+        path : str or path-like
+            Path of the file, overwritten if it exists
+        """
+        self._save(str(path))
+
+    @classmethod
+    def load(cls, path, mmap: bool = True):
+        """
+        Loads a tree written by save(), ready to predict.
+
+        Parameters
+        ----------
+        path : str or path-like
+            Path of the model file
+        mmap : bool
+            Whether to map the file : the nodes are read in place from the
+            mapped pages instead of being copied. Default is True.
+        """
+        model = cls.__new__(cls)
+        _DecisionTreeBase.__init__(model, _model_file=str(path), mmap=mmap)
+        return model
@@ -0,0 +1,86 @@
+
+from ._arboria import GradientBoosting as _GradientBoostingBase
+import numpy as np
+
+class _GradientBoosting(_GradientBoostingBase):
+    def __init__(self, n_estimators: int = 100,
+                 learning_rate: float = 0.1,
+                 max_depth: int = 3,
+                 min_sample_split: int | None = None,
+                 subsample: float = 1.0,
+                 colsample: float = 1.0,
+                 reg_lambda: float = 1.0,
+                 n_jobs: int = 1,
+                 seed : int | None = None,
+                 type : str = "regression"):
+        """
+        Gradient boosted decision trees.
+
+        Parameters
+        ----------
+        n_estimators : int
+            Number of boosting rounds. Default is 100
+        learning_rate : float
+            Shrinkage applied to the leaf values of every tree. Default is 0.1
+        max_depth : int
+            Maximum depth of the trees. Default is 3
+        min_sample_split : int
+            Minimum of samples allowed in a leaf. Default None will set no limit
+        subsample : float
+            Fraction of the rows used to fit each tree, in (0, 1]. Default is 1.0
+        colsample : float
+            Fraction of the features sampled at each split, in (0, 1]. Default is 1.0
+        reg_lambda : float
+            L2 regularisation of the Newton leaf values. Default is 1.0
+        n_jobs : int
+            Number of threads routing samples to the leaves. Default is 1, -1 
+            will use the maximum number of threads.
+        seed : int
+            Seed of the subsampling. Default None will result in a random seed.
+        """
+        super().__init__(
+            n_estimators=n_estimators,
+            max_depth=max_depth,
+            min_sample_split=min_sample_split,
+            n_jobs=n_jobs,
+            seed=seed,
+            type=type,
+            learning_rate=learning_rate,
+            reg_lambda=reg_lambda,
+            subsample=subsample,
+            colsample=colsample,
+        )
+
+    def fit(self, X, y):
+        """
+        Fit the model.
+
+        Parameters
+        ----------
+        X : ndarray of shape (n_samples, n_features)
+        y : ndarray of shape (n_samples,) ; labels in {0, 1} for classification
+        """
+        if not hasattr(X, "__array_interface__"):
+            raise TypeError("X must be a NumPy-compatible array")
+
+        if not hasattr(y, "__array_interface__"):
+            raise TypeError("y must be a NumPy-compatible array")
+
+        return self._fit(X, y)
+
+    def decision_function(self, X):
+        """
+        Returns the raw score of samples X (log-odds for classification).
+        """
+        if not hasattr(X, "__array_interface__"):
+            raise TypeError("X must be a NumPy-compatible array")
+        return np.asarray(self._decision_function(X))
+
+    def predict(self, X):
+        """
+        Returns the predicted class (classification) or value (regression)
+        of samples X.
+        """
+        if not hasattr(X, "__array_interface__"):
+            raise TypeError("X must be a NumPy-compatible array")
+        return np.asarray(self._predict(X))
@@ -0,0 +1,80 @@
+
+from ._arboria import IsolationForest as _IsolationForestBase
+import numpy as np
+
+class _IsolationForest(_IsolationForestBase):
+    def __init__(self, n_estimators: int = 100,
+                 max_samples: float | None = None,
+                 max_depth: int | None = None,
+                 n_jobs: int = 1,
+                 seed : int | None = None):
+        """
+        Isolation Forest for anomaly scoring.
+
+        Parameters
+        ----------
+        n_estimators : int
+            Number of trees in the forest. Default is 100
+        max_samples : float
+            Fraction of the rows subsampled (without replacement) per tree, 
+            in (0, 1]. Default None subsamples min(256, n_samples) rows.
+        max_depth : int
+            Maximum depth of the trees. Default None uses ceil(log2(subsample size)).
+        n_jobs : int
+            Number of threads to launch. Default is 1, -1 will use the maximum
+            number of threads.
+        seed : int
+            Seed of the forest. Default None will result in a random seed.
+        """
+        super().__init__(
+            n_estimators=n_estimators,
+            max_samples=max_samples,
+            max_depth=max_depth,
+            n_jobs=n_jobs,
+            seed=seed,
+        )
+
+    def fit(self, X):
+        """
+        Fit the Isolation Forest.
+
+        Parameters
+        ----------
+        X : ndarray of shape (n_samples, n_features)
+        """
+        if not hasattr(X, "__array_interface__"):
+            raise TypeError("X must be a NumPy-compatible array")
+        return self._fit(X)
+
+    def score_samples(self, X):
+        """
+        Returns the anomaly score of samples X, in (0, 1] : scores close 
+        to 1 flag anomalies, scores well below 0.5 normal samples.
+
+        Parameters
+        ----------
+        X : ndarray with same shape as training data
+
+        Returns
+        -------
+        np.ndarray : array of shape (n_samples,) of anomaly scores.
+        """
+        if not hasattr(X, "__array_interface__"):
+            raise TypeError("X must be a NumPy-compatible array")
+        return self._score_samples(X)
+
+    def predict(self, X, threshold: float = 0.5):
+        """
+        Flags anomalies in samples X.
+
+        Parameters
+        ----------
+        X : ndarray with same shape as training data
+        threshold : float
+            Score from which a sample is an anomaly. Default is 0.5
+
+        Returns
+        -------
+        np.ndarray : array of shape (n_samples,) with 1 for anomalies, 0 otherwise.
+        """
+        return (self.score_samples(X) >= threshold).astype(np.int32)
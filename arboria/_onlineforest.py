@@ -0,0 +1,110 @@
+
+from ._arboria import OnlineForest as _OnlineForestBase
+import math
+
+class _OnlineForest(_OnlineForestBase):
+    def __init__(self, n_estimators: int = 10,
+                 max_features: int | str = "sqrt",
+                 max_depth: int = None,
+                 n_jobs: int = 1,
+                 seed : int | None = None,
+                 type : str = "classification",
+                 grace_period: int = 50,
+                 split_confidence: float = 0.01,
+                 tie_threshold: float = 0.05,
+                 n_candidates: int = 16,
+                 max_nodes: int = 4096,
+                 n_classes: int | None = None):
+        """
+        Random forest learned from mini-batches (online bagging and
+        Hoeffding splits).
+
+        Parameters
+        ----------
+        n_estimators : int
+            Number of trees in the forest. Default is 10
+        max_features: int | str
+            Number of features monitored by each leaf. Can be int, "sqrt" or "log".
+        max_depth : int
+            Maximum depth of the trees. Default is None
+        n_jobs : int
+            Number of threads to launch. Default is 1, -1 will use the maximum
+            number of threads.
+        seed : int
+            Seed of the forest. Default None will result in a random seed.
+        grace_period : int
+            Number of samples a leaf receives between two split attempts. Default is 50
+        split_confidence : float
+            Probability of choosing a wrong split in the Hoeffding bound. Default is 0.01
+        tie_threshold : float
+            Bound under which candidate splits are considered tied. Default is 0.05
+        n_candidates : int
+            Number of thresholds monitored per feature and per leaf. Default is 16
+        max_nodes : int
+            Maximum number of nodes per tree, bounding the memory. Default is 4096
+        n_classes : int
+            Number of classes of the stream. Default None takes it from the first batch.
+        """
+        self._type = type
+        if max_features == "sqrt":
+            self.mtry = -99
+        elif max_features == "log":
+            self.mtry = -98
+        else:
+            self.mtry = max_features
+        super().__init__(
+            n_estimators=n_estimators,
+            max_depth=max_depth,
+            n_jobs=n_jobs,
+            seed=seed,
+            type=type,
+            grace_period=grace_period,
+            split_confidence=split_confidence,
+            tie_threshold=tie_threshold,
+            n_candidates=n_candidates,
+            max_nodes=max_nodes,
+            n_classes=n_classes,
+        )
+
+    def partial_fit(self, X, y, criterion=None):
+        """
+        Updates the forest with a mini-batch.
+
+        Parameters
+        ----------
+        X : ndarray of shape (n_samples, n_features)
+        y : ndarray of shape (n_samples,)
+        criterion : {"gini", "entropy"} for classification, {"sse"} for
+            regression. Default None uses "gini" or "sse".
+        """
+        if not hasattr(X, "__array_interface__"):
+            raise TypeError("X must be a NumPy-compatible array")
+
+        if not hasattr(y, "__array_interface__"):
+            raise TypeError("y must be a NumPy-compatible array")
+
+        if self.mtry == -99:
+            self.mtry = max(1, int(math.sqrt(X.shape[1])))
+        if self.mtry == -98:
+            self.mtry = max(1, int(math.log2(X.shape[1])))
+        if criterion is None:
+            criterion = "gini" if self._type == "classification" else "sse"
+        return self._partial_fit(X, y, criterion, self.mtry)
+
+    def predict(self, X):
+        """
+        Returns predicted class (or value for regression) for samples X.
+        """
+        if not hasattr(X, "__array_interface__"):
+            raise TypeError("X must be a NumPy-compatible array")
+        return self._predict(X)
+
+    def predict_proba(self, X):
+        """
+        Returns the average of the tree votes for samples X : probability of
+        class 1 for binary classification, array of shape (n_samples, K) for
+        K > 2 classes.
+        """
+        if not hasattr(X, "__array_interface__"):
+            raise TypeError("X must be a NumPy-compatible array")
+        return self._predict_proba(X)
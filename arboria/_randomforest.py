@@ -1,6 +1,7 @@
 
 from ._arboria import RandomForest as _RandomForestBase
 import math
+import numpy as np
 
 class _RandomForest(_RandomForestBase):
     def __init__(self, n_estimators: int = 70,
@@ -10,7 +11,13 @@ class _RandomForest(_RandomForestBase):
                  min_sample_split: int = None,
                  n_jobs: int = 1,
                  seed : int | None = None,
-                 type : str = "classification"):
+                 type : str = "classification",
+                 oob_score : bool = False,
+                 early_stopping_tol : float | None = None,
+                 early_stopping_batch : int | None = None,
+                 quantiles : bool = False,
+                 max_leaf_samples : int | None = None,
+                 honest_fraction : float | None = None):
         """
         Random Forest classifier.
 
@@ -33,6 +40,26 @@ class _RandomForest(_RandomForestBase):
             use the maximum number of threads. 
         seed : int
             Seed of the tree. Default None will result in a random seed.
+        oob_score : bool
+            Whether to compute out-of-bag predictions during fit. Default is False.
+        early_stopping_tol : float
+            If set, trees are fitted in batches and the fit stops once a batch
+            improves the out-of-bag score by less than this tolerance. Default None 
+            fits all n_estimators trees.
+        early_stopping_batch : int
+            Number of trees fitted between two out-of-bag checks. Default is 10.
+        quantiles : bool
+            Whether leaves store their training targets for predict_quantiles
+            (regression only). Default is False.
+        max_leaf_samples : int
+            If set, leaves holding more targets are summarised into this number
+            of equal-weight bins, and quantiles are stored. Default None keeps 
+            all targets.
+        honest_fraction : float
+            If set, each tree learns its structure on this fraction of its 
+            distinct bootstrapped rows and its leaf values on the others.
+            A leaf reached by none of them takes the value of its nearest 
+            ancestor reached by some. Default None uses all rows for both.
         """
         if max_features == "sqrt":
             self.mtry = -99
@@ -49,6 +76,12 @@ class _RandomForest(_RandomForestBase):
             n_jobs=n_jobs,
             seed=seed,
             type=type,
+            oob_score=oob_score,
+            early_stopping_tol=early_stopping_tol,
+            early_stopping_batch=early_stopping_batch,
+            quantiles=quantiles,
+            max_leaf_samples=max_leaf_samples,
+            honest_fraction=honest_fraction,
         )
 
     def fit(self, X, y, criterion= 'gini'):
@@ -72,6 +105,51 @@ class _RandomForest(_RandomForestBase):
         if self.mtry == -98:
             self.mtry = max(1, int(math.log2(X.shape[1])))
         return self._fit(X, y, criterion, self.mtry)
+
+    def fit_more(self, X, y, n_new, criterion= 'gini'):
+        """
+        Adds n_new trees to the fitted Random Forest (warm start). Existing
+        trees are kept : the result is identical to a single fit with
+        n_estimators + n_new trees.
+
+        Parameters
+        ----------
+        X : ndarray of samples passed as training data
+        y : ndarray of target values passed as training data
+        n_new : int
+            Number of trees to add
+        criterion : split criterion used in fit
+        """
+        if not hasattr(X, "__array_interface__"):
+            raise TypeError("X must be a NumPy-compatible array")
+
+        if not hasattr(y, "__array_interface__"):
+            raise TypeError("y must be a NumPy-compatible array")
+
+        return self._fit_more(X, y, criterion, self.mtry, n_new)
+
+    def update(self, X, y, k, criterion= 'gini'):
+        """
+        Rolling-window update : fits k new trees on a new batch (X, y) and
+        evicts the k oldest trees, keeping the number of trees fixed. 
+        Predictions made from other threads during the update use either 
+        the previous or the updated forest.
+
+        Parameters
+        ----------
+        X : ndarray of shape (n_samples, n_features) of the new batch
+        y : ndarray of target values of the new batch
+        k : int
+            Number of trees to replace
+        criterion : split criterion used in fit
+        """
+        if not hasattr(X, "__array_interface__"):
+            raise TypeError("X must be a NumPy-compatible array")
+
+        if not hasattr(y, "__array_interface__"):
+            raise TypeError("y must be a NumPy-compatible array")
+
+        return self._update(X, y, criterion, self.mtry, k)
     
     def predict(self, X):
         """
@@ -90,6 +168,22 @@ class _RandomForest(_RandomForestBase):
 
         return self._predict(X)
     
+    def predict_one(self, x):
+        """
+        Returns the prediction of predict for a single sample, with the lowest
+        latency : no thread is started and nothing is allocated for the sample.
+
+        Parameters
+        ----------
+        x : 1D ndarray with the features of one sample (or a 2D array of one
+            row). A C-contiguous float32 array is read without conversion.
+
+        Returns
+        -------
+        float : the predicted class, or the averaged prediction for regression.
+        """
+        return self._predict_one(x)
+
     def predict_proba(self, X):
         """
         Returns predicted class for samples X as float as the average
@@ -107,6 +201,34 @@ class _RandomForest(_RandomForestBase):
             raise TypeError("X must be a NumPy-compatible array")
         return self._predict_proba(X)
     
+    def predict_proba_anytime(self, X, max_trees=None, max_time=None):
+        """
+        Returns predict_proba computed within a budget of trees or of time.
+
+        Trees are evaluated one at a time over every sample, the most accurate
+        ones on their out-of-bag samples first (with oob_score=True, otherwise
+        in the order they were fitted), and the running average is returned 
+        when the budget expires.
+
+        Parameters
+        ----------
+        X : ndarray with same shape as training data
+        max_trees : int, optional
+            Maximum number of trees to evaluate. Default is every tree.
+        max_time : float, optional
+            Seconds after which no further tree is started. The first tree is
+            always evaluated. Default is unbounded.
+
+        Returns
+        -------
+        tuple : the predictions, with the layout of predict_proba, and the
+        number of trees that contributed to them.
+        """
+        if not hasattr(X, "__array_interface__"):
+            raise TypeError("X must be a NumPy-compatible array")
+        proba, n_trees = self._predict_proba_anytime(X, max_trees, max_time)
+        return np.asarray(proba), n_trees
+
     def out_of_bag(self, X, y):
         """
         Returns the out-of-bag accuracy of the Random Forest.
@@ -132,3 +254,89 @@ class _RandomForest(_RandomForestBase):
     def get_max_samples(self):
 
         return self._get_max_samples()
+
+    @property
+    def oob_score_(self):
+        """
+        Out-of-bag score computed during fit : accuracy for classification,
+        R² for regression. Requires oob_score=True.
+        """
+        return self._oob_score()
+
+    @property
+    def oob_prediction_(self):
+        """
+        Out-of-bag prediction of each training sample, computed during fit 
+        with the same layout as predict_proba. Samples that were never 
+        out-of-bag are NaN. Requires oob_score=True.
+        """
+        return np.asarray(self._oob_prediction())
+
+    def save(self, path):
+        """
+        Writes the fitted Random Forest to a binary model file.
+
+        Parameters
+        ----------
+        path : str or path-like
+            Path of the file, overwritten if it exists
+        """
+        self._save(str(path))
+
+    def compile_native(self, path):
+        """
+        Compiles the trees to a native shared library used by predictions.
+
+        The trees are generated as C++ source, written to path + ".cpp", and
+        compiled with the system compiler (the ARBORIA_CXX or CXX environment
+        variables, c++ by default). The library serves single-sample predictions,
+        or every prediction with predict_engine = "native", until the trees
+        change.
+
+        Parameters
+        ----------
+        path : str or path-like
+            Path of the shared library, overwritten if it exists
+        """
+        self._compile_native(str(path))
+
+    def load_native(self, path):
+        """
+        Loads a library written by compile_native() from the same trees, e.g.
+        for a forest loaded with load().
+
+        Parameters
+        ----------
+        path : str or path-like
+            Path of the shared library
+        """
+        self._load_native(str(path))
+
+    @classmethod
+    def load(cls, path, mmap: bool = True):
+        """
+        Loads a Random Forest written by save(), ready to predict.
+
+        Parameters
+        ----------
+        path : str or path-like
+            Path of the model file
+        mmap : bool
+            Whether to map the file : the nodes are read in place from the
+            mapped pages instead of being copied. Default is True.
+
+        Notes
+        -----
+        Worker processes loading the same file (e.g. saved under /dev/shm)
+        share one copy of the forest in memory instead of each holding a
+        pickled copy. save() replaces the file atomically, so that models
+        already mapping it are not affected.
+        """
+        model = cls.__new__(cls)
+        _RandomForestBase.__init__(model, _model_file=str(path), mmap=mmap)
+        model.mtry = model.max_features
+        if model.mtry == -99:
+            model.mtry = max(1, int(math.sqrt(model.n_features)))
+        if model.mtry == -98:
+            model.mtry = max(1, int(math.log2(model.n_features)))
+        return model
@@ -9,8 +9,12 @@
 #include <pybind11/pybind11.h>
 #include <pybind11/stl.h>
 #include <pybind11/numpy.h>
+#include <algorithm>
+#include <chrono>
 #include <stdexcept>
+#include <thread>
 #include <cstdint>
+#include <span>
 #include <variant>
 
 #include "dataset/dataset.h"
@@ -21,21 +25,103 @@
 #include "tree/TreeModel.h"
 #include "split_strategy/types/ParamBuilder/ParamBuilder.h"
 #include "tree/RandomForest/randomforest.h"
+#include "tree/OnlineForest/onlineforest.h"
+#include "tree/IsolationForest/isolationforest.h"
+#include "tree/GradientBoosting/gradientboosting.h"
 #include "helpers/helpers.h"
 
 namespace py = pybind11;
 using arboria::ParamBuilder;
 
+namespace {
+
+//Builds the SplitParam of a RandomForest fit
+SplitParam forest_param(const TreeType& type, const std::string& criterion, const int m_try){
+
+    //----------Threshold
+    ThresholdComputation threshold = CART{};
+    //----------Feature
+    FeatureSelection feature = RandomK{m_try};
+    
+    //----------Criterion
+    Criterion crit;
+    if (std::holds_alternative<Classification>(type)){
+        if (criterion == "gini") crit = Gini{};
+        else if (criterion == "entropy") crit = Entropy{};
+        else throw std::runtime_error("Unknown split criterion passed to fit for classification.");
+    }
+    if (std::holds_alternative<Regression>(type)){
+        if (criterion == "sse") crit = SSE{};
+        else throw std::runtime_error("Unknown split criterion passed to fit for regression.");
+    }
+
+    return ParamBuilder(TreeModel::RandomForest, type, crit, threshold, feature);
+}
+
+//Copies numpy training arrays into a DataSet ; 2D targets hold one column per output
+arboria::DataSet forest_dataset(py::array_t<float, py::array::c_style | py::array::forcecast> X,
+                                py::array_t<float, py::array::c_style | py::array::forcecast> y){
+
+    auto xb = X.request();
+    if (xb.ndim != 2) {
+        throw std::runtime_error("X must be a 2D numpy array.");
+    }
+    auto yb = y.request();
+    if (yb.ndim != 1 && yb.ndim != 2) {
+        throw std::runtime_error("y must be a 1D or 2D numpy array.");
+    }
+
+    const size_t n_rows = static_cast<size_t>(xb.shape[0]);
+    const size_t n_cols = static_cast<size_t>(xb.shape[1]);
+    const size_t n_targets = (yb.ndim == 2) ? static_cast<size_t>(yb.shape[1]) : 1;
+    if ((size_t)yb.shape[0] != n_rows) {
+        throw std::runtime_error("y length must match X.shape[0].");
+    }
+
+    const float* X_ptr = static_cast<float*>(xb.ptr);
+    const float* y_ptr = static_cast<float*>(yb.ptr);
+
+    std::vector<float> X_vec(X_ptr, X_ptr + n_rows * n_cols);
+    std::vector<float> y_vec(y_ptr, y_ptr + n_rows * n_targets);
+
+    return arboria::DataSet(std::move(X_vec), std::move(y_vec), n_rows, n_cols, n_targets);
+}
+
+//Instance dictionary of a Python subclass, pickled along with the model
+py::dict instance_dict(const py::object& self){
+    if (!py::hasattr(self, "__dict__")) return py::dict();
+    return self.attr("__dict__").cast<py::dict>();
+}
+
+//Copies a binary model file into Python bytes
+py::bytes model_bytes(const std::vector<std::byte>& bytes){
+    return py::bytes(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+}
+
+//View over Python bytes holding a binary model file
+std::span<const std::byte> bytes_view(const py::handle& bytes){
+    char* data = nullptr;
+    Py_ssize_t size = 0;
+    if (PyBytes_AsStringAndSize(bytes.ptr(), &data, &size) != 0) throw py::error_already_set();
+    return std::span<const std::byte>(reinterpret_cast<const std::byte*>(data), static_cast<size_t>(size));
+}
+
+}
+
 PYBIND11_MODULE(_arboria, m){
 
     py::class_<arboria::DecisionTree>(m, "DecisionTree")
         .def(py::init([](std::optional<int> max_depth,
                                  std::optional<int> min_sample_split,
-                                std::string& type)
+                                std::string& type,
+                                std::optional<float> honest_fraction,
+                                std::optional<int> n_jobs)
                         {        
                         HyperParam hp;
                         if (max_depth.has_value()) hp.max_depth = max_depth;
                         hp.min_sample_split = min_sample_split;
+                        hp.honest_fraction = honest_fraction;
+                        hp.n_jobs = n_jobs;
                         TreeType type_;
                         if (type == "regression") type_ = Regression{};
                         else if (type == "classification") type_ = Classification{};
@@ -45,9 +131,45 @@ PYBIND11_MODULE(_arboria, m){
                     ),
             py::arg("max_depth") = std::nullopt,
             py::arg("min_sample_split") = std::nullopt,
-            py::arg("type") = std::nullopt
+            py::arg("type") = std::nullopt,
+            py::arg("honest_fraction") = std::nullopt,
+            py::arg("n_jobs") = std::nullopt
+    )
+
+        //loads a model file written by _save
+        .def(py::init([](const std::string& path, bool mmap)
+                        {
+                        arboria::DecisionTree tree = [&]{
+                            py::gil_scoped_release release;
+                            return arboria::DecisionTree::load(path, mmap);
+                        }();
+                        return std::make_unique<arboria::DecisionTree>(std::move(tree));}
+                    ),
+            py::arg("_model_file"),
+            py::arg("mmap") = true
     )
 
+        .def("_save",
+            [](const arboria::DecisionTree& self, const std::string& path) {
+                py::gil_scoped_release release;
+                self.save(path);
+            },
+            py::arg("path")
+        )
+
+        //pickled as the binary model file and the attributes of the Python subclass
+        .def(py::pickle(
+            [](const py::object& self){
+                const arboria::DecisionTree& tree = self.cast<const arboria::DecisionTree&>();
+                return py::make_tuple(model_bytes(tree.to_bytes()), instance_dict(self));
+            },
+            [](const py::tuple& state){
+                if (state.size() != 2) throw std::runtime_error("DecisionTree.__setstate__ : invalid state");
+                auto tree = std::make_unique<arboria::DecisionTree>(arboria::DecisionTree::from_bytes(bytes_view(state[0])));
+                return std::make_pair(std::move(tree), state[1].cast<py::dict>());
+            }
+        ))
+
     .def("_fit",
     [](arboria::DecisionTree& self, 
          py::array_t<float, py::array::c_style | py::array::forcecast> X,
@@ -60,11 +182,13 @@ PYBIND11_MODULE(_arboria, m){
                     throw std::runtime_error("X must be a 2D numpy array.");
                 }
                 auto yb = y.request();
-                if (yb.ndim != 1) {
-                    throw std::runtime_error("y must be a 1D numpy array.");
+                if (yb.ndim != 1 && yb.ndim != 2) {
+                    throw std::runtime_error("y must be a 1D or 2D numpy array.");
                 }
                 const size_t n_rows = static_cast<size_t>(xb.shape[0]);
                 const size_t n_cols = static_cast<size_t>(xb.shape[1]);
+                //2D targets : one column per output (multi-output regression)
+                const size_t n_targets = (yb.ndim == 2) ? static_cast<size_t>(yb.shape[1]) : 1;
                 if ((size_t)yb.shape[0] != n_rows) {
                     throw std::runtime_error("y length must match X.shape[0].");
                 }
@@ -73,9 +197,9 @@ PYBIND11_MODULE(_arboria, m){
                 const float* y_ptr = static_cast<const float*>(yb.ptr);
 
                 std::vector<float> X_vec(X_ptr, X_ptr + n_rows * n_cols);
-                std::vector<float> y_vec(y_ptr, y_ptr + n_rows);
+                std::vector<float> y_vec(y_ptr, y_ptr + n_rows * n_targets);
 
-                arboria::DataSet data(std::move(X_vec), std::move(y_vec), n_rows, n_cols);
+                arboria::DataSet data(std::move(X_vec), std::move(y_vec), n_rows, n_cols, n_targets);
 
 
     //----------------------Param Build
@@ -130,36 +254,85 @@ PYBIND11_MODULE(_arboria, m){
             )
 
         .def("_predict",
-        [](arboria::DecisionTree& self, 
+        [](const arboria::DecisionTree& self, 
            py::array_t<float, py::array::c_style | py::array::forcecast> X
-        )
+        ) -> py::object
         {
             auto xb = X.request();
-            size_t ndim = xb.ndim;
-        
-            if( ndim ==1){
-            const size_t n_cols = static_cast<size_t>(xb.size);
-            const float* x_ptr = static_cast<const float*>(xb.ptr);
-            std::vector<float> X_vec(x_ptr, x_ptr + n_cols);
-            return std::vector<float>{self.predict_one(X_vec)};
+            if (xb.ndim != 1 && xb.ndim != 2) throw std::runtime_error("X must be a 1D or 2D numpy array");
+            std::span<const float> samples(static_cast<const float*>(xb.ptr), static_cast<size_t>(xb.size));
+            std::vector<float> preds;
+            {
+                py::gil_scoped_release release;
+                preds = self.predict(samples);
             }
 
-            else if (ndim == 2){
-            const size_t n_rows = static_cast<size_t>(xb.shape[0]);
-            const size_t n_cols = static_cast<size_t>(xb.shape[1]);
-            const float* x_ptr = static_cast<const float*>(xb.ptr);
-            std::vector<float> X_vec(x_ptr, x_ptr +n_rows*n_cols);
-            return self.predict(X_vec);
+            //multi-output trees return one column per target
+            if (self.n_outputs() > 1){
+                const size_t T = static_cast<size_t>(self.n_outputs());
+                py::array_t<float> out({preds.size() / T, T});
+                std::copy(preds.begin(), preds.end(), out.mutable_data());
+                return out;
+            }
+            return py::cast(preds);
+        },
+        py::arg("X")
+    )
+
+        .def("_predict_proba",
+        [](const arboria::DecisionTree& self, 
+           py::array_t<float, py::array::c_style | py::array::forcecast> X
+        )
+        {
+            auto xb = X.request();
+            if (xb.ndim != 1 && xb.ndim != 2) throw std::runtime_error("X must be a 1D or 2D numpy array");
+            std::span<const float> samples(static_cast<const float*>(xb.ptr), static_cast<size_t>(xb.size));
+            std::vector<float> proba;
+            {
+                py::gil_scoped_release release;
+                proba = self.predict_proba(samples);
             }
 
-            else{
-            throw std::runtime_error("X must be a 1D or 2D numpy array");
+            const size_t K = static_cast<size_t>(self.n_classes());
+            py::array_t<float> out({proba.size() / K, K});
+            std::copy(proba.begin(), proba.end(), out.mutable_data());
+            return out;
+        },
+        py::arg("X")
+    )
+
+        .def("_apply",
+        [](const arboria::DecisionTree& self, 
+           py::array_t<float, py::array::c_style | py::array::forcecast> X
+        )
+        {
+            auto xb = X.request();
+            if (xb.ndim != 1 && xb.ndim != 2) throw std::runtime_error("X must be a 1D or 2D numpy array");
+            std::span<const float> samples(static_cast<const float*>(xb.ptr), static_cast<size_t>(xb.size));
+            std::vector<int> leaves;
+            {
+                py::gil_scoped_release release;
+                leaves = self.apply(samples);
             }
+            py::array_t<int> out(leaves.size());
+            std::copy(leaves.begin(), leaves.end(), out.mutable_data());
+            return out;
         },
         py::arg("X")
     )
 
-        .def_property_readonly("is_fitted", &arboria::DecisionTree::is_fitted);
+        .def_property_readonly("is_fitted", &arboria::DecisionTree::is_fitted)
+        .def_property_readonly("n_classes", &arboria::DecisionTree::n_classes)
+        .def_property_readonly("n_outputs", &arboria::DecisionTree::n_outputs)
+
+        //threads routing the samples of apply, predict and predict_proba ; -1 uses every core
+        .def_property("n_jobs",
+            [](const arboria::DecisionTree& self){return self.n_jobs;},
+            [](arboria::DecisionTree& self, int n_jobs){
+                if (n_jobs < -1 || n_jobs == 0) throw std::invalid_argument("DecisionTree.n_jobs : n_jobs must be a positive int or equals to -1");
+                self.n_jobs = (n_jobs == -1) ? std::max(1, static_cast<int>(std::thread::hardware_concurrency())) : n_jobs;
+            }
+        );
 
 
 
@@ -172,10 +345,22 @@ PYBIND11_MODULE(_arboria, m){
                         std::optional<int> min_sample_split,
                         std::optional<int> n_jobs,
                         std::optional<std::uint32_t> seed,
-                        std::string type)
+                        std::string type,
+                        std::optional<bool> oob_score,
+                        std::optional<float> early_stopping_tol,
+                        std::optional<int> early_stopping_batch,
+                        std::optional<bool> quantiles,
+                        std::optional<int> max_leaf_samples,
+                        std::optional<float> honest_fraction)
                         {        
                         HyperParam hp;
+                        hp.honest_fraction = honest_fraction;
                         hp.n_estimators = n_estimators;
+                        hp.oob_score = oob_score;
+                        hp.early_stopping_tol = early_stopping_tol;
+                        hp.early_stopping_batch = early_stopping_batch;
+                        hp.quantiles = quantiles;
+                        hp.max_leaf_samples = max_leaf_samples;
                         hp.mtry = m_try; // value always set during Python init ; must be passed
                         hp.max_samples = max_samples;
                         hp.min_sample_split = min_sample_split;
@@ -202,85 +387,123 @@ PYBIND11_MODULE(_arboria, m){
             py::arg("min_sample_split") = std::nullopt,
             py::arg("n_jobs") = std::nullopt,
             py::arg("seed") = std::nullopt,
-            py::arg("type") = std::nullopt
+            py::arg("type") = std::nullopt,
+            py::arg("oob_score") = std::nullopt,
+            py::arg("early_stopping_tol") = std::nullopt,
+            py::arg("early_stopping_batch") = std::nullopt,
+            py::arg("quantiles") = std::nullopt,
+            py::arg("max_leaf_samples") = std::nullopt,
+            py::arg("honest_fraction") = std::nullopt
+    )
+
+        //loads a model file written by _save
+        .def(py::init([](const std::string& path, bool mmap)
+                        {
+                        py::gil_scoped_release release;
+                        return arboria::RandomForest::load(path, mmap);}
+                    ),
+            py::arg("_model_file"),
+            py::arg("mmap") = true
     )
 
+        .def("_save",
+            [](const arboria::RandomForest& self, const std::string& path) {
+                py::gil_scoped_release release;
+                self.save(path);
+            },
+            py::arg("path")
+        )
+
+        .def("_compile_native",
+            [](arboria::RandomForest& self, const std::string& path) {
+                py::gil_scoped_release release;
+                self.compile_native(path);
+            },
+            py::arg("path")
+        )
+
+        .def("_load_native",
+            [](arboria::RandomForest& self, const std::string& path) {
+                py::gil_scoped_release release;
+                self.load_native(path);
+            },
+            py::arg("path")
+        )
+
+        //pickled as the binary model file and the attributes of the Python subclass
+        .def(py::pickle(
+            [](const py::object& self){
+                const arboria::RandomForest& forest = self.cast<const arboria::RandomForest&>();
+                std::vector<std::byte> bytes;
+                {
+                    py::gil_scoped_release release;
+                    bytes = forest.to_bytes();
+                }
+                return py::make_tuple(model_bytes(bytes), instance_dict(self));
+            },
+            [](const py::tuple& state){
+                if (state.size() != 2) throw std::runtime_error("RandomForest.__setstate__ : invalid state");
+                std::unique_ptr<arboria::RandomForest> forest = arboria::RandomForest::from_bytes(bytes_view(state[0]));
+                return std::make_pair(std::move(forest), state[1].cast<py::dict>());
+            }
+        ))
+
         .def("_fit", 
             [](arboria::RandomForest& self, 
             py::array_t<float, py::array::c_style | py::array::forcecast> X,
             py::array_t<float, py::array::c_style | py::array::forcecast> y,
             const std::string& criterion, const int m_try) {
-                
-//----------------------Input Checks 
-                auto xb = X.request();
-                if (xb.ndim != 2) {
-                    throw std::runtime_error("X must be a 2D numpy array.");
-                }
-                auto yb = y.request();
-                if (yb.ndim != 1) {
-                    throw std::runtime_error("y must be a 1D numpy array.");
-                }
-                
-//----------------------Param Build
-
-
 
+                SplitParam param = forest_param(self.type_, criterion, m_try);
+                arboria::DataSet data = forest_dataset(X, y);
+                self.fit(data, param);
+            },
+            
+            py::arg("X"), py::arg("y"), py::arg("criterion") = "gini", py::arg("m_try")
+        )
 
-                //----------Threshold
-                ThresholdComputation threshold = CART{};
-                //----------Feature
-                FeatureSelection feature = RandomK{m_try};
-                TreeType type = self.type_;
-                
-                //----------Criterion
-                Criterion crit;
-                if (std::holds_alternative<Classification>(type)){
-                    if (criterion == "gini") crit = Gini{};
-                    else if (criterion == "entropy") crit = Entropy{};
-                    else throw std::runtime_error("Unknown split criterion passed to fit for classification.");
-                }
-                if (std::holds_alternative<Regression>(type)){
-                    if (criterion == "sse") crit = SSE{};
-                    else throw std::runtime_error("Unknown split criterion passed to fit for regression.");
-                }
+        .def("_fit_more", 
+            [](arboria::RandomForest& self, 
+            py::array_t<float, py::array::c_style | py::array::forcecast> X,
+            py::array_t<float, py::array::c_style | py::array::forcecast> y,
+            const std::string& criterion, const int m_try, const int n_new) {
 
-                SplitParam param = ParamBuilder(TreeModel::RandomForest, 
-                    type,
-                    crit, 
-                    threshold , 
-                    feature);
+                SplitParam param = forest_param(self.type_, criterion, m_try);
+                arboria::DataSet data = forest_dataset(X, y);
+                self.fit_more(data, param, n_new);
+            },
             
-//----------------------DataSet Build
-                const size_t n_rows = static_cast<size_t>(xb.shape[0]);
-                const size_t n_cols = static_cast<size_t>(xb.shape[1]);
-                if ((size_t)yb.shape[0] != n_rows) {
-                    throw std::runtime_error("y length must match X.shape[0].");
-                }
-
-                const float* X_ptr = static_cast<float*>(xb.ptr);
-                const float* y_ptr = static_cast<float*>(yb.ptr);
+            py::arg("X"), py::arg("y"), py::arg("criterion") = "gini", py::arg("m_try"), py::arg("n_new")
+        )
 
-                std::vector<float> X_vec(X_ptr, X_ptr + n_rows * n_cols);
-                std::vector<float> y_vec(y_ptr, y_ptr + n_rows);
+        .def("_update", 
+            [](arboria::RandomForest& self, 
+            py::array_t<float, py::array::c_style | py::array::forcecast> X,
+            py::array_t<float, py::array::c_style | py::array::forcecast> y,
+            const std::string& criterion, const int m_try, const int k) {
 
-                arboria::DataSet data(std::move(X_vec), std::move(y_vec), n_rows, n_cols);
-                self.fit(data, param);
+                SplitParam param = forest_param(self.type_, criterion, m_try);
+                arboria::DataSet data = forest_dataset(X, y);
+                //other Python threads keep serving predictions during the update
+                py::gil_scoped_release release;
+                self.update(data, param, k);
             },
             
-            py::arg("X"), py::arg("y"), py::arg("criterion") = "gini", py::arg("m_try")
+            py::arg("X"), py::arg("y"), py::arg("criterion") = "gini", py::arg("m_try"), py::arg("k")
         )
 
         .def("_predict", 
-        [](arboria::RandomForest& self, py::array_t<float, py::array::c_style | py::array::forcecast> X){
+        [](arboria::RandomForest& self, py::array_t<float, py::array::c_style | py::array::forcecast> X) -> py::object {
 
             auto xb = X.request();
             size_t ndim = xb.ndim;
+            std::vector<float> preds;
             
             if (ndim == 1){
                 const size_t n_cols = xb.size;
                 const float* x_ptr = static_cast<float*>(xb.ptr);
                 const std::vector<float> X_vec(x_ptr, x_ptr+n_cols);
-                return self.predict(X_vec);
+                preds = self.predict(X_vec);
 
             }
 
@@ -292,41 +515,55 @@ PYBIND11_MODULE(_arboria, m){
                 const float* x_ptr = static_cast<float*>(xb.ptr);
 
                 const std::vector<float> X_vec(x_ptr, x_ptr+n_cols*n_rows);
-                return self.predict(X_vec);
+                preds = self.predict(X_vec);
             }
 
             else {throw std::runtime_error("RandomForest.predict : invalid dimension of input");}
 
+            //multi-output forests return one column per target
+            if (self.n_outputs() > 1){
+                const size_t T = static_cast<size_t>(self.n_outputs());
+                py::array_t<float> out({preds.size() / T, T});
+                std::copy(preds.begin(), preds.end(), out.mutable_data());
+                return out;
+            }
+            return py::cast(preds);
         }
         
         )
 
+        .def("_predict_one",
+            [](const arboria::RandomForest& self, py::array_t<float, py::array::c_style | py::array::forcecast> x) {
+
+                //the sample is read in place : no copy for a contiguous float32 array
+                if (x.ndim() != 1 && !(x.ndim() == 2 && x.shape(0) == 1)) {throw std::runtime_error("RandomForest.predict_one : x must be a single sample");}
+                if (x.size() != static_cast<py::ssize_t>(self.n_features())) {throw std::invalid_argument("RandomForest.predict_one : x does not have the number of features seen in training");}
+                return self.predict_one(x.data());
+            },
+            py::arg("x")
+        )
+
         .def("_predict_proba",
-            [](arboria::RandomForest& self, py::array_t<float, py::array::c_style | py::array::forcecast> X){
+            [](arboria::RandomForest& self, py::array_t<float, py::array::c_style | py::array::forcecast> X) -> py::object {
                 
                 auto xb = X.request();
                 const size_t ndim = xb.ndim;
+                if (ndim != 1 && ndim != 2) {throw std::runtime_error("RandomForest.predict_proba : invalid dimension on inputs");}
 
-                if (ndim == 1){
-
-                    const size_t n_cols = xb.size;
-                    const float* x_ptr = static_cast<float*>(xb.ptr);
-                    std::vector<float> X_vec(x_ptr, x_ptr + n_cols);
-                    return self.predict_proba(X_vec);
-                }
-
-                else if (ndim == 2){
-                    const size_t n_rows = xb.shape[0];
-                    const size_t n_cols = xb.shape[1];
-
-                    const float* x_ptr = static_cast<float*>(xb.ptr);
-
-                    std::vector<float> X_vec(x_ptr, x_ptr+n_cols*n_rows);
-                    return self.predict_proba(X_vec);
-
+                const size_t n_values = xb.size;
+                const float* x_ptr = static_cast<float*>(xb.ptr);
+                std::vector<float> X_vec(x_ptr, x_ptr + n_values);
+                std::vector<float> proba = self.predict_proba(X_vec);
+
+                //multiclass forests return one column per class, multi-output
+                //forests one column per target
+                if (self.n_classes() > 2 || self.n_outputs() > 1){
+                    const size_t K = static_cast<size_t>(std::max(self.n_classes(), self.n_outputs()));
+                    py::array_t<float> out({proba.size() / K, K});
+                    std::copy(proba.begin(), proba.end(), out.mutable_data());
+                    return out;
                 }
-
-                else {throw std::runtime_error("RandomForest.predict_proba : invalid dimension on inputs");}
+                return py::cast(proba);
 
 
 
@@ -336,45 +573,371 @@ PYBIND11_MODULE(_arboria, m){
         
         )
 
-        .def("_out_of_bag",
-            [](arboria::RandomForest& self, py::array_t<float, py::array::c_style | py::array::forcecast> X,
-            py::array_t<float, py::array::c_style | py::array::forcecast> y){
-                
+        //returns (predictions, number of trees averaged) ; max_time in seconds
+        .def("_predict_proba_anytime",
+            [](const arboria::RandomForest& self, py::array_t<float, py::array::c_style | py::array::forcecast> X,
+               std::optional<int> max_trees, std::optional<double> max_time) -> py::tuple {
+
                 auto xb = X.request();
-                if (xb.ndim != 2) {
-                    throw std::runtime_error("X must be a 2D numpy array.");
-                }
-                auto yb = y.request();
-                if (yb.ndim != 1) {
-                    throw std::runtime_error("y must be a 1D numpy array.");
+                if (xb.ndim != 1 && xb.ndim != 2) {throw std::runtime_error("RandomForest.predict_proba_anytime : invalid dimension on inputs");}
+                const float* x_ptr = static_cast<float*>(xb.ptr);
+                std::vector<float> X_vec(x_ptr, x_ptr + xb.size);
+                std::optional<std::chrono::nanoseconds> budget;
+                if (max_time.has_value()) budget = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::duration<double>(*max_time));
+
+                arboria::AnytimePrediction result;
+                {
+                    py::gil_scoped_release release;
+                    result = self.predict_proba_anytime(X_vec, max_trees, budget);
                 }
-                const size_t n_rows = static_cast<size_t>(xb.shape[0]);
-                const size_t n_cols = static_cast<size_t>(xb.shape[1]);
-                if ((size_t)yb.shape[0] != n_rows) {
-                    throw std::runtime_error("y length must match X.shape[0].");
+                if (self.n_classes() > 2 || self.n_outputs() > 1){
+                    const size_t K = static_cast<size_t>(std::max(self.n_classes(), self.n_outputs()));
+                    py::array_t<float> out({result.proba.size() / K, K});
+                    std::copy(result.proba.begin(), result.proba.end(), out.mutable_data());
+                    return py::make_tuple(out, result.n_trees);
                 }
+                return py::make_tuple(py::cast(result.proba), result.n_trees);
+            },
+            py::arg("X"),
+            py::arg("max_trees") = std::nullopt,
+            py::arg("max_time") = std::nullopt
+        )
 
-                const float* X_ptr = static_cast<const float*>(xb.ptr);
-                const float* y_ptr = static_cast<const float*>(yb.ptr);
+        .def("_anytime_order", &arboria::RandomForest::anytime_order)
 
-                std::vector<float> X_vec(X_ptr, X_ptr + n_rows * n_cols);
-                std::vector<float> y_vec(y_ptr, y_ptr + n_rows);
+        .def("_out_of_bag",
+            [](arboria::RandomForest& self, py::array_t<float, py::array::c_style | py::array::forcecast> X,
+            py::array_t<float, py::array::c_style | py::array::forcecast> y){
 
-                arboria::DataSet data(std::move(X_vec), std::move(y_vec), n_rows, n_cols);
+                arboria::DataSet data = forest_dataset(X, y);
                 return self.out_of_bag(data);
             }
         
         )
 
+        .def("_oob_score", &arboria::RandomForest::oob_score)
+
+        .def("_predict_quantiles",
+            [](const arboria::RandomForest& self, py::array_t<float, py::array::c_style | py::array::forcecast> X,
+            std::vector<float> qs) {
+
+                auto xb = X.request();
+                if (xb.ndim != 1 && xb.ndim != 2) {throw std::runtime_error("RandomForest.predict_quantiles : invalid dimension on inputs");}
+                const float* x_ptr = static_cast<float*>(xb.ptr);
+                std::vector<float> X_vec(x_ptr, x_ptr + xb.size);
+                std::vector<float> quantiles = self.predict_quantiles(X_vec, qs);
+
+                //one row per sample, one column per quantile level
+                const size_t Q = qs.size();
+                py::array_t<float> out({Q == 0 ? size_t{0} : quantiles.size() / Q, Q});
+                std::copy(quantiles.begin(), quantiles.end(), out.mutable_data());
+                return out;
+            },
+            py::arg("X"), py::arg("qs")
+        )
+
+        .def("_oob_prediction",
+            [](const arboria::RandomForest& self) -> py::object {
+                std::vector<float> preds = self.oob_prediction();
+                //same layout as predict_proba : one column per class or per target
+                if (self.n_classes() > 2 || self.n_outputs() > 1){
+                    const size_t K = static_cast<size_t>(std::max(self.n_classes(), self.n_outputs()));
+                    py::array_t<float> out({preds.size() / K, K});
+                    std::copy(preds.begin(), preds.end(), out.mutable_data());
+                    return out;
+                }
+                return py::cast(preds);
+            }
+        )
+
         .def("_get_max_samples",
             [](const arboria::RandomForest& rf) -> py::object {
             auto d = rf.get_max_samples();
             if (d.has_value()) return py::float_(static_cast<double>(*d));
             return py::none();
         }
+        )
+
+        .def_property_readonly("n_classes", &arboria::RandomForest::n_classes)
+        .def_property_readonly("n_outputs", &arboria::RandomForest::n_outputs)
+        .def_property_readonly("n_trees", &arboria::RandomForest::n_trees)
+        .def_property_readonly("n_features", &arboria::RandomForest::n_features)
+        .def_property_readonly("max_features", &arboria::RandomForest::get_max_features)
+
+        //"auto", "traversal", "quickscorer", "blocked", "implicit" or "native" ; see RandomForest::set_predict_engine
+        .def_property("predict_engine",
+            [](const arboria::RandomForest& self) -> std::string {
+                const PredictEngine engine = self.get_predict_engine();
+                if (std::holds_alternative<Traversal>(engine)) return "traversal";
+                if (std::holds_alternative<QuickScorer>(engine)) return "quickscorer";
+                if (std::holds_alternative<Blocked>(engine)) return "blocked";
+                if (std::holds_alternative<Implicit>(engine)) return "implicit";
+                if (std::holds_alternative<Native>(engine)) return "native";
+                return "auto";
+            },
+            [](arboria::RandomForest& self, const std::string& engine){
+                if (engine == "auto") self.set_predict_engine(Undefined{});
+                else if (engine == "traversal") self.set_predict_engine(Traversal{});
+                else if (engine == "quickscorer") self.set_predict_engine(QuickScorer{});
+                else if (engine == "blocked") self.set_predict_engine(Blocked{});
+                else if (engine == "implicit") self.set_predict_engine(Implicit{});
+                else if (engine == "native") self.set_predict_engine(Native{});
+                else throw std::invalid_argument("RandomForest.predict_engine : expected 'auto', 'traversal', 'quickscorer', 'blocked', 'implicit' or 'native'");
+            }
         );
 
 
+    py::class_<arboria::OnlineForest>(m, "OnlineForest")
+        .def(py::init([](std::optional<int> n_estimators,
+                        std::optional<int> max_depth,
+                        std::optional<int> n_jobs,
+                        std::optional<std::uint32_t> seed,
+                        std::string type,
+                        int grace_period,
+                        float split_confidence,
+                        float tie_threshold,
+                        int n_candidates,
+                        int max_nodes,
+                        std::optional<int> n_classes)
+                        {
+                        HyperParam hp;
+                        hp.n_estimators = n_estimators;
+                        hp.max_depth = max_depth;
+                        hp.n_jobs = n_jobs;
+                        TreeType type_;
+                        if (type == "regression") type_ = Regression{};
+                        else if (type == "classification") type_ = Classification{};
+                        else throw std::invalid_argument("OnlineForest constructor : invalid TreeType");
+
+                        arboria::OnlineParam online{grace_period, split_confidence, tie_threshold, n_candidates, max_nodes, n_classes};
+                        return std::make_unique<arboria::OnlineForest>(hp, type_, seed, online);}
+                    ),
+            py::arg("n_estimators") = std::nullopt,
+            py::arg("max_depth") = std::nullopt,
+            py::arg("n_jobs") = std::nullopt,
+            py::arg("seed") = std::nullopt,
+            py::arg("type") = "classification",
+            py::arg("grace_period") = 50,
+            py::arg("split_confidence") = 0.01f,
+            py::arg("tie_threshold") = 0.05f,
+            py::arg("n_candidates") = 16,
+            py::arg("max_nodes") = 4096,
+            py::arg("n_classes") = std::nullopt
+    )
+
+        .def("_partial_fit",
+            [](arboria::OnlineForest& self,
+            py::array_t<float, py::array::c_style | py::array::forcecast> X,
+            py::array_t<float, py::array::c_style | py::array::forcecast> y,
+            const std::string& criterion, const int m_try) {
+
+                SplitParam param = forest_param(self.type_, criterion, m_try);
+                arboria::DataSet data = forest_dataset(X, y);
+                py::gil_scoped_release release;
+                self.partial_fit(data, param);
+            },
+            py::arg("X"), py::arg("y"), py::arg("criterion") = "gini", py::arg("m_try")
+        )
+
+        .def("_predict",
+            [](arboria::OnlineForest& self, py::array_t<float, py::array::c_style | py::array::forcecast> X) {
+
+                auto xb = X.request();
+                if (xb.ndim != 1 && xb.ndim != 2) {throw std::runtime_error("OnlineForest.predict : invalid dimension of input");}
+                const float* x_ptr = static_cast<float*>(xb.ptr);
+                std::vector<float> X_vec(x_ptr, x_ptr + xb.size);
+                return self.predict(X_vec);
+            }
+        )
+
+        .def("_predict_proba",
+            [](arboria::OnlineForest& self, py::array_t<float, py::array::c_style | py::array::forcecast> X) -> py::object {
+
+                auto xb = X.request();
+                if (xb.ndim != 1 && xb.ndim != 2) {throw std::runtime_error("OnlineForest.predict_proba : invalid dimension on inputs");}
+                const float* x_ptr = static_cast<float*>(xb.ptr);
+                std::vector<float> X_vec(x_ptr, x_ptr + xb.size);
+                std::vector<float> proba = self.predict_proba(X_vec);
+
+                //multiclass forests return one column per class
+                if (self.n_classes() > 2){
+                    const size_t K = static_cast<size_t>(self.n_classes());
+                    py::array_t<float> out({proba.size() / K, K});
+                    std::copy(proba.begin(), proba.end(), out.mutable_data());
+                    return out;
+                }
+                return py::cast(proba);
+            }
+        )
+
+        .def_property_readonly("is_fitted", &arboria::OnlineForest::is_fitted)
+        .def_property_readonly("n_classes", &arboria::OnlineForest::n_classes)
+        .def_property_readonly("n_nodes", &arboria::OnlineForest::n_nodes);
+
+
+    py::class_<arboria::IsolationForest>(m, "IsolationForest")
+        .def(py::init([](std::optional<int> n_estimators,
+                        std::optional<float> max_samples,
+                        std::optional<int> max_depth,
+                        std::optional<int> n_jobs,
+                        std::optional<std::uint32_t> seed)
+                        {
+                        HyperParam hp;
+                        hp.n_estimators = n_estimators;
+                        hp.max_samples = max_samples;
+                        hp.max_depth = max_depth;
+                        hp.n_jobs = n_jobs;
+                        return std::make_unique<arboria::IsolationForest>(hp, seed);}
+                    ),
+            py::arg("n_estimators") = std::nullopt,
+            py::arg("max_samples") = std::nullopt,
+            py::arg("max_depth") = std::nullopt,
+            py::arg("n_jobs") = std::nullopt,
+            py::arg("seed") = std::nullopt
+    )
+
+        .def("_fit",
+            [](arboria::IsolationForest& self, py::array_t<float, py::array::c_style | py::array::forcecast> X) {
+
+                auto xb = X.request();
+                if (xb.ndim != 2) {throw std::runtime_error("IsolationForest.fit : X must be a 2D array");}
+                std::span<const float> samples(static_cast<const float*>(xb.ptr), static_cast<size_t>(xb.size));
+                py::gil_scoped_release release;
+                self.fit(samples, static_cast<int>(xb.shape[1]));
+            },
+            py::arg("X")
+        )
+
+        .def("_score_samples",
+            [](const arboria::IsolationForest& self, py::array_t<float, py::array::c_style | py::array::forcecast> X) {
+
+                //the samples are scored in place : no copy of the input buffer
+                auto xb = X.request();
+                if (xb.ndim != 1 && xb.ndim != 2) {throw std::runtime_error("IsolationForest.score_samples : invalid dimension of input");}
+                std::span<const float> samples(static_cast<const float*>(xb.ptr), static_cast<size_t>(xb.size));
+                std::vector<float> scores;
+                {
+                    py::gil_scoped_release release;
+                    scores = self.score_samples(samples);
+                }
+                py::array_t<float> out(scores.size());
+                std::copy(scores.begin(), scores.end(), out.mutable_data());
+                return out;
+            },
+            py::arg("X")
+        )
+
+        .def("_path_length",
+            [](const arboria::IsolationForest& self, py::array_t<float, py::array::c_style | py::array::forcecast> X) {
+
+                auto xb = X.request();
+                if (xb.ndim != 1 && xb.ndim != 2) {throw std::runtime_error("IsolationForest.path_length : invalid dimension of input");}
+                std::span<const float> samples(static_cast<const float*>(xb.ptr), static_cast<size_t>(xb.size));
+                std::vector<float> lengths;
+                {
+                    py::gil_scoped_release release;
+                    lengths = self.path_length(samples);
+                }
+                py::array_t<float> out(lengths.size());
+                std::copy(lengths.begin(), lengths.end(), out.mutable_data());
+                return out;
+            },
+            py::arg("X")
+        )
+
+        .def_property_readonly("is_fitted", &arboria::IsolationForest::is_fitted)
+        .def_property_readonly("subsample_size", &arboria::IsolationForest::subsample_size)
+        .def_property_readonly("max_depth", &arboria::IsolationForest::get_max_depth)
+        .def_property_readonly("n_nodes", &arboria::IsolationForest::n_nodes);
+
+
+    py::class_<arboria::GradientBoosting>(m, "GradientBoosting")
+        .def(py::init([](std::optional<int> n_estimators,
+                        std::optional<int> max_depth,
+                        std::optional<int> min_sample_split,
+                        std::optional<int> n_jobs,
+                        std::optional<std::uint32_t> seed,
+                        std::string type,
+                        float learning_rate,
+                        float reg_lambda,
+                        float subsample,
+                        float colsample)
+                        {
+                        HyperParam hp;
+                        hp.n_estimators = n_estimators;
+                        hp.max_depth = max_depth;
+                        hp.min_sample_split = min_sample_split;
+                        hp.n_jobs = n_jobs;
+                        TreeType type_;
+                        if (type == "regression") type_ = Regression{};
+                        else if (type == "classification") type_ = Classification{};
+                        else throw std::invalid_argument("GradientBoosting constructor : invalid TreeType");
+
+                        arboria::BoostParam boost{learning_rate, reg_lambda, subsample, colsample};
+                        return std::make_unique<arboria::GradientBoosting>(hp, type_, seed, boost);}
+                    ),
+            py::arg("n_estimators") = std::nullopt,
+            py::arg("max_depth") = std::nullopt,
+            py::arg("min_sample_split") = std::nullopt,
+            py::arg("n_jobs") = std::nullopt,
+            py::arg("seed") = std::nullopt,
+            py::arg("type") = "regression",
+            py::arg("learning_rate") = 0.1f,
+            py::arg("reg_lambda") = 1.f,
+            py::arg("subsample") = 1.f,
+            py::arg("colsample") = 1.f
+    )
+
+        .def("_fit",
+            [](arboria::GradientBoosting& self,
+            py::array_t<float, py::array::c_style | py::array::forcecast> X,
+            py::array_t<float, py::array::c_style | py::array::forcecast> y) {
+
+                arboria::DataSet data = forest_dataset(X, y);
+                py::gil_scoped_release release;
+                self.fit(data);
+            },
+            py::arg("X"), py::arg("y")
+        )
+
+        .def("_decision_function",
+            [](const arboria::GradientBoosting& self, py::array_t<float, py::array::c_style | py::array::forcecast> X) {
+
+                auto xb = X.request();
+                if (xb.ndim != 1 && xb.ndim != 2) {throw std::runtime_error("GradientBoosting.decision_function : invalid dimension of input");}
+                std::span<const float> samples(static_cast<const float*>(xb.ptr), static_cast<size_t>(xb.size));
+                return self.decision_function(samples);
+            },
+            py::arg("X")
+        )
+
+        .def("_predict_proba",
+            [](const arboria::GradientBoosting& self, py::array_t<float, py::array::c_style | py::array::forcecast> X) {
+
+                auto xb = X.request();
+                if (xb.ndim != 1 && xb.ndim != 2) {throw std::runtime_error("GradientBoosting.predict_proba : invalid dimension of input");}
+                std::span<const float> samples(static_cast<const float*>(xb.ptr), static_cast<size_t>(xb.size));
+                return self.predict_proba(samples);
+            },
+            py::arg("X")
+        )
+
+        .def("_predict",
+            [](const arboria::GradientBoosting& self, py::array_t<float, py::array::c_style | py::array::forcecast> X) {
+
+                auto xb = X.request();
+                if (xb.ndim != 1 && xb.ndim != 2) {throw std::runtime_error("GradientBoosting.predict : invalid dimension of input");}
+                std::span<const float> samples(static_cast<const float*>(xb.ptr), static_cast<size_t>(xb.size));
+                return self.predict(samples);
+            },
+            py::arg("X")
+        )
+
+        .def_property_readonly("is_fitted", &arboria::GradientBoosting::is_fitted)
+        .def_property_readonly("base_score", &arboria::GradientBoosting::base_score)
+        .def_property_readonly("train_loss", &arboria::GradientBoosting::train_loss);
+
+
 
 
         m.def("_accuracy", 
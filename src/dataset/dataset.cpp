@@ -6,18 +6,29 @@
 
 namespace arboria{
 DataSet::DataSet(std::vector<float> X, std::vector<float> Y, int n_rows, int n_cols):
+    DataSet(std::move(X), std::move(Y), n_rows, n_cols, 1)
+{}
+
+DataSet::DataSet(std::vector<float> X, std::vector<float> Y, int n_rows, int n_cols, int n_targets):
 
     X_(std::move(X)),
     y_(std::move(Y)),
     n_rows_(n_rows),
-    n_cols_(n_cols)
+    n_cols_(n_cols),
+    n_targets_(n_targets)
 {
     if (n_cols_*n_rows_ != X_.size()) throw std::invalid_argument("The specified number of rows and columns does not match the number of samples.");
-    if (n_rows_ != y_.size()) throw std::invalid_argument("The size of y does not match the number of samples.");
+    if (n_targets_ <= 0) throw std::invalid_argument("The number of targets must be strictly positive.");
+    if (static_cast<size_t>(n_rows_)*n_targets_ != y_.size()) throw std::invalid_argument("The size of y does not match the number of samples.");
 
 }
 
 
+void DataSet::set_y(std::vector<float> Y){
+    if (static_cast<size_t>(n_rows_)*n_targets_ != Y.size()) throw std::invalid_argument("The size of y does not match the number of samples.");
+    y_ = std::move(Y);
+}
+
 DataSet DataSet::index_split(const std::vector<int>& index) const {
     // Returns a subsplit of the dataset object of the rows from the specified index
 
@@ -32,10 +43,12 @@ DataSet DataSet::index_split(const std::vector<int>& index) const {
 
 
     }
-        y_results.push_back(iloc_y(i));
+        for (int t = 0; t < n_targets_; t++){
+            y_results.push_back(iloc_y(i, t));
+        }
     }
 
-    DataSet output(X_results, y_results, index.size(), n_cols_);
+    DataSet output(X_results, y_results, index.size(), n_cols_, n_targets_);
     return output;
 }
 
@@ -20,15 +20,28 @@ public:
     /**
      * @brief Constructs a DataSet from features X and targets Y
      * @param X Flattened feature vector (expected size = n_rows * n_cols)
-     * @param Y Target vector of binary labels {0,1} (expected size = n_rows)
+     * @param Y Target vector (expected size = n_rows). For classification, labels
+     * are class indices {0, 1, ..., K-1}
      * @param n_rows Number of samples
      * @param n_cols Number of features per sample
      * @throws std::invalid_argument if X.size(), Y.size(), n_rows and n_cols values are incoherent 
-     * @throws std::invalid_argument if Y contains non binary labels (not in {0,1})
      * @note X uses row-major order: X[col + row * n_cols]
      */
 
     DataSet(std::vector<float> X, std::vector<float> Y, int n_rows, int n_cols);
+
+    /**
+     * @brief Constructs a DataSet from features X and a matrix of targets Y
+     * @param X Flattened feature vector (expected size = n_rows * n_cols)
+     * @param Y Flattened target matrix (expected size = n_rows * n_targets)
+     * @param n_rows Number of samples
+     * @param n_cols Number of features per sample
+     * @param n_targets Number of targets per sample (multi-output regression)
+     * @throws std::invalid_argument if X.size(), Y.size(), n_rows, n_cols and 
+     * n_targets values are incoherent 
+     * @note X and Y use row-major order: X[col + row * n_cols], Y[t + row * n_targets]
+     */
+    DataSet(std::vector<float> X, std::vector<float> Y, int n_rows, int n_cols, int n_targets);
     
     // Returns the number of samples in the DataSet
     int n_rows() const {return n_rows_;}
@@ -39,7 +52,10 @@ public:
     // Returns a 1D vector of the samples
     const std::vector<float>& X() const {return X_;}
 
-    // Returns the target values
+    // Returns the number of targets per sample
+    int n_targets() const {return n_targets_;}
+
+    // Returns the target values (row-major n_rows * n_targets)
     const std::vector<float>& y() const {return y_;}
 
     //Returns true if either the samples vector or the target vector is empty
@@ -64,10 +80,22 @@ public:
      * @brief Returns the value of a sample's class
      * @param row row index of the sample (0<= row < n_rows_)
      * @throws std::out_of_range if row out of bounds
+     * @note For multi-output DataSets, returns the first target
      */
     float iloc_y(int row) const {
         if (row < 0 || row >= n_rows_) {throw std::out_of_range("DataSet.iloc_y : index out of bound");}
-        return y_[row];
+        return y_[static_cast<size_t>(row)*n_targets_];
+    }
+
+    /**
+     * @brief Returns the value of one of a sample's targets
+     * @param row row index of the sample (0<= row < n_rows_)
+     * @param t target index (0<= t < n_targets_)
+     * @throws std::out_of_range if row or t out of bounds
+     */
+    float iloc_y(int row, int t) const {
+        if (row < 0 || row >= n_rows_ || t < 0 || t >= n_targets_) {throw std::out_of_range("DataSet.iloc_y : index out of bound");}
+        return y_[static_cast<size_t>(row)*n_targets_ + t];
     }
 
     /**
@@ -80,6 +108,15 @@ public:
      */
     DataSet index_split(const std::vector<int>& index) const;
 
+    /**
+     * @brief Replaces the targets of the DataSet, keeping the samples
+     * 
+     * @param Y Flattened target matrix (expected size = n_rows * n_targets)
+     * @throws std::invalid_argument if Y.size() does not match n_rows * n_targets
+     * @note Used by boosting to refit on new pseudo-targets without copying X
+     */
+    void set_y(std::vector<float> Y);
+
     /**
      * @brief Prints the DataSet content to standard output
      * This function prints the feature matrix X and target vector y in a readable format for debugging.
@@ -94,6 +131,7 @@ private:
     std::vector<float> y_;
     int n_rows_;
     int n_cols_;
+    int n_targets_;
 };
 
 }
\ No newline at end of file
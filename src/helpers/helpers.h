@@ -1,5 +1,7 @@
 #pragma once
 
+#include <algorithm>
+#include <cstdint>
 #include <vector>
 #include <utility>
 #include <stdexcept>
@@ -98,6 +100,71 @@ inline std::pair<int, int> count_classes(std::span<const int> idx, const std::ve
 
 }
 
+/**
+ * @brief Returns the number of classes of a classification target vector
+ * 
+ * Labels are expected to be encoded as integers {0, 1, ..., K-1}. The
+ * number of classes is the largest label + 1, and is at least 2 so
+ * that a target vector holding a single class remains a binary problem.
+ * 
+ * @param targets the target vector. All labels must be non-negative integers.
+ * @throws std::invalid_argument if a label is negative, not an integer or if targets is empty
+ * @return the number of classes K
+ */
+inline int num_classes(const std::vector<float>& targets){
+
+    if (targets.empty()) throw std::invalid_argument("arboria::helpers::num_classes -> target vector is empty");
+    float max_label = 0.f;
+    for (float y : targets) {
+        if (!(y >= 0.f) || y != std::floor(y)) throw std::invalid_argument("arboria::helpers::num_classes -> class labels must be non-negative integers {0, ..., K-1}.");
+        if (y > max_label) max_label = y;
+    }
+    return std::max(2, static_cast<int>(max_label) + 1);
+}
+
+/**
+ * @brief Returns the per-class count of labels from a span of indices
+ * 
+ * @param idx a span of row index. All index must be 0 <= i < targets.size()
+ * @param targets the target vector. All labels must be in {0, ..., n_classes-1}
+ * @param n_classes the number of classes K
+ * @throws std::out_of_range if an index is not in range [0, targets.size()) 
+ * or if a label is not in [0, n_classes)
+ * @return vector of size n_classes where counts[k] is the number of labels k
+ */
+inline std::vector<int> class_counts(std::span<const int> idx, const std::vector<float>& targets, int n_classes){
+
+    std::vector<int> counts(static_cast<size_t>(n_classes), 0);
+    int vec_size = targets.size();
+
+    for (int i : idx) {
+        if (i < 0 || i >= vec_size) throw std::out_of_range("arboria::helpers::class_counts -> one of the referenced index is out of bounds for target vector");
+        int label = static_cast<int>(targets[i]);
+        if (label < 0 || label >= n_classes) throw std::out_of_range("arboria::helpers::class_counts -> label is not in [0, n_classes)");
+        counts[label]++;
+    }
+    return counts;
+}
+
+/**
+ * @brief Returns the majority class of a count vector
+ * 
+ * @param counts per-class counts (counts[k] = number of samples of class k)
+ * @throws std::invalid_argument if counts is empty
+ * @return the index of the largest count
+ * @note In case of a tie, the highest class index is returned (for binary 
+ * problems, a tie predicts class 1)
+ */
+inline int majority_class(std::span<const int> counts){
+
+    if (counts.empty()) throw std::invalid_argument("arboria::helpers::majority_class -> counts are empty");
+    int best = 0;
+    for (size_t k = 1; k < counts.size(); k++){
+        if (counts[k] >= counts[best]) best = static_cast<int>(k);
+    }
+    return best;
+}
+
 inline float calculate_mean(std::span<const int> idx, const std::vector<float>& targets){
 
     float t_sum = 0;
@@ -114,6 +181,29 @@ inline float calculate_mean(std::span<const int> idx, const std::vector<float>&
 
 }
 
+/**
+ * @brief Returns the per-target mean of a row-major target matrix over a span of indices
+ * 
+ * @param idx a span of row index (must be non empty)
+ * @param targets the row-major target matrix of size n_rows * n_targets
+ * @param n_targets the number of targets per row
+ * @throws std::invalid_argument if idx is empty
+ * @return vector of size n_targets where means[t] is the mean of target t
+ */
+inline std::vector<float> calculate_means(std::span<const int> idx, const std::vector<float>& targets, int n_targets){
+
+    if (idx.empty()) throw std::invalid_argument("arboria::helpers::calculate_means : passed idx is empty");
+    const size_t T = static_cast<size_t>(n_targets);
+    std::vector<float> sums(T, 0.f);
+
+    for (auto i : idx){
+        const float* y = targets.data() + static_cast<size_t>(i)*T;
+        for (size_t t = 0; t < T; t++) sums[t] += y[t];
+    }
+    for (auto& v : sums) v /= static_cast<float>(idx.size());
+    return sums;
+}
+
 inline float accuracy(const std::span<const int> a, const std::span<const int> b){
 
     const size_t n = a.size();
@@ -131,6 +221,15 @@ inline uint64_t derive_seed(uint64_t seed, size_t i) {
     return seed + 0x9E3779B97F4A7C15ULL * i;
 }
 
+//Hints the CPU to load the cache line of a node read by the next pass of a traversal
+inline void prefetch(const void* address) {
+#if defined(__GNUC__) || defined(__clang__)
+    __builtin_prefetch(address, 0, 3);
+#else
+    (void)address;
+#endif
+}
+
 
 }
 }
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace arboria {
+namespace helpers {
+
+/**
+ * @brief Runs fn(i) for every i in [0, n_items) on a pool of threads
+ *
+ * Workers pull the next item from a shared atomic counter, so that items
+ * of uneven cost are balanced between threads. No more threads than items
+ * are launched, and the loop runs on the calling thread when a single
+ * worker is needed.
+ *
+ * @param n_items Number of items to process
+ * @param n_jobs Maximum number of threads to launch
+ * @param fn Callable invoked as fn(size_t item)
+ *
+ * @note If fn throws, the remaining items are abandoned and the first
+ * exception caught is rethrown on the calling thread once all workers joined.
+ */
+template <class F>
+void parallel_for(size_t n_items, size_t n_jobs, F&& fn){
+
+    if (n_items == 0) return;
+    n_jobs = std::clamp<size_t>(n_jobs, 1, n_items);
+
+    if (n_jobs == 1){
+        for (size_t i = 0; i < n_items; i++) fn(i);
+        return;
+    }
+
+    std::atomic<size_t> next{0};
+    std::atomic<bool> failed{false};
+    std::exception_ptr error;
+    std::mutex error_mutex;
+
+    auto worker = [&](){
+        for (;;){
+            if (failed.load(std::memory_order_relaxed)) break;
+            size_t i = next.fetch_add(1);
+            if (i >= n_items) break;
+            try {
+                fn(i);
+            }
+            catch (...){
+                std::lock_guard<std::mutex> lock(error_mutex);
+                if (!error) error = std::current_exception();
+                failed = true;
+            }
+        }
+    };
+
+    std::vector<std::thread> pool;
+    pool.reserve(n_jobs);
+    for (size_t j = 0; j < n_jobs; j++){
+        pool.emplace_back(worker);
+    }
+    for (auto& t : pool){
+        t.join();
+    }
+
+    if (error) std::rethrow_exception(error);
+}
+
+}
+}
@@ -2,13 +2,17 @@
 #include <random>
 #include <limits>
 #include <cmath>
+#include <stdexcept>
 
 namespace arboria {
 
 Node::Node():
     feature_index(-1),
     threshold(std::numeric_limits<float>::quiet_NaN()),
-    leaf_value(-1)
+    leaf_value(-1),
+    left_child(-1),
+    right_child(-1),
+    value_index(-1)
 {}
 
 int Node::return_feature_index() const{
@@ -25,9 +29,31 @@ bool Node::is_valid(int n_features) const{
         return false;                                     // on which the split takes place is indeed 
     if (!std::isfinite(threshold))                     // in the range of the number of features in the tree
         return false; //check that threshold was initialized
-    if (!left_child || !right_child) //check that has child, given it's not a leaf 
+    if (left_child < 0 || right_child < 0) //check that has child, given it's not a leaf 
         return false;
     return true;
 }
 
+NodeArena NodeArena::view(std::span<const Node> nodes, std::span<const float> values, std::shared_ptr<const void> storage){
+    if (!storage) throw std::invalid_argument("arboria::NodeArena::view -> no storage passed for the viewed nodes");
+    NodeArena arena;
+    arena.view_nodes_ = nodes;
+    arena.view_values_ = values;
+    arena.storage_ = std::move(storage);
+    return arena;
+}
+
+int NodeArena::emplace(){
+    if (storage_) throw std::logic_error("arboria::NodeArena::emplace -> arena is a read-only view");
+    nodes_.emplace_back();
+    return static_cast<int>(nodes_.size()) - 1;
+}
+
+int NodeArena::emplace_values(std::span<const float> values){
+    if (storage_) throw std::logic_error("arboria::NodeArena::emplace_values -> arena is a read-only view");
+    int offset = static_cast<int>(values_.size());
+    values_.insert(values_.end(), values.begin(), values.end());
+    return offset;
+}
+
 }
@@ -1,7 +1,8 @@
 #ifndef NODE_H
 #define NODE_H
+#include <cstddef>
 #include <memory>
-#include <variant>
+#include <span>
 #include <vector>
 
 namespace arboria{
@@ -15,7 +16,10 @@ public:
      * feature_index : the column index on which the split is made (default value -1)
      * threshold : the threshold that splits the targeted feature (default value NaN)
      * predicted_class : the majority class received by the node (default value -1)
-     * left_child and right_child : pointers to the next nodes
+     * left_child and right_child : indices of the next nodes in the NodeArena
+     * of the tree (default value -1)
+     * value_index : offset of the leaf distribution in the values of the 
+     * NodeArena (default value -1 : the leaf only carries leaf_value)
      */
     Node();
     int feature_index;
@@ -28,8 +32,96 @@ public:
     float return_threshold() const;
     bool is_valid(int n_features) const;
 
-    std::unique_ptr<Node> left_child;
-    std::unique_ptr<Node> right_child;
+    int left_child;
+    int right_child;
+    int value_index;
 };
+
+/**
+ * @brief Contiguous storage for the nodes of a tree
+ *
+ * Nodes are appended to a single buffer and refer to their children
+ * by index, so that building a tree does not allocate per node and
+ * destroying it releases every node in one shot.
+ *
+ * @note References returned by operator[] are invalidated by emplace() ;
+ * keep indices across insertions.
+ * @note An arena created with view() reads its nodes and values from memory
+ * it does not own (e.g. a mapped model file) : it is read-only until clear().
+ */
+class NodeArena
+{
+public:
+    /**
+     * @brief Creates a read-only arena over nodes and values stored elsewhere
+     * 
+     * @param nodes Nodes of the tree ; index 0 is the root
+     * @param values Leaf values referred to by Node::value_index
+     * @param storage Owner of the viewed memory, kept alive by the arena and its copies
+     */
+    static NodeArena view(std::span<const Node> nodes, std::span<const float> values, std::shared_ptr<const void> storage);
+
+    /**
+     * @brief Appends a default Node to the arena
+     * 
+     * @return the index of the created node
+     */
+    int emplace();
+
+    //Mutable access is reserved to owning arenas
+    Node& operator[](int i) {return nodes_[static_cast<size_t>(i)];}
+    const Node& operator[](int i) const {return nodes()[static_cast<size_t>(i)];}
+
+    //Returns the number of nodes stored in the arena
+    size_t size() const {return nodes().size();}
+    bool empty() const {return nodes().empty();}
+
+    //Pre-allocates room for n nodes
+    void reserve(size_t n) {nodes_.reserve(n);}
+    //Releases every node and value of the arena ; a view becomes an empty owning arena
+    void clear() {nodes_.clear(); values_.clear(); view_nodes_ = {}; view_values_ = {}; storage_.reset();}
+
+    //Returns whether the nodes are read from external storage (see view())
+    bool is_view() const {return storage_ != nullptr;}
+
+    //Returns a read-only view over the nodes ; index 0 is the root
+    std::span<const Node> nodes() const {return storage_ ? view_nodes_ : std::span<const Node>(nodes_);}
+
+    //Returns a read-only view over every block of leaf values
+    std::span<const float> all_values() const {return storage_ ? view_values_ : std::span<const float>(values_);}
+
+    /**
+     * @brief Appends a block of leaf values (e.g. a class distribution)
+     * 
+     * @param values the values to be stored
+     * @return the offset of the block, to be saved in Node::value_index
+     */
+    int emplace_values(std::span<const float> values);
+
+    /**
+     * @brief Returns a read-only view over a block of leaf values
+     * 
+     * @param offset the offset returned by emplace_values()
+     * @param dim the number of values in the block
+     */
+    std::span<const float> values(int offset, size_t dim) const {
+        return all_values().subspan(static_cast<size_t>(offset), dim);
+    }
+
+    //Mutable view over a block of leaf values, used to re-estimate leaves in place
+    std::span<float> values(int offset, size_t dim) {
+        return std::span<float>(values_).subspan(static_cast<size_t>(offset), dim);
+    }
+
+private:
+    std::vector<Node> nodes_;
+    //Leaf payloads of every node, stored back to back
+    std::vector<float> values_;
+    //Nodes and values of a view, owned by storage_
+    std::span<const Node> view_nodes_;
+    std::span<const float> view_values_;
+    std::shared_ptr<const void> storage_;
+};
+
 }
-#endif // NODE_H
\ No newline at end of file
+#endif // NODE_H
@@ -0,0 +1,206 @@
+/*
+
+                    Binary model format implementation
+
+*/
+
+#include "serialization.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstdio>
+#include <fstream>
+#include <variant>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define ARBORIA_HAS_MMAP 1
+#endif
+
+namespace arboria {
+namespace serialization {
+
+namespace {
+
+constexpr char MAGIC[8] = {'A', 'R', 'B', 'O', 'R', 'I', 'A', '\0'};
+//Read back as another value when the file was written with another byte order
+constexpr std::uint32_t BYTE_ORDER_MARK = 0x01020304;
+//Arrays start on multiples of ALIGNMENT from the start of the buffer
+constexpr size_t ALIGNMENT = 8;
+
+constexpr std::uint32_t REGRESSION_TAG = 1;
+constexpr std::uint32_t CLASSIFICATION_TAG = 2;
+
+static_assert(std::is_trivially_copyable_v<Node>, "Node must be trivially copyable to be mapped from a file");
+static_assert(std::is_standard_layout_v<Node>, "Node must have a standard layout to be mapped from a file");
+static_assert(alignof(Node) <= ALIGNMENT && alignof(float) <= ALIGNMENT && alignof(double) <= ALIGNMENT);
+
+}
+
+void Writer::append_(const void* data, size_t size){
+    const std::byte* first = static_cast<const std::byte*>(data);
+    bytes_.insert(bytes_.end(), first, first + size);
+}
+
+void Writer::pad_(){
+    bytes_.resize((bytes_.size() + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT, std::byte{0});
+}
+
+void Writer::put_nodes(std::span<const Node> nodes){
+    put<std::uint64_t>(nodes.size());
+    pad_();
+    const size_t first = bytes_.size();
+    append_(nodes.data(), nodes.size_bytes());
+
+    //the bytes between is_leaf and left_child are padding : they are zeroed so
+    //that a model is always written to the same bytes
+    constexpr size_t pad_begin = offsetof(Node, is_leaf) + sizeof(bool);
+    constexpr size_t pad_end = offsetof(Node, left_child);
+    for (size_t i = 0; i < nodes.size(); i++){
+        std::byte* node = bytes_.data() + first + i * sizeof(Node);
+        std::fill(node + pad_begin, node + pad_end, std::byte{0});
+    }
+}
+
+void Writer::put_type(const TreeType& type){
+    if (std::holds_alternative<Regression>(type)) put<std::uint32_t>(REGRESSION_TAG);
+    else if (std::holds_alternative<Classification>(type)) put<std::uint32_t>(CLASSIFICATION_TAG);
+    else throw std::invalid_argument("arboria::serialization::Writer -> undefined TreeType can't be written");
+}
+
+const std::byte* Reader::take_(size_t size){
+    if (size > buffer_.bytes.size() - pos_) throw std::invalid_argument("arboria::serialization::Reader -> truncated model buffer");
+    const std::byte* data = buffer_.bytes.data() + pos_;
+    pos_ += size;
+    return data;
+}
+
+void Reader::skip_padding_(){
+    const size_t aligned = (pos_ + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+    take_(aligned - pos_);
+}
+
+TreeType Reader::get_type(){
+    const std::uint32_t tag = get<std::uint32_t>();
+    if (tag == REGRESSION_TAG) return Regression{};
+    if (tag == CLASSIFICATION_TAG) return Classification{};
+    throw std::invalid_argument("arboria::serialization::Reader -> invalid TreeType in model buffer");
+}
+
+void write_header(Writer& out, ModelKind kind){
+    for (char c : MAGIC) out.put<char>(c);
+    out.put<std::uint32_t>(FORMAT_VERSION);
+    out.put<std::uint32_t>(BYTE_ORDER_MARK);
+    out.put<std::uint32_t>(static_cast<std::uint32_t>(kind));
+    out.put<std::uint32_t>(static_cast<std::uint32_t>(sizeof(Node)));
+}
+
+void read_header(Reader& in, ModelKind kind){
+    for (char c : MAGIC){
+        if (in.get<char>() != c) throw std::invalid_argument("arboria::serialization::read_header -> buffer is not an arboria model");
+    }
+    const std::uint32_t version = in.get<std::uint32_t>();
+    if (version != FORMAT_VERSION) {
+        throw std::invalid_argument("arboria::serialization::read_header -> unsupported format version " + std::to_string(version) +
+                                    " (expected " + std::to_string(FORMAT_VERSION) + ")");
+    }
+    if (in.get<std::uint32_t>() != BYTE_ORDER_MARK) throw std::invalid_argument("arboria::serialization::read_header -> model was written with another byte order");
+    if (in.get<std::uint32_t>() != static_cast<std::uint32_t>(kind)) throw std::invalid_argument("arboria::serialization::read_header -> buffer holds another kind of model");
+    if (in.get<std::uint32_t>() != sizeof(Node)) throw std::invalid_argument("arboria::serialization::read_header -> model was written with another Node layout");
+}
+
+void write_file(const std::string& path, std::span<const std::byte> bytes){
+    //the model is written next to its destination then renamed : processes
+    //mapping the previous file keep reading it, never a truncated one
+#ifdef ARBORIA_HAS_MMAP
+    //the sibling is unique, so that concurrent saves to one path don't share it
+    std::string tmp = path + ".XXXXXX";
+    const int fd = ::mkstemp(tmp.data());
+    if (fd < 0) throw std::runtime_error("arboria::serialization::write_file -> can't create a file next to " + path);
+    //mkstemp creates the file readable by its owner only
+    bool written = ::fchmod(fd, 0644) == 0;
+    for (size_t offset = 0; written && offset < bytes.size();){
+        const ssize_t n = ::write(fd, bytes.data() + offset, bytes.size() - offset);
+        if (n < 0 && errno == EINTR) continue;
+        written = n > 0;
+        if (written) offset += static_cast<size_t>(n);
+    }
+    written = (::close(fd) == 0) && written;
+    if (!written) {
+        std::remove(tmp.c_str());
+        throw std::runtime_error("arboria::serialization::write_file -> can't write " + tmp);
+    }
+#else
+    const std::string tmp = path + ".tmp";
+    {
+        std::ofstream file(tmp, std::ios::binary | std::ios::trunc);
+        if (!file) throw std::runtime_error("arboria::serialization::write_file -> can't open " + tmp);
+        file.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+        file.close();
+        if (!file) {
+            std::remove(tmp.c_str());
+            throw std::runtime_error("arboria::serialization::write_file -> can't write " + tmp);
+        }
+    }
+#endif
+    if (std::rename(tmp.c_str(), path.c_str()) != 0) {
+        std::remove(tmp.c_str());
+        throw std::runtime_error("arboria::serialization::write_file -> can't replace " + path);
+    }
+}
+
+Buffer map_file(const std::string& path){
+#ifdef ARBORIA_HAS_MMAP
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) throw std::runtime_error("arboria::serialization::map_file -> can't open " + path);
+    struct stat st;
+    if (::fstat(fd, &st) != 0) {
+        ::close(fd);
+        throw std::runtime_error("arboria::serialization::map_file -> can't stat " + path);
+    }
+    const size_t size = static_cast<size_t>(st.st_size);
+    if (size == 0) {
+        ::close(fd);
+        throw std::runtime_error("arboria::serialization::map_file -> " + path + " is empty");
+    }
+    //a read-only mapping, private or shared, reads the pages of the page cache :
+    //every process mapping the file shares them
+    void* data = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    //the mapping stays valid once the descriptor is closed
+    ::close(fd);
+    if (data == MAP_FAILED) throw std::runtime_error("arboria::serialization::map_file -> can't map " + path);
+
+    std::shared_ptr<const void> storage(data, [size](const void* p){::munmap(const_cast<void*>(p), size);});
+    return Buffer{std::span<const std::byte>(static_cast<const std::byte*>(data), size), std::move(storage)};
+#else
+    return read_file(path);
+#endif
+}
+
+Buffer read_file(const std::string& path){
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file) throw std::runtime_error("arboria::serialization::read_file -> can't open " + path);
+    const size_t size = static_cast<size_t>(file.tellg());
+    file.seekg(0);
+
+    //8-byte words keep the arrays of the model aligned
+    auto words = std::make_shared<std::vector<std::uint64_t>>((size + ALIGNMENT - 1) / ALIGNMENT);
+    file.read(reinterpret_cast<char*>(words->data()), static_cast<std::streamsize>(size));
+    if (!file) throw std::runtime_error("arboria::serialization::read_file -> can't read " + path);
+    const std::byte* data = reinterpret_cast<const std::byte*>(words->data());
+    return Buffer{std::span<const std::byte>(data, size), std::move(words)};
+}
+
+Buffer copy_bytes(std::span<const std::byte> bytes){
+    auto words = std::make_shared<std::vector<std::uint64_t>>((bytes.size() + ALIGNMENT - 1) / ALIGNMENT);
+    std::byte* data = reinterpret_cast<std::byte*>(words->data());
+    std::copy(bytes.begin(), bytes.end(), data);
+    return Buffer{std::span<const std::byte>(data, bytes.size()), std::move(words)};
+}
+
+}
+}
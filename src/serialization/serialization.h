@@ -0,0 +1,202 @@
+/*
+
+                    Binary model format header
+
+*/
+#pragma once
+
+#include "node/node.h"
+#include "split_strategy/types/split_param.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace arboria {
+namespace serialization {
+
+/*
+    Layout of a model file :
+
+    header   : magic "ARBORIA\0", format version, byte order mark, model kind, sizeof(Node)
+    sections : scalars in native byte order ; arrays as a uint64 length followed by
+               their elements, starting on an 8-byte boundary
+
+    Arrays of nodes and leaf values are stored exactly as they are laid out in
+    memory, so that a mapped file is used in place : loading a model only reads
+    the header and the scalars of each tree.
+*/
+
+//Version of the binary model format, bumped on every layout change
+constexpr std::uint32_t FORMAT_VERSION = 2;
+
+//Model stored in a file
+enum class ModelKind : std::uint32_t {
+    DecisionTree = 1,
+    RandomForest = 2
+};
+
+/**
+ * @brief Read-only bytes of a model, with the storage they live in
+ *
+ * @param bytes View over the content of the model
+ * @param storage Owner of the memory viewed by bytes (a mapped file or a heap buffer) ;
+ * models viewing the buffer in place share it
+ */
+struct Buffer {
+    std::span<const std::byte> bytes;
+    std::shared_ptr<const void> storage;
+};
+
+/**
+ * @brief Appends the sections of a model file to a byte buffer
+ */
+class Writer {
+
+    public:
+    //Appends a scalar ; bool is stored on one byte
+    template <class T>
+    void put(const T& value){
+        static_assert(std::is_arithmetic_v<T> || std::is_enum_v<T>, "serialization::Writer::put : scalar expected");
+        if constexpr (std::is_same_v<T, bool>) put<std::uint8_t>(value ? 1 : 0);
+        else append_(&value, sizeof(T));
+    }
+
+    //Appends a presence flag followed by the value, if any
+    template <class T>
+    void put(const std::optional<T>& value){
+        put<bool>(value.has_value());
+        if (value) put<T>(*value);
+    }
+
+    //Appends the length of the array then its elements, on an 8-byte boundary
+    template <class T>
+    void put_array(std::span<const T> values){
+        static_assert(std::is_arithmetic_v<T> && !std::is_same_v<T, bool>, "serialization::Writer::put_array : arithmetic elements expected");
+        put<std::uint64_t>(values.size());
+        pad_();
+        append_(values.data(), values.size_bytes());
+    }
+
+    //Appends an array of nodes ; the padding bytes of each node are zeroed
+    void put_nodes(std::span<const Node> nodes);
+
+    //Appends the tag of a Regression or Classification type
+    void put_type(const TreeType& type);
+
+    //Returns the buffer written so far
+    std::vector<std::byte> release() {return std::move(bytes_);}
+
+    private:
+    std::vector<std::byte> bytes_;
+
+    void append_(const void* data, size_t size);
+    void pad_();
+};
+
+/**
+ * @brief Reads the sections of a model file, in the order they were written
+ *
+ * @throws std::invalid_argument on every read past the end of the buffer
+ * or on a misaligned array
+ */
+class Reader {
+
+    public:
+    explicit Reader(Buffer buffer) : buffer_(std::move(buffer)) {}
+
+    template <class T>
+    T get(){
+        static_assert(std::is_arithmetic_v<T> || std::is_enum_v<T>, "serialization::Reader::get : scalar expected");
+        if constexpr (std::is_same_v<T, bool>) return get<std::uint8_t>() != 0;
+        else {
+            T value;
+            std::memcpy(&value, take_(sizeof(T)), sizeof(T));
+            return value;
+        }
+    }
+
+    template <class T>
+    std::optional<T> get_optional(){
+        if (!get<bool>()) return std::nullopt;
+        return get<T>();
+    }
+
+    //Returns a view over an array of the buffer, without copy
+    template <class T>
+    std::span<const T> get_array(){
+        static_assert(std::is_trivially_copyable_v<T>, "serialization::Reader::get_array : trivially copyable elements expected");
+        const std::uint64_t n = get<std::uint64_t>();
+        skip_padding_();
+        if (n > (buffer_.bytes.size() - pos_) / sizeof(T)) throw std::invalid_argument("arboria::serialization::Reader -> truncated model buffer");
+        const std::byte* data = take_(static_cast<size_t>(n) * sizeof(T));
+        if (reinterpret_cast<std::uintptr_t>(data) % alignof(T) != 0) throw std::invalid_argument("arboria::serialization::Reader -> misaligned model buffer");
+        return std::span<const T>(reinterpret_cast<const T*>(data), static_cast<size_t>(n));
+    }
+
+    //Reads the tag written by Writer::put_type
+    TreeType get_type();
+
+    //Storage of the buffer, to be shared by the models viewing it
+    const std::shared_ptr<const void>& storage() const {return buffer_.storage;}
+
+    private:
+    Buffer buffer_;
+    size_t pos_ = 0;
+
+    const std::byte* take_(size_t size);
+    void skip_padding_();
+};
+
+//Writes the header of a model file
+void write_header(Writer& out, ModelKind kind);
+
+/**
+ * @brief Reads and checks the header of a model file
+ *
+ * @throws std::invalid_argument if the buffer is not a model file, if it was written
+ * with another format version, byte order or Node layout, or holds another kind of model
+ */
+void read_header(Reader& in, ModelKind kind);
+
+/**
+ * @brief Writes a buffer to a file
+ *
+ * The buffer is written to path + ".tmp", then renamed : an existing file is 
+ * replaced atomically, and processes mapping it keep their pages.
+ *
+ * @throws std::runtime_error if the file can't be written
+ */
+void write_file(const std::string& path, std::span<const std::byte> bytes);
+
+/**
+ * @brief Maps a file read-only
+ *
+ * Pages are loaded on first access, so that the cost of opening a model
+ * does not depend on its size. The mapping is shared : processes mapping the
+ * same file (e.g. from /dev/shm) read one physical copy from the page cache.
+ * The mapping is released with the last owner of the storage.
+ *
+ * @throws std::runtime_error if the file can't be opened or mapped
+ */
+Buffer map_file(const std::string& path);
+
+/**
+ * @brief Reads a file into memory
+ *
+ * @throws std::runtime_error if the file can't be read
+ */
+Buffer read_file(const std::string& path);
+
+//Copies bytes into an owned buffer aligned for every array of the format
+Buffer copy_bytes(std::span<const std::byte> bytes);
+
+}
+}
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <vector>
+#include <span>
 #include <cmath>
 #include <utility>
 #include <stdexcept>
@@ -156,5 +157,60 @@ inline float weighted_entropy(int l_pos, int l_neg, int r_pos, int r_neg){
 }
 
 
+/**
+ * @brief Computes the Shannon entropy from a vector of per-class counts
+ * 
+ * @param counts per-class counts (counts[k] = number of samples of class k)
+ * @throws std::invalid_argument if a count is negative or if the counts sum to zero
+ * @return Entropy 
+ */
+inline float entropy_counts(std::span<const int> counts){
+
+    int total = 0;
+    for (int c : counts) {
+        if (c < 0) throw std::invalid_argument("arboria::split::entropy_counts -> Counts must be non-negative");
+        total += c;
+    }
+    if (total == 0) throw std::invalid_argument("arboria::split::entropy_counts -> Empty node");
+
+    const float n = static_cast<float>(total);
+    float H = 0.f;
+    for (int c : counts) {
+        if (c > 0) {
+            const float p = static_cast<float>(c) / n;
+            H -= p * std::log2(p);
+        }
+    }
+    return H;
+}
+
+/**
+ * @brief Returns the weighted entropy from the per-class counts of the left and right node
+ * 
+ * @param l_counts per-class counts of the left child
+ * @param r_counts per-class counts of the right child
+ * @throws std::invalid_argument if the total number of samples is zero, if a count 
+ * is negative or if both vectors have a different number of classes
+ * @return Weighted entropy
+ */
+inline float weighted_entropy_counts(std::span<const int> l_counts, std::span<const int> r_counts){
+
+    if (l_counts.size() != r_counts.size()) throw std::invalid_argument("arboria::split::weighted_entropy_counts -> left and right counts have different number of classes");
+
+    int l_size = 0;
+    int r_size = 0;
+    for (size_t k = 0; k < l_counts.size(); k++){
+        l_size += l_counts[k];
+        r_size += r_counts[k];
+    }
+    const float total_num_samples = static_cast<float>(l_size + r_size);
+    if (total_num_samples == 0.f) throw std::invalid_argument("arboria::split::weighted_entropy_counts -> no values were passed");
+
+    const float left_entropy = (l_size > 0) ? entropy_counts(l_counts) : 0.f;
+    const float right_entropy = (r_size > 0) ? entropy_counts(r_counts) : 0.f;
+
+    return (static_cast<float>(l_size)/total_num_samples) * left_entropy + (static_cast<float>(r_size)/total_num_samples) * right_entropy;
+}
+
 }
 }
\ No newline at end of file
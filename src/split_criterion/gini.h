@@ -1,6 +1,7 @@
 #pragma once
 
 #include <vector>
+#include <span>
 #include <cmath>
 #include <utility>
 #include <stdexcept>
@@ -127,6 +128,66 @@ inline float weighted_gini(int l_pos, int l_neg, int r_pos, int r_neg){
 
 }
 
+/**
+ * @brief Computes Gini impurity from a vector of per-class counts
+ *
+ * The K-way Gini impurity is defined as:
+ *   G = 1 - sum_k (n_k / n)²
+ * 
+ * @param counts per-class counts (counts[k] = number of samples of class k)
+ * @throws std::invalid_argument if a count is negative or if the counts sum to zero
+ * @return Gini impurity 
+ */
+inline float gini_counts(std::span<const int> counts){
+
+    int total = 0;
+    float sum_sq = 0.f;
+    for (int c : counts) {
+        if (c < 0) throw std::invalid_argument("arboria::split::gini_counts -> number of samples must be non-negative");
+        total += c;
+        sum_sq += static_cast<float>(c) * static_cast<float>(c);
+    }
+    if (total == 0) throw std::invalid_argument("arboria::split::gini_counts -> no values were passed");
+    const float n = static_cast<float>(total);
+    return 1.f - sum_sq / (n * n);
+}
+
+/**
+ * @brief Returns the weighted Gini impurity from the per-class counts of the left and right node
+ * 
+ * @param l_counts per-class counts of the left child
+ * @param r_counts per-class counts of the right child
+ * @throws std::invalid_argument if the total number of samples is zero, if a count
+ * is negative or if both vectors have a different number of classes
+ * @return Weighted Gini Impurity
+ */
+inline float weighted_gini_counts(std::span<const int> l_counts, std::span<const int> r_counts){
+
+    if (l_counts.size() != r_counts.size()) throw std::invalid_argument("arboria::split::weighted_gini_counts -> left and right counts have different number of classes");
+
+    // n_child * gini(child) = n_child - sum_k n_k² / n_child
+    int l_size = 0;
+    int r_size = 0;
+    float l_sq = 0.f;
+    float r_sq = 0.f;
+    for (size_t k = 0; k < l_counts.size(); k++){
+        const int l = l_counts[k];
+        const int r = r_counts[k];
+        if (l < 0 || r < 0) throw std::invalid_argument("arboria::split::weighted_gini_counts -> values must be non-negative");
+        l_size += l;
+        r_size += r;
+        l_sq += static_cast<float>(l) * static_cast<float>(l);
+        r_sq += static_cast<float>(r) * static_cast<float>(r);
+    }
+    const float total_num_samples = static_cast<float>(l_size + r_size);
+    if (total_num_samples == 0.f) throw std::invalid_argument("arboria::split::weighted_gini_counts -> no values were passed");
+
+    const float left = (l_size > 0) ? static_cast<float>(l_size) - l_sq / static_cast<float>(l_size) : 0.f;
+    const float right = (r_size > 0) ? static_cast<float>(r_size) - r_sq / static_cast<float>(r_size) : 0.f;
+
+    return (left + right) / total_num_samples;
+}
+
 }
 
 }
\ No newline at end of file
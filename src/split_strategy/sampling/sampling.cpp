@@ -6,6 +6,7 @@
 #include "sampling.h"
 #include <algorithm>
 #include <stdexcept>
+#include <unordered_map>
 #include <unordered_set>
 #include <numeric>
 #include <stdexcept>
@@ -42,6 +43,27 @@ std::vector<size_t> subsample(size_t s_size, size_t n_samples, std::mt19937& rng
     if (s_size == 0) throw std::invalid_argument("arboria::sampling::subsampling : number of samples must be superior to zero");
     if (n_samples == 0 || n_samples > s_size) throw std::invalid_argument("arboria::sampling::subsampling : number of drawn samples must be strictly positive and less than or equal to number of samples");
 
+    //small samples of large sets : the swapped positions are tracked in a map
+    //instead of materialising [0, s_size). The draws and swaps are the same,
+    //so the result is identical to the dense version.
+    if (n_samples * 8 < s_size){
+        std::unordered_map<size_t, size_t> swapped;
+        swapped.reserve(2 * n_samples);
+        auto at = [&](size_t i){
+            auto it = swapped.find(i);
+            return (it == swapped.end()) ? i : it->second;
+        };
+        std::vector<size_t> out(n_samples);
+        for (size_t i = 0; i < n_samples; i++){
+            std::uniform_int_distribution<size_t> dist(i, s_size-1);
+            size_t j = dist(rng);
+            const size_t vi = at(i);
+            out[i] = at(j);
+            swapped[j] = vi;
+        }
+        return out;
+    }
+
     std::vector<size_t> vec(s_size);
     std::iota(vec.begin(), vec.end(),0);
 
@@ -12,6 +12,8 @@
 #include "split_strategy/types/split_param.h"
 #include "split_strategy/types/split_stats.h"
 
+#include <algorithm>
+#include <cmath>
 #include <numeric>
 #include <random>
 #include <stdexcept>
@@ -67,6 +69,23 @@ SplitResult Splitter::best_split_classification(std::span<const int> idx, const
         return best_split;} //returning best_split here will return a SplitResult with 
                             // default attributes
 
+// ------------------------------------ class counts of the node -----------------
+
+    // labels are class indices {0, ..., K-1} ; K is local to the node
+    std::vector<int> labels(idx.size());
+    int n_classes = 2;
+    for (size_t r = 0; r < idx.size(); r++) {
+        float y = data.iloc_y(idx[r]);
+        if (!(y >= 0.f) || y != std::floor(y)) {throw std::invalid_argument("aboria::split_strategy::Splitter::best_split : class labels must be non-negative integers.");}
+        labels[r] = static_cast<int>(y);
+        n_classes = std::max(n_classes, labels[r] + 1);
+    }
+    std::vector<int> node_counts(static_cast<size_t>(n_classes), 0);
+    for (int label : labels) node_counts[label]++;
+
+    std::vector<int> l_counts(static_cast<size_t>(n_classes));
+    std::vector<int> r_counts(static_cast<size_t>(n_classes));
+
 // ------------------------------------ feature selection -----------------
 
 // -> filling col_vector with col index
@@ -142,18 +161,10 @@ SplitResult Splitter::best_split_classification(std::span<const int> idx, const
 
 
         //--------------------------------
-        int l_neg_count = 0;
-        int l_pos_count = 0;
-        int r_neg_count = 0; 
-        int r_pos_count = 0;
-
-        for (int i : idx) {
-            int y = data.iloc_y(i);
-            if (y == 1) r_pos_count++;
-            else        r_neg_count++;
-        }
-
-
+        std::fill(l_counts.begin(), l_counts.end(), 0);
+        std::copy(node_counts.begin(), node_counts.end(), r_counts.begin());
+        int l_size = 0;
+        int r_size = num_rows;
 
             size_t p = 0;
 
@@ -164,18 +175,20 @@ SplitResult Splitter::best_split_classification(std::span<const int> idx, const
                     float x = data.iloc_x(i, col);
                     if (!(x < t)) break; 
 
-                    int y = data.iloc_y(i);
-                    if (y == 1) { l_pos_count++; r_pos_count--; }
-                    else        { l_neg_count++; r_neg_count--; }
+                    int y = static_cast<int>(data.iloc_y(i));
+                    l_counts[y]++;
+                    r_counts[y]--;
+                    l_size++;
+                    r_size--;
 
                     ++p;
                 }
             
 
-            if ((l_pos_count + l_neg_count) == 0 || (r_pos_count + r_neg_count) == 0) {continue;} //ignoring if we have an empty leaf
+            if (l_size == 0 || r_size == 0) {continue;} //ignoring if we have an empty leaf
                 
             //--------------------------------
-            ClfStats split_stats { .l_pos = l_pos_count, .l_neg = l_neg_count, .r_pos = r_pos_count, .r_neg = r_neg_count};            
+            ClfStats split_stats { .l_counts = l_counts, .r_counts = r_counts};            
             float score = score_function(params, split_stats);
 
 
@@ -217,6 +230,13 @@ SplitResult Splitter::best_split_regression(std::span<const int> idx, const Data
         return best_split;} //returning best_split here will return a SplitResult with 
                             // default attributes
 
+    const std::vector<float>& targets = data.y();
+    const size_t n_targets = static_cast<size_t>(data.n_targets());
+    std::vector<float> y_ssL(n_targets);
+    std::vector<float> y_ssR(n_targets);
+    std::vector<float> y_sL(n_targets);
+    std::vector<float> y_sR(n_targets);
+
 // ------------------------------------ feature selection -----------------
 
 // -> filling col_vector with col index
@@ -293,19 +313,23 @@ SplitResult Splitter::best_split_regression(std::span<const int> idx, const Data
 
         //--------------------------------
 
+        // one running sum per target : the score of a split is the
+        // SSE summed over every output
         int nL = 0;
         int nR = 0;
-        float y_ssL = 0;
-        float y_ssR = 0;
-        float y_sL = 0;
-        float y_sR = 0;
+        std::fill(y_ssL.begin(), y_ssL.end(), 0.f);
+        std::fill(y_ssR.begin(), y_ssR.end(), 0.f);
+        std::fill(y_sL.begin(), y_sL.end(), 0.f);
+        std::fill(y_sR.begin(), y_sR.end(), 0.f);
 
         for (auto i : idx) {
 
-            float y = data.iloc_y(i);
+            const float* y = targets.data() + static_cast<size_t>(i)*n_targets;
             nR++;
-            y_sR += y;
-            y_ssR += y*y;
+            for (size_t k = 0; k < n_targets; k++){
+                y_sR[k] += y[k];
+                y_ssR[k] += y[k]*y[k];
+            }
         }
 
 
@@ -317,13 +341,15 @@ SplitResult Splitter::best_split_regression(std::span<const int> idx, const Data
                 int i = sorted_idx[p];
                 float x = data.iloc_x(i, col);
                 if (!(x < t)) break; 
-                float y = data.iloc_y(i);
+                const float* y = targets.data() + static_cast<size_t>(i)*n_targets;
                 nL++;
                 nR--;
-                y_sR -= y;
-                y_sL += y;
-                y_ssR -= y*y;
-                y_ssL += y*y;
+                for (size_t k = 0; k < n_targets; k++){
+                    y_sR[k] -= y[k];
+                    y_sL[k] += y[k];
+                    y_ssR[k] -= y[k]*y[k];
+                    y_ssL[k] += y[k]*y[k];
+                }
 
                 ++p;
 
@@ -332,8 +358,11 @@ SplitResult Splitter::best_split_regression(std::span<const int> idx, const Data
                 if (nL == 0 || nR == 0) continue; //ignore if we have an empty leaf
             
          //--------------------------------
-            RegStats split_stats{nL, nR, y_ssL, y_ssR, y_sL, y_sR};
-            float score = score_function(params, split_stats);
+            float score = 0.f;
+            for (size_t k = 0; k < n_targets; k++){
+                RegStats split_stats{nL, nR, y_ssL[k], y_ssR[k], y_sL[k], y_sR[k]};
+                score += score_function(params, split_stats);
+            }
 
 
             if (score < best_score){ 
@@ -367,10 +396,10 @@ float Splitter::score_function(const SplitParam& params, const ClfStats& stats)
         using T = std::decay_t<decltype(crit_function)>;
 
         if constexpr ((std::is_same_v<T, Gini>)) {
-            return split::weighted_gini(stats.l_pos, stats.l_neg, stats.r_pos, stats.r_neg);}
+            return split::weighted_gini_counts(stats.l_counts, stats.r_counts);}
          
         else if constexpr (std::is_same_v<T, Entropy>) {
-            return split::weighted_entropy(stats.l_pos, stats.l_neg, stats.r_pos, stats.r_neg);}
+            return split::weighted_entropy_counts(stats.l_counts, stats.r_counts);}
     
         
         else if constexpr ((std::is_same_v<T, Undefined>)) {
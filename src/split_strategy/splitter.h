@@ -97,6 +97,8 @@ class Splitter
          * On a SplitResult, one can test if a split has been found with SplitResult.has_split()
          * Splits are calculated with the following logic : if sample feature < candidate threshold -> left node
          * if sample feature >= candidate threshold -> right node
+         * @note For DataSets with several targets, the score of a split is the sum 
+         * of the loss over every target
          * @return a SplitResult struct 
          */
         SplitResult best_split_regression(std::span<const int> idx, const DataSet& data, const SplitParam& params, SplitContext& context);
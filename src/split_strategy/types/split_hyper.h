@@ -16,6 +16,18 @@
  * @param max_samples Optional percentage of total samples to be bootstrapped in RF 
  * @param min_sample_split Optional minimum number of samples allowed in a leaf
  * @param n_jobs Optional number of threads to launch
+ * @param oob_score Optional flag to compute out-of-bag predictions during RF fit
+ * @param early_stopping_tol Optional minimum OOB score improvement between two 
+ * batches of trees for the RF fit to continue
+ * @param early_stopping_batch Optional number of trees fitted between two OOB checks
+ * @param quantiles Optional flag to store the training targets of each RF leaf,
+ * for quantile regression
+ * @param max_leaf_samples Optional maximum number of weighted values kept per leaf
+ * when storing targets for quantile regression
+ * @param honest_fraction Optional fraction of the rows used to learn the structure
+ * of honest trees ; leaf values are re-estimated on the remaining rows. A leaf 
+ * reached by none of them takes the estimate of its nearest ancestor reached by
+ * some, which happens more often with a small min_sample_split or a high fraction
  * 
  */
 struct HyperParam{
@@ -26,5 +38,11 @@ struct HyperParam{
     std::optional<float> max_samples=std::nullopt;
     std::optional<float> min_sample_split=std::nullopt;
     std::optional<int> n_jobs = std::nullopt;
+    std::optional<bool> oob_score = std::nullopt;
+    std::optional<float> early_stopping_tol = std::nullopt;
+    std::optional<int> early_stopping_batch = std::nullopt;
+    std::optional<bool> quantiles = std::nullopt;
+    std::optional<int> max_leaf_samples = std::nullopt;
+    std::optional<float> honest_fraction = std::nullopt;
     
 };
\ No newline at end of file
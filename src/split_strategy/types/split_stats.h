@@ -1,20 +1,21 @@
 #pragma once
 
+#include <span>
+
 /**
  * @brief struct controlling the passed arguments 
  * to the scoring function for classification
  *
- *  - l_pos, l_neg -> the positive and negative labels going to the left node 
- *  - r_pos, r_neg -> the positive and negative labels going to the right node 
+ *  - l_counts -> per-class count of the labels going to the left node 
+ *  - r_counts -> per-class count of the labels going to the right node 
  *
+ * @note Both views have one entry per class and must outlive the struct
  */
 struct ClfStats {
 
 public:
-    int l_pos = 0;
-    int l_neg = 0;
-    int r_pos = 0;
-    int r_neg = 0;
+    std::span<const int> l_counts;
+    std::span<const int> r_counts;
 
 };
 
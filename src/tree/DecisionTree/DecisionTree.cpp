@@ -1,6 +1,7 @@
 
 #include "DecisionTree.h"
 #include "helpers/helpers.h"
+#include "helpers/parallel.h"
 #include "split_strategy/types/split_context.h"
 #include "split_strategy/types/split_hyper.h"
 #include "split_strategy/types/split_param.h"
@@ -11,8 +12,10 @@
 #include <cstddef>
 #include <numeric>
 #include <optional>
+#include <random>
 #include <stdexcept>
 #include <cmath>
+#include <thread>
 #include <variant>
 
 
@@ -29,6 +32,15 @@ DecisionTree::DecisionTree(HyperParam h_param, TreeType type)
         if (*h_param.min_sample_split <= 0) throw std::invalid_argument("arboria::tree::DecisionTree : min_sample_split argument must be greater than or equal 0");
         min_sample_split = *h_param.min_sample_split;
     }
+    if (h_param.honest_fraction.has_value()){
+        if (!(*h_param.honest_fraction > 0.f && *h_param.honest_fraction < 1.f)) throw std::invalid_argument("arboria::tree::DecisionTree : honest_fraction argument must be in (0, 1)");
+        honest_fraction = *h_param.honest_fraction;
+    }
+    if (h_param.n_jobs.has_value()){
+        if (*h_param.n_jobs < -1 || *h_param.n_jobs == 0) throw std::invalid_argument("arboria::tree::DecisionTree : n_jobs argument must be a positive int or equals to -1");
+        const unsigned hw = std::thread::hardware_concurrency();
+        n_jobs = (*h_param.n_jobs == -1) ? std::max(1, static_cast<int>(hw)) : *h_param.n_jobs;
+    }
 
     if (std::holds_alternative<Classification>(type) || std::holds_alternative<Regression>(type)){
     type_ = type;
@@ -66,20 +78,93 @@ void DecisionTree::fit(const DataSet& data,
     int n_rows = data.n_rows();
     int n_cols = data.n_cols();
     if (n_rows <= 1) {throw std::invalid_argument("arboria::DecisionTree::fit -> invalid fitted DataSet");}
+    //number of classes is taken from the whole DataSet so that trees fitted 
+    //on different subsets of rows share the same class encoding
+    if (std::holds_alternative<Classification>(params.type)) {
+        if (data.n_targets() != 1) throw std::invalid_argument("arboria::DecisionTree::fit -> classification requires a single target column");
+        n_classes_ = helpers::num_classes(data.y());
+    }
+    n_targets_ = data.n_targets();
+    nodes_.clear();
+    num_features = n_cols;
+
+    //honest trees learn the structure on the front rows only
+    std::span<int> structure = idx;
+    std::span<int> estimation;
+    if (honest_fraction.has_value()){
+        std::mt19937 default_rng(0);
+        std::mt19937& rng = context ? context->get().rng : default_rng;
+        const size_t n_structure = honest_split_(idx, rng);
+        structure = idx.first(n_structure);
+        estimation = idx.subspan(n_structure);
+    }
+
+    int root = nodes_.emplace();
     if (context){
-        fit_(data, root_node, idx, 0, params, context);
+        fit_(data, root, structure, 0, params, context);
     }
     else {
-        fit_(data, root_node, idx, 0, params);
+        fit_(data, root, structure, 0, params);
     }
+    if (!estimation.empty()) estimate_leaves_(data, estimation);
     fitted = true; 
-    num_features = n_cols;
 }
 
 float DecisionTree::predict_one(const std::span<const float> sample) const{
     if (!fitted) {throw std::invalid_argument("arboria::DecisionTree::predict_one -> tree has not been fitted");}
     if (sample.size() != num_features) throw std::invalid_argument("arboria::DecisionTree::predict_one -> the passed sample for prediction has different number of features than seen in training");
-    return predict_one_(sample, root_node);
+    if (n_targets_ != 1) throw std::invalid_argument("arboria::DecisionTree::predict_one -> tree has several outputs, use predict_outputs_one");
+    return predict_one_(sample);
+}
+
+std::span<const float> DecisionTree::predict_outputs_one(const std::span<const float> sample) const{
+    if (!fitted) {throw std::invalid_argument("arboria::DecisionTree::predict_outputs_one -> tree has not been fitted");}
+    if (sample.size() != static_cast<size_t>(num_features)) throw std::invalid_argument("arboria::DecisionTree::predict_outputs_one -> the passed sample for prediction has different number of features than seen in training");
+    return leaf_outputs(find_leaf_index_(sample));
+}
+
+size_t DecisionTree::n_leaves() const{
+    const std::span<const Node> nodes = nodes_.nodes();
+    return static_cast<size_t>(std::count_if(nodes.begin(), nodes.end(), [](const Node& n){return n.is_leaf;}));
+}
+
+int DecisionTree::depth() const{
+    const std::span<const Node> nodes = nodes_.nodes();
+    if (nodes.empty()) return 0;
+    int deepest = 0;
+    std::vector<std::pair<int, int>> stack {{0, 0}};
+    while (!stack.empty()){
+        const auto [node, level] = stack.back();
+        stack.pop_back();
+        if (nodes[node].is_leaf) {
+            deepest = std::max(deepest, level);
+            continue;
+        }
+        stack.push_back({nodes[node].left_child, level + 1});
+        stack.push_back({nodes[node].right_child, level + 1});
+    }
+    return deepest;
+}
+
+std::span<const float> DecisionTree::leaf_outputs(int leaf) const{
+    const Node& node = nodes_[leaf];
+    if (n_targets_ == 1) return std::span<const float>(&node.leaf_value, 1);
+    return nodes_.values(node.value_index, static_cast<size_t>(n_targets_));
+}
+
+int DecisionTree::leaf_index(const std::span<const float> sample) const{
+    if (!fitted) {throw std::invalid_argument("arboria::DecisionTree::leaf_index -> tree has not been fitted");}
+    if (sample.size() != static_cast<size_t>(num_features)) throw std::invalid_argument("arboria::DecisionTree::leaf_index -> the passed sample has different number of features than seen in training");
+    return find_leaf_index_(sample);
+}
+
+std::vector<int> DecisionTree::apply(const std::span<const float> samples) const{
+    if (!fitted) {throw std::invalid_argument("arboria::DecisionTree::apply -> tree has not been fitted");}
+    const size_t nf = static_cast<size_t>(num_features);
+    if (samples.size() % nf != 0) throw std::invalid_argument("arboria::DecisionTree::apply -> passed samples do not have the correct dimension");
+    std::vector<int> rows(samples.size() / nf);
+    std::iota(rows.begin(), rows.end(), 0);
+    return route_rows_(samples, rows);
 }
 
 std::vector<float> DecisionTree::predict(const std::span<const float> samples) const {
@@ -89,43 +174,283 @@ std::vector<float> DecisionTree::predict(const std::span<const float> samples) c
     if (samples.size() % nf != 0) throw std::invalid_argument("arboria::DecisionTree::predict -> passed samples do not have the correct dimension");
 
     size_t num_samples = samples.size()/nf;
-    std::vector<float> preds(num_samples);
-
-    for (size_t s = 0; s<num_samples; s++){
-        auto sample = samples.subspan(s*nf, nf);
-        preds[s] = predict_one(sample);
-    }
-    
+    const size_t T = static_cast<size_t>(n_targets_);
+    std::vector<float> preds(num_samples * T);
+
+    //the batch is validated once : blocks only read their leaves
+    route_blocks_(samples, [&](size_t first, std::span<const int> leaves){
+        for (size_t r = 0; r < leaves.size(); r++){
+            const std::span<const float> outputs = leaf_outputs(leaves[r]);
+            std::copy(outputs.begin(), outputs.end(), preds.begin() + (first + r) * T);
+        }
+    });
     return preds;
 }
 
+std::vector<float> DecisionTree::predict_proba(const std::span<const float> samples) const {
+
+    if (!fitted || num_features == 0) throw std::invalid_argument("arboria::DecisionTree::predict_proba -> tree has not been fitted");
+    if (!std::holds_alternative<Classification>(type_)) throw std::invalid_argument("arboria::DecisionTree::predict_proba -> tree is not a classification tree");
+    size_t nf = static_cast<size_t>(num_features);
+    if (samples.size() % nf != 0) throw std::invalid_argument("arboria::DecisionTree::predict_proba -> passed samples do not have the correct dimension");
+
+    size_t num_samples = samples.size()/nf;
+    size_t K = static_cast<size_t>(n_classes_);
+    std::vector<float> proba(num_samples * K);
+
+    route_blocks_(samples, [&](size_t first, std::span<const int> leaves){
+        for (size_t r = 0; r < leaves.size(); r++){
+            std::span<const float> dist = nodes_.values(nodes_[leaves[r]].value_index, K);
+            std::copy(dist.begin(), dist.end(), proba.begin() + (first + r) * K);
+        }
+    });
+    return proba;
+}
+
+
+void DecisionTree::save(const std::string& path) const {
+    const std::vector<std::byte> bytes = to_bytes();
+    serialization::write_file(path, bytes);
+}
+
+std::vector<std::byte> DecisionTree::to_bytes() const {
+    serialization::Writer out;
+    serialization::write_header(out, serialization::ModelKind::DecisionTree);
+    serialize(out);
+    return out.release();
+}
+
+DecisionTree DecisionTree::load(const std::string& path, bool mmap){
+    serialization::Reader in(mmap ? serialization::map_file(path) : serialization::read_file(path));
+    serialization::read_header(in, serialization::ModelKind::DecisionTree);
+    return deserialize(in);
+}
+
+DecisionTree DecisionTree::from_bytes(std::span<const std::byte> bytes){
+    serialization::Reader in(serialization::copy_bytes(bytes));
+    serialization::read_header(in, serialization::ModelKind::DecisionTree);
+    return deserialize(in);
+}
+
+void DecisionTree::serialize(serialization::Writer& out) const {
+    out.put_type(type_);
+    out.put(max_depth);
+    out.put(min_sample_split);
+    out.put(honest_fraction);
+    out.put<std::int32_t>(n_jobs);
+    //an unfitted tree only stores its hyperparameters, with empty arrays
+    out.put<bool>(fitted);
+    out.put<std::int32_t>(fitted ? num_features : 0);
+    out.put<std::int32_t>(n_classes_);
+    out.put<std::int32_t>(n_targets_);
+    out.put_nodes(nodes_.nodes());
+    out.put_array(nodes_.all_values());
+}
+
+DecisionTree DecisionTree::deserialize(serialization::Reader& in){
+    const TreeType type = in.get_type();
+    HyperParam h_param;
+    h_param.max_depth = in.get_optional<int>();
+    const std::optional<int> min_sample_split = in.get_optional<int>();
+    if (min_sample_split) h_param.min_sample_split = static_cast<float>(*min_sample_split);
+    h_param.honest_fraction = in.get_optional<float>();
+    h_param.n_jobs = in.get<std::int32_t>();
+
+    DecisionTree tree(h_param, type);
+    const bool fitted = in.get<bool>();
+    tree.num_features = in.get<std::int32_t>();
+    tree.n_classes_ = in.get<std::int32_t>();
+    tree.n_targets_ = in.get<std::int32_t>();
+    const std::span<const Node> nodes = in.get_array<Node>();
+    const std::span<const float> values = in.get_array<float>();
+    if (!fitted) return tree;
+    if (nodes.empty() || tree.num_features <= 0) throw std::invalid_argument("arboria::DecisionTree::deserialize -> model buffer holds an empty tree");
+
+    tree.nodes_ = NodeArena::view(nodes, values, in.storage());
+    tree.fitted = true;
+    return tree;
+}
 
 
 //############ Private ####
 
-float DecisionTree::predict_one_(const std::span<const float> sample, const Node& node) const{
+float DecisionTree::predict_one_(const std::span<const float> sample) const{
+    return find_leaf_(sample).leaf_value;
+}
 
+const Node& DecisionTree::find_leaf_(const std::span<const float> sample) const{
+    return nodes_[find_leaf_index_(sample)];
+}
 
-    if (node.is_leaf) {return node.leaf_value;}
+int DecisionTree::find_leaf_index_(const std::span<const float> sample) const{
 
-    if (!node.is_valid(num_features)) {
-        throw std::logic_error("arboria::DecisionTree::predict_one_ -> Invalid node reached");
+    const std::span<const Node> nodes = nodes_.nodes();
+    int index = 0;
+
+    while (!nodes[index].is_leaf) {
+
+        const Node& node = nodes[index];
+        if (!node.is_valid(num_features)) {
+            throw std::logic_error("arboria::DecisionTree::predict_one_ -> Invalid node reached");
+        }
+
+        int n_col = node.return_feature_index();
+        float threshold = node.return_threshold();
+        float sample_feature = sample[n_col];
+
+        if (std::isnan(sample_feature)) throw std::invalid_argument("arboria::DecisionTree::predict_one_ -> sample contains NaN.");
+
+        index = (sample_feature >= threshold) ? node.right_child : node.left_child;
     }
+    return index;
+}
 
+void DecisionTree::route_(std::span<const float> samples, std::span<const int> rows, std::span<int> leaves) const{
+
+    const size_t nf = static_cast<size_t>(num_features);
+    const std::span<const Node> nodes = nodes_.nodes();
+    std::fill(leaves.begin(), leaves.end(), 0);
+
+    //one level per pass for every row of the block ; rows already in a leaf stay in place
+    bool moving = !nodes[0].is_leaf;
+    while (moving){
+        moving = false;
+        for (size_t r = 0; r < rows.size(); r++){
+            const Node& node = nodes[leaves[r]];
+            if (node.is_leaf) continue;
+            const float value = samples[static_cast<size_t>(rows[r]) * nf + static_cast<size_t>(node.feature_index)];
+            if (std::isnan(value)) throw std::invalid_argument("arboria::DecisionTree::route_ -> sample contains NaN.");
+            const int go_right = value >= node.threshold;
+            leaves[r] = go_right * node.right_child + (1 - go_right) * node.left_child;
+            //the child is read by the next pass, once the other rows advanced
+            helpers::prefetch(&nodes[leaves[r]]);
+            moving = true;
+        }
+    }
+}
+
+void DecisionTree::route(std::span<const float> samples, std::span<const int> rows, std::span<int> leaves) const{
+    if (!fitted) {throw std::invalid_argument("arboria::DecisionTree::route -> tree has not been fitted");}
+    if (rows.size() != leaves.size()) throw std::invalid_argument("arboria::DecisionTree::route -> rows and leaves have different sizes");
+    route_(samples, rows, leaves);
+}
+
+std::vector<int> DecisionTree::route_rows_(std::span<const float> samples, std::span<const int> rows) const{
+
+    std::vector<int> leaves(rows.size());
+    const size_t n_blocks = (rows.size() + ROUTE_BLOCK - 1) / ROUTE_BLOCK;
+    helpers::parallel_for(n_blocks, static_cast<size_t>(n_jobs), [&](size_t b){
+        const size_t first = b * ROUTE_BLOCK;
+        const size_t n = std::min(ROUTE_BLOCK, rows.size() - first);
+        route_(samples, rows.subspan(first, n), std::span<int>(leaves).subspan(first, n));
+    });
+    return leaves;
+}
+
+void DecisionTree::route_blocks_(std::span<const float> samples, const std::function<void(size_t, std::span<const int>)>& fn) const{
+
+    const size_t num_samples = samples.size() / static_cast<size_t>(num_features);
+    const size_t n_blocks = (num_samples + ROUTE_BLOCK - 1) / ROUTE_BLOCK;
+    helpers::parallel_for(n_blocks, static_cast<size_t>(n_jobs), [&](size_t b){
+        const size_t first = b * ROUTE_BLOCK;
+        const size_t n = std::min(ROUTE_BLOCK, num_samples - first);
+        int rows[ROUTE_BLOCK];
+        int leaves[ROUTE_BLOCK];
+        std::iota(rows, rows + n, static_cast<int>(first));
+        route_(samples, std::span<const int>(rows, n), std::span<int>(leaves, n));
+        fn(first, std::span<const int>(leaves, n));
+    });
+}
+
+void DecisionTree::estimate_leaves_(const DataSet& data, std::span<const int> rows){
+
+    const std::vector<int> leaves = route_rows_(data.X(), rows);
+    const bool classification = std::holds_alternative<Classification>(type_);
+    const size_t width = classification ? static_cast<size_t>(n_classes_) : static_cast<size_t>(n_targets_);
+    const size_t n_nodes = nodes_.size();
+
+    //class counts (classification) or target sums (regression) per leaf
+    std::vector<double> sums(n_nodes * width, 0.0);
+    std::vector<int> counts(n_nodes, 0);
+    const std::vector<float>& y = data.y();
+    for (size_t r = 0; r < rows.size(); r++){
+        const size_t leaf = static_cast<size_t>(leaves[r]);
+        const size_t row = static_cast<size_t>(rows[r]);
+        counts[leaf]++;
+        if (classification) sums[leaf * width + static_cast<size_t>(y[row])] += 1.0;
+        else for (size_t k = 0; k < width; k++) sums[leaf * width + k] += y[row * width + k];
+    }
 
-    int n_col = node.return_feature_index();
-    float threshold = node.return_threshold();
-    float sample_feature = sample[n_col];
+    //every ancestor of a leaf also holds its estimation rows
+    std::vector<int> parent(n_nodes, -1);
+    for (size_t node = 0; node < n_nodes; node++){
+        const Node& internal = nodes_[static_cast<int>(node)];
+        if (internal.is_leaf) continue;
+        parent[static_cast<size_t>(internal.left_child)] = static_cast<int>(node);
+        parent[static_cast<size_t>(internal.right_child)] = static_cast<int>(node);
+    }
+    std::vector<double> subtree_sums(sums);
+    std::vector<int> subtree_counts(counts);
+    for (size_t leaf = 0; leaf < n_nodes; leaf++){
+        if (!nodes_[static_cast<int>(leaf)].is_leaf || counts[leaf] == 0) continue;
+        for (int up = parent[leaf]; up >= 0; up = parent[static_cast<size_t>(up)]){
+            const size_t ancestor = static_cast<size_t>(up);
+            subtree_counts[ancestor] += counts[leaf];
+            for (size_t k = 0; k < width; k++) subtree_sums[ancestor * width + k] += sums[leaf * width + k];
+        }
+    }
 
-    if (std::isnan(sample_feature)) throw std::invalid_argument("arboria::DecisionTree::predict_one_ -> sample contains NaN.");
+    for (size_t leaf = 0; leaf < n_nodes; leaf++){
+        Node& node = nodes_[static_cast<int>(leaf)];
+        if (!node.is_leaf) continue;
+        //a leaf reached by no estimation row takes the estimate of its nearest 
+        //ancestor reached by some, so that no value comes from the structure rows
+        size_t source = leaf;
+        while (subtree_counts[source] == 0) source = static_cast<size_t>(parent[source]);
+        const double n = static_cast<double>(subtree_counts[source]);
+        const double* source_sums = subtree_sums.data() + source * width;
+        if (classification){
+            std::vector<int> class_counts(width);
+            std::span<float> distribution = nodes_.values(node.value_index, width);
+            for (size_t k = 0; k < width; k++){
+                class_counts[k] = static_cast<int>(source_sums[k]);
+                distribution[k] = static_cast<float>(source_sums[k] / n);
+            }
+            node.leaf_value = static_cast<float>(helpers::majority_class(class_counts));
+            continue;
+        }
+        node.leaf_value = static_cast<float>(source_sums[0] / n);
+        if (width > 1){
+            std::span<float> means = nodes_.values(node.value_index, width);
+            for (size_t k = 0; k < width; k++) means[k] = static_cast<float>(source_sums[k] / n);
+        }
+    }
+}
 
-    if (sample[n_col] >= threshold){return predict_one_(sample, *node.right_child);}
-    else {return predict_one_(sample, *node.left_child);}
+size_t DecisionTree::honest_split_(std::span<int> idx, std::mt19937& rng) const{
+
+    //the split is drawn on distinct rows, so that copies of a bootstrapped
+    //row can't be used both for the structure and the estimation
+    std::vector<int> distinct(idx.begin(), idx.end());
+    std::sort(distinct.begin(), distinct.end());
+    distinct.erase(std::unique(distinct.begin(), distinct.end()), distinct.end());
+    if (distinct.size() < 2) throw std::invalid_argument("arboria::DecisionTree::fit -> honest trees require at least 2 distinct rows");
+    std::shuffle(distinct.begin(), distinct.end(), rng);
+
+    const size_t n_structure = std::clamp<size_t>(
+        static_cast<size_t>(static_cast<double>(*honest_fraction) * static_cast<double>(distinct.size())), 1, distinct.size() - 1);
+    std::vector<int> structure_rows(distinct.begin(), distinct.begin() + n_structure);
+    std::sort(structure_rows.begin(), structure_rows.end());
+
+    auto middle = std::stable_partition(idx.begin(), idx.end(), [&](int row){
+        return std::binary_search(structure_rows.begin(), structure_rows.end(), row);
+    });
+    return static_cast<size_t>(middle - idx.begin());
 }
 
 //fit the DecisionTree with SplitContext :
 void DecisionTree::fit_(const DataSet& data, 
-                        Node& node, 
+                        int node, 
                         std::span<int> idx, 
                         int depth, 
                         const SplitParam& params, 
@@ -133,21 +458,33 @@ void DecisionTree::fit_(const DataSet& data,
 
     //lambda function to stop iteration :
     auto end_branch= [&](){
-        node.is_leaf = true;
+        nodes_[node].is_leaf = true;
 
         if (std::holds_alternative<Classification>(params.type)){
-            std::pair<int,int>count = helpers::count_classes(idx, data.y());
-            int pos_count = count.first;
-            int neg_count = count.second;
+            std::vector<int> counts = helpers::class_counts(idx, data.y(), n_classes_);
+
+            // in case of tie break, node predicted class is the highest class (1 for binary)
+            nodes_[node].leaf_value = static_cast<float>(helpers::majority_class(counts));
 
-            (pos_count >= neg_count) ? node.leaf_value= 1 : node.leaf_value=0 ; // ">=" : in case of tie break, node predicted class = 1
+            std::vector<float> distribution(counts.size());
+            for (size_t k = 0; k < counts.size(); k++){
+                distribution[k] = static_cast<float>(counts[k]) / static_cast<float>(idx.size());
+            }
+            nodes_[node].value_index = nodes_.emplace_values(distribution);
             return;
         }
 
         if (std::holds_alternative<Regression>(params.type)){
 
-            float mean = helpers::calculate_mean(idx,data.y());
-            node.leaf_value = mean;
+            if (n_targets_ == 1){
+                float mean = helpers::calculate_mean(idx,data.y());
+                nodes_[node].leaf_value = mean;
+                return;
+            }
+            //multi-output leaves store the mean of every target
+            std::vector<float> means = helpers::calculate_means(idx, data.y(), n_targets_);
+            nodes_[node].leaf_value = means[0];
+            nodes_[node].value_index = nodes_.emplace_values(means);
             return;
         }
     };
@@ -184,9 +521,9 @@ void DecisionTree::fit_(const DataSet& data,
     if (split.has_split()){
         int feature_index= split.split_feature;
         float threshold = split.split_threshold;
-        node.feature_index = feature_index;
-        node.threshold = threshold;
-        node.is_leaf = false;
+        nodes_[node].feature_index = feature_index;
+        nodes_[node].threshold = threshold;
+        nodes_[node].is_leaf = false;
 
         auto mid = std::partition(idx.begin(), idx.end(), 
             [&](int i) {return data.iloc_x(i, feature_index) < threshold;});
@@ -199,11 +536,14 @@ void DecisionTree::fit_(const DataSet& data,
         std::span<int> left_idx(idx.data(), left_size);
         std::span<int> right_idx(idx.data()+left_size, right_size);
 
-        node.left_child  = std::make_unique<Node>();
-        node.right_child = std::make_unique<Node>();
+        //emplace() may reallocate the arena : children are linked by index
+        int left_child = nodes_.emplace();
+        int right_child = nodes_.emplace();
+        nodes_[node].left_child = left_child;
+        nodes_[node].right_child = right_child;
         
-        fit_(data, *node.left_child, left_idx, depth+1, params, context);
-        fit_(data, *node.right_child, right_idx, depth+1, params, context);
+        fit_(data, left_child, left_idx, depth+1, params, context);
+        fit_(data, right_child, right_idx, depth+1, params, context);
         
 
     }    
@@ -1,6 +1,9 @@
 
 #pragma once
+#include <cstddef>
+#include <functional>
 #include <optional>
+#include <string>
 #include <vector>
 #include <span>
 
@@ -8,6 +11,7 @@
 #include "dataset/dataset.h"
 #include "split_strategy/splitter.h"
 #include "helpers/helpers.h"
+#include "serialization/serialization.h"
 #include "split_strategy/types/split_context.h"
 #include "split_strategy/types/split_hyper.h"
 #include "split_strategy/types/split_param.h"
@@ -73,28 +77,173 @@ class DecisionTree
          * a unique sample. Sample must have the same number of
          * features as seen in training (sample.size() == num_features) 
          * @throw std::invalid_argument if sample number of features
-         * and training feature differ 
+         * and training feature differ, or if the tree has several outputs
          * @return the predicted class 
          */
         float predict_one(const std::span<const float> sample) const;
+
+        /**
+         * @brief Returns every output predicted for the passed sample
+         * 
+         * For multi-output regression trees, the returned view holds the
+         * mean of each target over the training samples of the reached leaf.
+         * For single-output trees, it holds the value returned by predict_one().
+         * 
+         * @param sample std::span view into a vector containing 
+         * a unique sample, with sample.size() == num_features 
+         * @throw std::invalid_argument if the tree has not been fitted or if
+         * sample number of features and training feature differ 
+         * @return a view of size n_outputs() into the tree storage, valid 
+         * as long as the tree is alive and not refitted
+         */
+        std::span<const float> predict_outputs_one(const std::span<const float> sample) const;
         
+        /**
+         * @brief Returns the index of the leaf reached by the passed sample
+         * 
+         * @param sample std::span view into a vector containing 
+         * a unique sample, with sample.size() == num_features 
+         * @throw std::invalid_argument if the tree has not been fitted or if
+         * sample number of features and training feature differ 
+         * @return the index of the leaf in the nodes of the tree, in [0, n_nodes())
+         */
+        int leaf_index(const std::span<const float> sample) const;
+
+        //Number of nodes of the fitted tree
+        size_t n_nodes() const {return nodes_.size();}
+
+        //Number of leaves of the fitted tree
+        size_t n_leaves() const;
+
+        //Depth of the deepest leaf of the fitted tree (0 for a single leaf)
+        int depth() const;
+
+        //Read-only view over the nodes of the fitted tree ; the root is at index 0
+        std::span<const Node> nodes() const {return nodes_.nodes();}
+
+        /**
+         * @brief Returns the outputs stored in a leaf
+         * 
+         * @param leaf Index of a leaf, as returned by leaf_index()
+         * @return a view of size n_outputs() : the value returned by 
+         * predict_outputs_one() for the samples reaching the leaf
+         */
+        std::span<const float> leaf_outputs(int leaf) const;
+
+        /**
+         * @brief Returns the index of the leaf reached by each sample of a batch
+         *
+         * Rows are routed in blocks : all the rows of a block descend the tree
+         * one level at a time, and blocks are distributed between n_jobs threads.
+         *
+         * @param samples Non owning view over a row-major representation
+         * of a set of samples, with the number of features seen in training
+         * @throws std::invalid_argument if the tree has not been fitted, if 
+         * samples dimensions are incompatible with training dataset dimensions
+         * or if a routed sample contains NaN
+         * @return a vector with the leaf index of each sample, as leaf_index()
+         */
+        std::vector<int> apply(const std::span<const float> samples) const;
+
+        /**
+         * @brief Routes a block of rows to their leaves on the calling thread
+         *
+         * Same kernel as apply() : every row advances by one level per pass. 
+         * Ensembles use it to walk a tile of samples through one tree while 
+         * its nodes stay in cache.
+         *
+         * @param samples Row-major samples, with the number of features seen in training
+         * @param rows Rows of samples to route ; they are not bounds-checked
+         * @param leaves Output : the leaf index of each row, of size rows.size()
+         * @throws std::invalid_argument if the tree has not been fitted, if rows 
+         * and leaves sizes differ or if a routed sample contains NaN
+         */
+        void route(std::span<const float> samples, std::span<const int> rows, std::span<int> leaves) const;
+
         /**
          * @brief Predict the class of a set of samples
          * The input is expected to be a flat, row-major buffer containing
          * consecutive samples. Each sample must have the same number of
-         * features as the data used during training
+         * features as the data used during training. Samples are routed 
+         * in blocks on n_jobs threads, as apply()
          * @param sample Non owning view over a row-major representation
          * of a set of samples. The number of features of the samples must
          * be coherent with the number of features seen in training.
          * @throws std::invalid_argument if the tree has not yet been fitted or
          * if samples dimensions are incompatible with training dataset dimensions.
-         * @return a vector of int of the predicted class
+         * @return a vector of int of the predicted class. For multi-output 
+         * regression, a row-major vector of size num_samples * n_outputs()
          */
         std::vector<float> predict(const std::span<const float> samples) const;
+
+        /**
+         * @brief Predict the class distribution of a set of samples
+         * 
+         * Each sample is routed to a leaf, which stores the proportion of 
+         * each class among the training samples that reached it.
+         * 
+         * @param samples Non owning view over a row-major representation
+         * of a set of samples, with the number of features seen in training.
+         * @throws std::invalid_argument if the tree has not yet been fitted, 
+         * is not a classification tree or if samples dimensions are incompatible
+         * with training dataset dimensions.
+         * @return a row-major vector of size num_samples * n_classes() where
+         * output[s * n_classes() + k] is the probability of class k for sample s
+         */
+        std::vector<float> predict_proba(const std::span<const float> samples) const;
+
+        /**
+         * @brief Writes the tree to a binary model file
+         *
+         * The file holds the hyperparameters, the number of features and the 
+         * node and leaf value arrays of the tree, laid out as in memory 
+         * (see serialization/serialization.h). An unfitted tree only stores
+         * its hyperparameters.
+         *
+         * @param path Path of the file, overwritten if it exists
+         * @throws std::runtime_error if the file can't be written
+         */
+        void save(const std::string& path) const;
+
+        //Returns the content of the model file written by save()
+        std::vector<std::byte> to_bytes() const;
+
+        /**
+         * @brief Loads a tree written by save()
+         *
+         * @param path Path of the model file
+         * @param mmap Whether to map the file : the nodes are then read in place
+         * from the mapped pages, which stay mapped as long as the tree (or a copy)
+         * is alive. Otherwise the file is read into memory.
+         * @throws std::invalid_argument if the file is not a tree model of the 
+         * current format version
+         * @throws std::runtime_error if the file can't be read
+         * @note Nodes are not validated : only load files written by save().
+         */
+        static DecisionTree load(const std::string& path, bool mmap = true);
+
+        //Loads a tree from the content of a model file ; the bytes are copied once
+        static DecisionTree from_bytes(std::span<const std::byte> bytes);
+
+        //Appends the tree section of a model file ; used by the ensembles to store their trees
+        void serialize(serialization::Writer& out) const;
+
+        //Reads a tree section written by serialize() ; nodes and values view the reader storage
+        static DecisionTree deserialize(serialization::Reader& in);
+
+        //Number of classes seen during training (0 for regression trees)
+        int n_classes() const {return n_classes_;}
+
+        //Number of targets predicted per sample (1 except for multi-output regression)
+        int n_outputs() const {return n_targets_;}
      
         //Maximum depth allowed for the construction of the DecisionTree
         std::optional<int>max_depth;
         std::optional<int>min_sample_split;
+        //Honest trees : fraction of the rows learning the structure, the others estimate the leaves
+        std::optional<float> honest_fraction;
+        //Number of threads used to route rows (apply and honest leaf estimation)
+        int n_jobs = 1;
         //Number of features seen in the DataSet during training
         int num_features;
         //Getter for fitted
@@ -125,7 +274,7 @@ class DecisionTree
          * best available split and recursively constructs child nodes
          *
          * @param data Training dataset
-         * @param node Current node 
+         * @param node Index of the current node in the NodeArena
          * @param idx Span of row indices corresponding to the samples
          * reaching this node.
          * @param depth Current depth in the tree
@@ -134,22 +283,96 @@ class DecisionTree
          * @param context SplitContext object passing the RNG if required by 
          * the algorithm
          */
-        void fit_(const DataSet& data, Node& node, std::span<int> idx, int depth, const SplitParam& params, std::optional<std::reference_wrapper<SplitContext>> context = std::nullopt);
+        void fit_(const DataSet& data, int node, std::span<int> idx, int depth, const SplitParam& params, std::optional<std::reference_wrapper<SplitContext>> context = std::nullopt);
 
 
 
         /**
-         * @brief Returns the predicted class of the current node or pass the sample 
-         * to the left/right child 
+         * @brief Walks the tree from the root node down to a leaf and
+         * returns its predicted value
          *
          * @param sample a sample with .size() = num_features
-         * @param node the current node 
          * @return the predicted class
          */
-        float predict_one_(const std::span<const float> sample, const Node& node) const;
-        
+        float predict_one_(const std::span<const float> sample) const;
+
+        /**
+         * @brief Walks the tree from the root node down to the leaf
+         * reached by the sample
+         *
+         * @param sample a sample with .size() = num_features
+         * @throws std::invalid_argument if the sample contains NaN
+         * @return the leaf node 
+         */
+        const Node& find_leaf_(const std::span<const float> sample) const;
+
+        //Same walk as find_leaf_, returning the index of the leaf in nodes_
+        int find_leaf_index_(const std::span<const float> sample) const;
+
+        /**
+         * @brief Routes a block of rows to their leaves
+         *
+         * Every row of the block advances by one level per pass, with the
+         * child selected without branching, until all rows reached a leaf.
+         *
+         * @param samples Row-major samples
+         * @param rows Rows of samples to route
+         * @param leaves Output : the leaf index of each row, of size rows.size()
+         * @throws std::invalid_argument if a routed sample contains NaN
+         */
+        void route_(std::span<const float> samples, std::span<const int> rows, std::span<int> leaves) const;
+
+        //Rows routed together by route_() : their indices and leaves stay in L1
+        static constexpr size_t ROUTE_BLOCK = 256;
+
+        /**
+         * @brief Routes rows to leaves in parallel blocks of route_()
+         *
+         * @return the leaf index of each row
+         */
+        std::vector<int> route_rows_(std::span<const float> samples, std::span<const int> rows) const;
+
+        /**
+         * @brief Routes every sample in parallel blocks of route_(), handing 
+         * each block to fn on the thread which routed it
+         *
+         * @param samples Row-major samples, already validated
+         * @param fn Called with the first sample of a block and the leaves of its samples
+         */
+        void route_blocks_(std::span<const float> samples, const std::function<void(size_t, std::span<const int>)>& fn) const;
+
+        /**
+         * @brief Honest estimation : replaces the values of the leaves with 
+         * the targets of the estimation rows
+         *
+         * Estimation rows are routed with a single batched pass, then their 
+         * targets are accumulated per leaf and per ancestor. Leaves reached by
+         * no estimation row take the estimate of their nearest ancestor 
+         * reached by some (the root holds every estimation row).
+         *
+         * @param data Training dataset
+         * @param rows Estimation rows, disjoint from the rows the structure was learned on
+         */
+        void estimate_leaves_(const DataSet& data, std::span<const int> rows);
+
+        /**
+         * @brief Splits the rows of an honest tree into structure and estimation rows
+         *
+         * Repeated rows (bootstrap) are kept on the same side.
+         *
+         * @param idx Rows passed to fit ; reordered with structure rows first
+         * @param rng RNG drawing the split
+         * @return the number of structure rows at the front of idx
+         */
+        size_t honest_split_(std::span<int> idx, std::mt19937& rng) const;
+
         bool fitted = false;
-        Node root_node;
+        //Number of classes K of a classification tree ; labels are in {0, ..., K-1}
+        int n_classes_ = 0;
+        //Number of targets of the training DataSet
+        int n_targets_ = 1;
+        //Contiguous storage of the nodes of the tree ; the root is at index 0
+        NodeArena nodes_;
         Splitter splitter;
 
         friend struct arboria::test::DecisionTreeAccess;
@@ -0,0 +1,257 @@
+/*
+
+                    Gradient Boosting implementation
+
+*/
+
+#include "gradientboosting.h"
+#include "helpers/helpers.h"
+#include "helpers/parallel.h"
+#include "split_strategy/sampling/sampling.h"
+#include "split_strategy/types/ParamBuilder/ParamBuilder.h"
+#include "split_strategy/types/split_context.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <numeric>
+#include <random>
+#include <stdexcept>
+#include <thread>
+#include <variant>
+
+namespace arboria {
+
+GradientBoosting::GradientBoosting(HyperParam hyperParam, TreeType type, std::optional<std::uint32_t> user_seed, BoostParam boost)
+{
+    if (hyperParam.n_estimators.has_value()) {
+        if (*hyperParam.n_estimators <= 0) throw std::invalid_argument("arboria::GradientBoosting : n_estimators argument must be greater than 0");
+        n_estimators = *hyperParam.n_estimators;
+    }
+    else n_estimators = 100;
+
+    if (hyperParam.max_depth.has_value()) {
+        if (*hyperParam.max_depth <= 0) throw std::invalid_argument("arboria::GradientBoosting : max_depth argument must be greater than 0");
+        max_depth = *hyperParam.max_depth;
+    }
+    else max_depth = 3;
+
+    if (hyperParam.min_sample_split.has_value()){
+        if (*hyperParam.min_sample_split <= 0) throw std::invalid_argument("arboria::GradientBoosting : min_sample_split argument must be greater than 0");
+        min_sample_split = static_cast<int>(*hyperParam.min_sample_split);
+    }
+
+    if (hyperParam.n_jobs.has_value()){
+        if (*hyperParam.n_jobs < -1 || *hyperParam.n_jobs == 0) throw std::invalid_argument("arboria::GradientBoosting : n_jobs argument must be a positive int or equals to -1");
+        const unsigned hw = std::thread::hardware_concurrency();
+        n_jobs = (*hyperParam.n_jobs == -1) ? std::max(1, static_cast<int>(hw)) : *hyperParam.n_jobs;
+    }
+    else n_jobs = 1;
+
+    if (!(boost.learning_rate > 0.f)) throw std::invalid_argument("arboria::GradientBoosting : learning_rate must be greater than 0");
+    if (!(boost.reg_lambda >= 0.f)) throw std::invalid_argument("arboria::GradientBoosting : reg_lambda must be greater than or equal 0");
+    if (!(boost.subsample > 0.f && boost.subsample <= 1.f)) throw std::invalid_argument("arboria::GradientBoosting : subsample must be in (0, 1]");
+    if (!(boost.colsample > 0.f && boost.colsample <= 1.f)) throw std::invalid_argument("arboria::GradientBoosting : colsample must be in (0, 1]");
+    boost_ = boost;
+
+    if (!user_seed){
+        std::random_device rd;
+        seed_ = static_cast<std::uint32_t>(rd());
+    }
+    else seed_ = *user_seed;
+
+    if (std::holds_alternative<Classification>(type) || std::holds_alternative<Regression>(type)){
+        type_ = type;
+    }
+    else throw std::invalid_argument("arboria::GradientBoosting : invalid type");
+}
+
+void GradientBoosting::fit(const DataSet& data){
+
+    if (data.is_empty() || data.n_rows() <= 1) throw std::invalid_argument("arboria::GradientBoosting::fit : DataSet is empty");
+    if (data.n_targets() != 1) throw std::invalid_argument("arboria::GradientBoosting::fit : multi-target DataSets are not supported");
+
+    const bool classification = std::holds_alternative<Classification>(type_);
+    const std::vector<float>& y = data.y();
+    const size_t n_rows = static_cast<size_t>(data.n_rows());
+    const size_t n_cols = static_cast<size_t>(data.n_cols());
+
+    if (classification){
+        for (float label : y){
+            if (label != 0.f && label != 1.f) throw std::invalid_argument("arboria::GradientBoosting::fit : classification labels must be in {0, 1}");
+        }
+    }
+
+    //base score : the constant minimising the loss
+    const double mean = std::accumulate(y.begin(), y.end(), 0.0) / static_cast<double>(n_rows);
+    if (classification){
+        const double p = std::clamp(mean, 1e-6, 1.0 - 1e-6);
+        base_score_ = static_cast<float>(std::log(p / (1.0 - p)));
+    }
+    else base_score_ = static_cast<float>(mean);
+
+    //trees are fitted on the negative gradients ; X is copied once and only
+    //the targets change between rounds
+    DataSet work = data;
+    const size_t n_sub = std::max<size_t>(2, static_cast<size_t>(static_cast<double>(boost_.subsample) * static_cast<double>(n_rows)));
+    const size_t mtry = std::max<size_t>(1, static_cast<size_t>(std::lround(static_cast<double>(boost_.colsample) * static_cast<double>(n_cols))));
+    FeatureSelection features = (mtry >= n_cols) ? FeatureSelection{AllFeatures{}} : FeatureSelection{RandomK{static_cast<int>(mtry)}};
+    const SplitParam param = ParamBuilder(TreeModel::DecisionTree, Regression{}, SSE{}, CART{}, features);
+    const HyperParam tree_param{.max_depth = max_depth, .min_sample_split = min_sample_split, .n_jobs = n_jobs};
+
+    std::vector<double> F(n_rows, static_cast<double>(base_score_));
+    std::vector<double> g(n_rows);
+    std::vector<double> h(n_rows);
+    std::vector<float> targets(n_rows);
+    std::vector<int> rows(n_rows);
+    //every training row, and the leaf it reaches in the tree of the round
+    std::vector<int> all_rows(n_rows);
+    std::iota(all_rows.begin(), all_rows.end(), 0);
+    std::vector<int> leaves(n_rows);
+    const size_t n_tiles = (n_rows + PREDICT_TILE - 1) / PREDICT_TILE;
+
+    std::vector<BoostedTree> fitted_trees;
+    fitted_trees.reserve(static_cast<size_t>(n_estimators));
+    train_loss_.clear();
+
+    for (int m = 0; m < n_estimators; m++){
+        gradients_(y, F, g, h);
+        for (size_t i = 0; i < n_rows; i++) targets[i] = static_cast<float>(-g[i]);
+        work.set_y(targets);
+
+        //row subsampling, then the tree draws its features from the same context
+        SplitContext context(static_cast<std::uint32_t>(helpers::derive_seed(seed_, static_cast<size_t>(m))));
+        rows.resize(n_rows);
+        if (n_sub < n_rows){
+            std::vector<size_t> drawn = sampling::subsample(n_rows, n_sub, context.rng);
+            rows.resize(n_sub);
+            for (size_t i = 0; i < n_sub; i++) rows[i] = static_cast<int>(drawn[i]);
+        }
+        else std::iota(rows.begin(), rows.end(), 0);
+
+        BoostedTree boosted{DecisionTree(tree_param, Regression{}), {}};
+        //fit reorders rows : the Newton values are accumulated from the subsample
+        std::vector<int> in_sample(rows);
+        boosted.tree.fit(work, rows, param, context);
+
+        //every training row is routed once, for the leaf sums and the score update
+        helpers::parallel_for(n_tiles, static_cast<size_t>(n_jobs), [&](size_t b){
+            const size_t first = b * PREDICT_TILE;
+            const size_t n = std::min(PREDICT_TILE, n_rows - first);
+            boosted.tree.route(data.X(), std::span<const int>(all_rows).subspan(first, n), std::span<int>(leaves).subspan(first, n));
+        });
+        const size_t n_nodes = boosted.tree.n_nodes();
+        std::vector<double> G(n_nodes, 0.0);
+        std::vector<double> H(n_nodes, 0.0);
+        for (int row : in_sample){
+            G[leaves[row]] += g[row];
+            H[leaves[row]] += h[row];
+        }
+        boosted.leaf_values.assign(n_nodes, 0.f);
+        for (size_t node = 0; node < n_nodes; node++){
+            const double denom = H[node] + static_cast<double>(boost_.reg_lambda);
+            if (denom > 0.0) boosted.leaf_values[node] = static_cast<float>(-G[node] / denom * boost_.learning_rate);
+        }
+        for (size_t i = 0; i < n_rows; i++) F[i] += boosted.leaf_values[leaves[i]];
+
+        train_loss_.push_back(loss_(y, F));
+        fitted_trees.push_back(std::move(boosted));
+    }
+
+    trees = std::move(fitted_trees);
+    num_features = static_cast<int>(n_cols);
+    fitted = true;
+}
+
+std::vector<float> GradientBoosting::decision_function(std::span<const float> samples) const {
+
+    if (!fitted) throw std::invalid_argument("arboria::GradientBoosting::decision_function -> model has not been fitted");
+    const size_t nf = static_cast<size_t>(num_features);
+    if (samples.size() % nf != 0) throw std::invalid_argument("arboria::GradientBoosting::decision_function -> passed samples do not have the correct dimension");
+
+    const size_t num_samples = samples.size() / nf;
+    std::vector<float> scores(num_samples);
+
+    //a tile of samples goes through every tree before the next tile : one 
+    //parallel region per call, and each sample still sums the trees in order
+    const size_t n_tiles = (num_samples + PREDICT_TILE - 1) / PREDICT_TILE;
+    helpers::parallel_for(n_tiles, static_cast<size_t>(n_jobs), [&](size_t b){
+        const size_t first = b * PREDICT_TILE;
+        const size_t n = std::min(PREDICT_TILE, num_samples - first);
+        std::array<int, PREDICT_TILE> rows;
+        std::array<int, PREDICT_TILE> leaves;
+        std::array<double, PREDICT_TILE> F;
+        std::iota(rows.begin(), rows.begin() + n, static_cast<int>(first));
+        F.fill(static_cast<double>(base_score_));
+        for (const BoostedTree& boosted : trees){
+            boosted.tree.route(samples, std::span<const int>(rows.data(), n), std::span<int>(leaves.data(), n));
+            for (size_t r = 0; r < n; r++) F[r] += boosted.leaf_values[leaves[r]];
+        }
+        for (size_t r = 0; r < n; r++) scores[first + r] = static_cast<float>(F[r]);
+    });
+    return scores;
+}
+
+std::vector<float> GradientBoosting::predict_proba(std::span<const float> samples) const {
+
+    std::vector<float> scores = decision_function(samples);
+    if (std::holds_alternative<Classification>(type_)){
+        for (float& s : scores) s = static_cast<float>(1.0 / (1.0 + std::exp(-static_cast<double>(s))));
+    }
+    return scores;
+}
+
+std::vector<float> GradientBoosting::predict(std::span<const float> samples) const {
+
+    std::vector<float> preds = predict_proba(samples);
+    if (std::holds_alternative<Classification>(type_)){
+        for (float& p : preds) p = (p >= 0.5f) ? 1.f : 0.f;
+    }
+    return preds;
+}
+
+/*
+--------------------------------------------------------------------------------------
+PRIVATE METHODS
+--------------------------------------------------------------------------------------
+*/
+
+void GradientBoosting::gradients_(std::span<const float> y, std::span<const double> F,
+                                  std::vector<double>& g, std::vector<double>& h) const {
+
+    if (std::holds_alternative<Classification>(type_)){
+        //binary log loss : g = p - y, h = p (1 - p)
+        for (size_t i = 0; i < y.size(); i++){
+            const double p = 1.0 / (1.0 + std::exp(-F[i]));
+            g[i] = p - static_cast<double>(y[i]);
+            h[i] = std::max(p * (1.0 - p), 1e-16);
+        }
+        return;
+    }
+    //squared error 1/2 (F - y)^2 : g = F - y, h = 1
+    for (size_t i = 0; i < y.size(); i++){
+        g[i] = F[i] - static_cast<double>(y[i]);
+        h[i] = 1.0;
+    }
+}
+
+float GradientBoosting::loss_(std::span<const float> y, std::span<const double> F) const {
+
+    double loss = 0.0;
+    if (std::holds_alternative<Classification>(type_)){
+        //log(1 + exp(F)) - y F, computed without overflow
+        for (size_t i = 0; i < y.size(); i++){
+            const double softplus = (F[i] > 0.0) ? F[i] + std::log1p(std::exp(-F[i])) : std::log1p(std::exp(F[i]));
+            loss += softplus - static_cast<double>(y[i]) * F[i];
+        }
+    }
+    else {
+        for (size_t i = 0; i < y.size(); i++){
+            const double r = F[i] - static_cast<double>(y[i]);
+            loss += r * r;
+        }
+    }
+    return static_cast<float>(loss / static_cast<double>(y.size()));
+}
+
+}
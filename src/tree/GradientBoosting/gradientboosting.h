@@ -0,0 +1,156 @@
+/*
+
+                    Gradient Boosting header
+
+*/
+#pragma once
+
+#include "dataset/dataset.h"
+#include "tree/DecisionTree/DecisionTree.h"
+#include "tree/TreeModel.h"
+#include "split_strategy/types/split_hyper.h"
+
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <vector>
+
+namespace arboria {
+
+/**
+ * @brief Struct passing the boosting parameters of a GradientBoosting model
+ *
+ * @param learning_rate Shrinkage applied to the leaf values of every tree
+ * @param reg_lambda L2 regularisation of the Newton leaf values
+ * @param subsample Fraction of the rows drawn (without replacement) to fit each tree
+ * @param colsample Fraction of the features sampled at each split
+ */
+struct BoostParam {
+    float learning_rate = 0.1f;
+    float reg_lambda = 1.f;
+    float subsample = 1.f;
+    float colsample = 1.f;
+};
+
+/**
+ * @brief Tree of a GradientBoosting model
+ *
+ * @param tree Regression tree fitted on the negative gradients
+ * @param leaf_values Newton value of each node, shrunk by the learning rate ;
+ * indexed like the nodes of the tree (0 for internal nodes)
+ */
+struct BoostedTree {
+    DecisionTree tree;
+    std::vector<float> leaf_values;
+};
+
+/**
+ * @brief Gradient boosted decision trees
+ *
+ * Regression minimises the squared error, classification the binary log loss.
+ * At each round, a regression tree is fitted with the SSE splitter on the
+ * negative gradients of a subsample of the rows, then each leaf takes the
+ * Newton value -G / (H + reg_lambda) computed from the gradients G and hessians
+ * H of its rows. The predictions of the training rows are updated by routing
+ * them to the leaves of the new tree with DecisionTree::route().
+ *
+ * @note The split structure follows the gradients (Friedman's gradient tree),
+ * the Newton step only applies to the leaf values.
+ */
+class GradientBoosting{
+
+    public:
+    /**
+     * @brief Constructor for the GradientBoosting model
+     *
+     * @param hyperParam Uses n_estimators (default 100), max_depth (default 3),
+     * min_sample_split and n_jobs (threads routing rows to leaves). Other fields are ignored.
+     * @param type Regression (squared error) or Classification (binary log loss)
+     * @param seed Optional seed of the row and feature subsampling
+     * @param boost Boosting parameters
+     */
+    GradientBoosting(HyperParam hyperParam, TreeType type, std::optional<uint32_t> seed = std::nullopt, BoostParam boost = {});
+
+    /**
+    * @brief Fits the GradientBoosting model
+    *
+    * @param data DataSet with a single target ; labels in {0, 1} for classification
+    *
+    * @throws std::invalid_argument If the DataSet is empty, has several targets,
+    * or if classification labels are not binary.
+    */
+    void fit(const DataSet& data);
+
+    /**
+    * @brief Returns the raw score of a batch of samples : the base score plus
+    * the values of the leaves reached in every tree
+    *
+    * @param samples Non owning view over a row-major representation
+    * of a set of samples, with the number of features seen in training
+    * @return A vector with one raw score per sample (log-odds for classification)
+    * @note Tiles of PREDICT_TILE samples are shared between n_jobs threads, each
+    * tile going through every tree without allocating.
+    * @throws std::invalid_argument If the model has not been fitted or if the
+    * input dimensions are inconsistent with the training data.
+    */
+    std::vector<float> decision_function(std::span<const float> samples) const;
+
+    /**
+    * @brief Predict the probability of class 1 (classification) or the
+    * value (regression) of a batch of samples
+    *
+    * Same exceptions as decision_function().
+    */
+    std::vector<float> predict_proba(std::span<const float> samples) const;
+
+    /**
+    * @brief Predict the class (classification, threshold 0.5) or the value
+    * (regression) of a batch of samples
+    *
+    * Same exceptions as decision_function().
+    */
+    std::vector<float> predict(std::span<const float> samples) const;
+
+    //Returns whether the model has been fitted
+    bool is_fitted() const {return fitted;}
+
+    //Returns the number of boosting rounds
+    int get_estimators() const {return n_estimators;}
+
+    //Returns the initial raw score of every sample
+    float base_score() const {return base_score_;}
+
+    //Returns the training loss after each boosting round
+    const std::vector<float>& train_loss() const {return train_loss_;}
+
+    //Returns the seed of the model
+    std::uint32_t seed() const {return seed_;}
+
+    //Number of samples routed together through every tree by decision_function()
+    static constexpr size_t PREDICT_TILE = 64;
+
+    TreeType type_;
+
+    private:
+    int n_estimators;
+    std::optional<int> max_depth;
+    std::optional<int> min_sample_split;
+    int n_jobs;
+    BoostParam boost_;
+
+    bool fitted = false;
+    int num_features = 0;
+    float base_score_ = 0.f;
+    std::uint32_t seed_;
+    std::vector<BoostedTree> trees;
+    std::vector<float> train_loss_;
+
+    //Gradient and hessian of the loss at the raw score F for target y
+    void gradients_(std::span<const float> y, std::span<const double> F,
+                    std::vector<double>& g, std::vector<double>& h) const;
+
+    //Mean loss of the raw scores F
+    float loss_(std::span<const float> y, std::span<const double> F) const;
+};
+
+}
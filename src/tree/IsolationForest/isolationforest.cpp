@@ -0,0 +1,238 @@
+/*
+
+                    Isolation Forest implementation
+
+*/
+
+#include "isolationforest.h"
+#include "helpers/helpers.h"
+#include "helpers/parallel.h"
+#include "split_strategy/sampling/sampling.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <thread>
+
+namespace arboria {
+
+namespace {
+
+//Number of rows walked through a tree before moving to the next tree
+constexpr size_t BLOCK_ROWS = 256;
+
+//Average path length of an unsuccessful search in a binary search tree of n elements
+double average_path_length(size_t n){
+    if (n <= 1) return 0.0;
+    if (n == 2) return 1.0;
+    const double harmonic = std::log(static_cast<double>(n - 1)) + 0.5772156649015329;
+    return 2.0 * harmonic - 2.0 * static_cast<double>(n - 1) / static_cast<double>(n);
+}
+
+}
+
+IsolationForest::IsolationForest(HyperParam hyperParam, std::optional<std::uint32_t> user_seed)
+{
+    if (hyperParam.n_estimators.has_value()) {
+        if (*hyperParam.n_estimators <= 0) throw std::invalid_argument("arboria::IsolationForest : n_estimators argument must be greater than 0");
+        n_estimators = *hyperParam.n_estimators;
+    }
+    else n_estimators = 100;
+
+    if (hyperParam.max_samples.has_value()){
+        if (!(*hyperParam.max_samples > 0.f && *hyperParam.max_samples <= 1.f)) throw std::invalid_argument("arboria::IsolationForest : max_samples argument must be in (0, 1]");
+        max_samples = *hyperParam.max_samples;
+    }
+
+    if (hyperParam.max_depth.has_value()) {
+        if (*hyperParam.max_depth <= 0) throw std::invalid_argument("arboria::IsolationForest : max_depth argument must be greater than 0");
+        max_depth = *hyperParam.max_depth;
+    }
+
+    if (hyperParam.n_jobs.has_value()){
+        if (*hyperParam.n_jobs < -1 || *hyperParam.n_jobs == 0) throw std::invalid_argument("arboria::IsolationForest : n_jobs argument must be a positive int or equals to -1");
+        const unsigned hw = std::thread::hardware_concurrency();
+        n_jobs = (*hyperParam.n_jobs == -1) ? std::max(1, static_cast<int>(hw)) : *hyperParam.n_jobs;
+    }
+    else n_jobs = 1;
+
+    if (!user_seed){
+        std::random_device rd;
+        seed_ = static_cast<std::uint32_t>(rd());
+    }
+    else seed_ = *user_seed;
+}
+
+void IsolationForest::fit(std::span<const float> samples, int n_features){
+
+    if (n_features <= 0 || samples.empty()) throw std::invalid_argument("arboria::IsolationForest::fit : no samples were passed");
+    const size_t nf = static_cast<size_t>(n_features);
+    if (samples.size() % nf != 0) throw std::invalid_argument("arboria::IsolationForest::fit : passed samples do not have the correct dimension");
+    if (std::any_of(samples.begin(), samples.end(), [](float v){return std::isnan(v);})) {
+        throw std::invalid_argument("arboria::IsolationForest::fit : samples contain NaN");
+    }
+
+    const size_t n_rows = samples.size() / nf;
+    size_t psi = max_samples.has_value() ? static_cast<size_t>(static_cast<double>(*max_samples) * static_cast<double>(n_rows))
+                                         : std::min<size_t>(256, n_rows);
+    psi = std::min(psi, n_rows);
+    if (psi < 2) throw std::invalid_argument("arboria::IsolationForest::fit : at least 2 rows must be subsampled per tree");
+
+    num_features = n_features;
+    psi_ = static_cast<int>(psi);
+    depth_limit_ = max_depth.has_value() ? *max_depth : static_cast<int>(std::ceil(std::log2(static_cast<double>(psi))));
+
+    std::vector<NodeArena> grown(static_cast<size_t>(n_estimators));
+    helpers::parallel_for(grown.size(), static_cast<size_t>(n_jobs), [&](size_t t){
+        std::mt19937 rng(static_cast<std::uint32_t>(helpers::derive_seed(seed_, t)));
+        grow_(grown[t], samples, sampling::subsample(n_rows, psi, rng), rng);
+    });
+
+    trees = std::move(grown);
+    fitted = true;
+}
+
+std::vector<float> IsolationForest::path_length(std::span<const float> samples) const {
+
+    if (!fitted) throw std::invalid_argument("arboria::IsolationForest::path_length -> IsolationForest has not been fitted");
+    const size_t nf = static_cast<size_t>(num_features);
+    if (samples.size() % nf != 0) throw std::invalid_argument("arboria::IsolationForest::path_length -> passed samples do not have the correct dimension");
+
+    const size_t num_samples = samples.size() / nf;
+    const size_t n_blocks = (num_samples + BLOCK_ROWS - 1) / BLOCK_ROWS;
+    std::vector<float> lengths(num_samples);
+
+    helpers::parallel_for(n_blocks, static_cast<size_t>(n_jobs), [&](size_t b){
+        const size_t first = b * BLOCK_ROWS;
+        const size_t n_block = std::min(BLOCK_ROWS, num_samples - first);
+        double sums[BLOCK_ROWS] = {};
+        accumulate_paths_(samples.subspan(first * nf, n_block * nf), std::span<double>(sums, n_block));
+        for (size_t r = 0; r < n_block; r++){
+            lengths[first + r] = static_cast<float>(sums[r] / static_cast<double>(trees.size()));
+        }
+    });
+
+    return lengths;
+}
+
+std::vector<float> IsolationForest::score_samples(std::span<const float> samples) const {
+
+    std::vector<float> scores = path_length(samples);
+    const double c = average_path_length(static_cast<size_t>(psi_));
+    for (float& s : scores) s = static_cast<float>(std::exp2(-static_cast<double>(s) / c));
+    return scores;
+}
+
+std::vector<float> IsolationForest::predict(std::span<const float> samples, float threshold) const {
+
+    if (!(threshold > 0.f && threshold <= 1.f)) throw std::invalid_argument("arboria::IsolationForest::predict -> threshold must be in (0, 1]");
+    std::vector<float> scores = score_samples(samples);
+    for (float& s : scores) s = (s >= threshold) ? 1.f : 0.f;
+    return scores;
+}
+
+size_t IsolationForest::n_nodes() const {
+    size_t n = 0;
+    for (const NodeArena& tree : trees) n += tree.size();
+    return n;
+}
+
+/*
+--------------------------------------------------------------------------------------
+PRIVATE METHODS
+--------------------------------------------------------------------------------------
+*/
+
+void IsolationForest::grow_(NodeArena& tree, std::span<const float> samples, std::vector<size_t> rows, std::mt19937& rng) const {
+
+    struct Pending {
+        int node;
+        size_t begin;
+        size_t end;
+        int depth;
+    };
+
+    const size_t nf = static_cast<size_t>(num_features);
+    std::vector<float> low(nf);
+    std::vector<float> high(nf);
+    std::vector<int> candidates;
+    candidates.reserve(nf);
+
+    tree.clear();
+    tree.reserve(2 * rows.size());
+    std::vector<Pending> stack{{tree.emplace(), 0, rows.size(), 0}};
+
+    while (!stack.empty()){
+        const Pending p = stack.back();
+        stack.pop_back();
+        const size_t n = p.end - p.begin;
+
+        //the leaf completes the path with the expected depth of its remaining rows
+        auto make_leaf = [&](){
+            tree[p.node].leaf_value = static_cast<float>(p.depth + average_path_length(n));
+        };
+        if (p.depth >= depth_limit_ || n <= 1) {make_leaf(); continue;}
+
+        //only features taking at least two values in the node can isolate rows
+        std::fill(low.begin(), low.end(), std::numeric_limits<float>::infinity());
+        std::fill(high.begin(), high.end(), -std::numeric_limits<float>::infinity());
+        for (size_t i = p.begin; i < p.end; i++){
+            const float* x = samples.data() + rows[i] * nf;
+            for (size_t f = 0; f < nf; f++){
+                low[f] = std::min(low[f], x[f]);
+                high[f] = std::max(high[f], x[f]);
+            }
+        }
+        candidates.clear();
+        for (size_t f = 0; f < nf; f++){
+            if (high[f] > low[f]) candidates.push_back(static_cast<int>(f));
+        }
+        if (candidates.empty()) {make_leaf(); continue;}
+
+        std::uniform_int_distribution<size_t> pick(0, candidates.size() - 1);
+        const int feature = candidates[pick(rng)];
+        const size_t f = static_cast<size_t>(feature);
+        std::uniform_real_distribution<float> draw(low[f], high[f]);
+        float threshold = draw(rng);
+        //keeps both children non empty : the minimum always goes left
+        if (threshold <= low[f]) threshold = std::nextafter(low[f], high[f]);
+
+        auto middle = std::partition(rows.begin() + p.begin, rows.begin() + p.end,
+                                    [&](size_t row){return samples[row * nf + f] < threshold;});
+        const size_t split = static_cast<size_t>(middle - rows.begin());
+
+        const int left = tree.emplace();
+        const int right = tree.emplace();
+        Node& node = tree[p.node];
+        node.is_leaf = false;
+        node.feature_index = feature;
+        node.threshold = threshold;
+        node.left_child = left;
+        node.right_child = right;
+
+        stack.push_back({right, split, p.end, p.depth + 1});
+        stack.push_back({left, p.begin, split, p.depth + 1});
+    }
+}
+
+void IsolationForest::accumulate_paths_(std::span<const float> block, std::span<double> lengths) const {
+
+    const size_t nf = static_cast<size_t>(num_features);
+    const size_t n_block = lengths.size();
+
+    for (const NodeArena& tree : trees){
+        const std::span<const Node> nodes = tree.nodes();
+        for (size_t r = 0; r < n_block; r++){
+            const float* x = block.data() + r * nf;
+            int index = 0;
+            while (!nodes[index].is_leaf){
+                const Node& node = nodes[index];
+                index = (x[node.feature_index] >= node.threshold) ? node.right_child : node.left_child;
+            }
+            lengths[r] += nodes[index].leaf_value;
+        }
+    }
+}
+
+}
@@ -0,0 +1,135 @@
+/*
+
+                    Isolation Forest header
+
+*/
+#pragma once
+
+#include "node/node.h"
+#include "split_strategy/types/split_hyper.h"
+
+#include <cstdint>
+#include <optional>
+#include <random>
+#include <span>
+#include <vector>
+
+namespace arboria {
+
+/**
+ * @brief Isolation Forest for anomaly scoring
+ *
+ * Each tree is grown on a subsample of psi rows drawn without replacement,
+ * splitting nodes on a random feature at a threshold drawn uniformly between
+ * the minimum and maximum of the feature in the node. Growth stops at depth
+ * ceil(log2(psi)) : anomalies, isolated by few splits, have short paths.
+ *
+ * The anomaly score of a sample x is s(x) = 2^(-E[h(x)] / c(psi)) where h(x)
+ * is the path length of x in a tree, completed by c(n) for leaves holding
+ * n > 1 rows, and c(n) the average path length of an unsuccessful search in
+ * a binary search tree of n elements. Scores close to 1 flag anomalies,
+ * scores well below 0.5 normal samples.
+ *
+ * @note Nodes are stored in a NodeArena per tree with the routing rule of
+ * DecisionTree (feature >= threshold goes right). The path length completion
+ * of each leaf is precomputed in Node::leaf_value.
+ */
+class IsolationForest{
+
+    public:
+    /**
+     * @brief Constructor for the IsolationForest
+     *
+     * @param hyperParam Uses n_estimators (default 100), max_samples (fraction
+     * of the rows subsampled per tree ; default min(256, n_rows) rows),
+     * max_depth (default ceil(log2(psi))) and n_jobs. Other fields are ignored.
+     * @param seed Optional seed of the forest
+     */
+    IsolationForest(HyperParam hyperParam, std::optional<uint32_t> seed = std::nullopt);
+
+    /**
+    * @brief Fits the IsolationForest on a set of samples
+    *
+    * @param samples Non owning view over a row-major representation of
+    * the training samples
+    * @param n_features Number of features per sample
+    *
+    * @throws std::invalid_argument If samples is empty, if its size is not a
+    * multiple of n_features or if it contains NaN
+    * @note Trees are fitted in parallel ; the result does not depend on n_jobs.
+    */
+    void fit(std::span<const float> samples, int n_features);
+
+    /**
+    * @brief Computes the anomaly score of a batch of samples
+    *
+    * Samples are processed in blocks : every tree is walked for all the rows
+    * of a block before moving to the next tree, so that the nodes of a tree
+    * stay in cache. Blocks are distributed between n_jobs threads.
+    *
+    * @param samples Non owning view over a row-major representation
+    * of a set of samples, with the number of features seen in training
+    * @return A vector with the anomaly score in (0, 1] of each sample
+    *
+    * @throws std::invalid_argument If the model has not been fitted or if the
+    * input dimensions are inconsistent with the training data.
+    * @note NaN feature values are routed to the left child.
+    */
+    std::vector<float> score_samples(std::span<const float> samples) const;
+
+    /**
+    * @brief Returns the average path length of a batch of samples over the trees
+    *
+    * Same traversal and exceptions as score_samples().
+    */
+    std::vector<float> path_length(std::span<const float> samples) const;
+
+    /**
+    * @brief Flags anomalies in a batch of samples
+    *
+    * @param samples Row-major samples, as in score_samples()
+    * @param threshold Score from which a sample is flagged, in (0, 1]
+    * @return A vector with 1 for samples scoring at least threshold, 0 otherwise
+    */
+    std::vector<float> predict(std::span<const float> samples, float threshold = 0.5f) const;
+
+    //Returns whether the IsolationForest has been fitted
+    bool is_fitted() const {return fitted;}
+
+    //Returns the number of trees of the forest
+    int get_estimators() const {return n_estimators;}
+
+    //Returns the number of rows subsampled per tree
+    int subsample_size() const {return psi_;}
+
+    //Returns the depth limit of the trees
+    int get_max_depth() const {return depth_limit_;}
+
+    //Returns the total number of nodes of the forest
+    size_t n_nodes() const;
+
+    //Returns the seed of the forest
+    std::uint32_t seed() const {return seed_;}
+
+    private:
+    int n_estimators;
+    std::optional<float> max_samples;
+    std::optional<int> max_depth;
+    int n_jobs;
+
+    bool fitted = false;
+    int num_features = 0;
+    //Subsample size and depth limit of the fitted trees
+    int psi_ = 0;
+    int depth_limit_ = 0;
+    std::uint32_t seed_;
+    std::vector<NodeArena> trees;
+
+    //Grows one isolation tree on the rows of the subsample
+    void grow_(NodeArena& tree, std::span<const float> samples, std::vector<size_t> rows, std::mt19937& rng) const;
+
+    //Adds the path length of each row of a block in every tree to lengths
+    void accumulate_paths_(std::span<const float> block, std::span<double> lengths) const;
+};
+
+}
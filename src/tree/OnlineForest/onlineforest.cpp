@@ -0,0 +1,411 @@
+/*
+
+                    Online Forest implementation
+
+*/
+
+#include "onlineforest.h"
+#include "helpers/helpers.h"
+#include "helpers/parallel.h"
+#include "split_criterion/entropy.h"
+#include "split_criterion/gini.h"
+#include "split_strategy/feature_selection/randomK/randomK.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <thread>
+#include <variant>
+
+namespace arboria {
+
+OnlineForest::OnlineForest(HyperParam hyperParam, TreeType type, std::optional<std::uint32_t> user_seed, OnlineParam online)
+{
+    if (hyperParam.n_estimators.has_value()) {
+        if (*hyperParam.n_estimators <= 0) throw std::invalid_argument("arboria::OnlineForest : n_estimators argument must be greater than 0");
+        n_estimators = *hyperParam.n_estimators;
+    }
+    else n_estimators = 10;
+
+    if (hyperParam.max_depth.has_value()) {
+        if (*hyperParam.max_depth <= 0) throw std::invalid_argument("arboria::OnlineForest : max_depth argument must be greater than 0");
+        max_depth = *hyperParam.max_depth;
+    }
+
+    if (hyperParam.n_jobs.has_value()){
+        if (*hyperParam.n_jobs < -1 || *hyperParam.n_jobs == 0) throw std::invalid_argument("arboria::OnlineForest : n_jobs argument must be a positive int or equals to -1");
+        const unsigned hw = std::thread::hardware_concurrency();
+        n_jobs = (*hyperParam.n_jobs == -1) ? std::max(1, static_cast<int>(hw)) : *hyperParam.n_jobs;
+    }
+    else n_jobs = 1;
+
+    if (online.grace_period <= 0) throw std::invalid_argument("arboria::OnlineForest : grace_period must be greater than 0");
+    if (!(online.split_confidence > 0.f && online.split_confidence < 1.f)) throw std::invalid_argument("arboria::OnlineForest : split_confidence must be in (0, 1)");
+    if (!(online.tie_threshold >= 0.f)) throw std::invalid_argument("arboria::OnlineForest : tie_threshold must be greater than or equal 0");
+    if (online.n_candidates < 2) throw std::invalid_argument("arboria::OnlineForest : n_candidates must be at least 2");
+    if (online.max_nodes <= 0) throw std::invalid_argument("arboria::OnlineForest : max_nodes must be greater than 0");
+    if (online.n_classes.has_value() && *online.n_classes < 2) throw std::invalid_argument("arboria::OnlineForest : n_classes must be at least 2");
+    online_ = online;
+
+    if (!user_seed){
+        std::random_device rd;
+        seed_ = static_cast<std::uint32_t>(rd());
+    }
+    else seed_ = *user_seed;
+
+    if (std::holds_alternative<Classification>(type) || std::holds_alternative<Regression>(type)){
+        type_ = type;
+    }
+    else throw std::invalid_argument("arboria::OnlineForest : invalid type");
+}
+
+void OnlineForest::partial_fit(const DataSet& data, const SplitParam& param){
+
+    if (data.is_empty() || data.n_rows() == 0) throw std::invalid_argument("arboria::OnlineForest::partial_fit : DataSet is empty");
+    if (data.n_targets() != 1) throw std::invalid_argument("arboria::OnlineForest::partial_fit : multi-target DataSets are not supported");
+    if (fitted && data.n_cols() != num_features) throw std::invalid_argument("arboria::OnlineForest::partial_fit : DataSet passed does not have the same dimensions as the previous batches");
+
+    const bool classification = std::holds_alternative<Classification>(type_);
+    const bool valid_criterion = classification
+        ? (std::holds_alternative<Gini>(param.criterion) || std::holds_alternative<Entropy>(param.criterion))
+        : std::holds_alternative<SSE>(param.criterion);
+    if (!valid_criterion) throw std::invalid_argument("arboria::OnlineForest::partial_fit : criterion does not match the type of the forest");
+
+    const auto* rk = std::get_if<RandomK>(&param.f_selection);
+    if (!rk || !rk->mtry) throw std::invalid_argument("arboria::OnlineForest::partial_fit : f_selection must be RandomK with a defined mtry");
+    if (*rk->mtry <= 0 || *rk->mtry > data.n_cols()) throw std::invalid_argument("arboria::OnlineForest::partial_fit : mtry must be in [1, n_features]");
+
+    if (classification){
+        //validates the labels ; classes can't be added after the first batch
+        const int batch_classes = helpers::num_classes(data.y());
+        if (!fitted) n_classes_ = online_.n_classes.value_or(batch_classes);
+        if (batch_classes > n_classes_) throw std::invalid_argument("arboria::OnlineForest::partial_fit : labels must be in {0, ..., K-1}");
+    }
+
+    if (!fitted){
+        num_features = data.n_cols();
+        mtry = *rk->mtry;
+        trees.resize(static_cast<size_t>(n_estimators));
+        for (size_t t = 0; t < trees.size(); t++){
+            OnlineTree& tree = trees[t];
+            tree.rng.seed(static_cast<std::uint32_t>(helpers::derive_seed(seed_, t)));
+            tree.nodes.emplace();
+            tree.nodes[0].leaf_value = 0.f;
+            tree.depth.push_back(0);
+            tree.slot.push_back(-1);
+            init_leaf_(tree, 0, 0);
+        }
+        fitted = true;
+    }
+
+    const size_t n_rows = static_cast<size_t>(data.n_rows());
+    const size_t nf = static_cast<size_t>(num_features);
+    std::span<const float> X(data.X());
+
+    //trees only share read-only data : each one consumes the whole batch
+    //with its own Poisson(1) weights
+    helpers::parallel_for(trees.size(), static_cast<size_t>(n_jobs), [&](size_t t){
+        OnlineTree& tree = trees[t];
+        std::poisson_distribution<int> poisson(1.0);
+        //monitored values of the current sample, reused across the batch
+        std::vector<float> values;
+        values.reserve(nf);
+        for (size_t row = 0; row < n_rows; row++){
+            const int weight = poisson(tree.rng);
+            if (weight == 0) continue;
+            learn_one_(tree, X.subspan(row*nf, nf), data.iloc_y(static_cast<int>(row)), weight, param, values);
+        }
+    });
+}
+
+std::vector<float> OnlineForest::predict_proba(std::span<const float> samples) const {
+
+    if (!fitted || num_features == 0) throw std::invalid_argument("arboria::OnlineForest::predict_proba -> OnlineForest has not been fitted");
+    const size_t nf = static_cast<size_t>(num_features);
+    if (samples.size() % nf != 0) throw std::invalid_argument("arboria::OnlineForest::predict_proba -> passed samples do not have the correct dimension");
+
+    const size_t num_samples = samples.size() / nf;
+    //multiclass forests return one probability per class and per sample
+    const bool multiclass = std::holds_alternative<Classification>(type_) && n_classes_ > 2;
+    const size_t width = multiclass ? static_cast<size_t>(n_classes_) : 1;
+    std::vector<float> preds(num_samples * width, 0.f);
+
+    helpers::parallel_for(num_samples, static_cast<size_t>(n_jobs), [&](size_t i){
+        std::span<const float> sample = samples.subspan(i*nf, nf);
+        float* out = preds.data() + i*width;
+        for (const OnlineTree& tree : trees){
+            const float value = predict_tree_(tree, sample);
+            if (multiclass) out[static_cast<size_t>(value)] += 1.f;
+            else out[0] += value;
+        }
+        for (size_t k = 0; k < width; k++) out[k] /= static_cast<float>(trees.size());
+    });
+
+    return preds;
+}
+
+std::vector<float> OnlineForest::predict(std::span<const float> samples) const {
+
+    std::vector<float> prob_pred = predict_proba(samples);
+
+    if (std::holds_alternative<Regression>(type_)) return prob_pred;
+
+    if (n_classes_ > 2){
+        const size_t K = static_cast<size_t>(n_classes_);
+        std::vector<float> class_pred(prob_pred.size() / K);
+        for (size_t i = 0; i < class_pred.size(); i++){
+            size_t best = 0;
+            for (size_t k = 1; k < K; k++){
+                if (prob_pred[i*K + k] >= prob_pred[i*K + best]) best = k;
+            }
+            class_pred[i] = static_cast<float>(best);
+        }
+        return class_pred;
+    }
+
+    std::vector<float> class_pred(prob_pred.size());
+    std::transform(prob_pred.begin(), prob_pred.end(), class_pred.begin(),
+                    [](float x){return (x >= 0.5f) ? 1.f : 0.f;});
+    return class_pred;
+}
+
+size_t OnlineForest::n_nodes() const {
+    size_t total = 0;
+    for (const OnlineTree& tree : trees) total += tree.nodes.size();
+    return total;
+}
+
+/*
+--------------------------------------------------------------------------------------
+PRIVATE METHODS
+--------------------------------------------------------------------------------------
+*/
+
+void OnlineForest::init_leaf_(OnlineTree& tree, int node, int slot) const {
+
+    if (static_cast<size_t>(slot) == tree.leaves.size()) tree.leaves.emplace_back();
+    LeafStats& stats = tree.leaves[static_cast<size_t>(slot)];
+    stats = LeafStats{};
+    stats.features = feature_selection::randomK(num_features, mtry, tree.rng);
+    stats.total.assign(stats_width_(), 0.0);
+    tree.slot[static_cast<size_t>(node)] = slot;
+}
+
+void OnlineForest::learn_one_(OnlineTree& tree, std::span<const float> sample, float y, int weight, const SplitParam& param,
+                              std::vector<float>& values) const {
+
+    int node = 0;
+    while (!tree.nodes[node].is_leaf){
+        const Node& n = tree.nodes[node];
+        const float value = sample[static_cast<size_t>(n.feature_index)];
+        if (std::isnan(value)) throw std::invalid_argument("arboria::OnlineForest::partial_fit : sample contains NaN.");
+        node = (value >= n.threshold) ? n.right_child : n.left_child;
+    }
+
+    LeafStats& stats = tree.leaves[static_cast<size_t>(tree.slot[static_cast<size_t>(node)])];
+    const size_t n_monitored = stats.features.size();
+
+    values.resize(n_monitored);
+    for (size_t f = 0; f < n_monitored; f++){
+        values[f] = sample[static_cast<size_t>(stats.features[f])];
+        if (std::isnan(values[f])) throw std::invalid_argument("arboria::OnlineForest::partial_fit : sample contains NaN.");
+    }
+
+    if (std::holds_alternative<Classification>(type_)) stats.total[static_cast<size_t>(y)] += weight;
+    else {
+        stats.total[0] += weight;
+        stats.total[1] += static_cast<double>(weight) * y;
+        stats.total[2] += static_cast<double>(weight) * y * y;
+    }
+    stats.weight += weight;
+    set_leaf_value_(tree.nodes[node], stats.total);
+
+    if (stats.thresholds.empty()){
+        //buffering : the first samples of the leaf become its candidates
+        stats.buffer_x.insert(stats.buffer_x.end(), values.begin(), values.end());
+        stats.buffer_y.push_back(y);
+        stats.buffer_w.push_back(weight);
+        if (stats.buffer_y.size() < static_cast<size_t>(online_.n_candidates)) return;
+
+        const size_t C = static_cast<size_t>(online_.n_candidates);
+        stats.thresholds.assign(n_monitored * C, std::numeric_limits<float>::quiet_NaN());
+        for (size_t f = 0; f < n_monitored; f++){
+            std::vector<float> seen(C);
+            for (size_t s = 0; s < C; s++) seen[s] = stats.buffer_x[s*n_monitored + f];
+            std::sort(seen.begin(), seen.end());
+            seen.erase(std::unique(seen.begin(), seen.end()), seen.end());
+            //the smallest value would send nothing to the left
+            for (size_t c = 1; c < seen.size(); c++) stats.thresholds[f*C + c - 1] = seen[c];
+        }
+        stats.left.assign(n_monitored * C * stats_width_(), 0.0);
+
+        for (size_t s = 0; s < stats.buffer_y.size(); s++){
+            add_to_stats_(stats, std::span<const float>(stats.buffer_x).subspan(s*n_monitored, n_monitored),
+                            stats.buffer_y[s], stats.buffer_w[s]);
+        }
+        std::vector<float>().swap(stats.buffer_x);
+        std::vector<float>().swap(stats.buffer_y);
+        std::vector<int>().swap(stats.buffer_w);
+    }
+    else add_to_stats_(stats, values, y, weight);
+
+    if (stats.weight - stats.weight_at_check >= online_.grace_period) try_split_(tree, node, param);
+}
+
+void OnlineForest::add_to_stats_(LeafStats& stats, std::span<const float> values, float y, int weight) const {
+
+    const size_t C = static_cast<size_t>(online_.n_candidates);
+    const size_t W = stats_width_();
+    const bool classification = std::holds_alternative<Classification>(type_);
+
+    for (size_t f = 0; f < values.size(); f++){
+        for (size_t c = 0; c < C; c++){
+            const float threshold = stats.thresholds[f*C + c];
+            //unused candidates are NaN : the comparison fails
+            if (!(values[f] < threshold)) continue;
+            double* left = stats.left.data() + (f*C + c)*W;
+            if (classification) left[static_cast<size_t>(y)] += weight;
+            else {
+                left[0] += weight;
+                left[1] += static_cast<double>(weight) * y;
+                left[2] += static_cast<double>(weight) * y * y;
+            }
+        }
+    }
+}
+
+void OnlineForest::try_split_(OnlineTree& tree, int node, const SplitParam& param) const {
+
+    const int slot = tree.slot[static_cast<size_t>(node)];
+    LeafStats& stats = tree.leaves[static_cast<size_t>(slot)];
+    stats.weight_at_check = stats.weight;
+
+    if (max_depth.has_value() && tree.depth[static_cast<size_t>(node)] >= *max_depth) return;
+    if (tree.nodes.size() + 2 > static_cast<size_t>(online_.max_nodes)) return;
+
+    const size_t C = static_cast<size_t>(online_.n_candidates);
+    const size_t W = stats_width_();
+    const bool classification = std::holds_alternative<Classification>(type_);
+    const bool entropy = std::holds_alternative<Entropy>(param.criterion);
+
+    //classification : decrease of impurity, in [0, R] with R the maximum impurity.
+    //regression : relative decrease of the SSE, in [0, 1]
+    std::vector<int> total_counts(W), l_counts(W), r_counts(W);
+    double parent = 0.0;
+    double range = 1.0;
+    if (classification){
+        for (size_t k = 0; k < W; k++) total_counts[k] = static_cast<int>(stats.total[k]);
+        parent = entropy ? split::entropy_counts(total_counts) : split::gini_counts(total_counts);
+        if (entropy) range = std::log2(static_cast<double>(W));
+    }
+    else {
+        parent = stats.total[2] - stats.total[1] * stats.total[1] / stats.total[0];
+    }
+    if (parent <= 0.0) return;
+
+    //as in Hoeffding trees, the best candidate is compared to the best 
+    //candidate of the other features : neighbouring thresholds of a same
+    //feature have close gains and would never be separated by the bound
+    std::vector<double> feature_gain(stats.features.size(), 0.0);
+    double best_gain = 0.0;
+    size_t best = C * stats.features.size();
+
+    for (size_t fc = 0; fc < C * stats.features.size(); fc++){
+        if (std::isnan(stats.thresholds[fc])) continue;
+        const double* left = stats.left.data() + fc*W;
+        double gain = 0.0;
+        if (classification){
+            int l_size = 0;
+            int r_size = 0;
+            for (size_t k = 0; k < W; k++){
+                l_counts[k] = static_cast<int>(left[k]);
+                r_counts[k] = total_counts[k] - l_counts[k];
+                l_size += l_counts[k];
+                r_size += r_counts[k];
+            }
+            if (l_size == 0 || r_size == 0) continue;
+            gain = parent - (entropy ? split::weighted_entropy_counts(l_counts, r_counts)
+                                     : split::weighted_gini_counts(l_counts, r_counts));
+        }
+        else {
+            const double nL = left[0];
+            const double nR = stats.total[0] - left[0];
+            if (nL == 0.0 || nR == 0.0) continue;
+            const double sR = stats.total[1] - left[1];
+            const double ssR = stats.total[2] - left[2];
+            const double sse = (left[2] - left[1] * left[1] / nL) + (ssR - sR * sR / nR);
+            gain = (parent - sse) / parent;
+        }
+        feature_gain[fc / C] = std::max(feature_gain[fc / C], gain);
+        if (gain > best_gain){
+            best_gain = gain;
+            best = fc;
+        }
+    }
+    if (best == C * stats.features.size()) return;
+
+    double second_gain = 0.0;
+    for (size_t f = 0; f < feature_gain.size(); f++){
+        if (f != best / C) second_gain = std::max(second_gain, feature_gain[f]);
+    }
+
+    //Hoeffding bound : with probability 1 - delta, the best candidate on the
+    //stream is within epsilon of its observed gain
+    const double n = static_cast<double>(stats.weight);
+    const double epsilon = std::sqrt(range * range * std::log(1.0 / online_.split_confidence) / (2.0 * n));
+    if (best_gain - second_gain <= epsilon && epsilon >= online_.tie_threshold) return;
+
+    std::vector<double> left_stats(stats.left.begin() + best*W, stats.left.begin() + (best + 1)*W);
+    std::vector<double> right_stats(W);
+    for (size_t k = 0; k < W; k++) right_stats[k] = stats.total[k] - left_stats[k];
+    const int feature = stats.features[best / C];
+    const float threshold = stats.thresholds[best];
+    const int depth = tree.depth[static_cast<size_t>(node)];
+
+    const int l = tree.nodes.emplace();
+    const int r = tree.nodes.emplace();
+    tree.depth.insert(tree.depth.end(), {depth + 1, depth + 1});
+    tree.slot.insert(tree.slot.end(), {-1, -1});
+
+    Node& parent_node = tree.nodes[node];
+    parent_node.is_leaf = false;
+    parent_node.feature_index = feature;
+    parent_node.threshold = threshold;
+    parent_node.left_child = l;
+    parent_node.right_child = r;
+
+    //the left child reuses the slot of the parent : slots are bounded by the leaves
+    tree.slot[static_cast<size_t>(node)] = -1;
+    init_leaf_(tree, l, slot);
+    init_leaf_(tree, r, static_cast<int>(tree.leaves.size()));
+    set_leaf_value_(tree.nodes[l], left_stats);
+    set_leaf_value_(tree.nodes[r], right_stats);
+}
+
+void OnlineForest::set_leaf_value_(Node& node, std::span<const double> stats) const {
+
+    if (std::holds_alternative<Classification>(type_)){
+        //ties are resolved toward the highest class
+        size_t best = 0;
+        for (size_t k = 1; k < stats.size(); k++){
+            if (stats[k] >= stats[best]) best = k;
+        }
+        node.leaf_value = static_cast<float>(best);
+        return;
+    }
+    if (stats[0] > 0.0) node.leaf_value = static_cast<float>(stats[1] / stats[0]);
+}
+
+float OnlineForest::predict_tree_(const OnlineTree& tree, std::span<const float> sample) const {
+
+    const Node* node = &tree.nodes[0];
+    while (!node->is_leaf){
+        const float value = sample[static_cast<size_t>(node->feature_index)];
+        if (std::isnan(value)) throw std::invalid_argument("arboria::OnlineForest::predict -> sample contains NaN.");
+        node = (value >= node->threshold) ? &tree.nodes[node->right_child] : &tree.nodes[node->left_child];
+    }
+    return node->leaf_value;
+}
+
+}
@@ -0,0 +1,188 @@
+/*
+
+                    Online Forest header
+
+*/
+#pragma once
+
+#include "dataset/dataset.h"
+#include "node/node.h"
+#include "split_strategy/types/split_param.h"
+#include "split_strategy/types/split_hyper.h"
+
+#include <cstdint>
+#include <optional>
+#include <random>
+#include <span>
+#include <vector>
+
+namespace arboria {
+
+/**
+ * @brief Struct passing the streaming parameters of an OnlineForest
+ *
+ * @param grace_period Weighted number of samples a leaf receives between two split attempts
+ * @param split_confidence Probability delta of choosing a wrong split in the Hoeffding bound
+ * @param tie_threshold Bound under which two candidate splits are considered tied and the best is taken
+ * @param n_candidates Number of threshold candidates monitored per feature and per leaf
+ * @param max_nodes Maximum number of nodes per tree : leaves of full trees keep updating but no longer split
+ * @param n_classes Optional number of classes ; if not set, it is taken from the first batch
+ */
+struct OnlineParam {
+    int grace_period = 50;
+    float split_confidence = 0.01f;
+    float tie_threshold = 0.05f;
+    int n_candidates = 16;
+    int max_nodes = 4096;
+    std::optional<int> n_classes = std::nullopt;
+};
+
+/**
+ * @brief Split statistics of a leaf of an OnlineTree
+ *
+ * The first n_candidates weighted samples reaching the leaf are buffered ;
+ * their values become the threshold candidates of each monitored feature and
+ * are replayed into the statistics. Afterwards, each sample only updates the
+ * statistics, so that the memory of a leaf is bounded by
+ * features.size() * n_candidates * K.
+ */
+struct LeafStats {
+    //Features monitored by the leaf
+    std::vector<int> features;
+    //Buffered samples : features.size() values, target and weight per sample
+    std::vector<float> buffer_x;
+    std::vector<float> buffer_y;
+    std::vector<int> buffer_w;
+    //Threshold candidates : n_candidates per feature, NaN if unused
+    std::vector<float> thresholds;
+    //Weight sent to the left of each candidate, per class (classification)
+    //or as {weight, sum, squared sum} (regression)
+    std::vector<double> left;
+    //Same statistics for the whole leaf
+    std::vector<double> total;
+    //Weight received by the leaf, and at the last split attempt
+    int weight = 0;
+    int weight_at_check = 0;
+};
+
+/**
+ * @brief Tree grown incrementally from a stream
+ *
+ * Internal nodes and leaf values are stored in a NodeArena, with the same
+ * routing rule as DecisionTree (feature >= threshold goes right). Leaves
+ * additionally own a LeafStats slot.
+ */
+struct OnlineTree {
+    NodeArena nodes;
+    //Depth of each node
+    std::vector<int> depth;
+    //LeafStats slot of each node, -1 for internal nodes
+    std::vector<int> slot;
+    std::vector<LeafStats> leaves;
+    //RNG of the tree : Poisson weights and monitored features
+    std::mt19937 rng;
+};
+
+/**
+ * @brief Random forest learned from mini-batches
+ *
+ * Each tree sees every sample of a batch with a Poisson(1) weight (online
+ * bagging, the streaming equivalent of the bootstrap). Leaves accumulate
+ * split statistics on mtry randomly selected features and split once the
+ * Hoeffding bound guarantees that the best candidate split is, with
+ * probability 1 - split_confidence, the one that would be selected on
+ * the whole stream.
+ *
+ * @note Batches are not kept : the memory of the forest only depends on
+ * the number of nodes, bounded by OnlineParam::max_nodes per tree.
+ */
+class OnlineForest{
+
+    public:
+    //Constructor for the OnlineForest
+    OnlineForest(HyperParam hyperParam, TreeType type, std::optional<uint32_t> seed = std::nullopt, OnlineParam online = {});
+
+    /**
+    * @brief Updates the forest with a mini-batch of samples
+    *
+    * @param data DataSet containing the batch samples and target values
+    * @param param SplitParam defining the splitting policy : criterion
+    * (Gini, Entropy or SSE) and the number of features monitored per leaf
+    * (RandomK::mtry). Threshold computation is ignored.
+    *
+    * @throws std::invalid_argument If the batch does not have the number of
+    * features seen so far, for multi-target batches, or for classification
+    * labels not in {0, ..., K-1}.
+    * @note Trees are updated in parallel ; the result does not depend on n_jobs.
+    */
+    void partial_fit(const DataSet& data, const SplitParam& param);
+
+    /**
+    * @brief Predict class labels (or values for regression) for a batch of samples
+    *
+    * Same semantics as RandomForest::predict().
+    */
+    std::vector<float> predict(std::span<const float> samples) const;
+
+    /**
+    * @brief Predict class probabilities (or averaged values) for a batch of samples
+    *
+    * Same semantics and layout as RandomForest::predict_proba().
+    */
+    std::vector<float> predict_proba(std::span<const float> samples) const;
+
+    //Returns whether the forest has received at least one batch
+    bool is_fitted() const {return fitted;}
+
+    //Returns the number of classes (0 for regression)
+    int n_classes() const {return n_classes_;}
+
+    //Returns the number of trees of the forest
+    int get_estimators() const {return n_estimators;}
+
+    //Returns the total number of nodes of the forest
+    size_t n_nodes() const;
+
+    //Returns the seed of the forest
+    std::uint32_t seed() const {return seed_;}
+
+    TreeType type_;
+
+    private:
+    int mtry;
+    int n_estimators;
+    std::optional<int> max_depth;
+    int n_jobs;
+    OnlineParam online_;
+
+    bool fitted = false;
+    int num_features = 0;
+    int n_classes_ = 0;
+    std::uint32_t seed_;
+    std::vector<OnlineTree> trees;
+
+    //Width of the statistics of a leaf : K classes or {weight, sum, squared sum}
+    size_t stats_width_() const {return std::holds_alternative<Classification>(type_) ? static_cast<size_t>(n_classes_) : 3;}
+
+    //Creates a leaf with fresh statistics at node, monitoring random features
+    void init_leaf_(OnlineTree& tree, int node, int slot) const;
+
+    //Routes one weighted sample to its leaf and updates the statistics ; values
+    //is a scratch buffer of the caller, receiving the monitored features of the sample
+    void learn_one_(OnlineTree& tree, std::span<const float> sample, float y, int weight, const SplitParam& param,
+                    std::vector<float>& values) const;
+
+    //Adds a weighted sample to the statistics of a leaf whose candidates are set
+    void add_to_stats_(LeafStats& stats, std::span<const float> values, float y, int weight) const;
+
+    //Attempts to split a leaf following the Hoeffding bound
+    void try_split_(OnlineTree& tree, int node, const SplitParam& param) const;
+
+    //Refreshes the value of a leaf from its statistics
+    void set_leaf_value_(Node& node, std::span<const double> stats) const;
+
+    //Returns the leaf value of the sample in a tree
+    float predict_tree_(const OnlineTree& tree, std::span<const float> sample) const;
+};
+
+}
@@ -0,0 +1,142 @@
+/*
+
+                    Implicit-index forest implementation
+
+*/
+
+#include "implicitforest.h"
+#include "helpers/parallel.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+namespace arboria {
+
+ImplicitForest::ImplicitForest(const std::vector<const DecisionTree*>& trees, int num_features, int n_votes){
+
+    if (num_features <= 0) throw std::invalid_argument("arboria::ImplicitForest -> num_features must be greater than 0");
+    if (n_votes < 0) throw std::invalid_argument("arboria::ImplicitForest -> n_votes must be greater than or equal 0");
+    num_features_ = static_cast<size_t>(num_features);
+    width_ = (n_votes > 0) ? static_cast<size_t>(n_votes) : (trees.empty() ? 1 : static_cast<size_t>(trees.front()->n_outputs()));
+
+    size_t n_nodes = 0;
+    size_t n_leaves = 0;
+    for (const DecisionTree* tree : trees){
+        if (!tree->is_fitted()) throw std::invalid_argument("arboria::ImplicitForest -> tree has not been fitted");
+        if (tree->num_features != num_features) throw std::invalid_argument("arboria::ImplicitForest -> trees were fitted on another number of features");
+        if (n_votes == 0 && static_cast<size_t>(tree->n_outputs()) != width_) throw std::invalid_argument("arboria::ImplicitForest -> trees have different numbers of outputs");
+        const int depth = tree->depth();
+        if (depth > MAX_DEPTH) throw std::invalid_argument("arboria::ImplicitForest -> trees are deeper than 12 levels");
+        depths_.push_back(depth);
+        node_offset_.push_back(n_nodes);
+        leaf_offset_.push_back(n_leaves);
+        n_nodes += (size_t{1} << depth) - 1;
+        n_leaves += size_t{1} << depth;
+    }
+
+    features_.assign(n_nodes, 0);
+    thresholds_.assign(n_nodes, std::numeric_limits<float>::quiet_NaN());
+    leaf_outputs_.assign(n_leaves * width_, 0.f);
+    for (size_t t = 0; t < trees.size(); t++) layout_(*trees[t], t, 0, 0, 0, n_votes);
+
+    std::vector<bool> used(num_features_, false);
+    for (size_t i = 0; i < n_nodes; i++){
+        if (!std::isnan(thresholds_[i])) used[static_cast<size_t>(features_[i])] = true;
+    }
+    for (size_t f = 0; f < num_features_; f++){
+        if (used[f]) used_features_.push_back(static_cast<std::int32_t>(f));
+    }
+}
+
+bool ImplicitForest::supports(const std::vector<const DecisionTree*>& trees){
+    return std::all_of(trees.begin(), trees.end(), [](const DecisionTree* tree){
+        return tree->is_fitted() && tree->depth() <= MAX_DEPTH;
+    });
+}
+
+std::vector<float> ImplicitForest::sum_outputs(std::span<const float> samples, size_t n_jobs) const{
+
+    if (samples.size() % num_features_ != 0) throw std::invalid_argument("arboria::ImplicitForest::sum_outputs -> passed samples do not have the correct dimension");
+    const size_t num_samples = samples.size() / num_features_;
+    std::vector<float> out(num_samples * width_, 0.f);
+
+    //padding nodes send NaN to the left : NaN is rejected before any traversal
+    for (size_t s = 0; s < num_samples; s++){
+        for (std::int32_t f : used_features_){
+            if (std::isnan(samples[s * num_features_ + static_cast<size_t>(f)])) throw std::invalid_argument("arboria::ImplicitForest::sum_outputs -> sample contains NaN.");
+        }
+    }
+
+    constexpr size_t tile = 64;
+    const size_t n_tiles = (num_samples + tile - 1) / tile;
+    helpers::parallel_for(n_tiles, n_jobs, [&](size_t b){
+        const size_t first = b * tile;
+        const size_t n = std::min(tile, num_samples - first);
+        const float* x = samples.data() + first * num_features_;
+        std::uint32_t position[tile];
+
+        for (size_t t = 0; t < depths_.size(); t++){
+            const std::int32_t* features = features_.data() + node_offset_[t];
+            const float* thresholds = thresholds_.data() + node_offset_[t];
+
+            //every sample of the tile takes exactly depth steps
+            std::fill(position, position + n, 0u);
+            for (int level = 0; level < depths_[t]; level++){
+                for (size_t s = 0; s < n; s++){
+                    const std::uint32_t i = position[s];
+                    const float value = x[s * num_features_ + static_cast<size_t>(features[i])];
+                    position[s] = 2 * i + 1 + static_cast<std::uint32_t>(value >= thresholds[i]);
+                }
+            }
+
+            const std::uint32_t first_leaf = (std::uint32_t{1} << depths_[t]) - 1;
+            for (size_t s = 0; s < n; s++){
+                const float* values = leaf_outputs_.data() + (leaf_offset_[t] + position[s] - first_leaf) * width_;
+                float* outputs = out.data() + (first + s) * width_;
+                for (size_t k = 0; k < width_; k++) outputs[k] += values[k];
+            }
+        }
+    });
+    return out;
+}
+
+/*
+--------------------------------------------------------------------------------------
+PRIVATE METHODS
+--------------------------------------------------------------------------------------
+*/
+
+void ImplicitForest::layout_(const DecisionTree& tree, size_t t, int node, size_t position, int level, int n_votes){
+
+    const Node& original = tree.nodes()[static_cast<size_t>(node)];
+    const int depth = depths_[t];
+
+    if (level == depth){
+        float* values = leaf_outputs_.data() + (leaf_offset_[t] + position - ((size_t{1} << depth) - 1)) * width_;
+        const std::span<const float> outputs = tree.leaf_outputs(node);
+        if (n_votes == 0) {
+            std::copy(outputs.begin(), outputs.end(), values);
+            return;
+        }
+        //one vote for the class of the leaf
+        const size_t k = static_cast<size_t>(outputs[0]);
+        if (k >= width_) throw std::invalid_argument("arboria::ImplicitForest -> leaf class out of range");
+        values[k] = 1.f;
+        return;
+    }
+
+    //a leaf above the last level is padded : its NaN threshold sends every sample left
+    if (original.is_leaf){
+        layout_(tree, t, node, 2 * position + 1, level + 1, n_votes);
+        layout_(tree, t, node, 2 * position + 2, level + 1, n_votes);
+        return;
+    }
+    features_[node_offset_[t] + position] = original.feature_index;
+    thresholds_[node_offset_[t] + position] = original.threshold;
+    layout_(tree, t, original.left_child, 2 * position + 1, level + 1, n_votes);
+    layout_(tree, t, original.right_child, 2 * position + 2, level + 1, n_votes);
+}
+
+}
@@ -0,0 +1,102 @@
+/*
+
+                    Implicit-index forest header
+
+*/
+#pragma once
+
+#include "tree/DecisionTree/DecisionTree.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace arboria {
+
+/**
+ * @brief Forest of depth-bounded trees stored as complete binary trees
+ *
+ * Each tree of depth d is laid out breadth-first in 2^d - 1 internal nodes,
+ * the children of node i being 2i+1 and 2i+2, followed by its 2^d leaves.
+ * Leaves of the original tree above depth d are padded with nodes sending every
+ * sample to the left (a NaN threshold), down to copies of the leaf. Nodes only
+ * hold a feature and a threshold : a sample reaches its leaf in exactly d steps,
+ * i = 2i + 1 + (x[feature[i]] >= threshold[i]), without child pointers.
+ *
+ * Samples are scored in tiles : the tile advances one level at a time through
+ * a tree, in a fixed-trip-count loop over samples the compiler can unroll.
+ *
+ * @note Trees are limited to MAX_DEPTH levels : padding doubles the nodes of
+ * every missing level.
+ * @note Predictions are identical to the ones of DecisionTree::predict_outputs_one().
+ */
+class ImplicitForest {
+
+    public:
+    //Maximum depth of a tree : 2^12 leaves per tree
+    static constexpr int MAX_DEPTH = 12;
+
+    /**
+     * @brief Lays out the trees of a forest breadth-first
+     *
+     * @param trees Fitted trees of the forest, in the order their outputs are summed
+     * @param num_features Number of features of the samples
+     * @param n_votes For multiclass forests, the number of classes K : the leaves
+     * of the trees vote for their class. 0 to sum the outputs of the leaves.
+     * @throws std::invalid_argument if a tree has not been fitted or is deeper than MAX_DEPTH
+     */
+    ImplicitForest(const std::vector<const DecisionTree*>& trees, int num_features, int n_votes = 0);
+
+    //Returns whether every tree is fitted and at most MAX_DEPTH deep
+    static bool supports(const std::vector<const DecisionTree*>& trees);
+
+    /**
+     * @brief Sums the outputs of every tree for a batch of samples
+     *
+     * @param samples Row-major samples, with num_features features
+     * @param n_jobs Number of threads scoring tiles of samples
+     * @return A row-major vector of size num_samples * width() : the sum over
+     * the trees of the leaf outputs (or of the class votes)
+     * @throws std::invalid_argument if samples dimensions are incompatible, or if
+     * a sample contains NaN on a feature used by the forest
+     */
+    std::vector<float> sum_outputs(std::span<const float> samples, size_t n_jobs = 1) const;
+
+    //Number of values summed per sample : K votes or T outputs
+    size_t width() const {return width_;}
+
+    //Number of trees of the forest
+    size_t n_trees() const {return depths_.size();}
+
+    private:
+    size_t num_features_;
+    size_t width_ = 1;
+
+    //Depth of each tree, and offset of its first internal node and first leaf
+    std::vector<int> depths_;
+    std::vector<size_t> node_offset_;
+    std::vector<size_t> leaf_offset_;
+
+    //Internal nodes of every tree, breadth-first
+    std::vector<std::int32_t> features_;
+    std::vector<float> thresholds_;
+    //width_ values per leaf
+    std::vector<float> leaf_outputs_;
+    //Features tested by at least one node, checked for NaN
+    std::vector<std::int32_t> used_features_;
+
+    /**
+     * @brief Copies the subtree of an original node to a position of the layout
+     *
+     * @param tree The original tree
+     * @param t Index of the tree in the forest
+     * @param node Node of the original tree
+     * @param position Breadth-first position of the node in the layout
+     * @param level Depth of the position
+     * @param n_votes See the constructor
+     */
+    void layout_(const DecisionTree& tree, size_t t, int node, size_t position, int level, int n_votes);
+};
+
+}
@@ -0,0 +1,283 @@
+/*
+
+                    Native forest implementation
+
+*/
+
+#include "nativeforest.h"
+#include "helpers/parallel.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <stdexcept>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <dlfcn.h>
+#include <unistd.h>
+#define ARBORIA_HAS_DLOPEN 1
+#endif
+
+namespace arboria {
+
+namespace {
+
+//Exact C++ literal of a float
+std::string literal(float value){
+    if (std::isnan(value)) return "__builtin_nanf(\"\")";
+    if (std::isinf(value)) return (value > 0) ? "__builtin_inff()" : "(-__builtin_inff())";
+    char buffer[64];
+    std::snprintf(buffer, sizeof(buffer), "%af", static_cast<double>(value));
+    return buffer;
+}
+
+//Quotes an argument of a shell command
+std::string quote(const std::string& arg){
+    std::string quoted = "'";
+    for (char c : arg){
+        if (c == '\'') quoted += "'\\''";
+        else quoted += c;
+    }
+    return quoted + "'";
+}
+
+//FNV-1a hash of the generated source
+std::uint64_t hash(const std::string& text){
+    std::uint64_t h = 0xcbf29ce484222325ULL;
+    for (char c : text){
+        h ^= static_cast<unsigned char>(c);
+        h *= 0x100000001b3ULL;
+    }
+    return h;
+}
+
+/**
+ * @brief Writes the nested if statements of a subtree
+ *
+ * @param tree The tree
+ * @param node Root of the subtree
+ * @param level Indentation level
+ * @param n_votes See NativeForest::source()
+ * @param used Output : features tested by a node
+ * @param code Output : the generated statements
+ */
+void emit_node(const DecisionTree& tree, int node, int level, int n_votes, std::vector<bool>& used, std::string& code){
+
+    const std::string indent(static_cast<size_t>(4 * level), ' ');
+    const Node& n = tree.nodes()[static_cast<size_t>(node)];
+
+    if (n.is_leaf){
+        const std::span<const float> outputs = tree.leaf_outputs(node);
+        if (n_votes == 0){
+            for (size_t k = 0; k < outputs.size(); k++){
+                code += indent + "out[" + std::to_string(k) + "] += " + literal(outputs[k]) + ";\n";
+            }
+            return;
+        }
+        //one vote for the class of the leaf
+        const size_t k = static_cast<size_t>(outputs[0]);
+        if (k >= static_cast<size_t>(n_votes)) throw std::invalid_argument("arboria::NativeForest::source -> leaf class out of range");
+        code += indent + "out[" + std::to_string(k) + "] += 1.0f;\n";
+        return;
+    }
+
+    used[static_cast<size_t>(n.feature_index)] = true;
+    code += indent + "if (x[" + std::to_string(n.feature_index) + "] >= " + literal(n.threshold) + ") {\n";
+    emit_node(tree, n.right_child, level + 1, n_votes, used, code);
+    code += indent + "} else {\n";
+    emit_node(tree, n.left_child, level + 1, n_votes, used, code);
+    code += indent + "}\n";
+}
+
+/**
+ * @brief Generates the source of a forest, without its fingerprint
+ *
+ * @see NativeForest::source()
+ */
+std::string body(const std::vector<const DecisionTree*>& trees, int num_features, int n_votes){
+
+    if (num_features <= 0) throw std::invalid_argument("arboria::NativeForest::source -> num_features must be greater than 0");
+    if (n_votes < 0) throw std::invalid_argument("arboria::NativeForest::source -> n_votes must be greater than or equal 0");
+    const size_t width = (n_votes > 0) ? static_cast<size_t>(n_votes) : (trees.empty() ? 1 : static_cast<size_t>(trees.front()->n_outputs()));
+
+    std::vector<bool> used(static_cast<size_t>(num_features), false);
+    std::string code = "// Generated by arboria : " + std::to_string(trees.size()) + " trees, " + std::to_string(num_features) +
+                       " features, " + std::to_string(width) + " values summed per sample\n\n";
+
+    for (size_t t = 0; t < trees.size(); t++){
+        const DecisionTree& tree = *trees[t];
+        if (!tree.is_fitted()) throw std::invalid_argument("arboria::NativeForest::source -> tree has not been fitted");
+        if (tree.num_features != num_features) throw std::invalid_argument("arboria::NativeForest::source -> trees were fitted on another number of features");
+        if (n_votes == 0 && static_cast<size_t>(tree.n_outputs()) != width) throw std::invalid_argument("arboria::NativeForest::source -> trees have different numbers of outputs");
+        code += "static void tree_" + std::to_string(t) + "(const float* x, float* out) {\n";
+        emit_node(tree, 0, 1, n_votes, used, code);
+        code += "}\n\n";
+    }
+
+    code += "extern \"C\" long long arboria_sum_outputs(const float* samples, unsigned long long first, unsigned long long last, float* out) {\n";
+    code += "    for (unsigned long long s = first; s < last; s++) {\n";
+    code += "        const float* x = samples + s * " + std::to_string(num_features) + "ULL;\n";
+    //NaN would silently go left : it is rejected as in the traversal of the trees
+    std::string nan_check;
+    for (size_t f = 0; f < used.size(); f++){
+        if (!used[f]) continue;
+        if (!nan_check.empty()) nan_check += " || ";
+        nan_check += "x[" + std::to_string(f) + "] != x[" + std::to_string(f) + "]";
+    }
+    if (!nan_check.empty()) code += "        if (" + nan_check + ") return static_cast<long long>(s);\n";
+    code += "        float* o = out + s * " + std::to_string(width) + "ULL;\n";
+    for (size_t t = 0; t < trees.size(); t++) code += "        tree_" + std::to_string(t) + "(x, o);\n";
+    code += "    }\n    return -1;\n}\n\n";
+
+    code += "extern \"C\" const int arboria_native_version = " + std::to_string(NativeForest::VERSION) + ";\n";
+    code += "extern \"C\" const int arboria_num_features = " + std::to_string(num_features) + ";\n";
+    code += "extern \"C\" const unsigned long long arboria_width = " + std::to_string(width) + "ULL;\n";
+    code += "extern \"C\" const unsigned long long arboria_n_trees = " + std::to_string(trees.size()) + "ULL;\n";
+    return code;
+}
+
+}
+
+std::string NativeForest::source(const std::vector<const DecisionTree*>& trees, int num_features, int n_votes){
+    std::string code = body(trees, num_features, n_votes);
+    const std::uint64_t h = hash(code);
+    code += "extern \"C\" const unsigned long long arboria_fingerprint = " + std::to_string(h) + "ULL;\n";
+    return code;
+}
+
+std::uint64_t NativeForest::fingerprint(const std::vector<const DecisionTree*>& trees, int num_features, int n_votes){
+    return hash(body(trees, num_features, n_votes));
+}
+
+#ifdef ARBORIA_HAS_DLOPEN
+
+void NativeForest::compile(const std::string& source, const std::string& path){
+
+    //the source and the library are built under unique names next to their
+    //destination then renamed, so that concurrent compiles to one path don't mix
+    std::string source_tmp = path + ".XXXXXX.cpp";
+    std::string tmp = path + ".XXXXXX";
+    const int source_fd = ::mkstemps(source_tmp.data(), 4);
+    if (source_fd < 0) throw std::runtime_error("arboria::NativeForest::compile -> can't create a source next to " + path);
+    ::close(source_fd);
+    {
+        std::ofstream file(source_tmp, std::ios::trunc);
+        file << source;
+        file.close();
+        if (!file) {
+            std::remove(source_tmp.c_str());
+            throw std::runtime_error("arboria::NativeForest::compile -> can't write " + source_tmp);
+        }
+    }
+    const int fd = ::mkstemp(tmp.data());
+    if (fd < 0) {
+        std::remove(source_tmp.c_str());
+        throw std::runtime_error("arboria::NativeForest::compile -> can't create a library next to " + path);
+    }
+    ::close(fd);
+
+    const char* cxx = std::getenv("ARBORIA_CXX");
+    if (!cxx || !*cxx) cxx = std::getenv("CXX");
+    if (!cxx || !*cxx) cxx = "c++";
+
+    const std::string command = std::string(cxx) + " -x c++ -O2 -fPIC -shared -ffp-contract=off -o " + quote(tmp) + " " + quote(source_tmp) + " 2>&1";
+    std::FILE* pipe = popen(command.c_str(), "r");
+    if (!pipe) {
+        std::remove(source_tmp.c_str());
+        std::remove(tmp.c_str());
+        throw std::runtime_error("arboria::NativeForest::compile -> can't run " + command);
+    }
+    std::string output;
+    char buffer[256];
+    while (std::fgets(buffer, sizeof(buffer), pipe)) {
+        if (output.size() < 4096) output += buffer;
+    }
+    if (pclose(pipe) != 0) {
+        std::remove(source_tmp.c_str());
+        std::remove(tmp.c_str());
+        throw std::runtime_error("arboria::NativeForest::compile -> compilation failed : " + command + "\n" + output);
+    }
+    const std::string source_path = path + ".cpp";
+    if (std::rename(source_tmp.c_str(), source_path.c_str()) != 0) {
+        std::remove(source_tmp.c_str());
+        std::remove(tmp.c_str());
+        throw std::runtime_error("arboria::NativeForest::compile -> can't replace " + source_path);
+    }
+    if (std::rename(tmp.c_str(), path.c_str()) != 0) {
+        std::remove(tmp.c_str());
+        throw std::runtime_error("arboria::NativeForest::compile -> can't replace " + path);
+    }
+}
+
+NativeForest::NativeForest(const std::string& path){
+
+    handle_ = dlopen(path.c_str(), RTLD_NOW | RTLD_LOCAL);
+    if (!handle_) {
+        const char* error = dlerror();
+        throw std::runtime_error("arboria::NativeForest -> can't load " + path + " : " + (error ? error : "unknown error"));
+    }
+
+    auto symbol = [&](const char* name){
+        void* address = dlsym(handle_, name);
+        if (!address) {
+            dlclose(handle_);
+            throw std::runtime_error("arboria::NativeForest -> " + path + " does not export " + name);
+        }
+        return address;
+    };
+    const int version = *static_cast<const int*>(symbol("arboria_native_version"));
+    if (version != VERSION) {
+        dlclose(handle_);
+        throw std::runtime_error("arboria::NativeForest -> " + path + " was compiled for another version of the interface");
+    }
+    num_features_ = *static_cast<const int*>(symbol("arboria_num_features"));
+    width_ = static_cast<size_t>(*static_cast<const unsigned long long*>(symbol("arboria_width")));
+    n_trees_ = static_cast<size_t>(*static_cast<const unsigned long long*>(symbol("arboria_n_trees")));
+    fingerprint_ = static_cast<std::uint64_t>(*static_cast<const unsigned long long*>(symbol("arboria_fingerprint")));
+    sum_ = reinterpret_cast<SumOutputs>(symbol("arboria_sum_outputs"));
+}
+
+NativeForest::~NativeForest(){
+    if (handle_) dlclose(handle_);
+}
+
+#else
+
+void NativeForest::compile(const std::string& source, const std::string& path){
+    throw std::runtime_error("arboria::NativeForest::compile -> compiling " + path + " requires popen and dlopen, not available on this platform");
+}
+
+NativeForest::NativeForest(const std::string& path){
+    throw std::runtime_error("arboria::NativeForest -> loading " + path + " requires dlopen, not available on this platform");
+}
+
+NativeForest::~NativeForest() = default;
+
+#endif
+
+std::vector<float> NativeForest::sum_outputs(std::span<const float> samples, size_t n_jobs) const{
+
+    const size_t nf = static_cast<size_t>(num_features_);
+    if (samples.size() % nf != 0) throw std::invalid_argument("arboria::NativeForest::sum_outputs -> passed samples do not have the correct dimension");
+    const size_t num_samples = samples.size() / nf;
+    std::vector<float> out(num_samples * width_, 0.f);
+
+    constexpr size_t tile = 64;
+    const size_t n_tiles = (num_samples + tile - 1) / tile;
+    helpers::parallel_for(n_tiles, n_jobs, [&](size_t b){
+        const size_t first = b * tile;
+        const size_t last = std::min(num_samples, first + tile);
+        if (sum_(samples.data(), first, last, out.data()) >= 0) {
+            throw std::invalid_argument("arboria::NativeForest::sum_outputs -> sample contains NaN.");
+        }
+    });
+    return out;
+}
+
+void NativeForest::sum_outputs_one(const float* sample, float* out) const{
+    if (sum_(sample, 0, 1, out) >= 0) throw std::invalid_argument("arboria::NativeForest::sum_outputs_one -> sample contains NaN.");
+}
+
+}
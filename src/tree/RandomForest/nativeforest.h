@@ -0,0 +1,133 @@
+/*
+
+                    Native forest header
+
+*/
+#pragma once
+
+#include "tree/DecisionTree/DecisionTree.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace arboria {
+
+/**
+ * @brief Forest compiled to native code and loaded as a shared library
+ *
+ * source() generates a standalone C++ translation unit in which every tree
+ * is a function of nested if statements with constant thresholds, followed
+ * by a function summing the trees for a range of samples. compile() builds
+ * it with the system compiler into a shared library, which the constructor
+ * loads with dlopen.
+ *
+ * The library also exports the number of features, the width of the sums,
+ * the number of trees and a fingerprint of the generated source, so that a
+ * library can be checked against the forest it is used for.
+ *
+ * @note Predictions are identical to the ones of DecisionTree::predict_outputs_one() :
+ * the generated code is compiled without floating-point contractions or fast-math.
+ * @note Only available on platforms with dlopen.
+ */
+class NativeForest {
+
+    public:
+    //Version of the interface exported by the generated libraries
+    static constexpr int VERSION = 1;
+
+    /**
+     * @brief Generates the C++ source of a forest
+     *
+     * @param trees Fitted trees of the forest, in the order their outputs are summed
+     * @param num_features Number of features of the samples
+     * @param n_votes For multiclass forests, the number of classes K : the leaves
+     * of the trees vote for their class. 0 to sum the outputs of the leaves.
+     * @return A translation unit depending on no header
+     * @throws std::invalid_argument if a tree has not been fitted or was fitted on
+     * another number of features
+     */
+    static std::string source(const std::vector<const DecisionTree*>& trees, int num_features, int n_votes = 0);
+
+    //Returns the fingerprint exported by the library compiled from source(trees, num_features, n_votes)
+    static std::uint64_t fingerprint(const std::vector<const DecisionTree*>& trees, int num_features, int n_votes = 0);
+
+    /**
+     * @brief Compiles a generated source into a shared library
+     *
+     * The source is written to path + ".cpp", kept next to the library, and
+     * compiled with the compiler named by the ARBORIA_CXX or CXX environment
+     * variables (c++ by default). Both files are written under unique names next
+     * to their destination then renamed : processes which loaded the previous library
+     * are not affected, and concurrent compiles to one path don't mix their files.
+     *
+     * @param source A translation unit returned by source()
+     * @param path Path of the shared library, overwritten if it exists
+     * @throws std::runtime_error if the source can't be written or the compiler fails
+     */
+    static void compile(const std::string& source, const std::string& path);
+
+    /**
+     * @brief Loads a shared library built by compile()
+     *
+     * @param path Path of the library
+     * @throws std::runtime_error if the library can't be loaded or does not export
+     * the interface of this VERSION
+     * @note A library already loaded from the same path by this process is shared
+     * by dlopen, even if the file was replaced since : check its fingerprint().
+     */
+    explicit NativeForest(const std::string& path);
+    ~NativeForest();
+
+    NativeForest(const NativeForest&) = delete;
+    NativeForest& operator=(const NativeForest&) = delete;
+
+    /**
+     * @brief Sums the outputs of every tree for a batch of samples
+     *
+     * @param samples Row-major samples, with num_features() features
+     * @param n_jobs Number of threads scoring tiles of samples
+     * @return A row-major vector of size num_samples * width() : the sum over
+     * the trees of the leaf outputs (or of the class votes)
+     * @throws std::invalid_argument if samples dimensions are incompatible, or if
+     * a sample contains NaN on a feature used by the forest
+     */
+    std::vector<float> sum_outputs(std::span<const float> samples, size_t n_jobs = 1) const;
+
+    /**
+     * @brief Adds the outputs of every tree for a single sample, without allocating
+     *
+     * @param sample Pointer to the num_features() values of the sample
+     * @param out Pointer to width() values, to which the sums are added
+     * @throws std::invalid_argument if the sample contains NaN on a feature used by the forest
+     */
+    void sum_outputs_one(const float* sample, float* out) const;
+
+    //Number of values summed per sample : K votes or T outputs
+    size_t width() const {return width_;}
+
+    //Number of trees of the forest
+    size_t n_trees() const {return n_trees_;}
+
+    //Number of features of the samples
+    int num_features() const {return num_features_;}
+
+    //Fingerprint of the source the library was compiled from
+    std::uint64_t fingerprint() const {return fingerprint_;}
+
+    private:
+    //Sums the trees for the samples [first, last) into out ; returns the first
+    //sample containing NaN on a used feature, or -1
+    using SumOutputs = long long (*)(const float* samples, unsigned long long first, unsigned long long last, float* out);
+
+    void* handle_ = nullptr;
+    SumOutputs sum_ = nullptr;
+    int num_features_ = 0;
+    size_t width_ = 1;
+    size_t n_trees_ = 0;
+    std::uint64_t fingerprint_ = 0;
+};
+
+}
@@ -0,0 +1,191 @@
+/*
+
+                    QuickScorer implementation
+
+*/
+
+#include "quickscorer.h"
+#include "helpers/parallel.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <stdexcept>
+
+namespace arboria {
+
+namespace {
+
+//Internal node of a tree, before the nodes of the forest are sorted
+struct SortedNode {
+    int feature;
+    float threshold;
+    std::uint32_t tree;
+    //Leaves of the left subtree : [first_leaf, end_leaf)
+    size_t first_leaf;
+    size_t end_leaf;
+};
+
+/**
+ * @brief Numbers the leaves of a subtree from left to right
+ *
+ * @param nodes Nodes of the tree
+ * @param node Root of the subtree
+ * @param tree Index of the tree in the forest
+ * @param next Number of leaves numbered so far
+ * @param leaf_nodes Output : node index of each leaf, in numbering order
+ * @param sorted Output : the internal nodes of the subtree
+ * @return the end of the range of leaves of the subtree
+ */
+size_t number_leaves(std::span<const Node> nodes, int node, std::uint32_t tree, size_t& next,
+                     std::vector<int>& leaf_nodes, std::vector<SortedNode>& sorted){
+
+    if (nodes[node].is_leaf){
+        leaf_nodes.push_back(node);
+        return ++next;
+    }
+    const size_t first = next;
+    const size_t end_left = number_leaves(nodes, nodes[node].left_child, tree, next, leaf_nodes, sorted);
+    sorted.push_back(SortedNode{nodes[node].feature_index, nodes[node].threshold, tree, first, end_left});
+    return number_leaves(nodes, nodes[node].right_child, tree, next, leaf_nodes, sorted);
+}
+
+}
+
+BitvectorForest::BitvectorForest(const std::vector<const DecisionTree*>& trees, int num_features, int n_votes){
+
+    if (num_features <= 0) throw std::invalid_argument("arboria::BitvectorForest -> num_features must be greater than 0");
+    if (n_votes < 0) throw std::invalid_argument("arboria::BitvectorForest -> n_votes must be greater than or equal 0");
+    num_features_ = static_cast<size_t>(num_features);
+    n_trees_ = trees.size();
+
+    size_t max_leaves = 1;
+    for (const DecisionTree* tree : trees){
+        if (!tree->is_fitted()) throw std::invalid_argument("arboria::BitvectorForest -> tree has not been fitted");
+        if (tree->num_features != num_features) throw std::invalid_argument("arboria::BitvectorForest -> trees were fitted on another number of features");
+        const size_t n_leaves = tree->n_leaves();
+        if (n_leaves > MAX_LEAVES) throw std::invalid_argument("arboria::BitvectorForest -> trees have more than 256 leaves");
+        max_leaves = std::max(max_leaves, n_leaves);
+    }
+    n_words_ = (max_leaves + 63) / 64;
+    width_ = (n_votes > 0) ? static_cast<size_t>(n_votes) : (trees.empty() ? 1 : static_cast<size_t>(trees.front()->n_outputs()));
+
+    std::vector<SortedNode> sorted;
+    leaf_offset_.reserve(n_trees_ + 1);
+    leaf_offset_.push_back(0);
+    for (size_t t = 0; t < n_trees_; t++){
+        const DecisionTree& tree = *trees[t];
+        if (n_votes == 0 && static_cast<size_t>(tree.n_outputs()) != width_) throw std::invalid_argument("arboria::BitvectorForest -> trees have different numbers of outputs");
+
+        std::vector<int> leaf_nodes;
+        size_t next = 0;
+        number_leaves(tree.nodes(), 0, static_cast<std::uint32_t>(t), next, leaf_nodes, sorted);
+
+        for (int leaf : leaf_nodes){
+            const std::span<const float> outputs = tree.leaf_outputs(leaf);
+            if (n_votes == 0){
+                leaf_outputs_.insert(leaf_outputs_.end(), outputs.begin(), outputs.end());
+                continue;
+            }
+            //one vote for the class of the leaf
+            const size_t k = static_cast<size_t>(outputs[0]);
+            if (k >= width_) throw std::invalid_argument("arboria::BitvectorForest -> leaf class out of range");
+            std::vector<float> votes(width_, 0.f);
+            votes[k] = 1.f;
+            leaf_outputs_.insert(leaf_outputs_.end(), votes.begin(), votes.end());
+        }
+        leaf_offset_.push_back(leaf_offset_.back() + leaf_nodes.size());
+    }
+
+    std::stable_sort(sorted.begin(), sorted.end(), [](const SortedNode& a, const SortedNode& b){
+        return (a.feature != b.feature) ? a.feature < b.feature : a.threshold < b.threshold;
+    });
+
+    feature_offset_.assign(num_features_ + 1, 0);
+    thresholds_.reserve(sorted.size());
+    node_tree_.reserve(sorted.size());
+    masks_.assign(sorted.size() * n_words_, ~std::uint64_t{0});
+    for (size_t j = 0; j < sorted.size(); j++){
+        const SortedNode& node = sorted[j];
+        feature_offset_[static_cast<size_t>(node.feature) + 1]++;
+        thresholds_.push_back(node.threshold);
+        node_tree_.push_back(node.tree);
+        std::uint64_t* mask = masks_.data() + j * n_words_;
+        for (size_t leaf = node.first_leaf; leaf < node.end_leaf; leaf++){
+            mask[leaf / 64] &= ~(std::uint64_t{1} << (leaf % 64));
+        }
+    }
+    for (size_t f = 0; f < num_features_; f++) feature_offset_[f + 1] += feature_offset_[f];
+}
+
+bool BitvectorForest::supports(const std::vector<const DecisionTree*>& trees){
+    return std::all_of(trees.begin(), trees.end(), [](const DecisionTree* tree){
+        return tree->is_fitted() && tree->n_leaves() <= MAX_LEAVES;
+    });
+}
+
+std::vector<float> BitvectorForest::sum_outputs(std::span<const float> samples, size_t n_jobs) const{
+
+    if (samples.size() % num_features_ != 0) throw std::invalid_argument("arboria::BitvectorForest::sum_outputs -> passed samples do not have the correct dimension");
+    const size_t num_samples = samples.size() / num_features_;
+    std::vector<float> out(num_samples * width_, 0.f);
+
+    //a block shares one scratch bitvector per tree
+    constexpr size_t block = 64;
+    const size_t n_blocks = (num_samples + block - 1) / block;
+    helpers::parallel_for(n_blocks, n_jobs, [&](size_t b){
+        const size_t first = b * block;
+        const size_t last = std::min(num_samples, first + block);
+        std::vector<std::uint64_t> bitvectors(n_trees_ * n_words_);
+        switch (n_words_){
+            case 1: score_<1>(samples, first, last, bitvectors, out); break;
+            case 2: score_<2>(samples, first, last, bitvectors, out); break;
+            case 3: score_<3>(samples, first, last, bitvectors, out); break;
+            default: score_<4>(samples, first, last, bitvectors, out); break;
+        }
+    });
+    return out;
+}
+
+/*
+--------------------------------------------------------------------------------------
+PRIVATE METHODS
+--------------------------------------------------------------------------------------
+*/
+
+template <size_t W>
+void BitvectorForest::score_(std::span<const float> samples, size_t first, size_t last,
+                             std::vector<std::uint64_t>& bitvectors, std::span<float> out) const{
+
+    for (size_t s = first; s < last; s++){
+        const float* sample = samples.data() + s * num_features_;
+        std::fill(bitvectors.begin(), bitvectors.end(), ~std::uint64_t{0});
+
+        for (size_t f = 0; f < num_features_; f++){
+            size_t j = feature_offset_[f];
+            const size_t end = feature_offset_[f + 1];
+            if (j == end) continue;
+            const float value = sample[f];
+            if (std::isnan(value)) throw std::invalid_argument("arboria::BitvectorForest::sum_outputs -> sample contains NaN.");
+            //nodes sending the sample right clear the leaves of their left subtree
+            for (; j < end && thresholds_[j] <= value; j++){
+                std::uint64_t* bitvector = bitvectors.data() + node_tree_[j] * W;
+                const std::uint64_t* mask = masks_.data() + j * W;
+                for (size_t w = 0; w < W; w++) bitvector[w] &= mask[w];
+            }
+        }
+
+        //the leaf reached is the first bit left set ; trees are summed in order
+        float* outputs = out.data() + s * width_;
+        for (size_t t = 0; t < n_trees_; t++){
+            const std::uint64_t* bitvector = bitvectors.data() + t * W;
+            size_t w = 0;
+            while (w + 1 < W && bitvector[w] == 0) w++;
+            const size_t leaf = w * 64 + static_cast<size_t>(std::countr_zero(bitvector[w]));
+            const float* values = leaf_outputs_.data() + (leaf_offset_[t] + leaf) * width_;
+            for (size_t k = 0; k < width_; k++) outputs[k] += values[k];
+        }
+    }
+}
+
+}
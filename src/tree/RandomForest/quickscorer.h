@@ -0,0 +1,110 @@
+/*
+
+                    QuickScorer header
+
+*/
+#pragma once
+
+#include "tree/DecisionTree/DecisionTree.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace arboria {
+
+/**
+ * @brief Bitvector evaluation of a forest of small trees (QuickScorer)
+ *
+ * The leaves of each tree are numbered from left to right, and every internal
+ * node is stored with a mask clearing the leaves of its left subtree. Nodes are
+ * grouped by feature and sorted by threshold : the nodes sending a sample to the
+ * right (x >= threshold) are a prefix of the thresholds of their feature.
+ *
+ * A sample starts with every leaf bit set. The prefix of each feature is scanned
+ * and the mask of each node is AND-ed into the bitvector of its tree ; the leaf
+ * reached in a tree is then its first bit still set. The walk from the root is
+ * replaced by a linear scan and bitwise work, without data-dependent branches
+ * between nodes.
+ *
+ * @note Trees are limited to MAX_LEAVES leaves, i.e. a max_depth of 8.
+ * @note Predictions are identical to the ones of DecisionTree::predict_outputs_one().
+ */
+class BitvectorForest {
+
+    public:
+    //Maximum number of leaves per tree : bitvectors hold up to 4 64-bit words
+    static constexpr size_t MAX_LEAVES = 256;
+
+    /**
+     * @brief Builds the sorted nodes and leaf outputs of a forest
+     *
+     * @param trees Fitted trees of the forest, in the order their outputs are summed
+     * @param num_features Number of features of the samples
+     * @param n_votes For multiclass forests, the number of classes K : the leaves
+     * of the trees vote for their class. 0 to sum the outputs of the leaves.
+     * @throws std::invalid_argument if a tree has not been fitted or has more
+     * than MAX_LEAVES leaves
+     */
+    BitvectorForest(const std::vector<const DecisionTree*>& trees, int num_features, int n_votes = 0);
+
+    //Returns whether every tree has at most MAX_LEAVES leaves
+    static bool supports(const std::vector<const DecisionTree*>& trees);
+
+    /**
+     * @brief Sums the outputs of every tree for a batch of samples
+     *
+     * @param samples Row-major samples, with num_features features
+     * @param n_jobs Number of threads scoring blocks of samples
+     * @return A row-major vector of size num_samples * width() : the sum over
+     * the trees of the leaf outputs (or of the class votes)
+     * @throws std::invalid_argument if samples dimensions are incompatible, or if
+     * a sample contains NaN on a feature used by the forest
+     */
+    std::vector<float> sum_outputs(std::span<const float> samples, size_t n_jobs = 1) const;
+
+    //Number of values summed per sample : K votes or T outputs
+    size_t width() const {return width_;}
+
+    //Number of trees of the forest
+    size_t n_trees() const {return n_trees_;}
+
+    //Number of 64-bit words of the bitvector of each tree
+    size_t n_words() const {return n_words_;}
+
+    private:
+    size_t num_features_;
+    size_t n_trees_ = 0;
+    size_t width_ = 1;
+    //Number of 64-bit words of each bitvector
+    size_t n_words_ = 1;
+
+    //Internal nodes sorted by feature then threshold ; the nodes of feature f
+    //are in [feature_offset_[f], feature_offset_[f+1])
+    std::vector<size_t> feature_offset_;
+    std::vector<float> thresholds_;
+    std::vector<std::uint32_t> node_tree_;
+    //n_words_ words per node, clearing the leaves of its left subtree
+    std::vector<std::uint64_t> masks_;
+
+    //Index of the first leaf of each tree in leaf_outputs_
+    std::vector<size_t> leaf_offset_;
+    //width_ values per leaf
+    std::vector<float> leaf_outputs_;
+
+    /**
+     * @brief Scores a block of samples with W-word bitvectors
+     *
+     * @param samples Row-major samples
+     * @param first First sample of the block
+     * @param last End of the block
+     * @param bitvectors Scratch space of n_trees_ * W words
+     * @param out Output of sum_outputs()
+     */
+    template <size_t W>
+    void score_(std::span<const float> samples, size_t first, size_t last,
+                std::vector<std::uint64_t>& bitvectors, std::span<float> out) const;
+};
+
+}
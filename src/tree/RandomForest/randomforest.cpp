@@ -7,6 +7,7 @@
 #include "randomforest.h"
 #include "dataset/dataset.h"
 #include "helpers/helpers.h"
+#include "helpers/parallel.h"
 #include "split_strategy/sampling/sampling.h"
 #include "split_strategy/types/split_context.h"
 #include "split_strategy/types/split_hyper.h"
@@ -14,16 +15,19 @@
 #include "split_strategy/types/split_hyper.h"
 #include "tree/DecisionTree/DecisionTree.h"
 #include "tree/TreeModel.h"
+#include "serialization/serialization.h"
 
 #include <atomic>
 #include <iostream>
 #include <cstdint>
 #include <algorithm>
+#include <cmath>
 #include <cstdint>
 #include <cstddef>
 #include <functional>
 #include <limits>
 #include <memory>
+#include <numeric>
 #include <optional>
 #include <random>
 #include <stdexcept>
@@ -32,7 +36,6 @@
 
 using arboria::sampling::bootstrap;
 using arboria::ForestTree;
-using arboria::helpers::derive_seed;
 
 namespace arboria{
 
@@ -90,7 +93,38 @@ RandomForest::RandomForest(HyperParam hyperParam, TreeType type, std::optional<s
     }
     else {n_jobs = 1;}
 
-    trees.reserve(static_cast<size_t>(n_estimators));
+    if (hyperParam.oob_score.has_value()) compute_oob = *hyperParam.oob_score;
+
+    if (hyperParam.early_stopping_tol.has_value()){
+        if (!(*hyperParam.early_stopping_tol >= 0)) throw std::invalid_argument("arboria::tree::RandomForest : early_stopping_tol argument must be greater than or equal 0");
+        early_stopping_tol = *hyperParam.early_stopping_tol;
+        //early stopping monitors the OOB accumulators
+        compute_oob = true;
+    }
+
+    if (hyperParam.early_stopping_batch.has_value()){
+        if (*hyperParam.early_stopping_batch <= 0) throw std::invalid_argument("arboria::tree::RandomForest : early_stopping_batch argument must be greater than 0");
+        early_stopping_batch = *hyperParam.early_stopping_batch;
+    }
+
+    if (hyperParam.honest_fraction.has_value()){
+        if (!(*hyperParam.honest_fraction > 0.f && *hyperParam.honest_fraction < 1.f)) throw std::invalid_argument("arboria::tree::RandomForest : honest_fraction argument must be in (0, 1)");
+        honest_fraction = *hyperParam.honest_fraction;
+    }
+
+    if (hyperParam.quantiles.has_value()) store_leaf_samples = *hyperParam.quantiles;
+
+    if (hyperParam.max_leaf_samples.has_value()){
+        if (*hyperParam.max_leaf_samples <= 0) throw std::invalid_argument("arboria::tree::RandomForest : max_leaf_samples argument must be greater than 0");
+        max_leaf_samples = *hyperParam.max_leaf_samples;
+        //the sketch size only applies to stored leaf targets
+        store_leaf_samples = true;
+    }
+
+    if (store_leaf_samples && !std::holds_alternative<Regression>(type)){
+        throw std::invalid_argument("arboria::tree::RandomForest : quantiles are only available for regression");
+    }
+
     if (!user_seed){
         std::random_device rd;
         seed_ = static_cast<std::uint32_t>(rd());
@@ -107,97 +141,227 @@ RandomForest::RandomForest(HyperParam hyperParam, TreeType type, std::optional<s
 void RandomForest::fit(const DataSet &data, const SplitParam& params){
 
     const size_t n_rows = static_cast<size_t>(data.n_rows());
-    const size_t n_cols = static_cast<size_t>(data.n_cols());
-    const auto* rk = std::get_if<RandomK>(&params.f_selection);
-    if (!rk) {
-        throw std::logic_error("arboria::tree::RandomForest::fit_ : f_selection is not RandomK");
+    validate_fit_(data, params);
+
+    num_features = data.n_cols();
+    if (std::holds_alternative<Classification>(type_) && data.n_targets() != 1) {
+        throw std::invalid_argument("arboria::tree::RandomForest::fit_ : classification requires a single target column");
     }
-    if (!rk->mtry) {
-        throw std::invalid_argument("arboria::tree::RandomForest::fit_ : RandomK::mtry is not defined");
+    if (store_leaf_samples && data.n_targets() != 1) {
+        throw std::invalid_argument("arboria::tree::RandomForest::fit_ : quantile regression requires a single target column");
+    }
+    n_classes_ = std::holds_alternative<Classification>(type_) ? helpers::num_classes(data.y()) : 0;
+    n_outputs_ = data.n_targets();
+    next_tree_ = 0;
+
+    //OOB accumulators are shared by the workers, which add the predictions
+    //of their tree as soon as it is built
+    oob_sums_.clear();
+    oob_counts_.clear();
+    release_stored_oob_();
+    oob_score_.reset();
+    if (compute_oob){
+        oob_sums_.assign(n_rows * oob_width_(), 0.0);
+        oob_counts_.assign(n_rows, 0);
     }
 
-    const int mtry = *rk->mtry;  
+    publish_(grow_(data, params, static_cast<size_t>(n_estimators), early_stopping_tol.has_value(), compute_oob));
 
-    if (mtry <= 0) {
-        throw std::invalid_argument("arboria::tree::RandomForest::fit_ : mtry parameter must be > 0");
+    fitted = true;
+    num_features = data.n_cols();
+}
+
+void RandomForest::fit_more(const DataSet &data, const SplitParam& params, int n_new){
+
+    if (!fitted) throw std::invalid_argument("arboria::RandomForest::fit_more : RandomForest was never fitted");
+    if (n_new <= 0) throw std::invalid_argument("arboria::RandomForest::fit_more : n_new argument must be greater than 0");
+    validate_fit_(data, params);
+
+    //the new trees must see the training set of the existing ones
+    if (data.n_cols() != num_features || data.n_targets() != n_outputs_) {
+        throw std::invalid_argument("arboria::RandomForest::fit_more : DataSet passed does not have the same dimensions as seen during training");
+    }
+    //after a partial update() the older trees keep their own training set :
+    //only the newest batch, which the accumulators restart on, must be matched
+    std::shared_ptr<const std::vector<ForestTree>> current = snapshot_();
+    if (current->back().n_rows != static_cast<size_t>(data.n_rows())) {
+        throw std::invalid_argument("arboria::RandomForest::fit_more : DataSet passed does not have the same dimensions as seen during training");
+    }
+    if (std::holds_alternative<Classification>(type_) && helpers::num_classes(data.y()) != n_classes_) {
+        throw std::invalid_argument("arboria::RandomForest::fit_more : DataSet passed does not have the same classes as seen during training");
     }
 
-    if (n_cols < mtry) {
-        throw std::invalid_argument("arboria::tree::RandomForest::fit_ : mtry parameter can't be larger than the number of features in the dataset");
+    //the new trees are added to the accumulators of a loaded forest
+    if (stored_oob_){
+        oob_sums_.assign(stored_oob_sums_.begin(), stored_oob_sums_.end());
+        oob_counts_.assign(stored_oob_counts_.begin(), stored_oob_counts_.end());
+        release_stored_oob_();
+    }
+    //update() discards the accumulators : they restart on this batch
+    const size_t n_rows = static_cast<size_t>(data.n_rows());
+    if (compute_oob && (oob_counts_.size() != n_rows || oob_sums_.size() != n_rows * oob_width_())){
+        oob_sums_.assign(n_rows * oob_width_(), 0.0);
+        oob_counts_.assign(n_rows, 0);
     }
+    std::vector<ForestTree> grown = grow_(data, params, static_cast<size_t>(n_new), false, compute_oob);
+    std::vector<ForestTree> next(*current);
+    next.insert(next.end(), std::make_move_iterator(grown.begin()), std::make_move_iterator(grown.end()));
+    n_estimators = static_cast<int>(next.size());
+    publish_(std::move(next));
+}
 
-    num_features = data.n_cols();
-    trees.clear();
-    trees.resize(static_cast<size_t>(n_estimators));
+void RandomForest::update(const DataSet &data, const SplitParam& params, int k){
+
+    if (!fitted) throw std::invalid_argument("arboria::RandomForest::update : RandomForest was never fitted");
+    std::shared_ptr<const std::vector<ForestTree>> current = snapshot_();
+    if (k <= 0 || static_cast<size_t>(k) > current->size()) throw std::invalid_argument("arboria::RandomForest::update : k argument must be in [1, n_trees]");
+    validate_fit_(data, params);
+
+    if (data.n_cols() != num_features || data.n_targets() != n_outputs_) {
+        throw std::invalid_argument("arboria::RandomForest::update : DataSet passed does not have the same dimensions as seen during training");
+    }
+    //a batch may miss some classes, but can't introduce new ones
+    if (std::holds_alternative<Classification>(type_) && helpers::num_classes(data.y()) > std::max(n_classes_, 2)) {
+        throw std::invalid_argument("arboria::RandomForest::update : DataSet passed contains classes not seen during training");
+    }
 
+    //the OOB accumulators describe the previous training set
+    oob_sums_.clear();
+    oob_counts_.clear();
+    release_stored_oob_();
+    oob_score_.reset();
+
+    //the new trees are fitted before anything is evicted, serving keeps
+    //reading the current ensemble until the swap
+    std::vector<ForestTree> grown = grow_(data, params, static_cast<size_t>(k), false, false);
+    std::vector<ForestTree> next(current->begin() + k, current->end());
+    next.insert(next.end(), std::make_move_iterator(grown.begin()), std::make_move_iterator(grown.end()));
+    publish_(std::move(next));
+}
 
-    std::atomic<size_t> next{0};
+float RandomForest::predict_one(const float* sample) const{
+
+    if (!fitted || num_features == 0) throw std::invalid_argument("arboria::RandomForest::predict_one -> RandomForest has not been fitted");
+    if (n_outputs_ != 1) throw std::invalid_argument("arboria::RandomForest::predict_one -> forest has several outputs, use predict");
+    const std::shared_ptr<const std::vector<ForestTree>> forest = snapshot_();
+    const std::vector<ForestTree>& trees = *forest;
+    if (trees.empty()) throw std::logic_error("arboria::RandomForest::predict_one -> no trees in the forest");
+    const bool classification = std::holds_alternative<Classification>(type_);
+    const size_t K = static_cast<size_t>(std::max(n_classes_, 2));
+    const float n_trees = static_cast<float>(trees.size());
+
+    //the buffers only grow : no allocation once they hold K values
+    thread_local std::vector<float> sums;
+    thread_local std::vector<int> votes;
+
+    if (std::shared_ptr<const NativeForest> native = native_(forest)){
+        sums.assign(native->width(), 0.f);
+        native->sum_outputs_one(sample, sums.data());
+        if (!classification) return sums[0] / n_trees;
+        if (n_classes_ <= 2) return (sums[0] / n_trees >= 0.5f) ? 1.f : 0.f;
+        size_t best = 0;
+        for (size_t k = 1; k < K; k++) if (sums[k] >= sums[best]) best = k;
+        return static_cast<float>(best);
+    }
 
-    auto worker = [&](){
-        for (;;) {
-            
-            size_t i = next.fetch_add(1);
-            if (i >= n_estimators) break;
-            SplitContext context(derive_seed(seed_.value(), i));
-            fit_(i, data, params, context);
+    //the trees of the forest are fitted on num_features : only NaN is checked on the way down
+    auto leaf_value = [&](const DecisionTree& tree){
+        const std::span<const Node> nodes = tree.nodes();
+        int index = 0;
+        while (!nodes[index].is_leaf){
+            const Node& node = nodes[index];
+            const float value = sample[node.feature_index];
+            if (std::isnan(value)) throw std::invalid_argument("arboria::RandomForest::predict_one -> sample contains NaN.");
+            index = (value >= node.threshold) ? node.right_child : node.left_child;
         }
+        return tree.leaf_outputs(index)[0];
     };
 
-    std::vector<std::thread>pool;
-    pool.reserve(n_jobs);
-
-    for (size_t i = 0 ; i < n_jobs; i++){
-        pool.emplace_back(worker);
+    if (!classification){
+        float sum = 0.f;
+        for (const ForestTree& t : trees) sum += leaf_value(*t.tree);
+        return sum / n_trees;
     }
 
-    for (auto& t : pool){
-        t.join();
+    //the vote may stop before a tree tests a NaN : it is rejected first, as in predict()
+    for (size_t f : compiled_(forest)->used_features){
+        if (std::isnan(sample[f])) throw std::invalid_argument("arboria::RandomForest::predict_one -> sample contains NaN.");
     }
-
-    fitted = true;
-    num_features = data.n_cols();
+    votes.assign(K, 0);
+    size_t remaining = trees.size();
+    for (const ForestTree& t : trees){
+        votes[static_cast<size_t>(leaf_value(*t.tree))]++;
+        const size_t leader = decided_leader_(votes.data(), K, --remaining);
+        if (leader < K) return static_cast<float>(leader);
+    }
+    //not reached : the vote is decided once every tree has voted
+    return static_cast<float>(decided_leader_(votes.data(), K, 0));
 }
 
 std::vector<float> RandomForest::predict_proba(std::span<const float> samples) const{
     if (!fitted || num_features == 0) throw std::invalid_argument("arboria::RandomForest::predict_proba -> RandomForest has not been fitted");
+    //the ensemble is pinned for the whole call : a concurrent update() can't change it
+    std::shared_ptr<const std::vector<ForestTree>> forest = snapshot_();
+    const std::vector<ForestTree>& trees = *forest;
     if (trees.size() < 1) throw std::logic_error("arboria::RandomForest::predict_proba -> no trees were found in the forest");
     size_t nf = static_cast<size_t>(num_features);
     if (samples.size() % nf != 0) throw std::invalid_argument("arboria::RandomForest::predict_proba -> passed samples do not have the correct dimension");
 
     size_t num_samples = samples.size()/nf;
-    std::vector<float> preds(num_samples);
-    
-    std::atomic<size_t> next{0};
+    //multiclass forests return one probability per class and per sample,
+    //multi-output forests one prediction per target and per sample
+    const bool multiclass = std::holds_alternative<Classification>(type_) && n_classes_ > 2;
+    const bool multioutput = n_outputs_ > 1;
+    const size_t width = multiclass ? static_cast<size_t>(n_classes_) : static_cast<size_t>(n_outputs_);
+
+    //compiled forms sum the trees in the same order as the walk below
+    if (std::shared_ptr<const NativeForest> native = native_(forest)){
+        std::vector<float> preds = native->sum_outputs(samples, static_cast<size_t>(n_jobs));
+        for (float& p : preds) p /= static_cast<float>(trees.size());
+        return preds;
+    }
+    if (std::shared_ptr<const ImplicitForest> implicit = implicit_(forest)){
+        std::vector<float> preds = implicit->sum_outputs(samples, static_cast<size_t>(n_jobs));
+        for (float& p : preds) p /= static_cast<float>(trees.size());
+        return preds;
+    }
+    if (std::shared_ptr<const BitvectorForest> scorer = scorer_(forest)){
+        std::vector<float> preds = scorer->sum_outputs(samples, static_cast<size_t>(n_jobs));
+        for (float& p : preds) p /= static_cast<float>(trees.size());
+        return preds;
+    }
+    if (std::holds_alternative<Blocked>(engine_) || (std::holds_alternative<Undefined>(engine_) && (num_samples > 1 || n_jobs > 1))){
+        return predict_blocked_(trees, samples);
+    }
 
-    auto worker = [&]() {
-        for (;;){
-            size_t i = next.fetch_add(1);
-            if (i>= num_samples) break; 
-            float sum_votes =0; 
+    std::vector<float> preds(num_samples * width);
+
+    helpers::parallel_for(num_samples, static_cast<size_t>(n_jobs), [&](size_t i){
             auto sample = samples.subspan(i*nf, nf);
+            if (multiclass){
+                float* votes = preds.data() + i*width;
+                for (const auto& t : trees){
+                    votes[static_cast<size_t>(t.tree->predict_one(sample))] += 1.f;
+                }
+                for (size_t k = 0; k < width; k++) votes[k] /= static_cast<float>(trees.size());
+                return;
+            }
+            if (multioutput){
+                float* outputs = preds.data() + i*width;
+                for (const auto& t : trees){
+                    std::span<const float> tree_outputs = t.tree->predict_outputs_one(sample);
+                    for (size_t k = 0; k < width; k++) outputs[k] += tree_outputs[k];
+                }
+                for (size_t k = 0; k < width; k++) outputs[k] /= static_cast<float>(trees.size());
+                return;
+            }
+            float sum_votes =0; 
             for (const auto& t : trees){
                 sum_votes += t.tree->predict_one(sample);
             }
-            preds[i] = sum_votes/static_cast<float>(n_estimators);
-        }
-
-        };
-
-        std::vector<std::thread> pool;
-        pool.reserve(n_jobs);
-
-        for (size_t i = 0; i < n_jobs; i++){
-            pool.emplace_back(worker);
-
-        }
+            preds[i] = sum_votes/static_cast<float>(trees.size());
+        });
 
-        for (auto& t : pool){
-            t.join() ;
-
-        }
-    
-
-    
     return preds;
 
 }
@@ -205,9 +369,36 @@ std::vector<float> RandomForest::predict_proba(std::span<const float> samples) c
 
 std::vector<float> RandomForest::predict(std::span<const float> sample) const {
 
+    //votes stop as soon as they are decided, unless a compiled form of the
+    //trees is used : it scores every tree faster than the walk exits early
+    if (std::holds_alternative<Classification>(type_)){
+        if (!fitted || num_features == 0) throw std::invalid_argument("arboria::RandomForest::predict -> RandomForest has not been fitted");
+        if (sample.size() % static_cast<size_t>(num_features) != 0) throw std::invalid_argument("arboria::RandomForest::predict -> passed samples do not have the correct dimension");
+        std::shared_ptr<const std::vector<ForestTree>> forest = snapshot_();
+        const size_t num_samples = sample.size() / static_cast<size_t>(num_features);
+        //the trees of a small batch are rather split between threads
+        if (tree_chunks_(num_samples, forest->size()) == 1 && 
+            !native_(forest) && !std::holds_alternative<Implicit>(engine_) && !std::holds_alternative<QuickScorer>(engine_)){
+            return predict_votes_(forest, sample);
+        }
+    }
+
     std::vector<float> prob_pred = predict_proba(sample);
     
 
+    if (std::holds_alternative<Classification>(type_) && n_classes_ > 2){
+        const size_t K = static_cast<size_t>(n_classes_);
+        std::vector<float> class_pred(prob_pred.size() / K);
+        for (size_t i = 0; i < class_pred.size(); i++){
+            size_t best = 0;
+            for (size_t k = 1; k < K; k++){
+                if (prob_pred[i*K + k] >= prob_pred[i*K + best]) best = k;
+            }
+            class_pred[i] = static_cast<float>(best);
+        }
+        return class_pred;
+    }
+
     if (std::holds_alternative<Classification>(type_)){
         std::vector<float> class_pred(prob_pred.size());
         std::transform(prob_pred.begin(), prob_pred.end(), class_pred.begin(),
@@ -220,6 +411,74 @@ std::vector<float> RandomForest::predict(std::span<const float> sample) const {
         
 }
 
+AnytimePrediction RandomForest::predict_proba_anytime(std::span<const float> samples, std::optional<int> max_trees,
+                                                      std::optional<std::chrono::nanoseconds> max_time) const{
+
+    const auto start = std::chrono::steady_clock::now();
+    if (!fitted || num_features == 0) throw std::invalid_argument("arboria::RandomForest::predict_proba_anytime -> RandomForest has not been fitted");
+    if (max_trees.has_value() && *max_trees < 1) throw std::invalid_argument("arboria::RandomForest::predict_proba_anytime -> max_trees must be greater than 0");
+    std::shared_ptr<const std::vector<ForestTree>> forest = snapshot_();
+    const std::vector<ForestTree>& trees = *forest;
+    const size_t nf = static_cast<size_t>(num_features);
+    if (samples.size() % nf != 0) throw std::invalid_argument("arboria::RandomForest::predict_proba_anytime -> passed samples do not have the correct dimension");
+
+    const size_t num_samples = samples.size() / nf;
+    const bool multiclass = std::holds_alternative<Classification>(type_) && n_classes_ > 2;
+    const size_t width = multiclass ? static_cast<size_t>(n_classes_) : static_cast<size_t>(n_outputs_);
+    const std::vector<size_t>& order = compiled_(forest)->anytime_order;
+    const size_t budget = max_trees.has_value() ? std::min(order.size(), static_cast<size_t>(*max_trees)) : order.size();
+
+    //(tree, tile) tasks in the order of the trees : once the deadline is seen, 
+    //the trees not started yet are dropped for every tile, and each task writes
+    //the leaves reached by its tile to its own slots
+    const size_t n_tiles = (num_samples + BLOCKED_TILE - 1) / BLOCKED_TILE;
+    std::vector<int> rows(num_samples);
+    std::iota(rows.begin(), rows.end(), 0);
+    std::vector<int> reached(budget * num_samples);
+    std::atomic<size_t> limit{budget};
+    helpers::parallel_for(budget * n_tiles, static_cast<size_t>(n_jobs), [&](size_t task){
+        const size_t j = task / n_tiles;
+        if (j >= limit.load(std::memory_order_relaxed)) return;
+        //the deadline is checked per tile ; the first tree is always evaluated
+        if (j > 0 && max_time.has_value() && std::chrono::steady_clock::now() - start >= *max_time){
+            size_t current = limit.load(std::memory_order_relaxed);
+            while (j < current && !limit.compare_exchange_weak(current, j, std::memory_order_relaxed)){}
+            return;
+        }
+        const size_t first = (task % n_tiles) * BLOCKED_TILE;
+        const size_t n = std::min(BLOCKED_TILE, num_samples - first);
+        trees[order[j]].tree->route(samples, std::span<const int>(rows).subspan(first, n),
+                                    std::span<int>(reached).subspan(j * num_samples + first, n));
+    });
+    //every tree below the limit was routed for every tile
+    const size_t n_used = limit.load();
+
+    AnytimePrediction result;
+    result.proba.assign(num_samples * width, 0.f);
+    helpers::parallel_for(n_tiles, static_cast<size_t>(n_jobs), [&](size_t b){
+        const size_t first = b * BLOCKED_TILE;
+        const size_t last = std::min(num_samples, first + BLOCKED_TILE);
+        for (size_t j = 0; j < n_used; j++){
+            const DecisionTree& tree = *trees[order[j]].tree;
+            for (size_t row = first; row < last; row++){
+                float* outputs = result.proba.data() + row * width;
+                const std::span<const float> leaf = tree.leaf_outputs(reached[j * num_samples + row]);
+                if (multiclass) outputs[static_cast<size_t>(leaf[0])] += 1.f;
+                else for (size_t k = 0; k < width; k++) outputs[k] += leaf[k];
+            }
+        }
+    });
+
+    for (float& p : result.proba) p /= static_cast<float>(n_used);
+    result.n_trees = static_cast<int>(n_used);
+    return result;
+}
+
+std::vector<size_t> RandomForest::anytime_order() const{
+    if (!fitted) throw std::invalid_argument("arboria::RandomForest::anytime_order -> RandomForest has not been fitted");
+    return compiled_(snapshot_())->anytime_order;
+}
+
 float RandomForest::out_of_bag(const DataSet &data) const {
 
     if (!fitted) throw std::invalid_argument("arboria::RandomForest::out_of_bag : RandomForest was never fitted");
@@ -231,42 +490,719 @@ float RandomForest::out_of_bag(const DataSet &data) const {
     if (n_rows == 0 || n_cols ==0) throw std::logic_error("arboria::RandomForest::out_of_bag : DataSet has no rows or cols");
     if (n_cols != static_cast<size_t>(num_features)) throw std::invalid_argument("arboria::RandomForest::out_of_bag : DataSet passed does not have the same dimensions as seen during training");
 
-    std::span<const float> samples(data.X());
+    std::shared_ptr<const std::vector<ForestTree>> forest = snapshot_();
+    const std::vector<ForestTree>& trees = *forest;
+    for (const ForestTree& t : trees){
+        if (t.n_rows != n_rows) throw std::invalid_argument("arboria::RandomForest::out_of_bag : DataSet passed does not have the same dimensions as seen during training");
+    }
+    if (data.n_targets() != n_outputs_) throw std::invalid_argument("arboria::RandomForest::out_of_bag : DataSet passed does not have the same number of targets as seen during training");
+
+    //trees are visited in parallel, each worker keeping a single in-bag mask alive
+    std::vector<double> sums(n_rows * oob_width_(), 0.0);
+    std::vector<int> counts(n_rows, 0);
+
+    helpers::parallel_for(trees.size(), static_cast<size_t>(n_jobs), [&](size_t i){
+        accumulate_oob_(*trees[i].tree, trees[i].in_bag(), data, sums, counts);
+    });
+
+    return score_oob_(data, sums, counts);
+}
+
+float RandomForest::oob_score() const {
+    if (!oob_score_.has_value()) throw std::logic_error("arboria::RandomForest::oob_score : RandomForest was not fitted with oob_score");
+    return *oob_score_;
+}
+
+std::vector<float> RandomForest::oob_prediction() const {
+    if (!oob_score_.has_value()) throw std::logic_error("arboria::RandomForest::oob_prediction : RandomForest was not fitted with oob_score");
 
-    int correct_pred = 0;
-    int wrong_pred = 0;
+    const size_t width = oob_width_();
+    const std::span<const double> oob_sums = oob_sums_view_();
+    const std::span<const int> oob_counts = oob_counts_view_();
+    const size_t n_rows = oob_counts.size();
+    //binary forests return the probability of class 1 only, as predict_proba
+    const bool binary = std::holds_alternative<Classification>(type_) && width == 2;
+    const size_t out_width = binary ? 1 : width;
+    std::vector<float> preds(n_rows * out_width, std::numeric_limits<float>::quiet_NaN());
 
     for (size_t row = 0; row < n_rows; row++){
-        
-        std::span<const float> s = samples.subspan(row*n_cols, n_cols);
-        int num_pred = 0;
-        int sum_pred = 0;
-        for (const ForestTree& t : trees){
+        if (oob_counts[row] == 0) continue;
+        const double n = static_cast<double>(oob_counts[row]);
+        if (binary){
+            preds[row] = static_cast<float>(oob_sums[row*width + 1] / n);
+            continue;
+        }
+        for (size_t k = 0; k < width; k++){
+            preds[row*width + k] = static_cast<float>(oob_sums[row*width + k] / n);
+        }
+    }
+    return preds;
+}
+
+std::vector<float> RandomForest::predict_quantiles(std::span<const float> samples, std::span<const float> qs) const {
+
+    if (!fitted || num_features == 0) throw std::invalid_argument("arboria::RandomForest::predict_quantiles -> RandomForest has not been fitted");
+    if (!store_leaf_samples) throw std::logic_error("arboria::RandomForest::predict_quantiles -> RandomForest was not fitted with quantiles");
+    for (float q : qs){
+        if (!(q >= 0.f && q <= 1.f)) throw std::invalid_argument("arboria::RandomForest::predict_quantiles -> quantile levels must be in [0, 1]");
+    }
+    const size_t nf = static_cast<size_t>(num_features);
+    if (samples.size() % nf != 0) throw std::invalid_argument("arboria::RandomForest::predict_quantiles -> passed samples do not have the correct dimension");
+
+    std::shared_ptr<const std::vector<ForestTree>> forest = snapshot_();
+    const std::vector<ForestTree>& trees = *forest;
+    if (trees.size() < 1) throw std::logic_error("arboria::RandomForest::predict_quantiles -> no trees were found in the forest");
+
+    const size_t num_samples = samples.size()/nf;
+    const size_t n_q = qs.size();
+    std::vector<float> preds(num_samples * n_q);
 
-            if (!t.in_bag[row]){
-                float pred = t.tree->predict_one(s);
-                sum_pred = sum_pred + pred;
-                num_pred++;   
+    helpers::parallel_for(num_samples, static_cast<size_t>(n_jobs), [&](size_t i){
+        auto sample = samples.subspan(i*nf, nf);
+
+        //weighted distribution of the targets sharing a leaf with the sample
+        std::vector<std::pair<float, double>> dist;
+        for (const ForestTree& t : trees){
+            const LeafSummary& leaves = *t.leaf_samples;
+            const int leaf = t.tree->leaf_index(sample);
+            const size_t begin = static_cast<size_t>(leaves.offset[leaf]);
+            const size_t end = static_cast<size_t>(leaves.offset[leaf + 1]);
+            double leaf_weight = 0.0;
+            for (size_t e = begin; e < end; e++) leaf_weight += leaves.weights[e];
+            if (leaf_weight == 0.0) continue;
+            for (size_t e = begin; e < end; e++){
+                dist.emplace_back(leaves.values[e], leaves.weights[e] / leaf_weight);
             }
         }
-        if (num_pred !=0) {
-            int row_vote = (static_cast<float>(sum_pred)/static_cast<float>(num_pred) >= 0.5) ? 1 : 0;
-            (row_vote == data.iloc_y(row)) ? correct_pred++ : wrong_pred++; 
+        std::sort(dist.begin(), dist.end(), [](const auto& a, const auto& b){return a.first < b.first;});
+
+        std::vector<double> cumulative(dist.size());
+        double total = 0.0;
+        for (size_t e = 0; e < dist.size(); e++){
+            total += dist[e].second;
+            cumulative[e] = total;
+        }
+        //the quantile q is the smallest value whose cumulative weight reaches q
+        for (size_t j = 0; j < n_q; j++){
+            const double target = static_cast<double>(qs[j]) * total;
+            size_t e = static_cast<size_t>(std::lower_bound(cumulative.begin(), cumulative.end(), target) - cumulative.begin());
+            e = std::min(e, dist.size() - 1);
+            preds[i*n_q + j] = dist[e].first;
         }
+    });
+
+    return preds;
+}
+
+void RandomForest::save(const std::string& path) const {
+    const std::vector<std::byte> bytes = to_bytes();
+    serialization::write_file(path, bytes);
+}
 
+std::vector<std::byte> RandomForest::to_bytes() const {
+
+    std::shared_ptr<const std::vector<ForestTree>> forest = snapshot_();
+
+    serialization::Writer out;
+    serialization::write_header(out, serialization::ModelKind::RandomForest);
+    out.put_type(type_);
+    out.put<std::int32_t>(mtry);
+    out.put<std::int32_t>(n_estimators);
+    out.put(max_depth);
+    out.put(max_samples);
+    out.put(min_sample_split);
+    out.put(honest_fraction);
+    out.put<std::int32_t>(n_jobs);
+    out.put<bool>(compute_oob);
+    out.put(early_stopping_tol);
+    out.put<std::int32_t>(early_stopping_batch);
+    out.put<bool>(store_leaf_samples);
+    out.put(max_leaf_samples);
+    out.put<std::uint32_t>(*seed_);
+    //an unfitted forest only stores its hyperparameters and seed, with no trees
+    out.put<bool>(fitted);
+    out.put<std::int32_t>(num_features);
+    out.put<std::int32_t>(n_classes_);
+    out.put<std::int32_t>(n_outputs_);
+    out.put<std::uint64_t>(next_tree_);
+    out.put(oob_score_);
+    out.put_array<double>(oob_sums_view_());
+    out.put_array<int>(oob_counts_view_());
+
+    out.put<std::uint64_t>(forest->size());
+    for (const ForestTree& t : *forest){
+        out.put<std::uint32_t>(t.seed);
+        out.put<std::uint64_t>(t.n_rows);
+        out.put<std::uint64_t>(t.n_draws);
+        out.put(t.oob_error);
+        out.put<bool>(t.leaf_samples != nullptr);
+        if (t.leaf_samples){
+            out.put_array<int>(t.leaf_samples->offset);
+            out.put_array<float>(t.leaf_samples->values);
+            out.put_array<float>(t.leaf_samples->weights);
+        }
+        t.tree->serialize(out);
     }
-    if (correct_pred+wrong_pred == 0) throw std::logic_error("arboria::RandomForest::out_of_bag : no OOB samples.");
-    return static_cast<float>(correct_pred)/(static_cast<float>(correct_pred)+static_cast<float>(wrong_pred));
-    
+    return out.release();
+}
+
+std::unique_ptr<RandomForest> RandomForest::load(const std::string& path, bool mmap){
+    serialization::Reader in(mmap ? serialization::map_file(path) : serialization::read_file(path));
+    return deserialize_(in);
+}
+
+std::unique_ptr<RandomForest> RandomForest::from_bytes(std::span<const std::byte> bytes){
+    serialization::Reader in(serialization::copy_bytes(bytes));
+    return deserialize_(in);
+}
 
+std::vector<bool> ForestTree::in_bag() const {
+
+    //replays the first draws of the tree RNG, which are the bootstrap
+    std::mt19937 rng(seed);
+    std::vector<size_t> bootstrapped_indices = bootstrap(n_rows, n_draws, rng);
+    std::vector<bool> mask(n_rows, false);
+    for (size_t row : bootstrapped_indices) mask[row] = true;
+    return mask;
 }
+
 /*
 --------------------------------------------------------------------------------------
 PRIVATE METHODS 
 --------------------------------------------------------------------------------------
 */
 
-void RandomForest::fit_(size_t i, const DataSet& data, const SplitParam &param, SplitContext &context){
+void RandomForest::validate_fit_(const DataSet& data, const SplitParam& params) const {
+
+    const size_t n_cols = static_cast<size_t>(data.n_cols());
+    const auto* rk = std::get_if<RandomK>(&params.f_selection);
+    if (!rk) {
+        throw std::logic_error("arboria::tree::RandomForest::fit_ : f_selection is not RandomK");
+    }
+    if (!rk->mtry) {
+        throw std::invalid_argument("arboria::tree::RandomForest::fit_ : RandomK::mtry is not defined");
+    }
+
+    const int mtry = *rk->mtry;  
+
+    if (mtry <= 0) {
+        throw std::invalid_argument("arboria::tree::RandomForest::fit_ : mtry parameter must be > 0");
+    }
+
+    if (n_cols < mtry) {
+        throw std::invalid_argument("arboria::tree::RandomForest::fit_ : mtry parameter can't be larger than the number of features in the dataset");
+    }
+}
+
+std::vector<ForestTree> RandomForest::grow_(const DataSet& data, const SplitParam& params, size_t n_new, bool early_stopping, bool track_oob){
+
+    //a forest where every row was bootstrapped by every tree has no OOB score
+    auto current_oob_score = [&](){
+        const bool has_oob = std::any_of(oob_counts_.begin(), oob_counts_.end(), [](int c){return c > 0;});
+        return has_oob ? score_oob_(data, oob_sums_, oob_counts_) : std::numeric_limits<float>::quiet_NaN();
+    };
+
+    //new trees take the next seed indices, so that growing a forest in 
+    //several calls gives the same trees as a single fit
+    std::vector<ForestTree> grown(n_new);
+
+    //without early stopping, the new trees are a single batch
+    const size_t batch = early_stopping ? static_cast<size_t>(early_stopping_batch) : n_new;
+    size_t n_fitted = 0;
+    float previous_score = std::numeric_limits<float>::quiet_NaN();
+
+    while (n_fitted < n_new){
+        const size_t first = n_fitted;
+        const size_t n_batch = std::min(batch, n_new - first);
+        helpers::parallel_for(n_batch, static_cast<size_t>(n_jobs), [&](size_t j){
+            SplitContext context(tree_seed(next_tree_ + first + j));
+            grown[first + j] = fit_(next_tree_ + first + j, data, params, context, track_oob);
+        });
+        n_fitted += n_batch;
+
+        if (!early_stopping) continue;
+        //stops once a batch no longer improves the OOB score by more than the tolerance
+        const float score = current_oob_score();
+        const bool converged = !std::isnan(previous_score) && !std::isnan(score) 
+                                && score - previous_score < *early_stopping_tol;
+        previous_score = score;
+        if (converged) break;
+    }
+
+    //the forest is truncated to the trees actually fitted
+    grown.resize(n_fitted);
+    next_tree_ += n_fitted;
+
+    if (track_oob) oob_score_ = current_oob_score();
+    return grown;
+}
+
+std::unique_ptr<RandomForest> RandomForest::deserialize_(serialization::Reader& in){
+
+    serialization::read_header(in, serialization::ModelKind::RandomForest);
+    const TreeType type = in.get_type();
+    HyperParam hp;
+    hp.mtry = in.get<std::int32_t>();
+    hp.n_estimators = in.get<std::int32_t>();
+    hp.max_depth = in.get_optional<int>();
+    hp.max_samples = in.get_optional<float>();
+    const std::optional<int> min_sample_split = in.get_optional<int>();
+    if (min_sample_split) hp.min_sample_split = static_cast<float>(*min_sample_split);
+    hp.honest_fraction = in.get_optional<float>();
+    hp.n_jobs = in.get<std::int32_t>();
+    hp.oob_score = in.get<bool>();
+    hp.early_stopping_tol = in.get_optional<float>();
+    hp.early_stopping_batch = in.get<std::int32_t>();
+    hp.quantiles = in.get<bool>();
+    hp.max_leaf_samples = in.get_optional<int>();
+    const std::uint32_t seed = in.get<std::uint32_t>();
+
+    //the constructor validates the stored hyperparameters
+    auto forest = std::make_unique<RandomForest>(hp, type, seed);
+    const bool fitted = in.get<bool>();
+    forest->num_features = in.get<std::int32_t>();
+    forest->n_classes_ = in.get<std::int32_t>();
+    forest->n_outputs_ = in.get<std::int32_t>();
+    forest->next_tree_ = static_cast<size_t>(in.get<std::uint64_t>());
+    forest->oob_score_ = in.get_optional<float>();
+    forest->stored_oob_sums_ = in.get_array<double>();
+    forest->stored_oob_counts_ = in.get_array<int>();
+    forest->stored_oob_ = in.storage();
+
+    const std::uint64_t n_trees = in.get<std::uint64_t>();
+    if (!fitted) return forest;
+    if (n_trees == 0 || forest->num_features <= 0) throw std::invalid_argument("arboria::RandomForest::load -> model buffer holds an empty forest");
+    std::vector<ForestTree> trees;
+    trees.reserve(static_cast<size_t>(std::min<std::uint64_t>(n_trees, 1 << 20)));
+    for (std::uint64_t i = 0; i < n_trees; i++){
+        ForestTree t;
+        t.seed = in.get<std::uint32_t>();
+        t.n_rows = static_cast<size_t>(in.get<std::uint64_t>());
+        t.n_draws = static_cast<size_t>(in.get<std::uint64_t>());
+        t.oob_error = in.get_optional<float>();
+        if (in.get<bool>()){
+            //leaf targets are only stored by quantile forests
+            const std::span<const int> offset = in.get_array<int>();
+            const std::span<const float> values = in.get_array<float>();
+            const std::span<const float> weights = in.get_array<float>();
+            t.leaf_samples = std::make_shared<const LeafSummary>(LeafSummary{offset, values, weights, in.storage()});
+        }
+        t.tree = std::make_shared<DecisionTree>(DecisionTree::deserialize(in));
+        if (t.tree->num_features != forest->num_features) throw std::invalid_argument("arboria::RandomForest::load -> trees of the model buffer do not have the same number of features");
+        trees.push_back(std::move(t));
+    }
+
+    forest->publish_(std::move(trees));
+    forest->fitted = true;
+    return forest;
+}
+
+size_t RandomForest::tree_chunks_(size_t num_samples, size_t n_trees) const{
+    const size_t jobs = static_cast<size_t>(std::max(n_jobs, 1));
+    const size_t n_tiles = (num_samples + BLOCKED_TILE - 1) / BLOCKED_TILE;
+    if (n_tiles >= jobs) return 1;
+    //enough chunks for the idle threads, each worth more than a thread start
+    const size_t wanted = (jobs + n_tiles - 1) / n_tiles;
+    return std::max<size_t>(1, std::min(wanted, n_trees / MIN_TREES_PER_TASK));
+}
+
+std::vector<float> RandomForest::predict_blocked_(const std::vector<ForestTree>& trees, std::span<const float> samples) const{
+
+    const size_t num_samples = samples.size() / static_cast<size_t>(num_features);
+    const bool multiclass = std::holds_alternative<Classification>(type_) && n_classes_ > 2;
+    const size_t width = multiclass ? static_cast<size_t>(n_classes_) : static_cast<size_t>(n_outputs_);
+    std::vector<float> preds(num_samples * width, 0.f);
+    const size_t n_tiles = (num_samples + BLOCKED_TILE - 1) / BLOCKED_TILE;
+
+    auto add_leaf = [&](const DecisionTree& tree, int leaf, size_t row){
+        float* outputs = preds.data() + row * width;
+        const std::span<const float> values = tree.leaf_outputs(leaf);
+        if (multiclass) outputs[static_cast<size_t>(values[0])] += 1.f;
+        else for (size_t k = 0; k < width; k++) outputs[k] += values[k];
+    };
+
+    const size_t n_chunks = tree_chunks_(num_samples, trees.size());
+    if (n_chunks == 1){
+        helpers::parallel_for(n_tiles, static_cast<size_t>(n_jobs), [&](size_t b){
+            const size_t first = b * BLOCKED_TILE;
+            const size_t n = std::min(BLOCKED_TILE, num_samples - first);
+            std::vector<int> rows(n);
+            std::iota(rows.begin(), rows.end(), static_cast<int>(first));
+            std::vector<int> leaves(n);
+
+            //the whole tile goes through a tree before the next one is loaded ; 
+            //each sample still sums the trees in order, as the walk does
+            for (const ForestTree& t : trees){
+                t.tree->route(samples, rows, leaves);
+                for (size_t r = 0; r < n; r++) add_leaf(*t.tree, leaves[r], first + r);
+            }
+            for (size_t i = first * width; i < (first + n) * width; i++) preds[i] /= static_cast<float>(trees.size());
+        });
+        return preds;
+    }
+
+    //small batch : every (tile, chunk of trees) pair is a task, writing the leaf
+    //reached by each sample in each tree of its chunk to its own slots
+    const size_t chunk = (trees.size() + n_chunks - 1) / n_chunks;
+    std::vector<int> reached(trees.size() * num_samples);
+    helpers::parallel_for(n_tiles * n_chunks, static_cast<size_t>(n_jobs), [&](size_t task){
+        const size_t first = (task / n_chunks) * BLOCKED_TILE;
+        const size_t n = std::min(BLOCKED_TILE, num_samples - first);
+        const size_t first_tree = (task % n_chunks) * chunk;
+        const size_t last_tree = std::min(trees.size(), first_tree + chunk);
+        std::vector<int> rows(n);
+        std::iota(rows.begin(), rows.end(), static_cast<int>(first));
+        for (size_t t = first_tree; t < last_tree; t++){
+            trees[t].tree->route(samples, rows, std::span<int>(reached).subspan(t * num_samples + first, n));
+        }
+    });
+
+    //the reduction sums the trees in order, as the walk does
+    helpers::parallel_for(num_samples, std::min(static_cast<size_t>(n_jobs), n_tiles), [&](size_t row){
+        for (size_t t = 0; t < trees.size(); t++) add_leaf(*trees[t].tree, reached[t * num_samples + row], row);
+        for (size_t k = row * width; k < (row + 1) * width; k++) preds[k] /= static_cast<float>(trees.size());
+    });
+    return preds;
+}
+
+std::vector<float> RandomForest::predict_votes_(const std::shared_ptr<const std::vector<ForestTree>>& forest, std::span<const float> samples) const{
+
+    const size_t nf = static_cast<size_t>(num_features);
+    const size_t num_samples = samples.size() / nf;
+    const size_t K = static_cast<size_t>(std::max(n_classes_, 2));
+    std::vector<float> labels(num_samples);
+
+    //the votes may stop before a tree tests a NaN : it is rejected before any vote,
+    //as a full walk would
+    const std::vector<size_t>& used_features = compiled_(forest)->used_features;
+    for (size_t s = 0; s < num_samples; s++){
+        for (size_t f : used_features){
+            if (std::isnan(samples[s * nf + f])) throw std::invalid_argument("arboria::RandomForest::predict -> sample contains NaN.");
+        }
+    }
+    const std::vector<ForestTree>& trees = *forest;
+
+    const size_t n_tiles = (num_samples + BLOCKED_TILE - 1) / BLOCKED_TILE;
+    helpers::parallel_for(n_tiles, static_cast<size_t>(n_jobs), [&](size_t b){
+        const size_t first = b * BLOCKED_TILE;
+        const size_t n = std::min(BLOCKED_TILE, num_samples - first);
+        //rows whose vote is still open
+        std::vector<int> rows(n);
+        std::iota(rows.begin(), rows.end(), static_cast<int>(first));
+        std::vector<int> leaves(n);
+        std::vector<int> votes(n * K, 0);
+
+        size_t remaining = trees.size();
+        for (const ForestTree& t : trees){
+            t.tree->route(samples, rows, std::span<int>(leaves).first(rows.size()));
+            remaining--;
+            size_t open = 0;
+            for (size_t r = 0; r < rows.size(); r++){
+                int* v = votes.data() + (static_cast<size_t>(rows[r]) - first) * K;
+                v[static_cast<size_t>(t.tree->leaf_outputs(leaves[r])[0])]++;
+
+                const size_t leader = decided_leader_(v, K, remaining);
+                if (leader < K) labels[static_cast<size_t>(rows[r])] = static_cast<float>(leader);
+                else rows[open++] = rows[r];
+            }
+            rows.resize(open);
+            if (rows.empty()) break;
+        }
+    });
+    return labels;
+}
+
+size_t RandomForest::decided_leader_(const int* votes, size_t K, size_t remaining){
+
+    //the leader is decided if no class can overtake it with the remaining trees
+    size_t leader = 0;
+    for (size_t k = 1; k < K; k++) if (votes[k] >= votes[leader]) leader = k;
+    for (size_t k = 0; k < K; k++){
+        if (k == leader) continue;
+        const int reachable = votes[k] + static_cast<int>(remaining);
+        if (votes[leader] < reachable || (votes[leader] == reachable && leader < k)) return K;
+    }
+    return leader;
+}
+
+std::shared_ptr<const CompiledForest> RandomForest::compiled_(const std::shared_ptr<const std::vector<ForestTree>>& forest) const{
+
+    std::shared_ptr<const CompiledForest> compiled = compiled_cache_.load(std::memory_order_acquire);
+    if (compiled && compiled->forest.lock() == forest) return compiled;
+
+    //the size of the trees is only inspected once per ensemble
+    CompiledForest next;
+    next.forest = forest;
+    std::vector<bool> used(static_cast<size_t>(num_features), false);
+    for (const ForestTree& t : *forest){
+        next.max_leaves = std::max(next.max_leaves, t.tree->n_leaves());
+        next.max_depth = std::max(next.max_depth, t.tree->depth());
+        for (const Node& node : t.tree->nodes()){
+            if (!node.is_leaf) used[static_cast<size_t>(node.feature_index)] = true;
+        }
+    }
+    for (size_t f = 0; f < used.size(); f++) if (used[f]) next.used_features.push_back(f);
+    //trees with an OOB error first, the most accurate ones leading
+    next.anytime_order.resize(forest->size());
+    std::iota(next.anytime_order.begin(), next.anytime_order.end(), size_t{0});
+    std::stable_sort(next.anytime_order.begin(), next.anytime_order.end(), [&](size_t a, size_t b){
+        const std::optional<float>& ea = (*forest)[a].oob_error;
+        const std::optional<float>& eb = (*forest)[b].oob_error;
+        if (ea.has_value() != eb.has_value()) return ea.has_value();
+        return ea.has_value() && *ea < *eb;
+    });
+    compiled = std::make_shared<const CompiledForest>(std::move(next));
+    compiled_cache_.store(compiled, std::memory_order_release);
+    return compiled;
+}
+
+std::vector<const DecisionTree*> RandomForest::tree_pointers_(const std::vector<ForestTree>& forest){
+    std::vector<const DecisionTree*> trees;
+    trees.reserve(forest.size());
+    for (const ForestTree& t : forest) trees.push_back(t.tree.get());
+    return trees;
+}
+
+std::shared_ptr<const NativeForest> RandomForest::native_(const std::shared_ptr<const std::vector<ForestTree>>& forest) const{
+
+    const bool automatic = std::holds_alternative<Undefined>(engine_);
+    if (!automatic && !std::holds_alternative<Native>(engine_)) return nullptr;
+
+    std::shared_ptr<const CompiledForest> compiled = compiled_(forest);
+    if (automatic) return compiled->native;
+    if (!compiled->native){
+        throw std::logic_error("arboria::RandomForest::predict_proba -> Native requires compile_native() or load_native() on the current trees");
+    }
+    return compiled->native;
+}
+
+void RandomForest::attach_native_(const std::shared_ptr<const std::vector<ForestTree>>& forest,
+                                  std::shared_ptr<const NativeForest> library, const std::string& caller){
+
+    if (library->fingerprint() != NativeForest::fingerprint(tree_pointers_(*forest), num_features, n_votes_())){
+        throw std::invalid_argument("arboria::RandomForest::" + caller + " -> library was not compiled from the trees of this forest");
+    }
+    CompiledForest next = *compiled_(forest);
+    next.native = std::move(library);
+    compiled_cache_.store(std::make_shared<const CompiledForest>(std::move(next)), std::memory_order_release);
+}
+
+void RandomForest::compile_native(const std::string& path){
+
+    if (!fitted || num_features == 0) throw std::invalid_argument("arboria::RandomForest::compile_native -> RandomForest has not been fitted");
+    std::shared_ptr<const std::vector<ForestTree>> forest = snapshot_();
+    NativeForest::compile(NativeForest::source(tree_pointers_(*forest), num_features, n_votes_()), path);
+    attach_native_(forest, std::make_shared<const NativeForest>(path), "compile_native");
+}
+
+void RandomForest::load_native(const std::string& path){
+
+    if (!fitted || num_features == 0) throw std::invalid_argument("arboria::RandomForest::load_native -> RandomForest has not been fitted");
+    attach_native_(snapshot_(), std::make_shared<const NativeForest>(path), "load_native");
+}
+
+std::shared_ptr<const BitvectorForest> RandomForest::scorer_(const std::shared_ptr<const std::vector<ForestTree>>& forest) const{
+
+    //only built on request : the bitvectors copy every threshold of a mapped model
+    if (!std::holds_alternative<QuickScorer>(engine_)) return nullptr;
+
+    std::shared_ptr<const CompiledForest> compiled = compiled_(forest);
+    if (compiled->max_leaves > BitvectorForest::MAX_LEAVES){
+        throw std::logic_error("arboria::RandomForest::predict_proba -> QuickScorer requires trees with at most 256 leaves");
+    }
+    if (compiled->bitvector) return compiled->bitvector;
+
+    const std::vector<const DecisionTree*> trees = tree_pointers_(*forest);
+    CompiledForest next = *compiled;
+    next.bitvector = std::make_shared<const BitvectorForest>(trees, num_features, n_votes_());
+    compiled_cache_.store(std::make_shared<const CompiledForest>(next), std::memory_order_release);
+    return next.bitvector;
+}
+
+std::shared_ptr<const ImplicitForest> RandomForest::implicit_(const std::shared_ptr<const std::vector<ForestTree>>& forest) const{
+
+    //only built on request : the padded copy would replace the nodes shared by a mapped model
+    if (!std::holds_alternative<Implicit>(engine_)) return nullptr;
+
+    std::shared_ptr<const CompiledForest> compiled = compiled_(forest);
+    if (compiled->max_depth > ImplicitForest::MAX_DEPTH){
+        throw std::logic_error("arboria::RandomForest::predict_proba -> Implicit requires trees of at most 12 levels");
+    }
+    if (compiled->implicit) return compiled->implicit;
+
+    const std::vector<const DecisionTree*> trees = tree_pointers_(*forest);
+    CompiledForest next = *compiled;
+    next.implicit = std::make_shared<const ImplicitForest>(trees, num_features, n_votes_());
+    compiled_cache_.store(std::make_shared<const CompiledForest>(next), std::memory_order_release);
+    return next.implicit;
+}
+
+void RandomForest::publish_(std::vector<ForestTree> next){
+    ensemble_.store(std::make_shared<const std::vector<ForestTree>>(std::move(next)), std::memory_order_release);
+}
+
+std::optional<float> RandomForest::accumulate_oob_(const DecisionTree& tree, const std::vector<bool>& in_bag,
+                                                   const DataSet& data,
+                                                   std::vector<double>& sums, std::vector<int>& counts) const {
+
+    const size_t nf = static_cast<size_t>(num_features);
+    const size_t width = oob_width_();
+    const bool classification = std::holds_alternative<Classification>(type_);
+    const std::span<const float> samples(data.X());
+
+    //error of the tree alone on its OOB rows
+    double error = 0.0;
+    size_t n_oob = 0;
+    for (size_t row = 0; row < in_bag.size(); row++){
+        if (in_bag[row]) continue;
+        std::span<const float> sample = samples.subspan(row*nf, nf);
+        if (classification){
+            const float label = tree.predict_one(sample);
+            size_t pred = static_cast<size_t>(label);
+            if (pred < width) std::atomic_ref<double>(sums[row*width + pred]).fetch_add(1.0, std::memory_order_relaxed);
+            if (label != data.iloc_y(static_cast<int>(row))) error += 1.0;
+        }
+        else {
+            std::span<const float> outputs = tree.predict_outputs_one(sample);
+            for (size_t k = 0; k < width; k++){
+                std::atomic_ref<double>(sums[row*width + k]).fetch_add(outputs[k], std::memory_order_relaxed);
+                const double residual = static_cast<double>(data.iloc_y(static_cast<int>(row), static_cast<int>(k))) - outputs[k];
+                error += residual * residual / static_cast<double>(width);
+            }
+        }
+        std::atomic_ref<int>(counts[row]).fetch_add(1, std::memory_order_relaxed);
+        n_oob++;
+    }
+    if (n_oob == 0) return std::nullopt;
+    return static_cast<float>(error / static_cast<double>(n_oob));
+}
+
+LeafSummary RandomForest::summarise_leaves_(const DecisionTree& tree, const DataSet& data, 
+                                            const std::vector<size_t>& bootstrapped_indices) const {
+
+    const size_t nf = static_cast<size_t>(num_features);
+    const std::vector<float>& X = data.X();
+    const std::span<const float> samples(X);
+
+    //(leaf, target) of each draw : repeated draws count as many times
+    std::vector<std::pair<int, float>> reached(bootstrapped_indices.size());
+    for (size_t d = 0; d < bootstrapped_indices.size(); d++){
+        const size_t row = bootstrapped_indices[d];
+        reached[d] = {tree.leaf_index(samples.subspan(row*nf, nf)), data.iloc_y(static_cast<int>(row))};
+    }
+    std::sort(reached.begin(), reached.end());
+
+    //arrays owned by the summary, which views them like the arrays of a model file
+    struct Arrays {
+        std::vector<int> offset;
+        std::vector<float> values;
+        std::vector<float> weights;
+    };
+    auto arrays = std::make_shared<Arrays>();
+    const size_t n_nodes = tree.n_nodes();
+    arrays->offset.assign(n_nodes + 1, 0);
+
+    std::vector<float> values;
+    std::vector<float> weights;
+    size_t d = 0;
+    for (size_t node = 0; node < n_nodes; node++){
+        arrays->offset[node] = static_cast<int>(arrays->values.size());
+
+        //distinct sorted targets of the leaf with their multiplicity
+        values.clear();
+        weights.clear();
+        while (d < reached.size() && reached[d].first == static_cast<int>(node)){
+            if (!values.empty() && values.back() == reached[d].second) weights.back() += 1.f;
+            else {
+                values.push_back(reached[d].second);
+                weights.push_back(1.f);
+            }
+            d++;
+        }
+
+        const size_t n_bins = max_leaf_samples.has_value() ? static_cast<size_t>(*max_leaf_samples) : values.size();
+        if (values.size() <= n_bins){
+            arrays->values.insert(arrays->values.end(), values.begin(), values.end());
+            arrays->weights.insert(arrays->weights.end(), weights.begin(), weights.end());
+            continue;
+        }
+
+        //sketch : consecutive values are merged into n_bins bins of equal weight
+        double leaf_weight = 0.0;
+        for (float w : weights) leaf_weight += w;
+        double bin_weight = 0.0;
+        double bin_sum = 0.0;
+        double cumulative = 0.0;
+        size_t bin = 1;
+        for (size_t e = 0; e < values.size(); e++){
+            bin_weight += weights[e];
+            bin_sum += static_cast<double>(values[e]) * weights[e];
+            cumulative += weights[e];
+            const bool last = (e + 1 == values.size());
+            if (last || cumulative >= leaf_weight * static_cast<double>(bin) / static_cast<double>(n_bins)){
+                arrays->values.push_back(static_cast<float>(bin_sum / bin_weight));
+                arrays->weights.push_back(static_cast<float>(bin_weight));
+                bin_weight = 0.0;
+                bin_sum = 0.0;
+                while (bin < n_bins && cumulative >= leaf_weight * static_cast<double>(bin) / static_cast<double>(n_bins)) bin++;
+            }
+        }
+    }
+    arrays->offset[n_nodes] = static_cast<int>(arrays->values.size());
+    return LeafSummary{arrays->offset, arrays->values, arrays->weights, arrays};
+}
+
+float RandomForest::score_oob_(const DataSet& data, const std::vector<double>& sums, const std::vector<int>& counts) const {
+
+    const size_t n_rows = counts.size();
+    const size_t width = oob_width_();
+
+    if (std::holds_alternative<Classification>(type_)){
+        int correct_pred = 0;
+        int wrong_pred = 0;
+        for (size_t row = 0; row < n_rows; row++){
+            if (counts[row] == 0) continue;
+            //ties are resolved toward the highest class, as in predict
+            size_t best = 0;
+            for (size_t k = 1; k < width; k++){
+                if (sums[row*width + k] >= sums[row*width + best]) best = k;
+            }
+            (static_cast<float>(best) == data.iloc_y(static_cast<int>(row))) ? correct_pred++ : wrong_pred++;
+        }
+        if (correct_pred+wrong_pred == 0) throw std::logic_error("arboria::RandomForest::out_of_bag : no OOB samples.");
+        return static_cast<float>(correct_pred)/(static_cast<float>(correct_pred)+static_cast<float>(wrong_pred));
+    }
+
+    //regression : R² of each target on the rows with an OOB prediction, averaged
+    double r2 = 0.0;
+    for (size_t k = 0; k < width; k++){
+        double mean = 0.0;
+        size_t n_oob = 0;
+        for (size_t row = 0; row < n_rows; row++){
+            if (counts[row] == 0) continue;
+            mean += data.iloc_y(static_cast<int>(row), static_cast<int>(k));
+            n_oob++;
+        }
+        if (n_oob == 0) throw std::logic_error("arboria::RandomForest::out_of_bag : no OOB samples.");
+        mean /= static_cast<double>(n_oob);
+
+        double ss_res = 0.0;
+        double ss_tot = 0.0;
+        for (size_t row = 0; row < n_rows; row++){
+            if (counts[row] == 0) continue;
+            const double y = data.iloc_y(static_cast<int>(row), static_cast<int>(k));
+            const double pred = sums[row*width + k] / static_cast<double>(counts[row]);
+            ss_res += (y - pred) * (y - pred);
+            ss_tot += (y - mean) * (y - mean);
+        }
+        //constant target : perfect if predicted exactly, 0 otherwise
+        if (ss_tot == 0.0) r2 += (ss_res == 0.0) ? 1.0 : 0.0;
+        else r2 += 1.0 - ss_res / ss_tot;
+    }
+    return static_cast<float>(r2 / static_cast<double>(width));
+}
+
+ForestTree RandomForest::fit_(size_t i, const DataSet& data, const SplitParam &param, SplitContext &context, bool track_oob){
 
         //Bootstrapping of dataset rows :
         const size_t n_rows = static_cast<size_t>(data.n_rows());
@@ -278,21 +1214,34 @@ void RandomForest::fit_(size_t i, const DataSet& data, const SplitParam &param,
         // passing from bootstrap to DecisionTree.fit(); 
         // to delete when all ref to indices will be in size_t
         std::vector<int> passed_idx(boostrapped_indices.size());
-        std::vector<bool> seen_idx(n_rows, false);
         for (size_t row_idx = 0; row_idx <boostrapped_indices.size(); row_idx++ ){
             passed_idx[row_idx] = static_cast<int>(boostrapped_indices[row_idx]);
-            seen_idx[boostrapped_indices[row_idx]] = true;
         }
         // then fit tree with param.f_selection = RandomK & 
         // add to the RF list 
         ForestTree forest_tree;
-        HyperParam h_param{.max_depth = max_depth, .min_sample_split = min_sample_split};
+        HyperParam h_param{.max_depth = max_depth, .min_sample_split = min_sample_split, .honest_fraction = honest_fraction};
         
-        forest_tree.tree = std::make_unique<DecisionTree>(h_param, param.type);
-        forest_tree.in_bag = std::move(seen_idx);
+        forest_tree.tree = std::make_shared<DecisionTree>(h_param, param.type);
+        //the in-bag mask is regenerated from the seed when needed
+        forest_tree.seed = tree_seed(i);
+        forest_tree.n_rows = n_rows;
+        forest_tree.n_draws = bootstrap_size;
 
-        trees[i]=(std::move(forest_tree));
-        trees[i].tree->fit(data, passed_idx, param, context);
+        forest_tree.tree->fit(data, passed_idx, param, context);
+
+        if (store_leaf_samples){
+            forest_tree.leaf_samples = std::make_shared<const LeafSummary>(
+                summarise_leaves_(*forest_tree.tree, data, boostrapped_indices));
+        }
+
+        //the bootstrap is at hand : OOB rows are predicted right away
+        if (track_oob){
+            std::vector<bool> in_bag(n_rows, false);
+            for (size_t row : boostrapped_indices) in_bag[row] = true;
+            forest_tree.oob_error = accumulate_oob_(*forest_tree.tree, in_bag, data, oob_sums_, oob_counts_);
+        }
+        return forest_tree;
 
 }
 
@@ -10,35 +10,139 @@
 #include "tree/DecisionTree/DecisionTree.h"
 #include "tree/TreeModel.h"
 #include "split_strategy/types/split_hyper.h"
+#include "serialization/serialization.h"
+#include "tree/RandomForest/implicitforest.h"
+#include "tree/RandomForest/nativeforest.h"
+#include "tree/RandomForest/quickscorer.h"
 
 
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
 #include <optional>
+#include <string>
 #include <vector>
 #include <span>
+#include <variant>
 
 namespace arboria::test { struct RandomForestAccess; }  
 
+//--------------------- PredictEngine
+
+//Walks every tree from its root to a leaf
+struct Traversal{};
+//Scores all trees at once with the sorted thresholds of a BitvectorForest
+struct QuickScorer{};
+//Routes tiles of samples through one tree at a time, level by level
+struct Blocked{};
+//Routes tiles of samples through the complete breadth-first trees of an ImplicitForest
+struct Implicit{};
+//Calls the shared library compiled from the trees by RandomForest::compile_native()
+struct Native{};
+
+//Undefined selects Native when a library was compiled for the trees, Blocked for batches,
+//Traversal otherwise ; QuickScorer and Implicit are only used on request
+using PredictEngine = std::variant<Undefined, Traversal, QuickScorer, Blocked, Implicit, Native>;
+
+
 namespace arboria {
 
 
+/**
+ * @brief Training targets reaching the leaves of a tree, for quantile regression
+ *
+ * Values are stored per node in CSR layout : the values of node n are 
+ * values[offset[n] .. offset[n+1]), sorted, with the in-bag multiplicity 
+ * of each value in weights. Internal nodes own an empty range.
+ *
+ * @note When a leaf holds more distinct values than HyperParam::max_leaf_samples, 
+ * its sorted values are summarised into max_leaf_samples bins of equal weight, 
+ * each bin keeping its weighted mean and its weight : the memory of a tree is then
+ * bounded by n_leaves * max_leaf_samples instead of the number of bootstrapped rows.
+ * @note The arrays are views : a fitted forest owns them through storage, a loaded
+ * forest reads them in place from its model file.
+ */
+struct LeafSummary {
+    std::span<const int> offset;
+    std::span<const float> values;
+    std::span<const float> weights;
+    //Owner of the viewed arrays
+    std::shared_ptr<const void> storage;
+};
+
 /**
  * @brief Struct to save each tree of the forest with extra informations
  *
- * @param tree A RandomForest DecisionTree 
- * @param in_bag A boolean vector with size equal to number of 
- * samples in training dataset with true if sample was seen 
- * during training
+ * @param tree A RandomForest DecisionTree, shared between ensemble snapshots
+ * @param seed The seed of the RNG used to bootstrap and fit the tree
+ * @param n_rows The number of samples of the training dataset
+ * @param n_draws The number of bootstrapped samples
+ * @param leaf_samples The targets of each leaf, when fitted with HyperParam::quantiles
  *
+ * @note The in-bag mask of the tree is not stored : it is regenerated 
+ * on demand from the seed, so that the memory of a fitted forest does
+ * not depend on the size of the training dataset.
  */
 struct ForestTree {
-    //Vector containing unique pointers to the fitted DecisionTree of the forest 
-    std::unique_ptr<DecisionTree> tree;    
-    //Saves the indices of the samples that were seen by the tree during training 
-    std::vector<bool> in_bag; 
+    //Pointer to the fitted DecisionTree ; shared so that successive 
+    //ensembles of a rolling forest do not copy the trees they keep
+    std::shared_ptr<DecisionTree> tree;    
+    //Seed of the SplitContext the tree was fitted with
+    std::uint32_t seed = 0;
+    //Number of rows of the training DataSet
+    size_t n_rows = 0;
+    //Number of bootstrapped rows
+    size_t n_draws = 0;
+    //In-bag targets of each leaf, only stored for quantile regression forests
+    std::shared_ptr<const LeafSummary> leaf_samples;
+    //Error of the tree on its OOB rows, measured during fit with HyperParam::oob_score :
+    //misclassification rate, or mean squared error over the targets
+    std::optional<float> oob_error;
+
+    /**
+     * @brief Regenerates the in-bag mask of the tree
+     * 
+     * @return A boolean vector of size n_rows with true if the sample 
+     * was seen during training
+     */
+    std::vector<bool> in_bag() const;
 
 };
 
+/**
+ * @brief Compiled forms of an ensemble, built on first use by the predict engines
+ *
+ * @param forest The ensemble ; the entry is stale once it is released
+ * @param max_leaves Number of leaves of the largest tree
+ * @param max_depth Depth of the deepest tree
+ */
+struct CompiledForest {
+    std::weak_ptr<const std::vector<ForestTree>> forest;
+    size_t max_leaves = 0;
+    int max_depth = 0;
+    std::shared_ptr<const BitvectorForest> bitvector;
+    std::shared_ptr<const ImplicitForest> implicit;
+    std::shared_ptr<const NativeForest> native;
+    //Sorted features tested by at least one node of the ensemble
+    std::vector<size_t> used_features;
+    //Order in which predict_proba_anytime() visits the trees
+    std::vector<size_t> anytime_order;
+};
+
+/**
+ * @brief Output of RandomForest::predict_proba_anytime()
+ *
+ * @param proba Average of the trees evaluated, with the layout of predict_proba()
+ * @param n_trees Number of trees averaged
+ */
+struct AnytimePrediction {
+    std::vector<float> proba;
+    int n_trees = 0;
+};
+
 class RandomForest{
 
     public:
@@ -55,46 +159,128 @@ class RandomForest{
     * (criterion, threshold computation method, and feature selection strategy).
     * 
     * @note Internally, each tree is trained using the DecisionTree::fit() method.
+    * @note With HyperParam::honest_fraction, each tree learns its structure on a 
+    * part of its distinct bootstrapped rows and its leaf values on the others.
+    * Leaves reached by none of the others take the value of their nearest 
+    * ancestor reached by some : such leaves are coarser than their split.
+    * @note With HyperParam::early_stopping_tol, trees are fitted in batches of 
+    * early_stopping_batch trees and the fit stops once a batch improves the OOB 
+    * score by less than the tolerance. The forest is then truncated to the trees
+    * fitted so far, which are the first trees of the full forest.
     */
     void fit(const DataSet& data, const SplitParam& param);
 
+    /**
+    * @brief Adds trees to an already fitted RandomForest (warm start)
+    *
+    * The existing trees are kept and only the new ones are trained, with 
+    * the next per-tree seeds : the resulting forest is identical to a 
+    * single fit with the larger number of trees. OOB accumulators, if any,
+    * are updated with the new trees ; after update(), which discards them,
+    * they restart with the new trees only.
+    *
+    * @param data The DataSet seen during training, or after update() the last batch
+    * @param param SplitParam defining the splitting policy
+    * @param n_new Number of trees to add
+    *
+    * @throws std::invalid_argument If the forest was never fitted, if n_new <= 0
+    * or if the DataSet does not match the one the newest trees were fitted on.
+    * @note Early stopping does not apply : the n_new trees are always fitted.
+    */
+    void fit_more(const DataSet& data, const SplitParam& param, int n_new);
+
+    /**
+    * @brief Rolling-window update : replaces the k oldest trees by k trees
+    * fitted on a new batch of data
+    *
+    * The ensemble size is kept fixed. New trees are fitted while the current
+    * ensemble keeps serving, then the updated ensemble is published with a 
+    * single atomic swap : predictions running concurrently see either the 
+    * previous or the updated ensemble, never a mix of both.
+    *
+    * @param data The new batch. Must have the features and targets seen during
+    * training ; for classification, labels must be classes seen during training.
+    * @param param SplitParam defining the splitting policy
+    * @param k Number of trees to replace, in [1, n_trees()]
+    *
+    * @throws std::invalid_argument If the forest was never fitted, if k is out of
+    * range or if the DataSet does not match the one seen during training.
+    * @note OOB scores computed during fit are discarded ; a later fit_more() 
+    * must be given this batch. update() and the fit methods must not run 
+    * concurrently with each other.
+    */
+    void update(const DataSet& data, const SplitParam& param, int k);
+
     //Returns whether the RandomForest has been fitted
     bool is_fitted() const {return fitted;}
     
     /**
     * @brief Predict class labels for a batch of samples.
     *
-    * Predicts the class label for each input sample by first computing
-    * class probabilities using @c predict_proba(), then applying a fixed
-    * decision threshold of 0.5. Samples with predicted probability greater
-    * than or equal to 0.5 are assigned to class 1, class 0 otherwise.
+    * Predicts the class label for each input sample as the class with the
+    * most votes among the trees. Tiles of samples are routed through one tree
+    * at a time, and the vote of a sample stops once no class can overtake the
+    * leader with the remaining trees : the label is that of the full vote. 
+    * For binary problems, class 1 wins ties, as with a threshold of 0.5 on
+    * predict_proba(). When QuickScorer, Implicit or Native evaluate the trees,
+    * or when the trees are split between threads for a small batch, the label
+    * is rather taken from the class probabilities of predict_proba().
     *
     * @param sample Non owning view over a row-major representation
     * of a set of samples. The number of features of the samples must
     * be coherent with the number of features seen in training.
     *
-    * @return A vector of predicted class labels (0 or 1), one per input sample
+    * @return A vector of predicted class labels in {0, ..., K-1}, one per input sample
     *
-    * @throws std::invalid_argument If the model has not been fitted or if the
-    * input dimensions are inconsistent with the training data.
+    * @throws std::invalid_argument If the model has not been fitted, if the
+    * input dimensions are inconsistent with the training data, or if a sample 
+    * contains NaN on a feature used by any tree.
     *
     * @note This method does not modify the state of the model
-    * @note The decision threshold is currently fixed at 0.5.
+    * @note In case of a tie between classes, the highest class is predicted.
     */
     std::vector<float> predict(std::span<const float> sample) const;
 
+    /**
+    * @brief Low-latency prediction of a single sample
+    *
+    * Returns what predict() returns for this sample, without allocating on the
+    * heap or starting threads : the trees are walked in turn (votes stopping
+    * once decided, as in predict()), or scored by the library of compile_native()
+    * or load_native() when the engine is Native or Undefined. Other engines
+    * walk the trees.
+    *
+    * @param sample Pointer to the num_features values of the sample
+    * @return The class label, or the averaged prediction for regression
+    *
+    * @throws std::invalid_argument If the model has not been fitted, if it has
+    * several outputs or if the sample contains NaN on a feature it reaches 
+    * (for classification, on a feature used by any tree, as in predict()).
+    * @throws std::logic_error If the engine is Native without a library.
+    *
+    * @note The first call after the trees change builds the description of the
+    * ensemble shared by the engines, which allocates ; multiclass forests and the
+    * native library also keep a per-thread buffer of K values.
+    */
+    float predict_one(const float* sample) const;
+
     /**
     * @brief Predict class probabilities for a batch of samples.
     *
-    * Computes the predicted probability of the positive class for each input
+    * Computes the predicted probability of the classes for each input
     * sample by averaging the votes of all decision trees in the forest.
-    * Each tree contributes a binary prediction (0 or 1), and the final
-    * probability is obtained as the percentage of trees predicting class 1
+    * Each tree votes for one class, and the probability of a class is 
+    * the percentage of trees predicting it.
     *
     * @param sample Non owning view over a row-major representation
     * of a set of samples. The number of features of the samples must
     * be coherent with the number of features seen in training
-    * @return A vector of probabilities in the range [0, 1], one per input sample
+    * @return For binary classification (and regression), a vector with one 
+    * value per input sample : the probability of class 1 (or the averaged 
+    * prediction). For K > 2 classes, a row-major vector of size 
+    * num_samples * K where output[s * K + k] is the probability of class k.
+    * For multi-output regression, a row-major vector of size num_samples * T
+    * holding the averaged prediction of each of the T targets.
     *
     * @throws std::invalid_argument If the model has not been fitted or if the
     * input dimensions are inconsistent with the training data.
@@ -103,18 +289,215 @@ class RandomForest{
     */
     std::vector<float> predict_proba(std::span<const float> sample) const;
 
+    /**
+     * @brief predict_proba() within a budget of trees or of time
+     *
+     * Tiles of BLOCKED_TILE samples are routed through the trees in the order 
+     * of anytime_order(), a whole tree over every tile before the next one, in
+     * a single parallel region of n_jobs threads. The time budget is checked 
+     * before each tile : once it is spent, no further tree is started, the 
+     * tiles already routed through it finish, and every sample averages the 
+     * same trees. The first tree is always evaluated.
+     *
+     * @param samples Row-major samples, with the number of features seen in training
+     * @param max_trees Maximum number of trees to evaluate, all of them if not set
+     * @param max_time Time after which no further tree is started, unbounded if not set
+     * @return The averaged predictions and the number of trees that contributed
+     * @throws std::invalid_argument If the forest has not been fitted, if the 
+     * dimensions of samples are incompatible, or if max_trees is lower than 1
+     * @note With a budget covering every tree, predictions match predict_proba()
+     * up to the order in which the trees are summed.
+     * @note The leaf reached by each sample in each tree of the budget is kept
+     * until the trees are summed : max_trees * num_samples integers.
+     */
+    AnytimePrediction predict_proba_anytime(std::span<const float> samples, std::optional<int> max_trees,
+                                            std::optional<std::chrono::nanoseconds> max_time = std::nullopt) const;
+
+    /**
+     * @brief Returns the order in which predict_proba_anytime() evaluates the trees
+     *
+     * Trees fitted with HyperParam::oob_score come first, by increasing OOB error ;
+     * the others follow in the order they were fitted.
+     *
+     * @return Indices of the trees of the current ensemble
+     */
+    std::vector<size_t> anytime_order() const;
+
+    /**
+     * @brief Selects how predict() and predict_proba() evaluate the trees
+     *
+     * Traversal walks each tree from its root, one sample after the other. 
+     * QuickScorer evaluates the whole forest from the thresholds of every tree
+     * sorted by feature (see BitvectorForest), built on the first prediction of 
+     * each ensemble. Blocked routes tiles of BLOCKED_TILE samples through one tree
+     * at a time, so that the nodes of the tree stay in cache for the whole tile.
+     * Implicit does the same on trees laid out breadth-first without child pointers
+     * (see ImplicitForest), for trees of at most ImplicitForest::MAX_DEPTH levels.
+     * Native calls the library of compile_native() or load_native() (see NativeForest).
+     *
+     * Undefined (the default) uses that library when the current trees have one.
+     * Otherwise it uses Blocked for batches or several threads, and Traversal for
+     * a single sample on one thread. It never selects QuickScorer or Implicit : 
+     * the bitvectors and the padded layout (up to 2^depth nodes per tree) are 
+     * private copies of the trees, which would replace the pages a loaded model
+     * shares with other processes.
+     *
+     * Blocked schedules its work on n_jobs threads : tiles of samples are shared 
+     * between threads when there are enough of them, otherwise the trees are also
+     * split in chunks of at least MIN_TREES_PER_TASK trees, each (tile, chunk) 
+     * pair being a task. Tasks write the leaf reached in each tree to their own 
+     * slots, which are summed in the order of the trees once every task is done.
+     *
+     * @param engine The engine used by the next predictions
+     * @note Every engine returns the same predictions. With QuickScorer, samples
+     * containing NaN on a feature used by any tree are rejected, as with Implicit
+     * and Native. The engine is not saved with the model.
+     */
+    void set_predict_engine(PredictEngine engine) {engine_ = engine;}
+
+    //Returns the engine selected with set_predict_engine()
+    PredictEngine get_predict_engine() const {return engine_;}
+
+    /**
+     * @brief Compiles the trees to a native shared library used by predictions
+     *
+     * The trees are generated as C++ source (see NativeForest::source()), written
+     * to path + ".cpp" and compiled with the system compiler. The library is then
+     * loaded for the current trees : the Native engine, and Undefined, use it until
+     * the trees change (fit, fit_more, update).
+     *
+     * @param path Path of the shared library, overwritten if it exists
+     * @throws std::invalid_argument If the forest has not been fitted
+     * @throws std::runtime_error If the compilation or the loading fail
+     * @note Compiling deep trees produces large sources and takes a long time :
+     * the library is meant for depth-bounded forests on latency-critical paths.
+     */
+    void compile_native(const std::string& path);
+
+    /**
+     * @brief Loads a library written by compile_native() for the current trees
+     *
+     * Lets processes serving a saved forest skip the compilation.
+     *
+     * @param path Path of the shared library
+     * @throws std::invalid_argument If the library was not compiled from these trees,
+     * e.g. when another library loaded from the same path is still in use
+     * @throws std::runtime_error If the library can't be loaded
+     */
+    void load_native(const std::string& path);
+
+    //Number of samples routed together through each tree by the Blocked engine
+    static constexpr size_t BLOCKED_TILE = 64;
+
+    //Minimum number of trees of a task when the Blocked engine splits the trees between threads
+    static constexpr size_t MIN_TREES_PER_TASK = 4;
+
     /**
      * @brief Compute the out-of-bag score of the RandomForest.
      *
      * Once fitted, allows to validate the tree by predicting samples
-     * that were not bootstrapped and seen during training.
+     * that were not bootstrapped and seen during training. Trees are 
+     * visited in parallel, each regenerating its in-bag mask.
      *
      * @param data The DataSet seen during training
      * 
-     * @return float : the accuracy of OOB prediction 
+     * @return float : the accuracy of OOB prediction for classification,
+     * the R² (averaged over targets) for regression
+     *
+     * @note When the forest was fitted with HyperParam::oob_score, the 
+     * same score is available from oob_score() without a second pass.
      */
     float out_of_bag(const DataSet& data) const;
 
+    /**
+     * @brief Returns the out-of-bag score computed during fit
+     *
+     * @return float : the accuracy of OOB prediction for classification,
+     * the R² (averaged over targets) for regression
+     * @throws std::logic_error If the forest was not fitted with HyperParam::oob_score
+     */
+    float oob_score() const;
+
+    /**
+     * @brief Returns the out-of-bag prediction of each training sample
+     *
+     * Each sample is predicted by the trees for which it was out of bag, 
+     * the accumulation being done by the workers right after each tree is
+     * built. The layout is the one of predict_proba() : the probability of 
+     * class 1 for binary classification, row-major n_rows * K class 
+     * probabilities for K > 2 classes, row-major n_rows * T averaged 
+     * predictions for regression.
+     *
+     * @return A vector of OOB predictions. Samples that were bootstrapped
+     * by every tree are set to NaN.
+     * @throws std::logic_error If the forest was not fitted with HyperParam::oob_score
+     */
+    std::vector<float> oob_prediction() const;
+
+    /**
+     * @brief Predict conditional quantiles of the target for a batch of samples
+     *
+     * Quantile Regression Forest : each tree weights the training targets of 
+     * the leaf reached by the sample by 1 / (leaf weight * n_trees), and the 
+     * quantiles are read on the weighted distribution aggregated over the trees.
+     * All quantiles are computed from a single traversal of the forest.
+     *
+     * @param samples Non owning view over a row-major representation
+     * of a set of samples, with the number of features seen in training
+     * @param qs Quantile levels, in [0, 1]
+     * @return A row-major vector of size num_samples * qs.size() where 
+     * output[s * Q + j] is the quantile qs[j] of sample s
+     *
+     * @throws std::invalid_argument If the model has not been fitted, if the
+     * input dimensions are inconsistent with the training data or if a level
+     * is not in [0, 1]
+     * @throws std::logic_error If the forest was not fitted with HyperParam::quantiles
+     */
+    std::vector<float> predict_quantiles(std::span<const float> samples, std::span<const float> qs) const;
+
+    /**
+     * @brief Writes the forest to a binary model file
+     *
+     * The file holds the hyperparameters, seed_, num_features, the OOB results
+     * and, for every tree, its seed and its node and leaf value arrays laid out
+     * as in memory (see serialization/serialization.h). An unfitted forest only
+     * stores its hyperparameters and seed.
+     *
+     * @param path Path of the file, overwritten if it exists
+     * @throws std::runtime_error If the file can't be written
+     */
+    void save(const std::string& path) const;
+
+    //Returns the content of the model file written by save()
+    std::vector<std::byte> to_bytes() const;
+
+    /**
+     * @brief Loads a forest written by save()
+     *
+     * With mmap, the nodes of every tree are read in place from the mapped 
+     * file : loading only reads the scalars of each tree, and pages are brought
+     * in by the first predictions that reach them. The mapping is released with
+     * the last tree viewing it. Without mmap, the file is read into memory.
+     *
+     * @param path Path of the model file
+     * @param mmap Whether to map the file
+     * @return The loaded forest, ready to predict
+     * @throws std::invalid_argument If the file is not a forest model of the current format version
+     * @throws std::runtime_error If the file can't be read
+     * @note Every array of the file (nodes, leaf values, quantile leaf targets, OOB
+     * accumulators) is viewed in place : worker processes mapping the same file,
+     * e.g. from /dev/shm, share a single physical copy of the model, and the memory
+     * of each process only grows with the number of trees. fit_more() copies the 
+     * OOB accumulators before adding trees to them, and the QuickScorer and Implicit
+     * engines build a private copy of the trees : select them only when that memory
+     * is acceptable.
+     * @note Nodes are not validated : only load files written by save().
+     */
+    static std::unique_ptr<RandomForest> load(const std::string& path, bool mmap = true);
+
+    //Loads a forest from the content of a model file ; the bytes are copied once
+    static std::unique_ptr<RandomForest> from_bytes(std::span<const std::byte> bytes);
+
     //Returns current seed
     std::uint32_t seed() const {return *seed_;}
 
@@ -128,10 +511,25 @@ class RandomForest{
 
     //Returns the number of sampled feature at each node
     int get_max_features() const {return mtry;}
+
+    //Returns the number of features seen during training
+    int n_features() const {return num_features;}
     
     //returns the number of trees used for fitting
     int get_estimators() const {return n_estimators;}
 
+    //Returns the number of trees in the fitted forest (lower than get_estimators() after early stopping)
+    size_t n_trees() const {return snapshot_()->size();}
+
+    //Returns the number of classes seen during training (0 for regression)
+    int n_classes() const {return n_classes_;}
+
+    //Returns whether the leaves store their training targets for predict_quantiles
+    bool stores_quantiles() const {return store_leaf_samples;}
+
+    //Returns the number of targets predicted per sample (1 except for multi-output regression)
+    int n_outputs() const {return n_outputs_;}
+
     //Returns the max depth of the trees of the forest
     std::optional<int> get_max_depth() const {
         if (max_depth.has_value()) return max_depth.value();
@@ -153,34 +551,240 @@ private:
     std::optional<int> max_depth; 
     std::optional<float> max_samples;
     std::optional<int> min_sample_split;
+    //Honest trees : fraction of the distinct bootstrapped rows learning the structure
+    std::optional<float> honest_fraction;
 
     /**
-    * @brief Private method used to fit the RandomForest.
+    * @brief Private method used to fit one tree of the RandomForest.
     *
-    * Builds the forest by training @c n_estimators decision trees on bootstrapped
-    * samples from the dataset. Random components (bootstrap sampling and
+    * Trains a decision tree on a bootstrapped sample of the dataset. 
+    * Random components (bootstrap sampling and
     * any randomized split logic such as RandomK) draw randomness from the
     * provided SplitContext.
     *
-    * @param t Fits the t tree in the forest
+    * @param t Index of the tree, from which its seed is derived
     * @param data DataSet containing input samples and target values.
     * @param param SplitParam defining the splitting policy (criterion, threshold
     * computation method, and feature selection strategy).
     * @param context SplitContext providing runtime state required for stochastic
     * training (e.g. RNG / seed).
-    * @note This method clears and rebuilds the internal tree container.
+    * @param track_oob Whether to add the OOB predictions of the tree to the accumulators
+    * @return The fitted tree
     */
-    void fit_(size_t t, const DataSet& data, const SplitParam& param, SplitContext &context);
+    ForestTree fit_(size_t t, const DataSet& data, const SplitParam& param, SplitContext &context, bool track_oob);
+
+    //Checks that the SplitParam can be used to fit the forest on data
+    void validate_fit_(const DataSet& data, const SplitParam& param) const;
+
+    /**
+     * @brief Fits n_new trees appended to the forest
+     *
+     * @param data DataSet containing input samples and target values.
+     * @param param SplitParam defining the splitting policy
+     * @param n_new Number of trees to fit, seeded from a running tree counter
+     * @param early_stopping Whether to fit in batches and stop on OOB convergence
+     * @param track_oob Whether to add the new trees to the OOB accumulators
+     *
+     * @return The fitted trees, which are not yet published
+     */
+    std::vector<ForestTree> grow_(const DataSet& data, const SplitParam& param, size_t n_new, bool early_stopping, bool track_oob);
+
+    //Returns the current ensemble ; the snapshot stays valid after a concurrent update()
+    std::shared_ptr<const std::vector<ForestTree>> snapshot_() const {return ensemble_.load(std::memory_order_acquire);}
+
+    //Atomically replaces the ensemble served by predictions
+    void publish_(std::vector<ForestTree> next);
+
+    /**
+     * @brief Returns the BitvectorForest of an ensemble, if predictions use QuickScorer
+     *
+     * The scorer is built once per ensemble and cached until the next publish_().
+     *
+     * @param forest The ensemble served by the prediction
+     * @return The scorer, or nullptr when another engine is used
+     * @throws std::logic_error If QuickScorer was selected and a tree has too many leaves
+     */
+    std::shared_ptr<const BitvectorForest> scorer_(const std::shared_ptr<const std::vector<ForestTree>>& forest) const;
+
+    /**
+     * @brief Returns the ImplicitForest of an ensemble, if predictions use the Implicit engine
+     *
+     * The layout is built once per ensemble and cached until the next publish_().
+     *
+     * @param forest The ensemble served by the prediction
+     * @return The implicit layout, or nullptr when another engine is used
+     * @throws std::logic_error If Implicit was selected and a tree is too deep
+     */
+    std::shared_ptr<const ImplicitForest> implicit_(const std::shared_ptr<const std::vector<ForestTree>>& forest) const;
+
+    /**
+     * @brief Returns the NativeForest of an ensemble, if predictions use the Native engine
+     *
+     * @param forest The ensemble served by the prediction
+     * @return The library, or nullptr when another engine is used
+     * @throws std::logic_error If Native was selected and no library was loaded for the ensemble
+     */
+    std::shared_ptr<const NativeForest> native_(const std::shared_ptr<const std::vector<ForestTree>>& forest) const;
+
+    /**
+     * @brief Attaches a native library to the current ensemble
+     *
+     * @param forest The ensemble the library was built for
+     * @param library The loaded library
+     * @param caller Name of the public method, for error messages
+     * @throws std::invalid_argument If the fingerprint of the library does not match the ensemble
+     */
+    void attach_native_(const std::shared_ptr<const std::vector<ForestTree>>& forest,
+                        std::shared_ptr<const NativeForest> library, const std::string& caller);
+
+    //Trees of an ensemble, in the order their outputs are summed
+    static std::vector<const DecisionTree*> tree_pointers_(const std::vector<ForestTree>& forest);
+
+    /**
+     * @brief Returns the compiled forms of an ensemble built so far
+     *
+     * The size of the trees is measured once per ensemble ; compiled forms are 
+     * added on first use and cached until the next publish_().
+     */
+    std::shared_ptr<const CompiledForest> compiled_(const std::shared_ptr<const std::vector<ForestTree>>& forest) const;
+
+    //Number of classes the leaves vote for in the compiled forms, 0 when they sum their outputs
+    int n_votes_() const {return (std::holds_alternative<Classification>(type_) && n_classes_ > 2) ? n_classes_ : 0;}
+
+    /**
+     * @brief Number of chunks the trees are split in by the Blocked engine
+     *
+     * @param num_samples Number of samples of the prediction
+     * @param n_trees Number of trees of the ensemble
+     * @return 1 when the tiles of samples keep every thread busy
+     */
+    size_t tree_chunks_(size_t num_samples, size_t n_trees) const;
+
+    /**
+     * @brief Majority vote of predict() for classification, with early exit
+     *
+     * Tiles of samples are routed through one tree at a time, as predict_blocked_(), 
+     * and a sample leaves its tile once its vote is decided : once no class can
+     * overtake the leader with the trees left (ties going to the highest class, 
+     * as in predict()). Labels are those of the full vote. Samples are first 
+     * checked for NaN on every feature the trees split on.
+     *
+     * @param forest The ensemble served by the prediction
+     * @param samples Row-major samples, with num_features features
+     * @return The class of each sample
+     * @throws std::invalid_argument if a sample contains NaN on a feature used by a tree
+     */
+    std::vector<float> predict_votes_(const std::shared_ptr<const std::vector<ForestTree>>& forest, std::span<const float> samples) const;
+
+    /**
+     * @brief Leader of an early-exit vote, if it is decided
+     *
+     * @param votes Votes of the K classes
+     * @param K Number of classes
+     * @param remaining Number of trees which have not voted yet
+     * @return The leader (the highest class on ties) if no class can overtake 
+     * it with the remaining trees, K otherwise
+     */
+    static size_t decided_leader_(const int* votes, size_t K, size_t remaining);
+
+    /**
+     * @brief Blocked engine of predict_proba : tiles of samples are routed 
+     * through one tree at a time
+     *
+     * @param trees The ensemble served by the prediction
+     * @param samples Row-major samples, with num_features features
+     * @return The output of predict_proba()
+     */
+    std::vector<float> predict_blocked_(const std::vector<ForestTree>& trees, std::span<const float> samples) const;
+
+    //Reads a model buffer written by to_bytes()
+    static std::unique_ptr<RandomForest> deserialize_(serialization::Reader& in);
+
+    //Current OOB accumulators : the ones of the fit, or the ones of the model file
+    std::span<const double> oob_sums_view_() const {return stored_oob_ ? stored_oob_sums_ : std::span<const double>(oob_sums_);}
+    std::span<const int> oob_counts_view_() const {return stored_oob_ ? stored_oob_counts_ : std::span<const int>(oob_counts_);}
+
+    //Forgets the OOB accumulators of the model file
+    void release_stored_oob_() {stored_oob_sums_ = {}; stored_oob_counts_ = {}; stored_oob_.reset();}
+
+    /**
+     * @brief Adds the predictions of a tree to the OOB accumulators
+     *
+     * @param tree The fitted tree
+     * @param in_bag The in-bag mask of the tree
+     * @param data The training DataSet
+     * @param sums Per-row accumulators of size n_rows * oob_width_() : 
+     * class votes for classification, summed outputs for regression
+     * @param counts Per-row number of trees for which the row is OOB
+     * @return The error of the tree on its OOB rows (see ForestTree::oob_error), 
+     * or nullopt without OOB rows
+     *
+     * @note Accumulators are updated with atomic operations and can be 
+     * shared between workers.
+     */
+    std::optional<float> accumulate_oob_(const DecisionTree& tree, const std::vector<bool>& in_bag,
+                                         const DataSet& data,
+                                         std::vector<double>& sums, std::vector<int>& counts) const;
+
+    //Computes the accuracy (classification) or R² (regression) of the OOB accumulators
+    float score_oob_(const DataSet& data, const std::vector<double>& sums, const std::vector<int>& counts) const;
+
+    /**
+     * @brief Routes the in-bag rows of a fitted tree to its leaves and 
+     * summarises their targets
+     *
+     * @param tree The fitted tree
+     * @param data DataSet the tree was fitted on
+     * @param bootstrapped_indices Rows drawn for the tree, with repetitions
+     * @return The LeafSummary of the tree
+     */
+    LeafSummary summarise_leaves_(const DecisionTree& tree, const DataSet& data, 
+                                  const std::vector<size_t>& bootstrapped_indices) const;
+
+    //Width of a row of the OOB accumulators : K classes or T targets
+    size_t oob_width_() const {
+        return std::holds_alternative<Classification>(type_) ? static_cast<size_t>(std::max(n_classes_, 2)) 
+                                                             : static_cast<size_t>(n_outputs_);}
+
+    //Returns the seed of the SplitContext used to fit the i-th tree
+    std::uint32_t tree_seed(size_t i) const {return static_cast<std::uint32_t>(helpers::derive_seed(seed_.value(), i));}
     //Wheter the RF model has already been fitted
     bool fitted = false;
     //Number of features seen during training. 
-    int num_features;
+    int num_features = 0;
+    //Number of classes K seen during training ; labels are in {0, ..., K-1}
+    int n_classes_ = 0;
+    //Number of targets seen during training
+    int n_outputs_ = 1;
     //seed : can be specified by the user (at declaration or via .set_seed()). Otherwise, 
     // is set by std::random_devices
     std::optional<std::uint32_t> seed_;
-    std::vector<ForestTree> trees;
+    //Current ensemble, swapped atomically by fit, fit_more and update
+    std::atomic<std::shared_ptr<const std::vector<ForestTree>>> ensemble_{std::make_shared<const std::vector<ForestTree>>()};
+    //Inference engine of predict_proba
+    PredictEngine engine_;
+    //Compiled forms of the last ensemble predicted with a compiled engine
+    mutable std::atomic<std::shared_ptr<const CompiledForest>> compiled_cache_;
+    //Index of the next tree to fit : seeds keep increasing across fit_more and update
+    size_t next_tree_ = 0;
     // Parallelism
     int n_jobs; 
+    //Whether OOB predictions are accumulated during fit
+    bool compute_oob = false;
+    //Early stopping : minimum OOB score improvement per batch of trees
+    std::optional<float> early_stopping_tol;
+    int early_stopping_batch = 10;
+    //OOB accumulators filled during fit (see accumulate_oob_)
+    std::vector<double> oob_sums_;
+    std::vector<int> oob_counts_;
+    //OOB accumulators of a loaded forest, read in place from its model file until fit_more() copies them
+    std::span<const double> stored_oob_sums_;
+    std::span<const int> stored_oob_counts_;
+    std::shared_ptr<const void> stored_oob_;
+    std::optional<float> oob_score_;
+    //Quantile regression : leaves keep their targets, summarised above max_leaf_samples values
+    bool store_leaf_samples = false;
+    std::optional<int> max_leaf_samples;
 
     //Accessor for tests
     friend struct arboria::test::RandomForestAccess;
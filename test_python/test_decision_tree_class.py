@@ -53,3 +53,41 @@ def test_decision_tree_min_sample_effective():
 
     assert(accuracy(pred1, pred2) != 1)
 
+
+
+def test_decision_tree_multiclass_proba():
+    from sklearn.datasets import load_iris
+
+    iris = load_iris()
+    X = iris.data.astype(np.float32)
+    y = iris.target.astype(np.int32)
+
+    tree = DecisionTreeClassifier(max_depth=3)
+    tree.fit(X, y)
+
+    proba = tree.predict_proba(X)
+    assert proba.shape == (X.shape[0], 3)
+    assert np.allclose(proba.sum(axis=1), 1.0)
+    pred = np.asarray(tree.predict(X), dtype=np.int32)
+    assert np.allclose(proba[np.arange(X.shape[0]), pred], proba.max(axis=1))
+
+
+def test_decision_tree_parallel_predict():
+    rng = np.random.default_rng(8)
+    X = rng.normal(size=(2000, 5)).astype(np.float32)
+    y = (X[:, 0] + 0.5 * X[:, 3] > 0).astype(np.float32)
+
+    tree = DecisionTreeClassifier(max_depth=8)
+    tree.fit(X, y)
+    labels = np.asarray(tree.predict(X))
+    proba = tree.predict_proba(X)
+
+    tree.n_jobs = 4
+    assert tree.n_jobs == 4
+    assert np.array_equal(np.asarray(tree.predict(X)), labels)
+    assert np.array_equal(tree.predict_proba(X), proba)
+
+    tree.n_jobs = -1
+    assert tree.n_jobs >= 1
+    with pytest.raises(ValueError):
+        tree.n_jobs = 0
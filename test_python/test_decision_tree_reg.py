@@ -30,3 +30,19 @@ def test_decision_tree_regressor_default_args():
 
     pred = tree.predict(np.array([1.0], dtype=np.float32))[0]
     assert abs(pred - 5.0) < 1e-6
+
+
+def test_decision_tree_regressor_honest_apply():
+    rng = np.random.default_rng(3)
+    X = rng.normal(size=(400, 2)).astype(np.float32)
+    y = (2 * X[:, 0] - X[:, 1]).astype(np.float32)
+
+    tree = DecisionTreeRegressor(max_depth=4, honest_fraction=0.5, n_jobs=2)
+    tree.fit(X, y)
+
+    leaves = tree.apply(X)
+    assert leaves.shape == (400,)
+    preds = np.array(tree.predict(X))
+    # rows sharing a leaf share a prediction
+    for leaf in np.unique(leaves):
+        assert np.unique(preds[leaves == leaf]).size == 1
@@ -0,0 +1,32 @@
+from arboria import GradientBoostingClassifier, GradientBoostingRegressor
+import numpy as np
+
+
+def test_gradient_boosting_regressor_fit_predict():
+    rng = np.random.default_rng(0)
+    X = rng.uniform(-1, 1, size=(300, 3)).astype(np.float32)
+    y = (np.sin(3 * X[:, 0]) + X[:, 1] ** 2).astype(np.float32)
+
+    gb = GradientBoostingRegressor(n_estimators=50, max_depth=3, seed=1)
+    gb.fit(X, y)
+
+    assert gb.is_fitted
+    loss = np.array(gb.train_loss)
+    assert loss.shape == (50,)
+    assert loss[-1] < loss[0]
+    preds = gb.predict(X)
+    assert preds.shape == (300,)
+    assert np.mean((preds - y) ** 2) < 0.2 * np.var(y)
+
+
+def test_gradient_boosting_classifier_fit_predict():
+    rng = np.random.default_rng(1)
+    X = rng.uniform(-1, 1, size=(400, 2)).astype(np.float32)
+    y = (X[:, 0] + X[:, 1] > 0).astype(np.float32)
+
+    gb = GradientBoostingClassifier(n_estimators=60, subsample=0.8, seed=2)
+    gb.fit(X, y)
+
+    proba = gb.predict_proba(X)
+    assert ((proba >= 0) & (proba <= 1)).all()
+    assert (gb.predict(X) == y).mean() > 0.9
@@ -0,0 +1,29 @@
+from arboria import IsolationForest
+import numpy as np
+
+
+def test_isolation_forest_scores_outliers_higher():
+    rng = np.random.default_rng(0)
+    X = rng.normal(size=(500, 2)).astype(np.float32)
+
+    iso = IsolationForest(n_estimators=100, n_jobs=2, seed=1)
+    iso.fit(X)
+    assert iso.is_fitted
+    assert iso.subsample_size == 256
+
+    queries = np.array([[0.0, 0.0], [6.0, 6.0]], dtype=np.float32)
+    scores = iso.score_samples(queries)
+    assert scores.shape == (2,)
+    assert scores[0] < 0.5 < scores[1]
+    assert (iso.predict(queries, threshold=0.6) == np.array([0, 1])).all()
+
+
+def test_isolation_forest_is_deterministic_across_n_jobs():
+    rng = np.random.default_rng(2)
+    X = rng.normal(size=(300, 3)).astype(np.float32)
+
+    a = IsolationForest(n_estimators=20, n_jobs=1, seed=5)
+    b = IsolationForest(n_estimators=20, n_jobs=4, seed=5)
+    a.fit(X)
+    b.fit(X)
+    assert np.array_equal(a.score_samples(X), b.score_samples(X))
@@ -0,0 +1,36 @@
+from arboria import OnlineForestClassifier, OnlineForestRegressor, accuracy
+import numpy as np
+
+
+def make_batch(rng, n, classification=True):
+    X = rng.uniform(-1, 1, size=(n, 2)).astype(np.float32)
+    if classification:
+        y = (X[:, 0] > 0.2).astype(np.float32)
+    else:
+        y = np.where(X[:, 0] > 0, 5.0, -5.0).astype(np.float32)
+    return X, y
+
+
+def test_online_forest_classifier_partial_fit():
+    rng = np.random.default_rng(0)
+    of = OnlineForestClassifier(n_estimators=8, max_features=2, seed=1)
+    for _ in range(20):
+        X, y = make_batch(rng, 100)
+        of.partial_fit(X, y)
+
+    X_test, y_test = make_batch(rng, 300)
+    preds = np.array(of.predict(X_test))
+    assert accuracy(y_test.astype(int), preds.astype(int)) > 0.9
+
+
+def test_online_forest_regressor_partial_fit():
+    rng = np.random.default_rng(1)
+    of = OnlineForestRegressor(n_estimators=5, max_features=2, seed=1, max_nodes=31)
+    for _ in range(10):
+        X, y = make_batch(rng, 100, classification=False)
+        of.partial_fit(X, y)
+
+    assert of.n_nodes <= 5 * 31
+    preds = np.array(of.predict(np.array([[0.8, 0.0], [-0.8, 0.0]], dtype=np.float32)))
+    assert abs(preds[0] - 5) < 1
+    assert abs(preds[1] + 5) < 1
@@ -1,5 +1,6 @@
 from arboria import RandomForestClassifier, accuracy
 import pytest
+import shutil
 import numpy as np
 
 def test_random_forest_init():
@@ -126,4 +127,160 @@ def test_random_forest_parallelism():
     prob1 = rf1.predict_proba(x_test)
     prob2 = rf2.predict_proba(x_test)
 
-    assert np.any(prob1 != prob2)
\ No newline at end of file
+    assert np.any(prob1 != prob2)
+
+def test_random_forest_multiclass():
+    from sklearn.datasets import load_iris
+
+    iris = load_iris()
+    X = iris.data.astype(np.float32)
+    y = iris.target.astype(np.int32)
+
+    rf = RandomForestClassifier(n_estimators=20, seed=10)
+    rf.fit(X, y)
+
+    assert rf.n_classes == 3
+    proba = rf.predict_proba(X)
+    assert proba.shape == (X.shape[0], 3)
+    assert np.allclose(proba.sum(axis=1), 1.0)
+
+    pred = rf.predict(X)
+    assert set(np.unique(pred)) <= {0, 1, 2}
+    assert accuracy(y, np.asarray(pred, dtype=np.int32)) > 0.9
+
+
+def test_random_forest_oob_score_during_fit():
+    rng = np.random.default_rng(0)
+    X = rng.normal(size=(80, 3)).astype(np.float32)
+    y = (X[:, 0] > 0).astype(np.float32)
+
+    rf = RandomForestClassifier(n_estimators=30, max_features=2, n_jobs=2, seed=3, oob_score=True)
+    rf.fit(X, y)
+
+    assert rf.oob_score_ == pytest.approx(rf.out_of_bag(X, y))
+    oob = rf.oob_prediction_
+    assert oob.shape == (80,)
+    seen = ~np.isnan(oob)
+    assert ((oob[seen] >= 0) & (oob[seen] <= 1)).all()
+
+
+def test_random_forest_oob_score_not_requested():
+    X = np.array([[0.0], [1.0], [10.0], [11.0]], dtype=np.float32)
+    y = np.array([0, 0, 1, 1], dtype=np.float32)
+    rf = RandomForestClassifier(n_estimators=3, max_features=1, seed=1)
+    rf.fit(X, y)
+    with pytest.raises(Exception):
+        rf.oob_score_
+
+
+def test_random_forest_early_stopping():
+    rng = np.random.default_rng(1)
+    X = rng.normal(size=(80, 3)).astype(np.float32)
+    y = (X[:, 0] > 0).astype(np.float32)
+
+    rf = RandomForestClassifier(n_estimators=200, max_features=2, seed=3,
+                                early_stopping_tol=2.0, early_stopping_batch=4)
+    rf.fit(X, y)
+
+    assert rf.n_trees == 8
+    assert 0 <= rf.oob_score_ <= 1
+
+
+def test_random_forest_fit_more_matches_full_fit():
+    rng = np.random.default_rng(2)
+    X = rng.normal(size=(60, 3)).astype(np.float32)
+    y = (X[:, 1] > 0).astype(np.float32)
+
+    warm = RandomForestClassifier(n_estimators=5, max_features=2, seed=9)
+    warm.fit(X, y)
+    warm.fit_more(X, y, 7)
+
+    full = RandomForestClassifier(n_estimators=12, max_features=2, seed=9)
+    full.fit(X, y)
+
+    assert warm.n_trees == 12
+    assert np.array_equal(warm.predict_proba(X), full.predict_proba(X))
+
+
+def test_random_forest_predict_engines_agree():
+    rng = np.random.default_rng(4)
+    X = rng.normal(size=(200, 5)).astype(np.float32)
+    y = np.digitize(X[:, 0] + X[:, 2], [-1, 0, 1]).astype(np.float32)
+
+    rf = RandomForestClassifier(n_estimators=25, max_depth=6, seed=2)
+    rf.fit(X, y)
+    assert rf.predict_engine == "auto"
+    auto = rf.predict_proba(X)
+
+    rf.predict_engine = "traversal"
+    walked = rf.predict_proba(X)
+    rf.predict_engine = "quickscorer"
+    assert np.array_equal(rf.predict_proba(X), walked)
+    rf.predict_engine = "blocked"
+    assert np.array_equal(rf.predict_proba(X), walked)
+    rf.predict_engine = "implicit"
+    assert np.array_equal(rf.predict_proba(X), walked)
+    assert np.array_equal(auto, walked)
+
+    with pytest.raises(ValueError):
+        rf.predict_engine = "gpu"
+
+
+@pytest.mark.skipif(shutil.which("c++") is None, reason="requires a C++ compiler")
+def test_random_forest_compile_native(tmp_path):
+    rng = np.random.default_rng(5)
+    X = rng.normal(size=(200, 4)).astype(np.float32)
+    y = (X[:, 0] - X[:, 3] > 0).astype(np.float32)
+
+    rf = RandomForestClassifier(n_estimators=10, max_depth=5, seed=3)
+    rf.fit(X, y)
+    walked = rf.predict_proba(X)
+
+    rf.compile_native(tmp_path / "forest.so")
+    assert (tmp_path / "forest.so.cpp").exists()
+    rf.predict_engine = "native"
+    assert np.array_equal(rf.predict_proba(X), walked)
+
+    rf.save(tmp_path / "forest.bin")
+    served = RandomForestClassifier.load(tmp_path / "forest.bin")
+    served.load_native(tmp_path / "forest.so")
+    served.predict_engine = "native"
+    assert np.array_equal(served.predict_proba(X), walked)
+
+
+def test_random_forest_predict_proba_anytime():
+    rng = np.random.default_rng(6)
+    X = rng.normal(size=(150, 4)).astype(np.float32)
+    y = (X[:, 0] + X[:, 1] > 0).astype(np.float32)
+
+    rf = RandomForestClassifier(n_estimators=12, max_depth=4, oob_score=True, seed=4)
+    rf.fit(X, y)
+
+    proba, n_trees = rf.predict_proba_anytime(X, max_trees=5)
+    assert n_trees == 5
+    assert proba.shape == (150,)
+
+    proba, n_trees = rf.predict_proba_anytime(X)
+    assert n_trees == 12
+    assert np.allclose(proba, rf.predict_proba(X), atol=1e-5)
+
+    _, n_trees = rf.predict_proba_anytime(X, max_time=0.0)
+    assert n_trees == 1
+
+
+def test_random_forest_predict_one():
+    rng = np.random.default_rng(7)
+    X = rng.normal(size=(100, 4)).astype(np.float32)
+    y = (X[:, 0] + X[:, 2] > 0).astype(np.float32) + (X[:, 1] > 0.5)
+
+    rf = RandomForestClassifier(n_estimators=15, seed=5)
+    rf.fit(X, y)
+    labels = rf.predict(X)
+    for i in range(10):
+        assert rf.predict_one(X[i]) == labels[i]
+    assert rf.predict_one(X[:1]) == labels[0]
+
+    with pytest.raises(Exception):
+        rf.predict_one(X[:2])
+    with pytest.raises(ValueError):
+        rf.predict_one(X[0, :3])
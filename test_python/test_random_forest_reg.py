@@ -1,5 +1,6 @@
 from arboria import RandomForestRegressor
 import numpy as np
+import pytest
 
 
 def test_random_forest_regressor_instanciation():
@@ -34,3 +35,70 @@ def test_random_forest_regressor_reproductible():
     pred2 = rf2.predict(sample)
 
     assert np.all(pred1 == pred2)
+
+
+def test_random_forest_regressor_multi_output():
+    X = np.array([[0.0], [0.0], [10.0], [10.0]], dtype=np.float32)
+    y = np.array([[1.0, -1.0], [3.0, -3.0], [5.0, -5.0], [7.0, -7.0]], dtype=np.float32)
+
+    rf = RandomForestRegressor(n_estimators=5, max_features=1, max_depth=1, seed=10)
+    rf.fit(X, y)
+
+    assert rf.n_outputs == 2
+    preds = rf.predict(np.array([[0.0], [10.0]], dtype=np.float32))
+    assert preds.shape == (2, 2)
+    assert np.allclose(preds[:, 0], -preds[:, 1])
+
+
+def test_random_forest_regressor_oob_score():
+    rng = np.random.default_rng(0)
+    X = rng.normal(size=(80, 2)).astype(np.float32)
+    y = (2 * X[:, 0] - X[:, 1]).astype(np.float32)
+
+    rf = RandomForestRegressor(n_estimators=30, max_features=2, n_jobs=2, seed=3, oob_score=True)
+    rf.fit(X, y)
+
+    assert 0.5 < rf.oob_score_ <= 1.0
+    assert np.isclose(rf.oob_score_, rf.out_of_bag(X, y), atol=1e-5)
+    assert rf.oob_prediction_.shape == (80,)
+
+
+def test_random_forest_regressor_rolling_update():
+    rng = np.random.default_rng(4)
+    X = rng.normal(size=(60, 2)).astype(np.float32)
+    y = X[:, 0].astype(np.float32)
+
+    rf = RandomForestRegressor(n_estimators=6, max_features=2, seed=5)
+    rf.fit(X, y)
+
+    X_new = rng.normal(size=(30, 2)).astype(np.float32)
+    y_new = (X_new[:, 0] + 10).astype(np.float32)
+    before = np.array(rf.predict(X_new))
+    rf.update(X_new, y_new, 6)
+
+    assert rf.n_trees == 6
+    assert (np.array(rf.predict(X_new)) > before + 5).all()
+
+
+def test_random_forest_regressor_predict_quantiles():
+    rng = np.random.default_rng(8)
+    X = rng.uniform(0, 1, size=(200, 1)).astype(np.float32)
+    y = (X[:, 0] + rng.normal(scale=0.1, size=200)).astype(np.float32)
+
+    rf = RandomForestRegressor(n_estimators=20, max_features=1, min_sample_split=10, seed=2, quantiles=True)
+    rf.fit(X, y)
+
+    q = rf.predict_quantiles(X, [0.1, 0.5, 0.9])
+    assert q.shape == (200, 3)
+    assert (q[:, 0] <= q[:, 1]).all() and (q[:, 1] <= q[:, 2]).all()
+    assert rf.predict_quantiles(X, 0.5).shape == (200,)
+
+    sketch = RandomForestRegressor(n_estimators=20, max_features=1, min_sample_split=10, seed=2, max_leaf_samples=4)
+    sketch.fit(X, y)
+    q_sketch = sketch.predict_quantiles(X, [0.1, 0.9])
+    assert (q_sketch[:, 0] <= q_sketch[:, 1]).all()
+
+    plain = RandomForestRegressor(n_estimators=2, max_features=1, seed=2)
+    plain.fit(X, y)
+    with pytest.raises(RuntimeError):
+        plain.predict_quantiles(X, 0.5)
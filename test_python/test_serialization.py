@@ -0,0 +1,120 @@
+from arboria import DecisionTreeClassifier, RandomForestClassifier, RandomForestRegressor
+from concurrent.futures import ProcessPoolExecutor
+import numpy as np
+import pickle
+import pytest
+
+
+def _data(classification):
+    rng = np.random.default_rng(0)
+    X = rng.normal(size=(150, 4)).astype(np.float32)
+    if classification:
+        y = (X[:, 0] + X[:, 1] > 0).astype(np.float32)
+    else:
+        y = (2 * X[:, 0] - X[:, 2]).astype(np.float32)
+    return X, y
+
+
+def test_decision_tree_save_load(tmp_path):
+    X, y = _data(True)
+    tree = DecisionTreeClassifier(max_depth=4)
+    tree.fit(X, y)
+    path = tmp_path / "tree.arb"
+    tree.save(path)
+
+    for mmap in (True, False):
+        loaded = DecisionTreeClassifier.load(path, mmap=mmap)
+        assert isinstance(loaded, DecisionTreeClassifier)
+        assert np.array_equal(loaded.predict(X), tree.predict(X))
+        assert np.array_equal(loaded.predict_proba(X), tree.predict_proba(X))
+
+
+@pytest.mark.parametrize("mmap", [True, False])
+def test_random_forest_save_load(tmp_path, mmap):
+    X, y = _data(False)
+    rf = RandomForestRegressor(n_estimators=10, max_depth=5, seed=3, quantiles=True)
+    rf.fit(X, y)
+    path = tmp_path / "forest.arb"
+    rf.save(path)
+
+    loaded = RandomForestRegressor.load(path, mmap=mmap)
+    assert isinstance(loaded, RandomForestRegressor)
+    assert loaded.n_trees == 10
+    assert np.array_equal(loaded.predict(X), rf.predict(X))
+    assert np.array_equal(loaded.predict_quantiles(X, [0.1, 0.9]), rf.predict_quantiles(X, [0.1, 0.9]))
+
+
+def test_loaded_random_forest_fit_more(tmp_path):
+    X, y = _data(True)
+    rf = RandomForestClassifier(n_estimators=5, seed=4)
+    rf.fit(X, y)
+    path = tmp_path / "forest.arb"
+    rf.save(path)
+
+    loaded = RandomForestClassifier.load(path)
+    loaded.fit_more(X, y, 3)
+    rf.fit_more(X, y, 3)
+    assert loaded.n_trees == 8
+    assert np.array_equal(loaded.predict_proba(X), rf.predict_proba(X))
+
+
+def _predict_from_file(path, X):
+    return RandomForestRegressor.load(path).predict(X)
+
+
+def test_worker_processes_share_a_saved_forest(tmp_path):
+    X, y = _data(False)
+    rf = RandomForestRegressor(n_estimators=10, max_depth=5, seed=6, quantiles=True)
+    rf.fit(X, y)
+    path = tmp_path / "shared.arb"
+    rf.save(path)
+
+    #every worker maps the same file instead of unpickling its own copy
+    with ProcessPoolExecutor(max_workers=3) as pool:
+        preds = list(pool.map(_predict_from_file, [path] * 3, [X] * 3))
+    for p in preds:
+        assert np.array_equal(p, rf.predict(X))
+
+    #saving again replaces the file without touching the models mapping it
+    loaded = RandomForestRegressor.load(path)
+    before = loaded.predict(X)
+    rf.fit_more(X, y, 2)
+    rf.save(path)
+    assert np.array_equal(loaded.predict(X), before)
+    assert RandomForestRegressor.load(path).n_trees == 12
+
+
+def test_load_rejects_invalid_files(tmp_path):
+    path = tmp_path / "not_a_model.arb"
+    path.write_bytes(b"not an arboria model")
+    with pytest.raises(ValueError):
+        RandomForestClassifier.load(path)
+    with pytest.raises(RuntimeError):
+        DecisionTreeClassifier.load(tmp_path / "missing.arb")
+
+
+def test_pickle_fitted_models():
+    X, y = _data(True)
+    rf = RandomForestClassifier(n_estimators=8, seed=5, oob_score=True)
+    rf.fit(X, y)
+    tree = DecisionTreeClassifier(max_depth=3)
+    tree.fit(X, y)
+
+    rf_copy = pickle.loads(pickle.dumps(rf))
+    assert isinstance(rf_copy, RandomForestClassifier)
+    assert rf_copy.mtry == rf.mtry
+    assert np.array_equal(rf_copy.predict_proba(X), rf.predict_proba(X))
+    assert rf_copy.oob_score_ == rf.oob_score_
+
+    tree_copy = pickle.loads(pickle.dumps(tree))
+    assert isinstance(tree_copy, DecisionTreeClassifier)
+    assert np.array_equal(tree_copy.predict(X), tree.predict(X))
+
+
+def test_pickle_unfitted_model_fits_like_the_original():
+    X, y = _data(False)
+    rf = RandomForestRegressor(n_estimators=4, max_depth=3, seed=8)
+    rf_copy = pickle.loads(pickle.dumps(rf))
+    rf.fit(X, y)
+    rf_copy.fit(X, y)
+    assert np.array_equal(rf_copy.predict(X), rf.predict(X))
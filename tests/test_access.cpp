@@ -12,10 +12,22 @@ const std::optional<size_t> arboria::test::DecisionTreeAccess::access_min_sample
 
 }
 
+bool arboria::test::DecisionTreeAccess::access_nodes_are_view(const arboria::DecisionTree &tree){
+
+    return tree.nodes_.is_view();
+
+}
+
 
 const arboria::ForestTree& arboria::test::RandomForestAccess::access_forest_trees(const arboria::RandomForest &rf, size_t i_tree){
 
-    return rf.trees[i_tree];
+    return (*rf.snapshot_())[i_tree];
+
+}
+
+std::shared_ptr<const arboria::CompiledForest> arboria::test::RandomForestAccess::access_compiled_forest(const arboria::RandomForest &rf){
+
+    return rf.compiled_(rf.snapshot_());
 
 }
 }//end of namespace
\ No newline at end of file
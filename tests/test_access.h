@@ -1,6 +1,7 @@
 #pragma once
 #include "tree/DecisionTree/DecisionTree.h"
 #include "tree/RandomForest/randomforest.h"
+#include <memory>
 #include <optional>
 
 namespace arboria::test{
@@ -8,12 +9,16 @@ namespace arboria::test{
 //access to private arguments of DecisionTree
 struct DecisionTreeAccess {
     static const std::optional<size_t> access_min_samples_split(const arboria::DecisionTree& t);
+    //Whether the nodes of the tree are a view over a loaded model
+    static bool access_nodes_are_view(const arboria::DecisionTree& t);
 };
 
 //access to private arguments of RandomForest
 struct RandomForestAccess {
     //Allows to access the ith ForestTree of the RandomForest. 
     static const arboria::ForestTree& access_forest_trees(const arboria::RandomForest& rf, size_t i_tree);
+    //Compiled forms of the current ensemble built by the predict engines
+    static std::shared_ptr<const arboria::CompiledForest> access_compiled_forest(const arboria::RandomForest& rf);
 };
 
 }//end of namespace
\ No newline at end of file
@@ -540,3 +540,67 @@ TEST_CASE("best_split + randomk : errors - mtry illegal") {
     }
 
 }
+
+
+TEST_CASE("best_split : multiclass perfect split - Gini") {
+
+    std::vector<float> x{1, 5,
+                        2, 5,
+                        10, 5,
+                        11, 5,
+                        20, 5,
+                        21, 5};
+    std::vector<float> y{0, 0, 1, 1, 2, 2};
+
+    DataSet data(x, y, 6, 2);
+    std::vector<int> rows {0,1,2,3,4,5};
+    std::span s(rows);
+
+    SplitParam param{Classification{}, Gini{}, CART{}, AllFeatures{}};
+
+    Splitter splitter;
+    SplitResult b_split = splitter.best_split(s, data, param);
+
+    REQUIRE(b_split.split_feature == 0);
+    REQUIRE((b_split.split_threshold == Catch::Approx(6.f) || b_split.split_threshold == Catch::Approx(15.5f)));
+    // one pure child of 2 samples, one child of 4 samples split evenly between 2 classes
+    REQUIRE(b_split.score == Catch::Approx((4.f/6.f) * 0.5f));
+}
+
+TEST_CASE("best_split : non integer class labels") {
+
+    std::vector<float> x{1, 2, 3, 4};
+    std::vector<float> y{0, 0.5f, 1, 1};
+
+    DataSet data(x, y, 4, 1);
+    std::vector<int> rows {0,1,2,3};
+    std::span s(rows);
+
+    SplitParam param{Classification{}, Gini{}, CART{}, AllFeatures{}};
+
+    Splitter splitter;
+    REQUIRE_THROWS_AS(splitter.best_split(s, data, param), std::invalid_argument);
+}
+
+TEST_CASE("best_split : multi-output regression sums the SSE of every target") {
+
+    // target 0 is split at x = 1.5, target 1 (with a larger range) at x = 2.5
+    std::vector<float> x{0, 1, 2, 3};
+    std::vector<float> y{0, 0,
+                        0, 0,
+                        1, 0,
+                        1, 100};
+
+    DataSet data(x, y, 4, 1, 2);
+    std::vector<int> rows {0,1,2,3};
+    std::span s(rows);
+
+    SplitParam param{Regression{}, SSE{}, CART{}, AllFeatures{}};
+    Splitter splitter;
+    SplitResult b_split = splitter.best_split(s, data, param);
+
+    REQUIRE(b_split.split_feature == 0);
+    REQUIRE(b_split.split_threshold == Catch::Approx(2.5f));
+    // left {0, 0, 1} on target 0 : SSE = 2/3 ; everything else is pure
+    REQUIRE(b_split.score == Catch::Approx(2.f/3.f));
+}
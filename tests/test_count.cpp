@@ -70,4 +70,35 @@ SECTION("Negative index"){
     REQUIRE_THROWS_AS(count_classes(s, y), std::out_of_range);
     }
 
-}
\ No newline at end of file
+}
+
+
+TEST_CASE("class_counts : multiclass") {
+
+SECTION("Number of classes"){
+    REQUIRE(num_classes(std::vector<float>{0, 2, 1, 4}) == 5);
+    REQUIRE(num_classes(std::vector<float>{0, 0}) == 2);
+    REQUIRE_THROWS_AS(num_classes(std::vector<float>{0, 1.5f}), std::invalid_argument);
+    REQUIRE_THROWS_AS(num_classes(std::vector<float>{-1, 1}), std::invalid_argument);
+    }
+
+SECTION("Count from span"){
+    std::vector<float> y{0, 2, 1, 2, 2, 0};
+    std::vector<int> rows{1, 2, 3, 5};
+    std::vector<int> counts = class_counts(std::span<const int>(rows), y, 3);
+    REQUIRE(counts == std::vector<int>{1, 1, 2});
+    }
+
+SECTION("Label out of range"){
+    std::vector<float> y{0, 3};
+    std::vector<int> rows{0, 1};
+    REQUIRE_THROWS_AS(class_counts(std::span<const int>(rows), y, 3), std::out_of_range);
+    }
+
+SECTION("Majority class with ties"){
+    REQUIRE(majority_class(std::vector<int>{1, 4, 2}) == 1);
+    REQUIRE(majority_class(std::vector<int>{3, 3}) == 1);
+    REQUIRE(majority_class(std::vector<int>{5, 2, 5}) == 2);
+    }
+
+}
@@ -181,3 +181,28 @@ TEST_CASE("iloc out of range") {
 
 }
 
+TEST_CASE("Multi-output DataSet") {
+
+    std::vector<float> x{1,2,
+                        3,4,
+                        5,6};
+    std::vector<float> y{0, 10,
+                        1, 11,
+                        2, 12};
+
+    DataSet data(x, y, 3, 2, 2);
+
+    REQUIRE(data.n_targets() == 2);
+    REQUIRE(data.iloc_y(1) == 1);
+    REQUIRE(data.iloc_y(1, 1) == 11);
+    REQUIRE_THROWS_AS(data.iloc_y(1, 2), std::out_of_range);
+
+    DataSet sub = data.index_split({2, 0});
+    REQUIRE(sub.n_targets() == 2);
+    REQUIRE(sub.iloc_y(0, 1) == 12);
+    REQUIRE(sub.iloc_y(1, 0) == 0);
+
+    REQUIRE_THROWS_AS(DataSet(x, y, 3, 2, 3), std::invalid_argument);
+    REQUIRE_THROWS_AS(DataSet(x, y, 3, 2, 0), std::invalid_argument);
+    REQUIRE(DataSet(x, std::vector<float>{0, 1, 2}, 3, 2).n_targets() == 1);
+}
@@ -0,0 +1,26 @@
+#include "test_datasets.h"
+#include "dataset/dataset.h"
+#include <random>
+#include <vector>
+
+
+namespace arboria::test{
+
+arboria::DataSet make_noisy_dataset(bool classification, int n_rows, std::uint32_t seed, float target_noise){
+
+    std::mt19937 rng(seed);
+    std::normal_distribution<float> noise(0.f, 1.f);
+    std::vector<float> X;
+    std::vector<float> y;
+    for (int i = 0; i < n_rows; i++){
+        float a = noise(rng);
+        float b = noise(rng);
+        X.push_back(a);
+        X.push_back(b);
+        if (classification) y.push_back((a + 0.5f * noise(rng) > 0.f) ? 1.f : 0.f);
+        else y.push_back(2.f * a - b + target_noise * noise(rng));
+    }
+    return arboria::DataSet(X, y, n_rows, 2);
+
+}
+}//end of namespace
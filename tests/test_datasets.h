@@ -0,0 +1,11 @@
+#pragma once
+#include "dataset/dataset.h"
+#include <cstdint>
+
+namespace arboria::test{
+
+//Noisy binary classes (a + noise > 0), or a noisy linear target (2a - b + noise), 
+//on 2 gaussian features a and b ; target_noise scales the noise of the regression target
+arboria::DataSet make_noisy_dataset(bool classification, int n_rows = 60, std::uint32_t seed = 7, float target_noise = 0.3f);
+
+}//end of namespace
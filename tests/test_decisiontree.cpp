@@ -4,8 +4,13 @@
 
 #include <catch2/catch_test_macros.hpp>
 #include <catch2/catch_approx.hpp>
+#include <algorithm>
+#include <iterator>
 #include <limits>
+#include <numeric>
+#include <random>
 #include <stdexcept>
+#include <vector>
 
 #include "tree/DecisionTree/DecisionTree.h"
 #include "split_strategy/types/split_param.h"
@@ -13,6 +18,8 @@
 #include "split_strategy/types/ParamBuilder/ParamBuilder.h"
 #include "tree/TreeModel.h"
 
+#include "test_datasets.h"
+
 TEST_CASE("DecisionTree :  predict_one() basic usage - fit") {
 
 
@@ -494,3 +501,305 @@ TEST_CASE("DecisionTreeRegressor : unsplittable data returns mean") {
 
     REQUIRE(pred == Catch::Approx(5.f));
 }
+
+TEST_CASE("DecisionTree : multiclass predict and predict_proba") {
+
+    std::vector<float> X {0,
+                        1,
+                        10,
+                        11,
+                        20,
+                        21,
+                        22};
+    std::vector<float> y {0, 0, 1, 1, 2, 2, 1};
+
+    arboria::DataSet data(X, y, 7, 1);
+    HyperParam h_param{.max_depth = 2};
+    arboria::DecisionTree tree(h_param, Classification{});
+    SplitParam params = arboria::ParamBuilder(TreeModel::DecisionTree, Classification{});
+    tree.fit(data, params);
+
+    REQUIRE(tree.n_classes() == 3);
+
+    std::vector<float> samples {0, 10.5, 21};
+    std::vector<float> preds = tree.predict(samples);
+    REQUIRE(preds == std::vector<float>{0, 1, 2});
+
+    std::vector<float> proba = tree.predict_proba(samples);
+    REQUIRE(proba.size() == 9);
+    REQUIRE(proba[0] == Catch::Approx(1.f));
+    REQUIRE(proba[4] == Catch::Approx(1.f));
+    for (size_t s = 0; s < 3; s++){
+        REQUIRE(proba[s*3] + proba[s*3+1] + proba[s*3+2] == Catch::Approx(1.f));
+    }
+    // leaf reached by 21 holds {20, 21, 22} : 2 samples of class 2, 1 of class 1
+    REQUIRE(proba[8] == Catch::Approx(2.f/3.f));
+}
+
+TEST_CASE("DecisionTree : predict_proba error on regression tree") {
+
+    std::vector<float> X {0, 1, 2, 3};
+    std::vector<float> y {0.5, 1.5, 2.5, 3.5};
+
+    arboria::DataSet data(X, y, 4, 1);
+    arboria::DecisionTree tree(HyperParam{}, Regression{});
+    SplitParam params = arboria::ParamBuilder(TreeModel::DecisionTree, Regression{});
+    tree.fit(data, params);
+
+    std::vector<float> samples {0};
+    REQUIRE_THROWS_AS(tree.predict_proba(samples), std::invalid_argument);
+}
+
+TEST_CASE("DecisionTreeRegressor : multi-output leaves store mean vectors") {
+
+    std::vector<float> X {0,
+                        1,
+                        10,
+                        11};
+    std::vector<float> y {1, -1,
+                        3, -3,
+                        5, -5,
+                        7, -7};
+
+    arboria::DataSet data(X, y, 4, 1, 2);
+    HyperParam h_param{.max_depth = 1};
+    arboria::DecisionTree tree(h_param, Regression{});
+    SplitParam params = arboria::ParamBuilder(TreeModel::DecisionTree, Regression{});
+    tree.fit(data, params);
+
+    REQUIRE(tree.n_outputs() == 2);
+
+    std::vector<float> sample {0};
+    std::span<const float> outputs = tree.predict_outputs_one(sample);
+    REQUIRE(outputs.size() == 2);
+    REQUIRE(outputs[0] == Catch::Approx(2.f));
+    REQUIRE(outputs[1] == Catch::Approx(-2.f));
+    REQUIRE_THROWS_AS(tree.predict_one(sample), std::invalid_argument);
+
+    std::vector<float> samples {0, 10};
+    std::vector<float> preds = tree.predict(samples);
+    REQUIRE(preds.size() == 4);
+    REQUIRE(preds[2] == Catch::Approx(6.f));
+    REQUIRE(preds[3] == Catch::Approx(-6.f));
+}
+
+TEST_CASE("DecisionTree : classification rejects multi-output targets") {
+
+    std::vector<float> X {0, 1};
+    std::vector<float> y {0, 1, 1, 0};
+
+    arboria::DataSet data(X, y, 2, 1, 2);
+    arboria::DecisionTree tree(HyperParam{}, Classification{});
+    SplitParam params = arboria::ParamBuilder(TreeModel::DecisionTree, Classification{});
+    REQUIRE_THROWS_AS(tree.fit(data, params), std::invalid_argument);
+}
+
+TEST_CASE("DecisionTree : leaf_index points to the leaf giving the prediction") {
+
+    std::vector<float> X {0, 1, 10, 11};
+    std::vector<float> y {1, 1, 5, 5};
+
+    arboria::DataSet data(X, y, 4, 1);
+    arboria::DecisionTree tree(HyperParam{}, Regression{});
+    SplitParam params = arboria::ParamBuilder(TreeModel::DecisionTree, Regression{});
+
+    std::vector<float> sample {0};
+    REQUIRE_THROWS_AS(tree.leaf_index(sample), std::invalid_argument);
+
+    tree.fit(data, params);
+    REQUIRE(tree.n_nodes() >= 3);
+
+    std::vector<float> low {0.5f};
+    std::vector<float> high {10.5f};
+    int low_leaf = tree.leaf_index(low);
+    int high_leaf = tree.leaf_index(high);
+    REQUIRE(low_leaf != high_leaf);
+    REQUIRE(low_leaf > 0);
+    REQUIRE(static_cast<size_t>(high_leaf) < tree.n_nodes());
+
+    std::vector<float> wrong {0, 1};
+    REQUIRE_THROWS_AS(tree.leaf_index(wrong), std::invalid_argument);
+}
+
+TEST_CASE("DecisionTree : apply routes every sample to its leaf") {
+
+    arboria::DataSet data = arboria::test::make_noisy_dataset(false, 700, 11, 0.5f);
+    SplitParam params = arboria::ParamBuilder(TreeModel::DecisionTree, Regression{});
+
+    for (int n_jobs : {1, 3}){
+        arboria::DecisionTree tree(HyperParam{.max_depth = 6, .n_jobs = n_jobs}, Regression{});
+        REQUIRE_THROWS_AS(tree.apply(data.X()), std::invalid_argument);
+        tree.fit(data, params);
+
+        //700 rows : several blocks, the last one partial
+        std::vector<int> leaves = tree.apply(data.X());
+        REQUIRE(leaves.size() == 700);
+        for (int i = 0; i < 700; i++){
+            std::span<const float> sample(data.X().data() + 2*i, 2);
+            REQUIRE(leaves[i] == tree.leaf_index(sample));
+        }
+    }
+
+    arboria::DecisionTree tree(HyperParam{.max_depth = 3}, Regression{});
+    tree.fit(data, params);
+    std::vector<float> wrong {0.f, 0.f, 0.f};
+    REQUIRE_THROWS_AS(tree.apply(wrong), std::invalid_argument);
+    std::vector<float> with_nan {std::numeric_limits<float>::quiet_NaN(), std::numeric_limits<float>::quiet_NaN()};
+    REQUIRE_THROWS_AS(tree.apply(with_nan), std::invalid_argument);
+}
+
+TEST_CASE("DecisionTree : honest_fraction validation") {
+
+    REQUIRE_THROWS_AS(arboria::DecisionTree(HyperParam{.honest_fraction = 0.f}, Regression{}), std::invalid_argument);
+    REQUIRE_THROWS_AS(arboria::DecisionTree(HyperParam{.honest_fraction = 1.f}, Regression{}), std::invalid_argument);
+    REQUIRE_THROWS_AS(arboria::DecisionTree(HyperParam{.n_jobs = 0}, Regression{}), std::invalid_argument);
+
+    //a single distinct row can't be split between structure and estimation
+    std::vector<float> X {1, 1, 1};
+    std::vector<float> y {0, 0, 0};
+    arboria::DataSet data(X, y, 3, 1);
+    std::vector<int> idx {0, 0, 0};
+    arboria::DecisionTree tree(HyperParam{.honest_fraction = 0.5f}, Regression{});
+    SplitParam params = arboria::ParamBuilder(TreeModel::DecisionTree, Regression{});
+    REQUIRE_THROWS_AS(tree.fit(data, idx, params), std::invalid_argument);
+}
+
+TEST_CASE("DecisionTree : honest leaves hold the means of the estimation rows") {
+
+    arboria::DataSet data = arboria::test::make_noisy_dataset(false, 400, 11, 0.5f);
+    SplitParam params = arboria::ParamBuilder(TreeModel::DecisionTree, Regression{});
+    arboria::DecisionTree tree(HyperParam{.max_depth = 4, .n_jobs = 2, .honest_fraction = 0.5f}, Regression{});
+
+    std::vector<int> idx(400);
+    std::iota(idx.begin(), idx.end(), 0);
+    SplitContext context(5);
+    tree.fit(data, idx, params, context);
+
+    //fit leaves the structure rows in front of idx, then the estimation rows
+    std::vector<int> estimation(idx.begin() + 200, idx.end());
+    std::vector<int> structure(idx.begin(), idx.begin() + 200);
+    std::sort(estimation.begin(), estimation.end());
+    std::sort(structure.begin(), structure.end());
+    std::vector<int> shared;
+    std::set_intersection(estimation.begin(), estimation.end(), structure.begin(), structure.end(), std::back_inserter(shared));
+    REQUIRE(shared.empty());
+
+    std::vector<double> sums(tree.n_nodes(), 0.0);
+    std::vector<int> counts(tree.n_nodes(), 0);
+    for (int row : estimation){
+        std::span<const float> sample(data.X().data() + 2*row, 2);
+        int leaf = tree.leaf_index(sample);
+        sums[leaf] += data.iloc_y(row);
+        counts[leaf]++;
+    }
+    int checked = 0;
+    for (int row : estimation){
+        std::span<const float> sample(data.X().data() + 2*row, 2);
+        int leaf = tree.leaf_index(sample);
+        REQUIRE(tree.predict_one(sample) == Catch::Approx(sums[leaf] / counts[leaf]).margin(1e-4));
+        checked++;
+    }
+    REQUIRE(checked == 200);
+}
+
+TEST_CASE("DecisionTree : honest leaves without estimation rows take their nearest estimated ancestor") {
+
+    //few estimation rows for many small leaves : some leaves see none of them
+    arboria::DataSet data = arboria::test::make_noisy_dataset(false, 300, 11, 0.5f);
+    SplitParam params = arboria::ParamBuilder(TreeModel::DecisionTree, Regression{});
+    arboria::DecisionTree tree(HyperParam{.min_sample_split = 2, .honest_fraction = 0.875f}, Regression{});
+    std::vector<int> idx(300);
+    std::iota(idx.begin(), idx.end(), 0);
+    SplitContext context(3);
+    tree.fit(data, idx, params, context);
+    const std::vector<int> estimation(idx.begin() + 262, idx.end());
+
+    //estimation rows below each node
+    std::span<const arboria::Node> nodes = tree.nodes();
+    std::vector<int> parent(nodes.size(), -1);
+    for (size_t n = 0; n < nodes.size(); n++){
+        if (nodes[n].is_leaf) continue;
+        parent[static_cast<size_t>(nodes[n].left_child)] = static_cast<int>(n);
+        parent[static_cast<size_t>(nodes[n].right_child)] = static_cast<int>(n);
+    }
+    std::vector<double> sums(nodes.size(), 0.0);
+    std::vector<int> counts(nodes.size(), 0);
+    for (int row : estimation){
+        for (int n = tree.leaf_index(std::span<const float>(data.X().data() + 2*row, 2)); n >= 0; n = parent[static_cast<size_t>(n)]){
+            sums[static_cast<size_t>(n)] += data.iloc_y(row);
+            counts[static_cast<size_t>(n)]++;
+        }
+    }
+
+    int empty_leaves = 0;
+    for (size_t n = 0; n < nodes.size(); n++){
+        if (!nodes[n].is_leaf) continue;
+        size_t source = n;
+        if (counts[n] == 0) empty_leaves++;
+        while (counts[source] == 0) source = static_cast<size_t>(parent[source]);
+        REQUIRE(nodes[n].leaf_value == Catch::Approx(sums[source] / counts[source]).margin(1e-4));
+    }
+    REQUIRE(empty_leaves > 0);
+}
+
+TEST_CASE("DecisionTree : honest classification leaves store distributions") {
+
+    arboria::DataSet data = arboria::test::make_noisy_dataset(true, 300, 11, 0.5f);
+    SplitParam params = arboria::ParamBuilder(TreeModel::DecisionTree, Classification{});
+    arboria::DecisionTree tree(HyperParam{.max_depth = 3, .honest_fraction = 0.4f}, Classification{});
+    tree.fit(data, params);
+
+    std::vector<float> proba = tree.predict_proba(data.X());
+    std::vector<float> preds = tree.predict(data.X());
+    REQUIRE(proba.size() == 600);
+    int correct = 0;
+    for (int i = 0; i < 300; i++){
+        REQUIRE(proba[2*i] + proba[2*i + 1] == Catch::Approx(1.f));
+        REQUIRE(preds[i] == ((proba[2*i + 1] >= proba[2*i]) ? 1.f : 0.f));
+        if (preds[i] == data.iloc_y(i)) correct++;
+    }
+    REQUIRE(correct > 200);
+}
+
+TEST_CASE("DecisionTree : batch predictions are routed in parallel blocks") {
+
+    arboria::DataSet regression = arboria::test::make_noisy_dataset(false, 700, 11, 0.5f);
+    arboria::DataSet binary = arboria::test::make_noisy_dataset(true, 700, 11, 0.5f);
+    std::vector<float> targets;
+    for (int i = 0; i < 700; i++) targets.insert(targets.end(), {regression.X()[2*i] - regression.X()[2*i + 1], regression.X()[2*i]});
+    arboria::DataSet multioutput(regression.X(), targets, 700, 2, 2);
+
+    for (int n_jobs : {1, 3}){
+        arboria::DecisionTree tree(HyperParam{.max_depth = 7, .n_jobs = n_jobs}, Regression{});
+        tree.fit(regression, arboria::ParamBuilder(TreeModel::DecisionTree, Regression{}));
+        arboria::DecisionTree classifier(HyperParam{.max_depth = 7, .n_jobs = n_jobs}, Classification{});
+        classifier.fit(binary, arboria::ParamBuilder(TreeModel::DecisionTree, Classification{}));
+        arboria::DecisionTree outputs(HyperParam{.max_depth = 7, .n_jobs = n_jobs}, Regression{});
+        outputs.fit(multioutput, arboria::ParamBuilder(TreeModel::DecisionTree, Regression{}));
+
+        //700 rows : several blocks, the last one partial
+        const std::vector<float> preds = tree.predict(regression.X());
+        const std::vector<float> labels = classifier.predict(binary.X());
+        const std::vector<float> proba = classifier.predict_proba(binary.X());
+        const std::vector<float> pairs = outputs.predict(regression.X());
+        REQUIRE(preds.size() == 700);
+        REQUIRE(proba.size() == 1400);
+        REQUIRE(pairs.size() == 1400);
+        for (size_t i = 0; i < 700; i++){
+            std::span<const float> sample(regression.X().data() + 2*i, 2);
+            REQUIRE(preds[i] == tree.predict_one(sample));
+            REQUIRE(labels[i] == classifier.predict_one(std::span<const float>(binary.X().data() + 2*i, 2)));
+            const std::span<const float> dist = classifier.leaf_outputs(classifier.leaf_index(std::span<const float>(binary.X().data() + 2*i, 2)));
+            REQUIRE(proba[2*i + static_cast<size_t>(labels[i])] >= proba[2*i + 1 - static_cast<size_t>(labels[i])]);
+            REQUIRE(dist[0] == labels[i]);
+            const std::span<const float> expected = outputs.predict_outputs_one(sample);
+            REQUIRE(pairs[2*i] == expected[0]);
+            REQUIRE(pairs[2*i + 1] == expected[1]);
+        }
+
+        std::vector<float> with_nan(2 * 300, 0.f);
+        with_nan[2 * 299] = std::numeric_limits<float>::quiet_NaN();
+        REQUIRE_THROWS_AS(tree.predict(with_nan), std::invalid_argument);
+        REQUIRE_THROWS_AS(classifier.predict_proba(with_nan), std::invalid_argument);
+    }
+}
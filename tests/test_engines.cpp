@@ -0,0 +1,67 @@
+#include "test_engines.h"
+#include "dataset/dataset.h"
+#include "tree/RandomForest/randomforest.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <random>
+
+
+namespace arboria::test{
+
+arboria::DataSet make_engine_dataset(int n_classes, int n_targets, int n_rows){
+
+    std::mt19937 rng(11);
+    std::normal_distribution<float> noise(0.f, 1.f);
+    std::vector<float> X;
+    std::vector<float> y;
+    for (int i = 0; i < n_rows; i++){
+        std::vector<float> row;
+        for (int f = 0; f < 5; f++) row.push_back(std::round(noise(rng) * 8.f) / 8.f);
+        X.insert(X.end(), row.begin(), row.end());
+        if (n_classes > 0){
+            const float score = row[0] + 0.5f * row[1] - row[3] + 0.5f * noise(rng);
+            y.push_back(std::clamp(std::floor(score + static_cast<float>(n_classes) / 2.f), 0.f, static_cast<float>(n_classes - 1)));
+        }
+        else {
+            for (int t = 0; t < n_targets; t++) y.push_back(row[t] - 2.f * row[4] + 0.1f * noise(rng));
+        }
+    }
+    return arboria::DataSet(X, y, n_rows, 5, n_targets);
+
+}
+
+std::vector<float> predict_with(arboria::RandomForest& forest, PredictEngine engine, std::span<const float> X){
+
+    forest.set_predict_engine(engine);
+    return forest.predict_proba(X);
+
+}
+
+std::string temp_library(const std::string& name){
+
+    return (std::filesystem::temp_directory_path() / ("arboria_" + name + ".so")).string();
+
+}
+
+size_t leftover_siblings(const std::string& path){
+
+    const std::filesystem::path file(path);
+    const std::string prefix = file.filename().string() + ".";
+    size_t n = 0;
+    for (const auto& entry : std::filesystem::directory_iterator(file.parent_path())){
+        const std::string name = entry.path().filename().string();
+        if (name.starts_with(prefix) && name != prefix + "cpp") n++;
+    }
+    return n;
+
+}
+
+void remove_library(const std::string& path){
+
+    std::remove(path.c_str());
+    std::remove((path + ".cpp").c_str());
+
+}
+}//end of namespace
@@ -0,0 +1,27 @@
+#pragma once
+#include "dataset/dataset.h"
+#include "tree/RandomForest/randomforest.h"
+#include <cstddef>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace arboria::test{
+
+//K noisy classes, or n_targets noisy linear targets, on 5 features ; some values repeat
+arboria::DataSet make_engine_dataset(int n_classes, int n_targets = 1, int n_rows = 300);
+
+//Selects engine on the forest and returns its predict_proba() of X
+std::vector<float> predict_with(arboria::RandomForest& forest, PredictEngine engine, std::span<const float> X);
+
+//Path of a native library in the temporary directory
+std::string temp_library(const std::string& name);
+
+//Number of temporary files left next to path by a save or a compile, 
+//the source path + ".cpp" aside
+size_t leftover_siblings(const std::string& path);
+
+//Removes a library written by NativeForest::compile() and its source
+void remove_library(const std::string& path);
+
+}//end of namespace
@@ -11,6 +11,8 @@
 
 using arboria::split::entropy;
 using arboria::split::weighted_entropy;
+using arboria::split::entropy_counts;
+using arboria::split::weighted_entropy_counts;
 
 
 
@@ -188,3 +190,27 @@ TEST_CASE("Weighted entropy Calculations (int overload)", "[entropy][int]") {
     REQUIRE_THROWS_AS(weighted_entropy(1,2,0,-1), std::invalid_argument);
     }
 }
+
+TEST_CASE("Entropy Calculations (K-way counts)", "[entropy][multiclass]") {
+
+    SECTION("Matches binary overload") {
+    std::vector<int> counts{3, 7};
+    REQUIRE(entropy_counts(counts) == Catch::Approx(entropy(3, 7)));
+    }
+
+    SECTION("Four balanced classes") {
+    std::vector<int> counts{5, 5, 5, 5};
+    REQUIRE(entropy_counts(counts) == Catch::Approx(2.f));
+    }
+
+    SECTION("Weighted children") {
+    std::vector<int> left{4, 0, 0};
+    std::vector<int> right{0, 2, 2};
+    REQUIRE(weighted_entropy_counts(left, right) == Catch::Approx(0.5f));
+    }
+
+    SECTION("Errors") {
+    REQUIRE_THROWS_AS(entropy_counts(std::vector<int>{0, 0, 0}), std::invalid_argument);
+    REQUIRE_THROWS_AS(weighted_entropy_counts(std::vector<int>{1}, std::vector<int>{1, 1}), std::invalid_argument);
+    }
+}
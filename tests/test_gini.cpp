@@ -10,6 +10,8 @@
 
 using arboria::split::gini;
 using arboria::split::weighted_gini;
+using arboria::split::gini_counts;
+using arboria::split::weighted_gini_counts;
 
 TEST_CASE("Gini Calculations (float overload)", "[gini][float]") {
 
@@ -184,3 +186,29 @@ TEST_CASE("Weighted Gini Calculations (int overload)", "[gini][int]") {
     REQUIRE_THROWS_AS(weighted_gini(1,2,0,-1), std::invalid_argument);
     }
 }
+
+TEST_CASE("Gini Calculations (K-way counts)", "[gini][multiclass]") {
+
+    SECTION("Matches binary overload") {
+    std::vector<int> counts{3, 7};
+    REQUIRE(gini_counts(counts) == Catch::Approx(gini(3, 7)));
+    }
+
+    SECTION("Three balanced classes") {
+    std::vector<int> counts{2, 2, 2};
+    REQUIRE(gini_counts(counts) == Catch::Approx(1.f - 3.f/9.f));
+    }
+
+    SECTION("Weighted children") {
+    std::vector<int> left{4, 0, 0};
+    std::vector<int> right{0, 2, 2};
+    REQUIRE(weighted_gini_counts(left, right) == Catch::Approx((4.f/8.f) * 0.5f));
+    REQUIRE(weighted_gini_counts(std::vector<int>{2,2}, std::vector<int>{0,4}) == Catch::Approx(weighted_gini(2,2,0,4)));
+    }
+
+    SECTION("Errors") {
+    REQUIRE_THROWS_AS(gini_counts(std::vector<int>{0, 0, 0}), std::invalid_argument);
+    REQUIRE_THROWS_AS(gini_counts(std::vector<int>{1, -1, 2}), std::invalid_argument);
+    REQUIRE_THROWS_AS(weighted_gini_counts(std::vector<int>{1, 1}, std::vector<int>{1, 1, 1}), std::invalid_argument);
+    }
+}
@@ -0,0 +1,148 @@
+/*
+
+                                    TESTS FOR GRADIENT BOOSTING
+
+*/
+
+
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/catch_approx.hpp>
+#include <stdexcept>
+#include <vector>
+#include <cmath>
+#include <random>
+
+#include "dataset/dataset.h"
+#include "tree/GradientBoosting/gradientboosting.h"
+#include "tree/TreeModel.h"
+
+using arboria::BoostParam;
+using arboria::DataSet;
+using arboria::GradientBoosting;
+
+namespace {
+
+//Nonlinear regression target (or its sign for classification) on 3 features
+DataSet make_boosting_dataset(int n_rows, bool classification, std::uint32_t seed) {
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> unif(-1.f, 1.f);
+    std::normal_distribution<float> noise(0.f, 0.1f);
+    std::vector<float> X;
+    std::vector<float> y;
+    for (int i = 0; i < n_rows; i++){
+        float a = unif(rng);
+        float b = unif(rng);
+        float c = unif(rng);
+        X.push_back(a);
+        X.push_back(b);
+        X.push_back(c);
+        float target = std::sin(3.f * a) + b * b + noise(rng);
+        if (classification) y.push_back(target > 0.3f ? 1.f : 0.f);
+        else y.push_back(target);
+    }
+    return DataSet(X, y, n_rows, 3);
+}
+
+}
+
+TEST_CASE("GradientBoosting : constructor validation") {
+
+    REQUIRE_THROWS_AS(GradientBoosting(HyperParam{.n_estimators = 0}, Regression{}), std::invalid_argument);
+    REQUIRE_THROWS_AS(GradientBoosting(HyperParam{.max_depth = 0}, Regression{}), std::invalid_argument);
+    REQUIRE_THROWS_AS(GradientBoosting(HyperParam{}, Regression{}, 1, BoostParam{.learning_rate = 0.f}), std::invalid_argument);
+    REQUIRE_THROWS_AS(GradientBoosting(HyperParam{}, Regression{}, 1, BoostParam{.reg_lambda = -1.f}), std::invalid_argument);
+    REQUIRE_THROWS_AS(GradientBoosting(HyperParam{}, Regression{}, 1, BoostParam{.subsample = 1.5f}), std::invalid_argument);
+    REQUIRE_THROWS_AS(GradientBoosting(HyperParam{}, Regression{}, 1, BoostParam{.colsample = 0.f}), std::invalid_argument);
+    REQUIRE_THROWS_AS(GradientBoosting(HyperParam{}, Undefined{}, 1), std::invalid_argument);
+}
+
+TEST_CASE("GradientBoosting : fit validation") {
+
+    GradientBoosting model(HyperParam{.n_estimators = 2}, Classification{}, 1);
+    std::vector<float> sample {0.f, 0.f, 0.f};
+    REQUIRE_THROWS_AS(model.predict(sample), std::invalid_argument);
+
+    DataSet multiclass({0, 1, 2}, {0, 1, 2}, 3, 1);
+    REQUIRE_THROWS_AS(model.fit(multiclass), std::invalid_argument);
+
+    DataSet multi_target({0, 1}, {0, 1, 1, 0}, 2, 1, 2);
+    REQUIRE_THROWS_AS(model.fit(multi_target), std::invalid_argument);
+
+    DataSet data = make_boosting_dataset(50, true, 1);
+    model.fit(data);
+    std::vector<float> wrong {0.f, 0.f};
+    REQUIRE_THROWS_AS(model.predict(wrong), std::invalid_argument);
+}
+
+TEST_CASE("GradientBoosting : regression loss decreases and training rows are fitted") {
+
+    DataSet data = make_boosting_dataset(300, false, 2);
+    GradientBoosting model(HyperParam{.n_estimators = 60, .max_depth = 3}, Regression{}, 3);
+    model.fit(data);
+
+    const std::vector<float>& loss = model.train_loss();
+    REQUIRE(loss.size() == 60);
+    for (size_t m = 1; m < loss.size(); m++) REQUIRE(loss[m] <= loss[m-1] + 1e-6f);
+
+    //the first loss is the one of the base score after one shrunk tree
+    double variance = 0.0;
+    for (float v : data.y()) variance += (v - model.base_score()) * (v - model.base_score());
+    variance /= data.n_rows();
+    REQUIRE(loss.back() < 0.2 * variance);
+
+    //predictions of the training rows match the incrementally updated scores
+    std::vector<float> preds = model.predict(data.X());
+    double mse = 0.0;
+    for (int i = 0; i < data.n_rows(); i++) mse += (preds[i] - data.iloc_y(i)) * (preds[i] - data.iloc_y(i));
+    REQUIRE(mse / data.n_rows() == Catch::Approx(loss.back()).epsilon(1e-3));
+}
+
+TEST_CASE("GradientBoosting : leaf values are the shrunk Newton steps") {
+
+    //a single depth-1 tree on a step function : leaf values are -G / (H + lambda) * lr
+    std::vector<float> X {0, 1, 2, 10, 11, 12};
+    std::vector<float> y {1, 1, 1, 7, 7, 7};
+    DataSet data(X, y, 6, 1);
+    GradientBoosting model(HyperParam{.n_estimators = 1, .max_depth = 1}, Regression{}, 0, BoostParam{.learning_rate = 0.5f, .reg_lambda = 1.f});
+    model.fit(data);
+
+    REQUIRE(model.base_score() == Catch::Approx(4.f));
+    //left leaf : G = 3 * (4 - 1) = 9, H = 3 -> -9 / 4 * 0.5
+    std::vector<float> samples {0.f, 12.f};
+    std::vector<float> preds = model.predict(samples);
+    REQUIRE(preds[0] == Catch::Approx(4.f - 9.f / 4.f * 0.5f));
+    REQUIRE(preds[1] == Catch::Approx(4.f + 9.f / 4.f * 0.5f));
+}
+
+TEST_CASE("GradientBoosting : binary classification with subsampling") {
+
+    DataSet train = make_boosting_dataset(400, true, 4);
+    DataSet test = make_boosting_dataset(200, true, 5);
+    GradientBoosting model(HyperParam{.n_estimators = 80, .max_depth = 3, .n_jobs = 2}, Classification{}, 6,
+                           BoostParam{.learning_rate = 0.2f, .subsample = 0.7f, .colsample = 0.67f});
+    model.fit(train);
+
+    std::vector<float> proba = model.predict_proba(test.X());
+    std::vector<float> preds = model.predict(test.X());
+    int correct = 0;
+    for (int i = 0; i < test.n_rows(); i++){
+        REQUIRE(proba[i] >= 0.f);
+        REQUIRE(proba[i] <= 1.f);
+        REQUIRE(preds[i] == (proba[i] >= 0.5f ? 1.f : 0.f));
+        if (preds[i] == test.iloc_y(i)) correct++;
+    }
+    REQUIRE(correct > 160);
+
+    //same seed : same model, whatever the number of threads
+    GradientBoosting sequential(HyperParam{.n_estimators = 80, .max_depth = 3, .n_jobs = 1}, Classification{}, 6,
+                                BoostParam{.learning_rate = 0.2f, .subsample = 0.7f, .colsample = 0.67f});
+    sequential.fit(train);
+    REQUIRE(sequential.decision_function(test.X()) == model.decision_function(test.X()));
+
+    //samples are scored alike whatever the tile they fall in
+    const std::vector<float> scores = model.decision_function(test.X());
+    const size_t nf = static_cast<size_t>(test.n_cols());
+    for (size_t i = 0; i < scores.size(); i++){
+        REQUIRE(model.decision_function(std::span<const float>(test.X()).subspan(i * nf, nf))[0] == scores[i]);
+    }
+}
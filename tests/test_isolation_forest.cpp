@@ -0,0 +1,129 @@
+/*
+
+                                    TESTS FOR ISOLATION FOREST
+
+*/
+
+
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/catch_approx.hpp>
+#include <stdexcept>
+#include <vector>
+#include <cmath>
+#include <random>
+#include <limits>
+
+#include "tree/IsolationForest/isolationforest.h"
+
+using arboria::IsolationForest;
+
+namespace {
+
+//Gaussian cloud of n_rows samples around the origin
+std::vector<float> make_cloud(int n_rows, int n_features, std::uint32_t seed) {
+    std::mt19937 rng(seed);
+    std::normal_distribution<float> noise(0.f, 1.f);
+    std::vector<float> X(static_cast<size_t>(n_rows * n_features));
+    for (float& v : X) v = noise(rng);
+    return X;
+}
+
+}
+
+TEST_CASE("IsolationForest : constructor validation") {
+
+    REQUIRE_THROWS_AS(IsolationForest(HyperParam{.n_estimators = 0}), std::invalid_argument);
+    REQUIRE_THROWS_AS(IsolationForest(HyperParam{.max_depth = 0}), std::invalid_argument);
+    REQUIRE_THROWS_AS(IsolationForest(HyperParam{.max_samples = 1.5f}), std::invalid_argument);
+    REQUIRE_THROWS_AS(IsolationForest(HyperParam{.max_samples = 0.f}), std::invalid_argument);
+    REQUIRE_THROWS_AS(IsolationForest(HyperParam{.n_jobs = 0}), std::invalid_argument);
+    REQUIRE_NOTHROW(IsolationForest(HyperParam{}, 1));
+}
+
+TEST_CASE("IsolationForest : fit validation") {
+
+    IsolationForest forest(HyperParam{.n_estimators = 5}, 1);
+    std::vector<float> X = make_cloud(10, 2, 1);
+
+    REQUIRE_THROWS_AS(forest.score_samples(X), std::invalid_argument);
+    REQUIRE_THROWS_AS(forest.fit(std::vector<float>{}, 2), std::invalid_argument);
+    REQUIRE_THROWS_AS(forest.fit(X, 3), std::invalid_argument);
+    REQUIRE_THROWS_AS(forest.fit(std::vector<float>{1.f, 2.f}, 2), std::invalid_argument);
+
+    std::vector<float> with_nan = X;
+    with_nan[3] = std::numeric_limits<float>::quiet_NaN();
+    REQUIRE_THROWS_AS(forest.fit(with_nan, 2), std::invalid_argument);
+
+    forest.fit(X, 2);
+    REQUIRE(forest.is_fitted());
+    REQUIRE(forest.subsample_size() == 10);
+    REQUIRE(forest.get_max_depth() == 4);
+    std::vector<float> wrong {0.f, 0.f, 0.f};
+    REQUIRE_THROWS_AS(forest.score_samples(wrong), std::invalid_argument);
+    REQUIRE_THROWS_AS(forest.predict(X, 0.f), std::invalid_argument);
+}
+
+TEST_CASE("IsolationForest : subsample size and depth limit") {
+
+    std::vector<float> X = make_cloud(1000, 3, 2);
+
+    IsolationForest by_default(HyperParam{.n_estimators = 4}, 3);
+    by_default.fit(X, 3);
+    REQUIRE(by_default.subsample_size() == 256);
+    REQUIRE(by_default.get_max_depth() == 8);
+    //a tree of depth 8 holds at most 2^9 - 1 nodes
+    REQUIRE(by_default.n_nodes() <= 4u * 511u);
+
+    IsolationForest fraction(HyperParam{.n_estimators = 4, .max_samples = 0.1f}, 3);
+    fraction.fit(X, 3);
+    REQUIRE(fraction.subsample_size() == 100);
+    REQUIRE(fraction.get_max_depth() == 7);
+}
+
+TEST_CASE("IsolationForest : outliers score higher than inliers") {
+
+    std::vector<float> X = make_cloud(500, 2, 4);
+    IsolationForest forest(HyperParam{.n_estimators = 100, .n_jobs = 3}, 7);
+    forest.fit(X, 2);
+
+    std::vector<float> queries {0.f, 0.f,   0.1f, -0.2f,   6.f, 6.f,   -8.f, 0.f};
+    std::vector<float> scores = forest.score_samples(queries);
+    REQUIRE(scores.size() == 4);
+    for (float s : scores){
+        REQUIRE(s > 0.f);
+        REQUIRE(s <= 1.f);
+    }
+    REQUIRE(scores[0] < 0.5f);
+    REQUIRE(scores[1] < 0.5f);
+    REQUIRE(scores[2] > 0.6f);
+    REQUIRE(scores[3] > 0.6f);
+
+    std::vector<float> flags = forest.predict(queries, 0.6f);
+    REQUIRE(flags == std::vector<float>{0.f, 0.f, 1.f, 1.f});
+
+    //outliers are isolated by shorter paths
+    std::vector<float> lengths = forest.path_length(queries);
+    REQUIRE(lengths[2] < lengths[0]);
+    REQUIRE(lengths[3] < lengths[1]);
+}
+
+TEST_CASE("IsolationForest : results do not depend on n_jobs or on the block layout") {
+
+    std::vector<float> X = make_cloud(700, 3, 5);
+
+    IsolationForest sequential(HyperParam{.n_estimators = 20, .n_jobs = 1}, 11);
+    IsolationForest parallel(HyperParam{.n_estimators = 20, .n_jobs = 4}, 11);
+    sequential.fit(X, 3);
+    parallel.fit(X, 3);
+
+    //700 rows span several blocks, the last one partial
+    std::vector<float> a = sequential.score_samples(X);
+    std::vector<float> b = parallel.score_samples(X);
+    REQUIRE(a == b);
+
+    //scoring rows one at a time gives the same values
+    for (size_t i = 0; i < 700; i += 97){
+        std::vector<float> row(X.begin() + i * 3, X.begin() + i * 3 + 3);
+        REQUIRE(sequential.score_samples(row)[0] == a[i]);
+    }
+}
@@ -0,0 +1,190 @@
+/*
+
+                                    TESTS FOR NATIVEFOREST
+
+*/
+
+
+#include <catch2/catch_test_macros.hpp>
+#include <cstdlib>
+#include <filesystem>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "test_engines.h"
+#include "dataset/dataset.h"
+#include "split_strategy/types/ParamBuilder/ParamBuilder.h"
+#include "split_strategy/types/split_param.h"
+#include "tree/DecisionTree/DecisionTree.h"
+#include "tree/RandomForest/nativeforest.h"
+#include "tree/RandomForest/randomforest.h"
+#include "tree/TreeModel.h"
+
+using arboria::DataSet;
+using arboria::DecisionTree;
+using arboria::NativeForest;
+using arboria::ParamBuilder;
+using arboria::RandomForest;
+using arboria::test::leftover_siblings;
+using arboria::test::make_engine_dataset;
+using arboria::test::predict_with;
+using arboria::test::remove_library;
+using arboria::test::temp_library;
+
+//RandomForest predictions are checked against the other engines in test_predict_engines.cpp
+
+TEST_CASE("NativeForest : the compiled library sums the leaves reached in every tree") {
+
+    DataSet data = make_engine_dataset(0);
+    std::vector<DecisionTree> trees;
+    for (int depth : {1, 3, 6}){
+        trees.emplace_back(HyperParam{.max_depth = depth}, Regression{});
+        trees.back().fit(data, ParamBuilder(TreeModel::DecisionTree, Regression{}, SSE{}, CART{}, AllFeatures{}));
+    }
+    std::vector<const DecisionTree*> pointers;
+    for (const DecisionTree& tree : trees) pointers.push_back(&tree);
+
+    const std::string path = temp_library("native_trees");
+    NativeForest::compile(NativeForest::source(pointers, 5), path);
+    REQUIRE(std::filesystem::exists(path + ".cpp"));
+    REQUIRE(leftover_siblings(path) == 0);
+    {
+        NativeForest native(path);
+        REQUIRE(native.n_trees() == 3);
+        REQUIRE(native.width() == 1);
+        REQUIRE(native.num_features() == 5);
+        REQUIRE(native.fingerprint() == NativeForest::fingerprint(pointers, 5));
+        REQUIRE(native.fingerprint() != NativeForest::fingerprint({pointers[0], pointers[1]}, 5));
+
+        const std::vector<float> sums = native.sum_outputs(data.X(), 3);
+        const size_t n_rows = static_cast<size_t>(data.n_rows());
+        REQUIRE(sums.size() == n_rows);
+        for (size_t i = 0; i < n_rows; i++){
+            std::span<const float> sample = std::span<const float>(data.X()).subspan(i * 5, 5);
+            float expected = 0.f;
+            for (const DecisionTree& tree : trees) expected += tree.predict_one(sample);
+            REQUIRE(sums[i] == expected);
+        }
+
+        REQUIRE_THROWS_AS(native.sum_outputs(std::vector<float>(7, 0.f)), std::invalid_argument);
+        std::vector<float> nan_sample(5, std::numeric_limits<float>::quiet_NaN());
+        REQUIRE_THROWS_AS(native.sum_outputs(nan_sample), std::invalid_argument);
+    }
+    remove_library(path);
+
+    DecisionTree unfitted(HyperParam{.max_depth = 2}, Regression{});
+    REQUIRE_THROWS_AS(NativeForest::source({&unfitted}, 5), std::invalid_argument);
+    REQUIRE_THROWS_AS(NativeForest::source(pointers, 4), std::invalid_argument);
+    REQUIRE_THROWS_AS(NativeForest(temp_library("native_missing")), std::runtime_error);
+}
+
+TEST_CASE("NativeForest : a saved forest loads the library") {
+
+    DataSet data = make_engine_dataset(4);
+    RandomForest forest(HyperParam{.mtry = 3, .n_estimators = 12, .max_depth = 6, .n_jobs = 2}, Classification{}, 1);
+    forest.fit(data, ParamBuilder(TreeModel::RandomForest, Classification{}, Entropy{}, CART{}, RandomK{3}));
+    const std::vector<float> walked = predict_with(forest, Traversal{}, data.X());
+
+    const std::string path = temp_library("native_served");
+    forest.compile_native(path);
+    forest.set_predict_engine(Native{});
+    //single samples are scored by the library
+    const std::vector<float> first = forest.predict_proba(std::span<const float>(data.X()).first(5));
+    REQUIRE(first == std::vector<float>(walked.begin(), walked.begin() + 4));
+
+    std::unique_ptr<RandomForest> served = RandomForest::from_bytes(forest.to_bytes());
+    served->load_native(path);
+    REQUIRE(predict_with(*served, Native{}, data.X()) == walked);
+    remove_library(path);
+}
+
+TEST_CASE("NativeForest : the library follows the trees") {
+
+    DataSet data = make_engine_dataset(0);
+    SplitParam param = ParamBuilder(TreeModel::RandomForest, Regression{}, SSE{}, CART{}, RandomK{2});
+    RandomForest forest(HyperParam{.mtry = 2, .n_estimators = 5, .max_depth = 4}, Regression{}, 3);
+    REQUIRE_THROWS_AS(forest.compile_native(temp_library("native_unfitted")), std::invalid_argument);
+    forest.fit(data, param);
+
+    forest.set_predict_engine(Native{});
+    REQUIRE_THROWS_AS(forest.predict_proba(data.X()), std::logic_error);
+
+    const std::string path = temp_library("native_grown");
+    forest.compile_native(path);
+    const std::vector<float> before = forest.predict(data.X());
+
+    //the library of the previous trees is dropped with them
+    forest.fit_more(data, param, 3);
+    REQUIRE_THROWS_AS(forest.predict_proba(data.X()), std::logic_error);
+    forest.set_predict_engine(Undefined{});
+    REQUIRE(forest.predict(data.X()) == predict_with(forest, Traversal{}, data.X()));
+
+    //a library compiled from other trees is rejected
+    RandomForest other(HyperParam{.mtry = 2, .n_estimators = 5, .max_depth = 4}, Regression{}, 4);
+    other.fit(data, param);
+    const std::string other_path = temp_library("native_other");
+    other.compile_native(other_path);
+    REQUIRE_THROWS_AS(forest.load_native(other_path), std::invalid_argument);
+
+    forest.compile_native(path);
+    REQUIRE(predict_with(forest, Native{}, data.X()) == predict_with(forest, Traversal{}, data.X()));
+    REQUIRE(predict_with(forest, Native{}, data.X()) != before);
+    remove_library(path);
+    remove_library(other_path);
+}
+
+TEST_CASE("NativeForest : compiler errors are reported") {
+
+    DataSet data = make_engine_dataset(0);
+    RandomForest forest(HyperParam{.mtry = 2, .n_estimators = 2, .max_depth = 2}, Regression{}, 5);
+    forest.fit(data, ParamBuilder(TreeModel::RandomForest, Regression{}, SSE{}, CART{}, RandomK{2}));
+
+    const std::string path = temp_library("native_failed");
+    setenv("ARBORIA_CXX", "false", 1);
+    REQUIRE_THROWS_AS(forest.compile_native(path), std::runtime_error);
+    unsetenv("ARBORIA_CXX");
+    REQUIRE_FALSE(std::filesystem::exists(path));
+    REQUIRE(leftover_siblings(path) == 0);
+    remove_library(path);
+}
+
+TEST_CASE("NativeForest : concurrent compiles to one path leave a whole library") {
+
+    DataSet data = make_engine_dataset(0);
+    DecisionTree shallow(HyperParam{.max_depth = 2}, Regression{});
+    DecisionTree deep(HyperParam{.max_depth = 5}, Regression{});
+    shallow.fit(data, ParamBuilder(TreeModel::DecisionTree, Regression{}, SSE{}, CART{}, AllFeatures{}));
+    deep.fit(data, ParamBuilder(TreeModel::DecisionTree, Regression{}, SSE{}, CART{}, AllFeatures{}));
+
+    //each compile writes its own source and library : the last renames win
+    const std::string path = temp_library("native_concurrent");
+    std::thread other([&](){ NativeForest::compile(NativeForest::source({&deep}, 5), path); });
+    NativeForest::compile(NativeForest::source({&shallow}, 5), path);
+    other.join();
+
+    NativeForest native(path);
+    REQUIRE((native.fingerprint() == NativeForest::fingerprint({&shallow}, 5) || native.fingerprint() == NativeForest::fingerprint({&deep}, 5)));
+    REQUIRE(leftover_siblings(path) == 0);
+    remove_library(path);
+}
+
+TEST_CASE("NativeForest : predict_one scores single samples with the library") {
+
+    DataSet data = make_engine_dataset(4);
+    RandomForest forest(HyperParam{.mtry = 3, .n_estimators = 9, .max_depth = 6}, Classification{}, 6);
+    forest.fit(data, ParamBuilder(TreeModel::RandomForest, Classification{}, Gini{}, CART{}, RandomK{3}));
+    forest.set_predict_engine(Traversal{});
+    const std::vector<float> labels = forest.predict(data.X());
+
+    const std::string path = temp_library("native_one");
+    forest.compile_native(path);
+    forest.set_predict_engine(Native{});
+    for (size_t i = 0; i < 20; i++) REQUIRE(forest.predict_one(data.X().data() + 5 * i) == labels[i]);
+    std::vector<float> nan_sample(5, std::numeric_limits<float>::quiet_NaN());
+    REQUIRE_THROWS_AS(forest.predict_one(nan_sample.data()), std::invalid_argument);
+    remove_library(path);
+}
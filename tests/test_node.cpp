@@ -9,6 +9,7 @@
 #include <cmath>
 
 using arboria::Node;
+using arboria::NodeArena;
 
 TEST_CASE("Node default state") {
     Node node;
@@ -16,8 +17,8 @@ TEST_CASE("Node default state") {
     REQUIRE(node.return_feature_index() == -1);
     REQUIRE(node.leaf_value == -1);
     REQUIRE(!std::isfinite(node.return_threshold()));
-    REQUIRE(node.left_child == nullptr);
-    REQUIRE(node.right_child == nullptr);
+    REQUIRE(node.left_child == -1);
+    REQUIRE(node.right_child == -1);
     REQUIRE(node.is_valid(1) == false);
 }
 
@@ -26,8 +27,8 @@ TEST_CASE("Node split validity") {
     node.is_leaf = false;
     node.feature_index = 1;
     node.threshold = 2.5f;
-    node.left_child = std::make_unique<Node>();
-    node.right_child = std::make_unique<Node>();
+    node.left_child = 1;
+    node.right_child = 2;
 
     REQUIRE(node.is_valid(3) == true);
 }
@@ -37,8 +38,8 @@ TEST_CASE("Node split invalid cases") {
     node.is_leaf = false;
     node.feature_index = 0;
     node.threshold = 1.0f;
-    node.left_child = std::make_unique<Node>();
-    node.right_child = std::make_unique<Node>();
+    node.left_child = 1;
+    node.right_child = 2;
 
     node.feature_index = -1;
     REQUIRE(node.is_valid(2) == false);
@@ -51,7 +52,31 @@ TEST_CASE("Node split invalid cases") {
     REQUIRE(node.is_valid(2) == false);
 
     node.threshold = 1.0f;
-    node.left_child.reset();
+    node.left_child = -1;
     REQUIRE(node.is_valid(2) == false);
 }
 
+TEST_CASE("NodeArena : emplace returns contiguous indices") {
+    NodeArena arena;
+    REQUIRE(arena.empty());
+
+    int root = arena.emplace();
+    int left = arena.emplace();
+    int right = arena.emplace();
+
+    REQUIRE(root == 0);
+    REQUIRE(left == 1);
+    REQUIRE(right == 2);
+    REQUIRE(arena.size() == 3);
+
+    arena[root].left_child = left;
+    arena[root].right_child = right;
+    arena[root].is_leaf = false;
+    REQUIRE(arena.nodes()[0].left_child == 1);
+    REQUIRE(arena.nodes()[0].right_child == 2);
+    REQUIRE(arena[left].is_leaf == true);
+
+    arena.clear();
+    REQUIRE(arena.empty());
+    REQUIRE(arena.emplace() == 0);
+}
@@ -0,0 +1,126 @@
+/*
+
+                                    TESTS FOR ONLINE FOREST
+
+*/
+
+
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/catch_approx.hpp>
+#include <stdexcept>
+#include <vector>
+#include <cmath>
+#include <random>
+
+#include "dataset/dataset.h"
+#include "split_strategy/types/split_param.h"
+#include "tree/OnlineForest/onlineforest.h"
+#include "split_strategy/types/ParamBuilder/ParamBuilder.h"
+#include "tree/TreeModel.h"
+
+using arboria::DataSet;
+using arboria::OnlineForest;
+using arboria::OnlineParam;
+using arboria::ParamBuilder;
+
+namespace {
+
+//Batch of a stream where the label (or target) depends on the first feature
+DataSet make_batch(std::mt19937& rng, int n_rows, bool classification) {
+    std::uniform_real_distribution<float> unif(-1.f, 1.f);
+    std::vector<float> X;
+    std::vector<float> y;
+    for (int i = 0; i < n_rows; i++){
+        float a = unif(rng);
+        float b = unif(rng);
+        X.push_back(a);
+        X.push_back(b);
+        if (classification) y.push_back(a > 0.2f ? 1.f : 0.f);
+        else y.push_back(a > 0.f ? 5.f + b : -5.f + b);
+    }
+    return DataSet(X, y, n_rows, 2);
+}
+
+float accuracy_on(const OnlineForest& forest, const DataSet& data) {
+    std::vector<float> preds = forest.predict(data.X());
+    int correct = 0;
+    for (int i = 0; i < data.n_rows(); i++) correct += (preds[i] == data.iloc_y(i));
+    return static_cast<float>(correct) / static_cast<float>(data.n_rows());
+}
+
+}
+
+TEST_CASE("OnlineForest : learns a classification stream by mini-batches") {
+    std::mt19937 rng(3);
+    OnlineForest forest(HyperParam{.n_estimators = 8, .n_jobs = 2}, Classification{}, 11,
+                        OnlineParam{.grace_period = 50});
+    SplitParam param = ParamBuilder(TreeModel::RandomForest, Classification{}, Gini{}, CART{}, RandomK{1});
+
+    for (int batch = 0; batch < 20; batch++) forest.partial_fit(make_batch(rng, 100, true), param);
+
+    REQUIRE(forest.is_fitted());
+    REQUIRE(forest.n_classes() == 2);
+    REQUIRE(forest.n_nodes() > 8);
+    REQUIRE(accuracy_on(forest, make_batch(rng, 500, true)) > 0.9f);
+
+    std::vector<float> probas = forest.predict_proba(std::vector<float>{0.9f, 0.f, -0.9f, 0.f});
+    REQUIRE(probas.size() == 2);
+    REQUIRE(probas[0] > 0.5f);
+    REQUIRE(probas[1] < 0.5f);
+}
+
+TEST_CASE("OnlineForest : learns a regression stream by mini-batches") {
+    std::mt19937 rng(5);
+    OnlineForest forest(HyperParam{.n_estimators = 5}, Regression{}, 11, OnlineParam{.grace_period = 50});
+    SplitParam param = ParamBuilder(TreeModel::RandomForest, Regression{}, SSE{}, CART{}, RandomK{2});
+
+    for (int batch = 0; batch < 10; batch++) forest.partial_fit(make_batch(rng, 100, false), param);
+
+    std::vector<float> preds = forest.predict(std::vector<float>{0.8f, 0.f, -0.8f, 0.f});
+    REQUIRE(preds[0] == Catch::Approx(5.f).margin(1.f));
+    REQUIRE(preds[1] == Catch::Approx(-5.f).margin(1.f));
+}
+
+TEST_CASE("OnlineForest : memory is bounded and independent of n_jobs") {
+    SplitParam param = ParamBuilder(TreeModel::RandomForest, Classification{}, Entropy{}, CART{}, RandomK{2});
+    OnlineParam online{.grace_period = 20, .n_candidates = 8, .max_nodes = 7};
+    OnlineForest serial(HyperParam{.n_estimators = 4, .n_jobs = 1}, Classification{}, 7, online);
+    OnlineForest parallel(HyperParam{.n_estimators = 4, .n_jobs = 4}, Classification{}, 7, online);
+
+    std::mt19937 rng_a(1);
+    std::mt19937 rng_b(1);
+    for (int batch = 0; batch < 10; batch++){
+        serial.partial_fit(make_batch(rng_a, 200, true), param);
+        parallel.partial_fit(make_batch(rng_b, 200, true), param);
+    }
+
+    REQUIRE(serial.n_nodes() <= 4 * 7);
+    REQUIRE(serial.n_nodes() == parallel.n_nodes());
+    std::mt19937 rng(2);
+    DataSet test = make_batch(rng, 100, true);
+    REQUIRE(serial.predict_proba(test.X()) == parallel.predict_proba(test.X()));
+}
+
+TEST_CASE("OnlineForest : input validation") {
+    SplitParam param = ParamBuilder(TreeModel::RandomForest, Classification{}, Gini{}, CART{}, RandomK{1});
+    REQUIRE_THROWS_AS(OnlineForest(HyperParam{.n_estimators = 0}, Classification{}), std::invalid_argument);
+    REQUIRE_THROWS_AS(OnlineForest(HyperParam{}, Classification{}, 1, OnlineParam{.split_confidence = 0.f}), std::invalid_argument);
+
+    OnlineForest forest(HyperParam{.n_estimators = 2}, Classification{}, 1);
+    REQUIRE_THROWS_AS(forest.predict(std::vector<float>{0.f, 0.f}), std::invalid_argument);
+
+    std::mt19937 rng(1);
+    forest.partial_fit(make_batch(rng, 20, true), param);
+
+    //classes can't be added after the first batch
+    std::vector<float> X{0.f, 0.f};
+    std::vector<float> y{2.f};
+    REQUIRE_THROWS_AS(forest.partial_fit(DataSet(X, y, 1, 2), param), std::invalid_argument);
+    //the number of features is fixed by the first batch
+    std::vector<float> X3{0.f, 0.f, 0.f};
+    std::vector<float> y0{0.f};
+    REQUIRE_THROWS_AS(forest.partial_fit(DataSet(X3, y0, 1, 3), param), std::invalid_argument);
+    //criterion must match the type of the forest
+    SplitParam sse = ParamBuilder(TreeModel::RandomForest, Classification{}, SSE{}, CART{}, RandomK{1});
+    REQUIRE_THROWS_AS(forest.partial_fit(make_batch(rng, 20, true), sse), std::invalid_argument);
+}
@@ -0,0 +1,165 @@
+/*
+
+                                    TESTS FOR THE PREDICT ENGINES
+
+*/
+
+
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/catch_template_test_macros.hpp>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "test_engines.h"
+#include "dataset/dataset.h"
+#include "split_strategy/types/ParamBuilder/ParamBuilder.h"
+#include "split_strategy/types/split_param.h"
+#include "tree/DecisionTree/DecisionTree.h"
+#include "tree/RandomForest/implicitforest.h"
+#include "tree/RandomForest/quickscorer.h"
+#include "tree/RandomForest/randomforest.h"
+#include "tree/TreeModel.h"
+
+using arboria::BitvectorForest;
+using arboria::DataSet;
+using arboria::DecisionTree;
+using arboria::ImplicitForest;
+using arboria::ParamBuilder;
+using arboria::RandomForest;
+using arboria::test::make_engine_dataset;
+using arboria::test::predict_with;
+using arboria::test::remove_library;
+using arboria::test::temp_library;
+
+namespace {
+
+using NamedEngine = std::pair<std::string, PredictEngine>;
+
+//Engines building a compiled form of the trees on their first prediction
+const std::vector<NamedEngine> COMPILED_ENGINES {{"QuickScorer", QuickScorer{}}, {"Implicit", Implicit{}}};
+
+//Checks predict_proba() and predict() of every engine against the walk of every tree ;
+//the trees are compiled to a library for Native, which Undefined then uses as well
+void require_same_predictions(RandomForest& forest, std::span<const float> X, const std::string& name) {
+
+    forest.set_predict_engine(Traversal{});
+    const std::vector<float> walked = forest.predict_proba(X);
+    const std::vector<float> labels = forest.predict(X);
+
+    auto require_engine = [&](const NamedEngine& named){
+        INFO(named.first);
+        forest.set_predict_engine(named.second);
+        REQUIRE(forest.predict_proba(X) == walked);
+        REQUIRE(forest.predict(X) == labels);
+    };
+    for (const NamedEngine& named : COMPILED_ENGINES) require_engine(named);
+    require_engine({"Blocked", Blocked{}});
+    require_engine({"Undefined", Undefined{}});
+
+    const std::string path = temp_library(name);
+    forest.compile_native(path);
+    require_engine({"Native", Native{}});
+    require_engine({"Undefined with a library", Undefined{}});
+    remove_library(path);
+}
+
+}
+
+TEMPLATE_TEST_CASE("Predict engines : compiled forests sum the leaves reached in every tree", "", BitvectorForest, ImplicitForest) {
+
+    DataSet data = make_engine_dataset(0);
+    std::vector<DecisionTree> trees;
+    //unbalanced trees : depth 8 needs 4-word bitvectors, and leaves above the
+    //last level are padded in the implicit layout
+    for (int depth : {1, 3, 6, 8}){
+        trees.emplace_back(HyperParam{.max_depth = depth, .min_sample_split = 12}, Regression{});
+        trees.back().fit(data, ParamBuilder(TreeModel::DecisionTree, Regression{}, SSE{}, CART{}, AllFeatures{}));
+    }
+    std::vector<const DecisionTree*> pointers;
+    for (const DecisionTree& tree : trees) pointers.push_back(&tree);
+    REQUIRE(trees.back().n_leaves() < (size_t{1} << trees.back().depth()));
+
+    REQUIRE(TestType::supports(pointers));
+    TestType compiled(pointers, 5);
+    REQUIRE(compiled.n_trees() == 4);
+    REQUIRE(compiled.width() == 1);
+
+    const std::vector<float> sums = compiled.sum_outputs(data.X(), 3);
+    const size_t n_rows = static_cast<size_t>(data.n_rows());
+    REQUIRE(sums.size() == n_rows);
+    for (size_t i = 0; i < n_rows; i++){
+        std::span<const float> sample = std::span<const float>(data.X()).subspan(i * 5, 5);
+        float expected = 0.f;
+        for (const DecisionTree& tree : trees) expected += tree.predict_one(sample);
+        REQUIRE(sums[i] == expected);
+    }
+}
+
+TEST_CASE("Predict engines : RandomForest predictions do not depend on the engine") {
+
+    SECTION("binary classification"){
+        DataSet data = make_engine_dataset(2);
+        RandomForest forest(HyperParam{.mtry = 2, .n_estimators = 20, .max_depth = 5, .n_jobs = 2}, Classification{}, 1);
+        forest.fit(data, ParamBuilder(TreeModel::RandomForest, Classification{}, Gini{}, CART{}, RandomK{2}));
+        require_same_predictions(forest, data.X(), "engines_binary");
+    }
+    SECTION("multiclass classification"){
+        DataSet data = make_engine_dataset(4);
+        RandomForest forest(HyperParam{.mtry = 3, .n_estimators = 15, .max_depth = 8}, Classification{}, 2);
+        forest.fit(data, ParamBuilder(TreeModel::RandomForest, Classification{}, Entropy{}, CART{}, RandomK{3}));
+        REQUIRE(forest.n_classes() == 4);
+        require_same_predictions(forest, data.X(), "engines_multiclass");
+    }
+    SECTION("multi-output regression"){
+        DataSet data = make_engine_dataset(0, 2);
+        RandomForest forest(HyperParam{.mtry = 3, .n_estimators = 10, .max_depth = 6, .n_jobs = 3}, Regression{}, 3);
+        forest.fit(data, ParamBuilder(TreeModel::RandomForest, Regression{}, SSE{}, CART{}, RandomK{3}));
+        require_same_predictions(forest, data.X(), "engines_multioutput");
+    }
+    SECTION("honest regression trees"){
+        DataSet data = make_engine_dataset(0);
+        RandomForest forest(HyperParam{.mtry = 2, .n_estimators = 10, .max_depth = 4, .honest_fraction = 0.5f}, Regression{}, 4);
+        forest.fit(data, ParamBuilder(TreeModel::RandomForest, Regression{}, SSE{}, CART{}, RandomK{2}));
+        require_same_predictions(forest, data.X(), "engines_honest");
+    }
+}
+
+TEST_CASE("Predict engines : compiled forms follow the published ensemble") {
+
+    DataSet data = make_engine_dataset(0);
+    SplitParam param = ParamBuilder(TreeModel::RandomForest, Regression{}, SSE{}, CART{}, RandomK{2});
+    for (const NamedEngine& named : COMPILED_ENGINES){
+        INFO(named.first);
+        RandomForest forest(HyperParam{.mtry = 2, .n_estimators = 6, .max_depth = 4}, Regression{}, 5);
+        forest.fit(data, param);
+        forest.set_predict_engine(named.second);
+        const std::vector<float> before = forest.predict(data.X());
+
+        forest.fit_more(data, param, 4);
+        const std::vector<float> grown = forest.predict(data.X());
+        REQUIRE(grown != before);
+        REQUIRE(grown == predict_with(forest, Traversal{}, data.X()));
+
+        forest.set_predict_engine(named.second);
+        forest.update(make_engine_dataset(0, 1, 120), param, 3);
+        const std::vector<float> updated = forest.predict(data.X());
+        REQUIRE(updated == predict_with(forest, Traversal{}, data.X()));
+    }
+}
+
+TEST_CASE("Predict engines : trees too large for a compiled form are rejected") {
+
+    DataSet data = make_engine_dataset(0, 1, 1000);
+    RandomForest forest(HyperParam{.mtry = 5, .n_estimators = 3}, Regression{}, 6);
+    forest.fit(data, ParamBuilder(TreeModel::RandomForest, Regression{}, SSE{}, CART{}, RandomK{5}));
+
+    const std::vector<float> walked = predict_with(forest, Traversal{}, data.X());
+    REQUIRE(predict_with(forest, Undefined{}, data.X()) == walked);
+    for (const NamedEngine& named : COMPILED_ENGINES){
+        INFO(named.first);
+        forest.set_predict_engine(named.second);
+        REQUIRE_THROWS_AS(forest.predict_proba(data.X()), std::logic_error);
+    }
+}
@@ -0,0 +1,49 @@
+/*
+
+                                    TESTS FOR QUICKSCORER
+
+*/
+
+
+#include <catch2/catch_test_macros.hpp>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+#include "test_engines.h"
+#include "dataset/dataset.h"
+#include "split_strategy/types/ParamBuilder/ParamBuilder.h"
+#include "split_strategy/types/split_param.h"
+#include "tree/DecisionTree/DecisionTree.h"
+#include "tree/RandomForest/quickscorer.h"
+#include "tree/TreeModel.h"
+
+using arboria::BitvectorForest;
+using arboria::DataSet;
+using arboria::DecisionTree;
+using arboria::ParamBuilder;
+using arboria::test::make_engine_dataset;
+
+//sums and RandomForest predictions are checked against the other engines in test_predict_engines.cpp
+
+TEST_CASE("QuickScorer : BitvectorForest validation") {
+
+    DataSet data = make_engine_dataset(0);
+    DecisionTree deep(HyperParam{}, Regression{});
+    deep.fit(data, ParamBuilder(TreeModel::DecisionTree, Regression{}, SSE{}, CART{}, AllFeatures{}));
+    REQUIRE(deep.n_nodes() > 2 * BitvectorForest::MAX_LEAVES);
+    REQUIRE_FALSE(BitvectorForest::supports({&deep}));
+    REQUIRE_THROWS_AS(BitvectorForest({&deep}, 5), std::invalid_argument);
+
+    DecisionTree unfitted(HyperParam{.max_depth = 2}, Regression{});
+    REQUIRE_FALSE(BitvectorForest::supports({&unfitted}));
+    REQUIRE_THROWS_AS(BitvectorForest({&unfitted}, 5), std::invalid_argument);
+
+    DecisionTree shallow(HyperParam{.max_depth = 3}, Regression{});
+    shallow.fit(data, ParamBuilder(TreeModel::DecisionTree, Regression{}, SSE{}, CART{}, AllFeatures{}));
+    REQUIRE_THROWS_AS(BitvectorForest({&shallow}, 4), std::invalid_argument);
+    BitvectorForest scorer({&shallow}, 5);
+    REQUIRE_THROWS_AS(scorer.sum_outputs(std::vector<float>(7, 0.f)), std::invalid_argument);
+    std::vector<float> nan_sample(5, std::numeric_limits<float>::quiet_NaN());
+    REQUIRE_THROWS_AS(scorer.sum_outputs(nan_sample), std::invalid_argument);
+}
@@ -11,18 +11,29 @@
 #include <vector>
 #include <iostream>
 #include <cmath>
+#include <random>
+#include <atomic>
+#include <thread>
+#include <cstdint>
+#include <algorithm>
+#include <limits>
+#include <chrono>
+#include <optional>
 
 #include "dataset/dataset.h"
 #include "split_strategy/types/split_param.h"
 #include "tree/RandomForest/randomforest.h"
 #include "split_strategy/types/ParamBuilder/ParamBuilder.h"
+#include "split_strategy/sampling/sampling.h"
 #include "tree/TreeModel.h"
 
 #include "test_access.h"
+#include "test_datasets.h"
 
 using arboria::DataSet;
 using arboria::RandomForest;
 using arboria::ParamBuilder;
+using arboria::test::make_noisy_dataset;
 
 namespace {
 
@@ -50,6 +61,7 @@ DataSet make_regression_dataset() {
     return DataSet(X, y, 4, 1);
 }
 
+
 }
 
 TEST_CASE("RandomForest : constructor validation") {
@@ -336,3 +348,741 @@ TEST_CASE("RandomForestRegressor : reproducibility") {
     REQUIRE(pred1 == pred2);
 }
 
+TEST_CASE("RandomForest : multiclass fit then predict") {
+
+    std::vector<float> X{
+        0, 0,
+        1, 0,
+        0, 1,
+        10, 10,
+        11, 10,
+        10, 11,
+        20, 0,
+        21, 0,
+        20, 1
+    };
+    std::vector<float> y{0, 0, 0, 1, 1, 1, 2, 2, 2};
+    DataSet data(X, y, 9, 2);
+
+    HyperParam h_param{.mtry = 2, .n_estimators = 30};
+    RandomForest forest(h_param, Classification{}, 123);
+    SplitParam param = ParamBuilder(TreeModel::RandomForest, Classification{}, Gini{}, CART{}, RandomK{2});
+    forest.fit(data, param);
+
+    REQUIRE(forest.n_classes() == 3);
+
+    std::vector<float> samples{
+        0, 0,
+        10, 10,
+        20, 0
+    };
+    std::vector<float> probas = forest.predict_proba(samples);
+    REQUIRE(probas.size() == 9);
+    for (size_t s = 0; s < 3; s++){
+        REQUIRE(probas[s*3] + probas[s*3+1] + probas[s*3+2] == Catch::Approx(1.f));
+    }
+
+    std::vector<float> preds = forest.predict(samples);
+    REQUIRE(preds == std::vector<float>{0, 1, 2});
+
+    float score = forest.out_of_bag(data);
+    REQUIRE(score >= 0.0f);
+    REQUIRE(score <= 1.0f);
+}
+
+TEST_CASE("RandomForestRegressor : multi-output fit then predict") {
+
+    std::vector<float> X{0, 0, 10, 10};
+    std::vector<float> y{1, -1,
+                        3, -3,
+                        5, -5,
+                        7, -7};
+    DataSet data(X, y, 4, 1, 2);
+
+    HyperParam h_param{.mtry=1, .n_estimators=5, .max_depth=1};
+    RandomForest forest(h_param, Regression{}, 123);
+    SplitParam param = ParamBuilder(TreeModel::RandomForest, Regression{}, SSE{}, CART{}, RandomK{1});
+    forest.fit(data, param);
+
+    REQUIRE(forest.n_outputs() == 2);
+
+    std::vector<float> samples{0, 10};
+    std::vector<float> preds = forest.predict(samples);
+    REQUIRE(preds.size() == 4);
+    for (size_t s = 0; s < 2; s++){
+        // both targets are mirrored : so are the averaged leaf means
+        REQUIRE(preds[s*2] == Catch::Approx(-preds[s*2+1]));
+        REQUIRE(preds[s*2] >= 1.f);
+        REQUIRE(preds[s*2] <= 7.f);
+    }
+}
+
+TEST_CASE("RandomForest : in-bag masks are regenerated from the tree seed") {
+    DataSet data = make_separable_dataset();
+    HyperParam h_param{.mtry = 2, .n_estimators = 5, .max_samples = 0.5f};
+    RandomForest forest(h_param, Classification{}, 123);
+    SplitParam param = ParamBuilder(TreeModel::RandomForest, Classification{}, Gini{}, CART{}, RandomK{2});
+    forest.fit(data, param);
+
+    for (size_t i = 0; i < 5; i++){
+        const arboria::ForestTree& forest_tree = arboria::test::RandomForestAccess::access_forest_trees(forest, i);
+        REQUIRE(forest_tree.n_rows == 6);
+        REQUIRE(forest_tree.n_draws == 3);
+
+        std::vector<bool> mask = forest_tree.in_bag();
+        REQUIRE(mask.size() == 6);
+        REQUIRE(mask == forest_tree.in_bag());
+
+        std::mt19937 rng(forest_tree.seed);
+        std::vector<size_t> drawn = arboria::sampling::bootstrap(6, 3, rng);
+        size_t n_in_bag = 0;
+        for (bool b : mask) n_in_bag += b;
+        REQUIRE(n_in_bag <= 3);
+        for (size_t row : drawn) REQUIRE(mask[row]);
+    }
+}
+
+TEST_CASE("RandomForest : OOB computed during fit matches out_of_bag") {
+    DataSet data = make_noisy_dataset(true);
+    HyperParam h_param{.mtry = 1, .n_estimators = 30, .n_jobs = 4, .oob_score = true};
+    RandomForest forest(h_param, Classification{}, 42);
+    SplitParam param = ParamBuilder(TreeModel::RandomForest, Classification{}, Gini{}, CART{}, RandomK{1});
+    forest.fit(data, param);
+
+    REQUIRE(forest.oob_score() == forest.out_of_bag(data));
+    REQUIRE(forest.oob_score() > 0.6f);
+
+    std::vector<float> oob_pred = forest.oob_prediction();
+    REQUIRE(oob_pred.size() == 60);
+    for (float p : oob_pred){
+        if (std::isnan(p)) continue;
+        REQUIRE(p >= 0.f);
+        REQUIRE(p <= 1.f);
+    }
+
+    //the score does not depend on the number of workers
+    HyperParam h_serial{.mtry = 1, .n_estimators = 30, .n_jobs = 1, .oob_score = true};
+    RandomForest serial(h_serial, Classification{}, 42);
+    serial.fit(data, param);
+    REQUIRE(serial.oob_score() == forest.oob_score());
+    REQUIRE(serial.oob_prediction().size() == oob_pred.size());
+}
+
+TEST_CASE("RandomForestRegressor : OOB score is a R2") {
+    DataSet data = make_noisy_dataset(false);
+    HyperParam h_param{.mtry = 2, .n_estimators = 30, .n_jobs = 2, .oob_score = true};
+    RandomForest forest(h_param, Regression{}, 42);
+    SplitParam param = ParamBuilder(TreeModel::RandomForest, Regression{}, SSE{}, CART{}, RandomK{2});
+    forest.fit(data, param);
+
+    float r2 = forest.oob_score();
+    REQUIRE(r2 == Catch::Approx(forest.out_of_bag(data)).margin(1e-5));
+    REQUIRE(r2 > 0.5f);
+    REQUIRE(r2 <= 1.f);
+
+    std::vector<float> oob_pred = forest.oob_prediction();
+    REQUIRE(oob_pred.size() == 60);
+}
+
+TEST_CASE("RandomForest : OOB accessors require oob_score") {
+    DataSet data = make_separable_dataset();
+    HyperParam h_param{.mtry = 2, .n_estimators = 5};
+    RandomForest forest(h_param, Classification{}, 123);
+    SplitParam param = ParamBuilder(TreeModel::RandomForest, Classification{}, Gini{}, CART{}, RandomK{2});
+    forest.fit(data, param);
+
+    REQUIRE_THROWS_AS(forest.oob_score(), std::logic_error);
+    REQUIRE_THROWS_AS(forest.oob_prediction(), std::logic_error);
+}
+
+TEST_CASE("RandomForest : OOB early stopping truncates the forest") {
+    DataSet data = make_noisy_dataset(true);
+    SplitParam param = ParamBuilder(TreeModel::RandomForest, Classification{}, Gini{}, CART{}, RandomK{1});
+
+    //a tolerance no batch can reach stops the fit after the second batch
+    HyperParam h_param{.mtry = 1, .n_estimators = 100, .n_jobs = 3, 
+                        .early_stopping_tol = 2.f, .early_stopping_batch = 5};
+    RandomForest forest(h_param, Classification{}, 42);
+    forest.fit(data, param);
+
+    REQUIRE(forest.n_trees() == 10);
+    REQUIRE(forest.get_estimators() == 100);
+    REQUIRE(forest.oob_score() == forest.out_of_bag(data));
+
+    //the kept trees are the first trees of the full forest
+    HyperParam h_small{.mtry = 1, .n_estimators = 10};
+    RandomForest small(h_small, Classification{}, 42);
+    small.fit(data, param);
+    std::span<const float> X(data.X());
+    REQUIRE(forest.predict_proba(X) == small.predict_proba(X));
+
+    //with a null tolerance, the fit stops only if a batch decreases the OOB score
+    HyperParam h_full{.mtry = 1, .n_estimators = 12, .early_stopping_tol = 0.f, .early_stopping_batch = 5};
+    RandomForest full(h_full, Classification{}, 42);
+    full.fit(data, param);
+    REQUIRE(full.n_trees() <= 12);
+    REQUIRE(full.n_trees() >= 10);
+}
+
+TEST_CASE("RandomForest : early stopping parameters validation") {
+    REQUIRE_THROWS_AS(RandomForest(HyperParam{.mtry = 1, .early_stopping_tol = -1.f}, Classification{}, 1), std::invalid_argument);
+    REQUIRE_THROWS_AS(RandomForest(HyperParam{.mtry = 1, .early_stopping_tol = 0.01f, .early_stopping_batch = 0}, Classification{}, 1), std::invalid_argument);
+}
+
+TEST_CASE("RandomForest : fit_more is identical to a single larger fit") {
+    DataSet data = make_noisy_dataset(true);
+    SplitParam param = ParamBuilder(TreeModel::RandomForest, Classification{}, Gini{}, CART{}, RandomK{1});
+
+    HyperParam h_param{.mtry = 1, .n_estimators = 8, .n_jobs = 2, .oob_score = true};
+    RandomForest warm(h_param, Classification{}, 42);
+    warm.fit(data, param);
+    warm.fit_more(data, param, 4);
+    warm.fit_more(data, param, 3);
+
+    HyperParam h_full{.mtry = 1, .n_estimators = 15, .oob_score = true};
+    RandomForest full(h_full, Classification{}, 42);
+    full.fit(data, param);
+
+    REQUIRE(warm.n_trees() == 15);
+    REQUIRE(warm.get_estimators() == 15);
+    std::span<const float> X(data.X());
+    REQUIRE(warm.predict_proba(X) == full.predict_proba(X));
+    REQUIRE(warm.oob_score() == full.oob_score());
+}
+
+TEST_CASE("RandomForest : fit_more validation") {
+    DataSet data = make_noisy_dataset(true);
+    SplitParam param = ParamBuilder(TreeModel::RandomForest, Classification{}, Gini{}, CART{}, RandomK{1});
+    RandomForest forest(HyperParam{.mtry = 1, .n_estimators = 3}, Classification{}, 42);
+
+    REQUIRE_THROWS_AS(forest.fit_more(data, param, 2), std::invalid_argument);
+    forest.fit(data, param);
+    REQUIRE_THROWS_AS(forest.fit_more(data, param, 0), std::invalid_argument);
+    REQUIRE_THROWS_AS(forest.fit_more(make_separable_dataset(), param, 2), std::invalid_argument);
+}
+
+TEST_CASE("RandomForest : rolling update replaces the oldest trees") {
+    DataSet data = make_noisy_dataset(true);
+    SplitParam param = ParamBuilder(TreeModel::RandomForest, Classification{}, Gini{}, CART{}, RandomK{1});
+    RandomForest forest(HyperParam{.mtry = 1, .n_estimators = 6, .n_jobs = 2, .oob_score = true}, Classification{}, 42);
+    forest.fit(data, param);
+
+    std::vector<std::uint32_t> seeds;
+    for (size_t i = 0; i < 6; i++) seeds.push_back(arboria::test::RandomForestAccess::access_forest_trees(forest, i).seed);
+
+    //new batch : first rows of the dataset with flipped labels
+    std::vector<float> X(data.X().begin(), data.X().begin() + 40);
+    std::vector<float> y;
+    for (int row = 0; row < 20; row++) y.push_back(1.f - data.iloc_y(row));
+    DataSet batch(X, y, 20, 2);
+
+    forest.update(batch, param, 2);
+
+    REQUIRE(forest.n_trees() == 6);
+    for (size_t i = 0; i < 4; i++){
+        REQUIRE(arboria::test::RandomForestAccess::access_forest_trees(forest, i).seed == seeds[i + 2]);
+    }
+    for (size_t i = 4; i < 6; i++){
+        const arboria::ForestTree& t = arboria::test::RandomForestAccess::access_forest_trees(forest, i);
+        REQUIRE(t.n_rows == 20);
+        for (std::uint32_t s : seeds) REQUIRE(t.seed != s);
+    }
+    REQUIRE_THROWS_AS(forest.oob_score(), std::logic_error);
+    REQUIRE_THROWS_AS(forest.update(batch, param, 7), std::invalid_argument);
+
+    std::vector<float> bad_y(20, 5.f);
+    REQUIRE_THROWS_AS(forest.update(DataSet(X, bad_y, 20, 2), param, 1), std::invalid_argument);
+}
+
+TEST_CASE("RandomForest : fit_more after an update restarts the OOB accumulators") {
+    DataSet data = make_noisy_dataset(true);
+    SplitParam param = ParamBuilder(TreeModel::RandomForest, Classification{}, Gini{}, CART{}, RandomK{1});
+
+    //batches larger than, and as large as, the training set ; replacing 
+    //every tree or only some, the older trees keeping the training set
+    for (int repeat : {4, 1}){
+        for (int k : {5, 2}){
+            RandomForest forest(HyperParam{.mtry = 1, .n_estimators = 5, .n_jobs = 2, .oob_score = true}, Classification{}, 42);
+            forest.fit(data, param);
+            std::vector<float> X;
+            std::vector<float> y;
+            for (int r = 0; r < repeat; r++){
+                X.insert(X.end(), data.X().begin(), data.X().end());
+                for (int row = 0; row < data.n_rows(); row++) y.push_back(1.f - data.iloc_y(row));
+            }
+            DataSet batch(X, y, data.n_rows() * repeat, 2);
+
+            forest.update(batch, param, k);
+            REQUIRE_THROWS_AS(forest.oob_score(), std::logic_error);
+            if (repeat != 1) REQUIRE_THROWS_AS(forest.fit_more(data, param, 4), std::invalid_argument);
+            forest.fit_more(batch, param, 4);
+            REQUIRE(forest.n_trees() == 9);
+            const float score = forest.oob_score();
+            REQUIRE(score >= 0.f);
+            REQUIRE(score <= 1.f);
+        }
+    }
+}
+
+TEST_CASE("RandomForest : predictions see a whole ensemble during updates") {
+    DataSet data = make_noisy_dataset(false);
+    SplitParam param = ParamBuilder(TreeModel::RandomForest, Regression{}, SSE{}, CART{}, RandomK{2});
+    RandomForest forest(HyperParam{.mtry = 2, .n_estimators = 4, .max_depth = 1}, Regression{}, 42);
+    forest.fit(data, param);
+
+    //every ensemble is made of stumps fitted on a constant target : its 
+    //average is exactly the constant of the batches it was fitted on
+    std::vector<float> X(data.X().begin(), data.X().begin() + 20);
+    std::vector<float> ones(10, 1.f);
+    DataSet batch(X, ones, 10, 2);
+    forest.update(batch, param, 4);
+
+    std::atomic<bool> done{false};
+    std::atomic<int> mixed{0};
+    std::thread reader([&](){
+        std::vector<float> sample{0.f, 0.f};
+        while (!done){
+            float pred = forest.predict(sample)[0];
+            if (pred != 1.f && pred != 2.f) mixed++;
+        }
+    });
+
+    std::vector<float> twos(10, 2.f);
+    DataSet batch2(X, twos, 10, 2);
+    for (int round = 0; round < 20; round++){
+        forest.update(round % 2 ? batch : batch2, param, 4);
+    }
+    done = true;
+    reader.join();
+    REQUIRE(mixed == 0);
+}
+
+TEST_CASE("RandomForest : quantile regression validation") {
+
+    REQUIRE_THROWS_AS(RandomForest(HyperParam{.mtry = 1, .quantiles = true}, Classification{}, 1), std::invalid_argument);
+    REQUIRE_THROWS_AS(RandomForest(HyperParam{.mtry = 1, .max_leaf_samples = 0}, Regression{}, 1), std::invalid_argument);
+
+    DataSet data = make_noisy_dataset(false);
+    SplitParam params = ParamBuilder(TreeModel::RandomForest, Regression{}, SSE{}, CART{}, RandomK{1});
+    std::vector<float> qs {0.5f};
+
+    RandomForest plain(HyperParam{.mtry = 1, .n_estimators = 5}, Regression{}, 3);
+    REQUIRE_FALSE(plain.stores_quantiles());
+    plain.fit(data, params);
+    REQUIRE_THROWS_AS(plain.predict_quantiles(data.X(), qs), std::logic_error);
+
+    RandomForest forest(HyperParam{.mtry = 1, .n_estimators = 5, .quantiles = true}, Regression{}, 3);
+    REQUIRE_THROWS_AS(forest.predict_quantiles(data.X(), qs), std::invalid_argument);
+    forest.fit(data, params);
+    std::vector<float> bad_qs {1.5f};
+    REQUIRE_THROWS_AS(forest.predict_quantiles(data.X(), bad_qs), std::invalid_argument);
+    std::vector<float> bad_sample {0.f, 0.f, 0.f};
+    REQUIRE_THROWS_AS(forest.predict_quantiles(bad_sample, qs), std::invalid_argument);
+
+    DataSet multi(std::vector<float>{0, 1, 2, 3}, std::vector<float>{0, 0, 1, 1, 2, 2, 3, 3}, 4, 1, 2);
+    RandomForest multi_forest(HyperParam{.mtry = 1, .n_estimators = 2, .quantiles = true}, Regression{}, 3);
+    SplitParam multi_params = ParamBuilder(TreeModel::RandomForest, Regression{}, SSE{}, CART{}, RandomK{1});
+    REQUIRE_THROWS_AS(multi_forest.fit(multi, multi_params), std::invalid_argument);
+}
+
+TEST_CASE("RandomForest : quantiles are ordered and bracket the training targets") {
+
+    DataSet data = make_noisy_dataset(false);
+    SplitParam params = ParamBuilder(TreeModel::RandomForest, Regression{}, SSE{}, CART{}, RandomK{1});
+    RandomForest forest(HyperParam{.mtry = 1, .n_estimators = 20, .n_jobs = 3, .quantiles = true}, Regression{}, 42);
+    forest.fit(data, params);
+
+    const std::vector<float>& y = data.y();
+    const float y_min = *std::min_element(y.begin(), y.end());
+    const float y_max = *std::max_element(y.begin(), y.end());
+
+    std::vector<float> qs {0.f, 0.1f, 0.5f, 0.9f, 1.f};
+    std::vector<float> quantiles = forest.predict_quantiles(data.X(), qs);
+    REQUIRE(quantiles.size() == static_cast<size_t>(data.n_rows()) * qs.size());
+
+    for (int i = 0; i < data.n_rows(); i++){
+        for (size_t j = 0; j < qs.size(); j++){
+            const float value = quantiles[i*qs.size() + j];
+            REQUIRE(value >= y_min);
+            REQUIRE(value <= y_max);
+            if (j > 0) REQUIRE(value >= quantiles[i*qs.size() + j - 1]);
+        }
+    }
+
+    //fully grown trees : the median of a training row is close to its target
+    std::vector<float> median {0.5f};
+    std::vector<float> medians = forest.predict_quantiles(data.X(), median);
+    double abs_err = 0.0;
+    for (int i = 0; i < data.n_rows(); i++) abs_err += std::abs(medians[i] - y[i]);
+    REQUIRE(abs_err / data.n_rows() < 1.0);
+}
+
+TEST_CASE("RandomForest : a single stored value per leaf gives the leaf means") {
+
+    DataSet data = make_noisy_dataset(false);
+    SplitParam params = ParamBuilder(TreeModel::RandomForest, Regression{}, SSE{}, CART{}, RandomK{1});
+    RandomForest forest(HyperParam{.mtry = 1, .n_estimators = 1, .max_depth = 2, .max_leaf_samples = 1}, Regression{}, 5);
+    REQUIRE(forest.stores_quantiles());
+    forest.fit(data, params);
+
+    //a sketch of one bin keeps the weighted mean of the leaf, i.e. its prediction
+    std::vector<float> qs {0.f, 0.5f, 1.f};
+    std::vector<float> quantiles = forest.predict_quantiles(data.X(), qs);
+    std::vector<float> preds = forest.predict(data.X());
+    for (int i = 0; i < data.n_rows(); i++){
+        for (size_t j = 0; j < qs.size(); j++){
+            REQUIRE(quantiles[i*qs.size() + j] == Catch::Approx(preds[i]).margin(1e-4));
+        }
+    }
+}
+
+TEST_CASE("RandomForest : leaf sketch bounds the stored values") {
+
+    DataSet data = make_noisy_dataset(false);
+    SplitParam params = ParamBuilder(TreeModel::RandomForest, Regression{}, SSE{}, CART{}, RandomK{1});
+    RandomForest exact(HyperParam{.mtry = 1, .n_estimators = 10, .max_depth = 2, .quantiles = true}, Regression{}, 9);
+    RandomForest sketch(HyperParam{.mtry = 1, .n_estimators = 10, .max_depth = 2, .max_leaf_samples = 4}, Regression{}, 9);
+    exact.fit(data, params);
+    sketch.fit(data, params);
+
+    for (size_t t = 0; t < sketch.n_trees(); t++){
+        const arboria::LeafSummary& leaves = *arboria::test::RandomForestAccess::access_forest_trees(sketch, t).leaf_samples;
+        const arboria::LeafSummary& full = *arboria::test::RandomForestAccess::access_forest_trees(exact, t).leaf_samples;
+        for (size_t node = 0; node + 1 < leaves.offset.size(); node++){
+            REQUIRE(leaves.offset[node + 1] - leaves.offset[node] <= 4);
+            float w = 0.f, w_full = 0.f;
+            for (int e = leaves.offset[node]; e < leaves.offset[node + 1]; e++) w += leaves.weights[e];
+            for (int e = full.offset[node]; e < full.offset[node + 1]; e++) w_full += full.weights[e];
+            REQUIRE(w == w_full);
+        }
+        REQUIRE(full.values.size() >= leaves.values.size());
+    }
+
+    //medians of the sketch stay within the range of the exact quantiles
+    std::vector<float> qs {0.5f};
+    std::vector<float> q_sketch = sketch.predict_quantiles(data.X(), qs);
+    std::vector<float> lo_hi {0.f, 1.f};
+    std::vector<float> q_exact = exact.predict_quantiles(data.X(), lo_hi);
+    for (int i = 0; i < data.n_rows(); i++){
+        REQUIRE(q_sketch[i] >= q_exact[2*i]);
+        REQUIRE(q_sketch[i] <= q_exact[2*i + 1]);
+    }
+}
+
+TEST_CASE("RandomForest : honest trees") {
+
+    REQUIRE_THROWS_AS(RandomForest(HyperParam{.mtry = 1, .honest_fraction = 1.f}, Regression{}, 1), std::invalid_argument);
+
+    DataSet data = make_noisy_dataset(false);
+    SplitParam params = ParamBuilder(TreeModel::RandomForest, Regression{}, SSE{}, CART{}, RandomK{1});
+
+    RandomForest sequential(HyperParam{.mtry = 1, .n_estimators = 20, .n_jobs = 1, .honest_fraction = 0.5f}, Regression{}, 8);
+    RandomForest parallel(HyperParam{.mtry = 1, .n_estimators = 20, .n_jobs = 4, .honest_fraction = 0.5f}, Regression{}, 8);
+    RandomForest adaptive(HyperParam{.mtry = 1, .n_estimators = 20, .n_jobs = 1}, Regression{}, 8);
+    sequential.fit(data, params);
+    parallel.fit(data, params);
+    adaptive.fit(data, params);
+
+    REQUIRE(sequential.predict(data.X()) == parallel.predict(data.X()));
+    REQUIRE(sequential.predict(data.X()) != adaptive.predict(data.X()));
+    //honest leaves still fit the signal
+    REQUIRE(sequential.out_of_bag(data) > 0.5f);
+}
+
+TEST_CASE("RandomForest : blocked engine matches the walk of every tree") {
+
+    std::mt19937 rng(12);
+    std::normal_distribution<float> noise(0.f, 1.f);
+    //150 rows : two full tiles and a partial one
+    const int n_rows = 150;
+    std::vector<float> X;
+    std::vector<float> labels;
+    std::vector<float> targets;
+    for (int i = 0; i < n_rows; i++){
+        const float a = noise(rng);
+        const float b = noise(rng);
+        X.insert(X.end(), {a, b});
+        labels.push_back(static_cast<float>((a > 0.f) + (b > 0.5f)));
+        targets.insert(targets.end(), {a - b, 2.f * b});
+    }
+
+    auto check = [&](RandomForest& forest){
+        forest.set_predict_engine(Traversal{});
+        const std::vector<float> walked = forest.predict_proba(X);
+        forest.set_predict_engine(Blocked{});
+        REQUIRE(forest.predict_proba(X) == walked);
+        //a batch smaller than a tile
+        std::span<const float> few(X.data(), 2 * 5);
+        REQUIRE(forest.predict_proba(few) == std::vector<float>(walked.begin(), walked.begin() + static_cast<std::ptrdiff_t>(walked.size() / n_rows * 5)));
+    };
+
+    for (int n_jobs : {1, 3}){
+        RandomForest multiclass(HyperParam{.mtry = 2, .n_estimators = 12, .n_jobs = n_jobs}, Classification{}, 5);
+        multiclass.fit(DataSet(X, labels, n_rows, 2), ParamBuilder(TreeModel::RandomForest, Classification{}, Gini{}, CART{}, RandomK{2}));
+        check(multiclass);
+
+        RandomForest multioutput(HyperParam{.mtry = 1, .n_estimators = 12, .n_jobs = n_jobs}, Regression{}, 5);
+        multioutput.fit(DataSet(X, targets, n_rows, 2, 2), ParamBuilder(TreeModel::RandomForest, Regression{}, SSE{}, CART{}, RandomK{1}));
+        check(multioutput);
+    }
+
+    DataSet binary = make_noisy_dataset(true);
+    RandomForest forest(HyperParam{.mtry = 1, .n_estimators = 10}, Classification{}, 6);
+    forest.fit(binary, ParamBuilder(TreeModel::RandomForest, Classification{}, Gini{}, CART{}, RandomK{1}));
+    forest.set_predict_engine(Blocked{});
+    std::vector<float> with_nan {std::numeric_limits<float>::quiet_NaN(), 0.f};
+    REQUIRE_THROWS_AS(forest.predict(with_nan), std::invalid_argument);
+}
+
+TEST_CASE("RandomForest : anytime prediction visits the most accurate trees first") {
+
+    DataSet data = make_noisy_dataset(false);
+    RandomForest forest(HyperParam{.mtry = 1, .n_estimators = 15, .max_depth = 4, .oob_score = true}, Regression{}, 7);
+    forest.fit(data, ParamBuilder(TreeModel::RandomForest, Regression{}, SSE{}, CART{}, RandomK{1}));
+
+    const std::vector<size_t> order = forest.anytime_order();
+    REQUIRE(order.size() == 15);
+    for (size_t j = 1; j < order.size(); j++){
+        const std::optional<float> previous = arboria::test::RandomForestAccess::access_forest_trees(forest, order[j - 1]).oob_error;
+        const std::optional<float> next = arboria::test::RandomForestAccess::access_forest_trees(forest, order[j]).oob_error;
+        REQUIRE(previous.has_value());
+        REQUIRE(next.has_value());
+        REQUIRE(*previous <= *next);
+    }
+
+    //the first trees of the order, averaged
+    const arboria::AnytimePrediction three = forest.predict_proba_anytime(data.X(), 3);
+    REQUIRE(three.n_trees == 3);
+    for (int row = 0; row < data.n_rows(); row++){
+        std::span<const float> sample = std::span<const float>(data.X()).subspan(static_cast<size_t>(row) * 2, 2);
+        float sum = 0.f;
+        for (size_t j = 0; j < 3; j++) sum += arboria::test::RandomForestAccess::access_forest_trees(forest, order[j]).tree->predict_one(sample);
+        REQUIRE(three.proba[static_cast<size_t>(row)] == sum / 3.f);
+    }
+
+    //every tree : predict_proba up to the order of the sum
+    const arboria::AnytimePrediction all = forest.predict_proba_anytime(data.X(), std::nullopt);
+    REQUIRE(all.n_trees == 15);
+    const std::vector<float> full = forest.predict_proba(data.X());
+    for (size_t i = 0; i < full.size(); i++) REQUIRE(all.proba[i] == Catch::Approx(full[i]).margin(1e-5));
+    REQUIRE(forest.predict_proba_anytime(data.X(), 100).n_trees == 15);
+
+    //an expired deadline still evaluates the first tree
+    const arboria::AnytimePrediction expired = forest.predict_proba_anytime(data.X(), std::nullopt, std::chrono::nanoseconds(0));
+    REQUIRE(expired.n_trees == 1);
+    REQUIRE(expired.proba == forest.predict_proba_anytime(data.X(), 1).proba);
+
+    //a deadline met mid-batch on several threads : every sample averages the same trees
+    RandomForest threaded(HyperParam{.mtry = 1, .n_estimators = 40, .max_depth = 6, .n_jobs = 3}, Regression{}, 7);
+    threaded.fit(data, ParamBuilder(TreeModel::RandomForest, Regression{}, SSE{}, CART{}, RandomK{1}));
+    std::vector<float> batch;
+    for (int r = 0; r < 200; r++) batch.insert(batch.end(), data.X().begin(), data.X().end());
+    const arboria::AnytimePrediction partial = threaded.predict_proba_anytime(batch, std::nullopt, std::chrono::microseconds(300));
+    REQUIRE(partial.n_trees >= 1);
+    REQUIRE(partial.n_trees <= 40);
+    REQUIRE(partial.proba == threaded.predict_proba_anytime(batch, partial.n_trees).proba);
+
+    REQUIRE_THROWS_AS(forest.predict_proba_anytime(data.X(), 0), std::invalid_argument);
+    REQUIRE_THROWS_AS(forest.predict_proba_anytime(std::vector<float>(3, 0.f), 2), std::invalid_argument);
+    RandomForest unfitted(HyperParam{.mtry = 1, .n_estimators = 2}, Regression{}, 7);
+    REQUIRE_THROWS_AS(unfitted.predict_proba_anytime(data.X(), 1), std::invalid_argument);
+}
+
+TEST_CASE("RandomForest : anytime order of forests without OOB errors") {
+
+    DataSet data = make_noisy_dataset(true);
+    SplitParam param = ParamBuilder(TreeModel::RandomForest, Classification{}, Gini{}, CART{}, RandomK{1});
+    RandomForest forest(HyperParam{.mtry = 1, .n_estimators = 6}, Classification{}, 8);
+    forest.fit(data, param);
+    REQUIRE(forest.anytime_order() == std::vector<size_t>{0, 1, 2, 3, 4, 5});
+
+    //the OOB errors are saved with the trees
+    RandomForest scored(HyperParam{.mtry = 1, .n_estimators = 8, .oob_score = true}, Classification{}, 8);
+    scored.fit(data, param);
+    const std::vector<std::byte> bytes = scored.to_bytes();
+    std::unique_ptr<RandomForest> loaded = RandomForest::from_bytes(bytes);
+    REQUIRE(loaded->anytime_order() == scored.anytime_order());
+    const arboria::AnytimePrediction half = loaded->predict_proba_anytime(data.X(), 4);
+    REQUIRE(half.proba == scored.predict_proba_anytime(data.X(), 4).proba);
+}
+
+TEST_CASE("RandomForest : early-exit votes give the labels of the full vote") {
+
+    std::mt19937 rng(13);
+    std::normal_distribution<float> noise(0.f, 1.f);
+    const int n_rows = 200;
+    std::vector<float> X;
+    std::vector<float> binary;
+    std::vector<float> multiclass;
+    for (int i = 0; i < n_rows; i++){
+        const float a = noise(rng);
+        const float b = noise(rng);
+        X.insert(X.end(), {a, b});
+        //noisy labels : some votes are close, some are ties
+        binary.push_back((a + noise(rng) > 0.f) ? 1.f : 0.f);
+        multiclass.push_back(static_cast<float>((a + 0.7f * noise(rng) > 0.f) + (b + 0.7f * noise(rng) > 0.5f)));
+    }
+
+    //labels thresholded from the averaged votes
+    auto full_vote = [&](RandomForest& forest){
+        const std::vector<float> proba = forest.predict_proba(X);
+        const size_t K = (forest.n_classes() > 2) ? static_cast<size_t>(forest.n_classes()) : 1;
+        std::vector<float> labels(proba.size() / K);
+        for (size_t i = 0; i < labels.size(); i++){
+            if (K == 1) {labels[i] = (proba[i] >= 0.5f) ? 1.f : 0.f; continue;}
+            size_t best = 0;
+            for (size_t k = 1; k < K; k++) if (proba[i*K + k] >= proba[i*K + best]) best = k;
+            labels[i] = static_cast<float>(best);
+        }
+        return labels;
+    };
+
+    for (int n_estimators : {10, 15}){
+        for (int n_jobs : {1, 3}){
+            RandomForest two(HyperParam{.mtry = 1, .n_estimators = n_estimators, .n_jobs = n_jobs}, Classification{}, 9);
+            two.fit(DataSet(X, binary, n_rows, 2), ParamBuilder(TreeModel::RandomForest, Classification{}, Gini{}, CART{}, RandomK{1}));
+            RandomForest four(HyperParam{.mtry = 2, .n_estimators = n_estimators, .n_jobs = n_jobs}, Classification{}, 9);
+            four.fit(DataSet(X, multiclass, n_rows, 2), ParamBuilder(TreeModel::RandomForest, Classification{}, Entropy{}, CART{}, RandomK{2}));
+            REQUIRE(four.n_classes() == 3);
+
+            for (RandomForest* forest : {&two, &four}){
+                const std::vector<float> expected = full_vote(*forest);
+                for (PredictEngine engine : std::vector<PredictEngine>{Traversal{}, Blocked{}, Undefined{}}){
+                    forest->set_predict_engine(engine);
+                    REQUIRE(forest->predict(X) == expected);
+                    //single samples
+                    for (size_t i = 0; i < 5; i++){
+                        REQUIRE(forest->predict(std::span<const float>(X).subspan(2 * i, 2)) == std::vector<float>{expected[i]});
+                    }
+                }
+            }
+        }
+    }
+}
+
+TEST_CASE("RandomForest : early-exit votes reject NaN met by skipped trees only") {
+
+    //the first trees only split on a, the last ones, learned by update(), on b
+    std::vector<float> on_a;
+    std::vector<float> on_b;
+    std::vector<float> y;
+    for (int i = 0; i < 40; i++){
+        const float v = static_cast<float>(i) - 19.5f;
+        on_a.insert(on_a.end(), {v, 0.f});
+        on_b.insert(on_b.end(), {0.f, v});
+        y.push_back(v > 0.f ? 1.f : 0.f);
+    }
+    SplitParam param = ParamBuilder(TreeModel::RandomForest, Classification{}, Gini{}, CART{}, RandomK{2});
+    RandomForest forest(HyperParam{.mtry = 2, .n_estimators = 7, .max_depth = 1}, Classification{}, 3);
+    forest.fit(DataSet(on_a, y, 40, 2), param);
+    forest.update(DataSet(on_b, y, 40, 2), param, 2);
+
+    //the five trees on a decide the vote before b is tested
+    const std::vector<float> with_nan {10.f, std::numeric_limits<float>::quiet_NaN()};
+    REQUIRE_THROWS_AS(forest.predict_proba(with_nan), std::invalid_argument);
+    REQUIRE_THROWS_AS(forest.predict(with_nan), std::invalid_argument);
+    REQUIRE_THROWS_AS(forest.predict_one(with_nan.data()), std::invalid_argument);
+    REQUIRE(forest.predict(std::vector<float>{10.f, 10.f}) == std::vector<float>{1.f});
+}
+
+TEST_CASE("RandomForest : small batches split the trees between threads") {
+
+    std::mt19937 rng(14);
+    std::normal_distribution<float> noise(0.f, 1.f);
+    const int n_rows = 130;
+    std::vector<float> X;
+    std::vector<float> labels;
+    std::vector<float> targets;
+    for (int i = 0; i < n_rows; i++){
+        const float a = noise(rng);
+        const float b = noise(rng);
+        X.insert(X.end(), {a, b});
+        labels.push_back(static_cast<float>((a + 0.5f * noise(rng) > 0.f) + (b > 0.5f)));
+        targets.insert(targets.end(), {a - b, 2.f * b});
+    }
+
+    //a single sample, a partial tile, and two tiles and a half for 4 threads
+    auto check = [&](RandomForest& forest){
+        forest.set_predict_engine(Traversal{});
+        const std::vector<float> walked = forest.predict_proba(X);
+        const size_t width = walked.size() / n_rows;
+        for (size_t n : {size_t{1}, size_t{7}, size_t{n_rows}}){
+            std::span<const float> batch(X.data(), 2 * n);
+            const std::vector<float> expected(walked.begin(), walked.begin() + static_cast<std::ptrdiff_t>(width * n));
+            for (PredictEngine engine : std::vector<PredictEngine>{Blocked{}, Undefined{}}){
+                forest.set_predict_engine(engine);
+                REQUIRE(forest.predict_proba(batch) == expected);
+            }
+            forest.set_predict_engine(Traversal{});
+            const std::vector<float> voted = forest.predict(batch);
+            forest.set_predict_engine(Blocked{});
+            REQUIRE(forest.predict(batch) == voted);
+        }
+    };
+
+    RandomForest multiclass(HyperParam{.mtry = 2, .n_estimators = 18, .n_jobs = 4}, Classification{}, 7);
+    multiclass.fit(DataSet(X, labels, n_rows, 2), ParamBuilder(TreeModel::RandomForest, Classification{}, Gini{}, CART{}, RandomK{2}));
+    REQUIRE(multiclass.n_classes() == 3);
+    check(multiclass);
+
+    RandomForest multioutput(HyperParam{.mtry = 1, .n_estimators = 18, .n_jobs = 4}, Regression{}, 7);
+    multioutput.fit(DataSet(X, targets, n_rows, 2, 2), ParamBuilder(TreeModel::RandomForest, Regression{}, SSE{}, CART{}, RandomK{1}));
+    check(multioutput);
+
+    //fewer trees than a task : the trees are not split
+    RandomForest binary(HyperParam{.mtry = 1, .n_estimators = 3, .n_jobs = 4}, Classification{}, 7);
+    binary.fit(make_noisy_dataset(true), ParamBuilder(TreeModel::RandomForest, Classification{}, Gini{}, CART{}, RandomK{1}));
+    check(binary);
+
+    multiclass.set_predict_engine(Blocked{});
+    std::vector<float> with_nan {0.f, std::numeric_limits<float>::quiet_NaN()};
+    REQUIRE_THROWS_AS(multiclass.predict_proba(with_nan), std::invalid_argument);
+}
+
+TEST_CASE("RandomForest : predict_one gives the predictions of predict") {
+
+    std::mt19937 rng(15);
+    std::normal_distribution<float> noise(0.f, 1.f);
+    const int n_rows = 80;
+    std::vector<float> X;
+    std::vector<float> labels;
+    std::vector<float> targets;
+    for (int i = 0; i < n_rows; i++){
+        const float a = noise(rng);
+        const float b = noise(rng);
+        X.insert(X.end(), {a, b});
+        labels.push_back(static_cast<float>((a + 0.7f * noise(rng) > 0.f) + (b + 0.7f * noise(rng) > 0.5f)));
+        targets.push_back(a - b + 0.1f * noise(rng));
+    }
+
+    auto check = [&](RandomForest& forest){
+        for (PredictEngine engine : std::vector<PredictEngine>{Traversal{}, Undefined{}}){
+            forest.set_predict_engine(engine);
+            const std::vector<float> expected = forest.predict(X);
+            for (size_t i = 0; i < static_cast<size_t>(n_rows); i++) REQUIRE(forest.predict_one(X.data() + 2 * i) == expected[i]);
+        }
+    };
+
+    RandomForest multiclass(HyperParam{.mtry = 2, .n_estimators = 15}, Classification{}, 8);
+    multiclass.fit(DataSet(X, labels, n_rows, 2), ParamBuilder(TreeModel::RandomForest, Classification{}, Entropy{}, CART{}, RandomK{2}));
+    REQUIRE(multiclass.n_classes() == 3);
+    check(multiclass);
+
+    RandomForest binary(HyperParam{.mtry = 1, .n_estimators = 10}, Classification{}, 8);
+    binary.fit(make_noisy_dataset(true), ParamBuilder(TreeModel::RandomForest, Classification{}, Gini{}, CART{}, RandomK{1}));
+    check(binary);
+
+    RandomForest regression(HyperParam{.mtry = 1, .n_estimators = 10}, Regression{}, 8);
+    regression.fit(DataSet(X, targets, n_rows, 2), ParamBuilder(TreeModel::RandomForest, Regression{}, SSE{}, CART{}, RandomK{1}));
+    check(regression);
+
+    std::vector<float> with_nan {std::numeric_limits<float>::quiet_NaN(), std::numeric_limits<float>::quiet_NaN()};
+    REQUIRE_THROWS_AS(regression.predict_one(with_nan.data()), std::invalid_argument);
+    RandomForest multioutput(HyperParam{.mtry = 1, .n_estimators = 3}, Regression{}, 8);
+    std::vector<float> two_targets;
+    for (float t : targets) two_targets.insert(two_targets.end(), {t, -t});
+    multioutput.fit(DataSet(X, two_targets, n_rows, 2, 2), ParamBuilder(TreeModel::RandomForest, Regression{}, SSE{}, CART{}, RandomK{1}));
+    REQUIRE_THROWS_AS(multioutput.predict_one(X.data()), std::invalid_argument);
+    RandomForest unfitted(HyperParam{.mtry = 1, .n_estimators = 3}, Regression{}, 8);
+    REQUIRE_THROWS_AS(unfitted.predict_one(X.data()), std::invalid_argument);
+}
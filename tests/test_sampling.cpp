@@ -143,4 +143,24 @@ TEST_CASE("Sampling - subsampling - errors : n_sample > size_s"){
     
     REQUIRE_THROWS_AS(subsample(data_size, n_samples, rng), std::invalid_argument);
 
-}
\ No newline at end of file
+}
+TEST_CASE("Sampling - subsampling - small samples of large sets match the dense shuffle"){
+
+    size_t data_size = 1000;
+    size_t n_samples = 20;
+    std::mt19937 rng(3);
+    std::mt19937 reference_rng(3);
+
+    std::vector<size_t> indices = subsample(data_size, n_samples, rng);
+
+    //partial Fisher-Yates over the materialised indices
+    std::vector<size_t> vec(data_size);
+    for (size_t i = 0; i < data_size; i++) vec[i] = i;
+    for (size_t i = 0; i < n_samples; i++){
+        std::uniform_int_distribution<size_t> dist(i, data_size-1);
+        std::swap(vec[i], vec[dist(reference_rng)]);
+    }
+    vec.resize(n_samples);
+
+    REQUIRE(indices == vec);
+}
@@ -0,0 +1,292 @@
+/*
+
+                                    TESTS FOR MODEL SERIALIZATION
+
+*/
+
+
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/catch_approx.hpp>
+#include <cmath>
+#include <cstddef>
+#include <cstdio>
+#include <filesystem>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <variant>
+#include <vector>
+
+#include "test_access.h"
+#include "test_engines.h"
+#include "dataset/dataset.h"
+#include "serialization/serialization.h"
+#include "split_strategy/types/ParamBuilder/ParamBuilder.h"
+#include "split_strategy/types/split_param.h"
+#include "tree/DecisionTree/DecisionTree.h"
+#include "tree/RandomForest/randomforest.h"
+#include "tree/TreeModel.h"
+
+using arboria::DataSet;
+using arboria::DecisionTree;
+using arboria::RandomForest;
+using arboria::ParamBuilder;
+using arboria::test::DecisionTreeAccess;
+using arboria::test::RandomForestAccess;
+using arboria::test::leftover_siblings;
+using arboria::test::make_engine_dataset;
+
+namespace {
+
+std::string temp_path(const std::string& name) {
+    return (std::filesystem::temp_directory_path() / ("arboria_" + name + ".bin")).string();
+}
+
+}
+
+TEST_CASE("Serialization : DecisionTree round trip") {
+
+    DataSet data = make_engine_dataset(3, 1, 120);
+    DecisionTree tree(HyperParam{.max_depth = 5, .min_sample_split = 2}, Classification{});
+    tree.fit(data, ParamBuilder(TreeModel::DecisionTree, Classification{}, Gini{}, CART{}, AllFeatures{}));
+    std::span<const float> X(data.X());
+
+    const std::vector<std::byte> bytes = tree.to_bytes();
+    //padding is zeroed : a tree is always written to the same bytes
+    REQUIRE(tree.to_bytes() == bytes);
+
+    const std::string path = temp_path("tree");
+    tree.save(path);
+
+    for (bool mmap : {true, false}){
+        DecisionTree loaded = DecisionTree::load(path, mmap);
+        REQUIRE(loaded.is_fitted());
+        REQUIRE(loaded.num_features == 5);
+        REQUIRE(loaded.n_classes() == 3);
+        REQUIRE(loaded.max_depth == tree.max_depth);
+        REQUIRE(loaded.min_sample_split == tree.min_sample_split);
+        REQUIRE(loaded.n_nodes() == tree.n_nodes());
+        REQUIRE(loaded.predict(X) == tree.predict(X));
+        REQUIRE(loaded.predict_proba(X) == tree.predict_proba(X));
+        REQUIRE(loaded.apply(X) == tree.apply(X));
+        REQUIRE(loaded.to_bytes() == bytes);
+    }
+
+    DecisionTree copied = DecisionTree::from_bytes(bytes);
+    REQUIRE(copied.predict_proba(X) == tree.predict_proba(X));
+
+    //a loaded tree can be refitted : it then owns its nodes
+    copied.fit(data, ParamBuilder(TreeModel::DecisionTree, Classification{}, Gini{}, CART{}, AllFeatures{}));
+    REQUIRE(copied.predict(X) == tree.predict(X));
+    std::remove(path.c_str());
+}
+
+TEST_CASE("Serialization : multi-output DecisionTree round trip") {
+
+    std::mt19937 rng(5);
+    std::normal_distribution<float> noise(0.f, 1.f);
+    std::vector<float> X(80 * 2);
+    std::vector<float> y;
+    for (float& v : X) v = noise(rng);
+    for (size_t i = 0; i < 80; i++) y.insert(y.end(), {X[2 * i], X[2 * i] - X[2 * i + 1]});
+    DataSet data(X, y, 80, 2, 2);
+
+    DecisionTree tree(HyperParam{.max_depth = 4}, Regression{});
+    tree.fit(data, ParamBuilder(TreeModel::DecisionTree, Regression{}, SSE{}, CART{}, AllFeatures{}));
+
+    DecisionTree loaded = DecisionTree::from_bytes(tree.to_bytes());
+    REQUIRE(loaded.n_outputs() == 2);
+    REQUIRE(loaded.predict(X) == tree.predict(X));
+}
+
+TEST_CASE("Serialization : RandomForest round trip") {
+
+    DataSet data = make_engine_dataset(0, 1, 120);
+    SplitParam param = ParamBuilder(TreeModel::RandomForest, Regression{}, SSE{}, CART{}, RandomK{2});
+    RandomForest forest(HyperParam{.mtry = 2, .n_estimators = 12, .max_depth = 6, .n_jobs = 2, .oob_score = true, .quantiles = true}, Regression{}, 17);
+    forest.fit(data, param);
+    std::span<const float> X(data.X());
+    const std::vector<float> qs {0.1f, 0.5f, 0.9f};
+
+    const std::vector<std::byte> bytes = forest.to_bytes();
+    const std::string path = temp_path("forest");
+    forest.save(path);
+
+    for (bool mmap : {true, false}){
+        std::unique_ptr<RandomForest> loaded = RandomForest::load(path, mmap);
+        REQUIRE(loaded->is_fitted());
+        REQUIRE(loaded->seed() == 17);
+        REQUIRE(loaded->n_trees() == 12);
+        REQUIRE(loaded->get_max_depth() == 6);
+        REQUIRE(loaded->stores_quantiles());
+        REQUIRE(loaded->predict(X) == forest.predict(X));
+        REQUIRE(loaded->predict_quantiles(X, qs) == forest.predict_quantiles(X, qs));
+        REQUIRE(loaded->oob_score() == forest.oob_score());
+        REQUIRE(loaded->oob_prediction() == forest.oob_prediction());
+        REQUIRE(loaded->to_bytes() == bytes);
+    }
+
+    //the mapping outlives the file
+    std::unique_ptr<RandomForest> mapped = RandomForest::load(path);
+    std::remove(path.c_str());
+    REQUIRE(mapped->predict(X) == forest.predict(X));
+}
+
+TEST_CASE("Serialization : a loaded RandomForest keeps growing like the original") {
+
+    DataSet data = make_engine_dataset(3, 1, 120);
+    SplitParam param = ParamBuilder(TreeModel::RandomForest, Classification{}, Gini{}, CART{}, RandomK{1});
+    RandomForest forest(HyperParam{.mtry = 1, .n_estimators = 6, .oob_score = true}, Classification{}, 9);
+    forest.fit(data, param);
+
+    std::unique_ptr<RandomForest> loaded = RandomForest::from_bytes(forest.to_bytes());
+    loaded->fit_more(data, param, 4);
+    forest.fit_more(data, param, 4);
+
+    std::span<const float> X(data.X());
+    REQUIRE(loaded->n_trees() == 10);
+    REQUIRE(loaded->predict_proba(X) == forest.predict_proba(X));
+    REQUIRE(loaded->oob_score() == forest.oob_score());
+}
+
+TEST_CASE("Serialization : a mapped RandomForest reads every array in place") {
+
+    DataSet data = make_engine_dataset(0, 1, 120);
+    SplitParam param = ParamBuilder(TreeModel::RandomForest, Regression{}, SSE{}, CART{}, RandomK{2});
+    RandomForest forest(HyperParam{.mtry = 2, .n_estimators = 8, .oob_score = true, .quantiles = true}, Regression{}, 4);
+    forest.fit(data, param);
+    std::span<const float> X(data.X());
+    const std::vector<float> qs {0.25f, 0.75f};
+
+    const std::string path = temp_path("shared_forest");
+    forest.save(path);
+    std::unique_ptr<RandomForest> loaded = RandomForest::load(path);
+
+    //nodes and leaf targets point into the mapping
+    const std::vector<std::byte> bytes = forest.to_bytes();
+    for (size_t t = 0; t < 8; t++){
+        const arboria::ForestTree& ft = RandomForestAccess::access_forest_trees(*loaded, t);
+        REQUIRE(DecisionTreeAccess::access_nodes_are_view(*ft.tree));
+        REQUIRE(ft.leaf_samples);
+        REQUIRE(ft.leaf_samples->storage);
+        REQUIRE_FALSE(DecisionTreeAccess::access_nodes_are_view(*RandomForestAccess::access_forest_trees(forest, t).tree));
+    }
+
+    //fit_more copies the OOB accumulators before adding trees to them
+    std::unique_ptr<RandomForest> grown = RandomForest::load(path);
+    grown->fit_more(data, param, 3);
+    forest.fit_more(data, param, 3);
+    REQUIRE(grown->oob_score() == forest.oob_score());
+    //rows never out of bag are NaN in both
+    const std::vector<float> grown_oob = grown->oob_prediction();
+    const std::vector<float> forest_oob = forest.oob_prediction();
+    REQUIRE(grown_oob.size() == forest_oob.size());
+    for (size_t i = 0; i < grown_oob.size(); i++){
+        REQUIRE(std::isnan(grown_oob[i]) == std::isnan(forest_oob[i]));
+        if (!std::isnan(forest_oob[i])) REQUIRE(grown_oob[i] == forest_oob[i]);
+    }
+    REQUIRE(grown->predict_quantiles(X, qs) == forest.predict_quantiles(X, qs));
+
+    //the first mapping is untouched by a later save to the same path
+    const std::vector<float> before = loaded->predict(X);
+    forest.save(path);
+    REQUIRE(loaded->predict(X) == before);
+    REQUIRE(loaded->to_bytes() == bytes);
+    REQUIRE(RandomForest::load(path)->n_trees() == 11);
+    REQUIRE(leftover_siblings(path) == 0);
+    std::remove(path.c_str());
+}
+
+TEST_CASE("Serialization : concurrent saves to one path leave a whole model") {
+
+    DataSet data = make_engine_dataset(3, 1, 120);
+    DecisionTree shallow(HyperParam{.max_depth = 2}, Classification{});
+    DecisionTree deep(HyperParam{.max_depth = 6}, Classification{});
+    shallow.fit(data, ParamBuilder(TreeModel::DecisionTree, Classification{}, Gini{}, CART{}, AllFeatures{}));
+    deep.fit(data, ParamBuilder(TreeModel::DecisionTree, Classification{}, Gini{}, CART{}, AllFeatures{}));
+    const std::string path = temp_path("concurrent_tree");
+
+    //each save writes its own sibling : the last rename wins, whole
+    std::thread other([&](){ for (int i = 0; i < 20; i++) deep.save(path); });
+    for (int i = 0; i < 20; i++) shallow.save(path);
+    other.join();
+
+    const size_t n_nodes = DecisionTree::load(path).n_nodes();
+    REQUIRE((n_nodes == shallow.n_nodes() || n_nodes == deep.n_nodes()));
+    REQUIRE(leftover_siblings(path) == 0);
+    std::remove(path.c_str());
+}
+
+TEST_CASE("Serialization : the default engine predicts a mapped RandomForest in place") {
+
+    DataSet data = make_engine_dataset(3, 1, 120);
+    RandomForest forest(HyperParam{.mtry = 1, .n_estimators = 6, .max_depth = 4}, Classification{}, 8);
+    forest.fit(data, ParamBuilder(TreeModel::RandomForest, Classification{}, Gini{}, CART{}, RandomK{1}));
+    const std::string path = temp_path("in_place_forest");
+    forest.save(path);
+    std::unique_ptr<RandomForest> loaded = RandomForest::load(path);
+    std::remove(path.c_str());
+
+    //no private copy of the nodes is built for a batch
+    std::span<const float> X(data.X());
+    REQUIRE(loaded->predict_proba(X) == forest.predict_proba(X));
+    REQUIRE(loaded->predict(X) == forest.predict(X));
+    REQUIRE_FALSE(RandomForestAccess::access_compiled_forest(*loaded)->implicit);
+    REQUIRE_FALSE(RandomForestAccess::access_compiled_forest(*loaded)->bitvector);
+}
+
+TEST_CASE("Serialization : unfitted models keep their hyperparameters") {
+
+    DecisionTree tree(HyperParam{.max_depth = 3, .honest_fraction = 0.5f}, Regression{});
+    DecisionTree tree_copy = DecisionTree::from_bytes(tree.to_bytes());
+    REQUIRE_FALSE(tree_copy.is_fitted());
+    REQUIRE(tree_copy.max_depth == 3);
+    REQUIRE(tree_copy.honest_fraction == 0.5f);
+    REQUIRE(std::holds_alternative<Regression>(tree_copy.type_));
+    REQUIRE_THROWS_AS(tree_copy.predict(std::vector<float>{0.f}), std::invalid_argument);
+
+    RandomForest forest(HyperParam{.mtry = 1, .n_estimators = 5, .quantiles = true}, Regression{}, 21);
+    std::unique_ptr<RandomForest> forest_copy = RandomForest::from_bytes(forest.to_bytes());
+    REQUIRE_FALSE(forest_copy->is_fitted());
+    REQUIRE(forest_copy->seed() == 21);
+    REQUIRE(forest_copy->get_estimators() == 5);
+    REQUIRE(forest_copy->stores_quantiles());
+
+    //the copy fits like the original
+    DataSet data = make_engine_dataset(0, 1, 120);
+    SplitParam param = ParamBuilder(TreeModel::RandomForest, Regression{}, SSE{}, CART{}, RandomK{1});
+    forest.fit(data, param);
+    forest_copy->fit(data, param);
+    REQUIRE(forest_copy->predict(data.X()) == forest.predict(data.X()));
+}
+
+TEST_CASE("Serialization : invalid buffers are rejected") {
+
+    DataSet data = make_engine_dataset(3, 1, 120);
+    DecisionTree tree(HyperParam{.max_depth = 3}, Classification{});
+    tree.fit(data, ParamBuilder(TreeModel::DecisionTree, Classification{}, Gini{}, CART{}, AllFeatures{}));
+    const std::vector<std::byte> bytes = tree.to_bytes();
+
+    //another kind of model
+    REQUIRE_THROWS_AS(RandomForest::from_bytes(bytes), std::invalid_argument);
+
+    //not a model
+    std::vector<std::byte> wrong_magic = bytes;
+    wrong_magic[0] = std::byte{'X'};
+    REQUIRE_THROWS_AS(DecisionTree::from_bytes(wrong_magic), std::invalid_argument);
+
+    //another format version
+    std::vector<std::byte> wrong_version = bytes;
+    wrong_version[8] = std::byte{0x7f};
+    REQUIRE_THROWS_AS(DecisionTree::from_bytes(wrong_version), std::invalid_argument);
+
+    //truncated anywhere
+    for (size_t size : {size_t{0}, size_t{12}, bytes.size() / 2, bytes.size() - 1}){
+        std::vector<std::byte> truncated(bytes.begin(), bytes.begin() + static_cast<std::ptrdiff_t>(size));
+        REQUIRE_THROWS_AS(DecisionTree::from_bytes(truncated), std::invalid_argument);
+    }
+
+    REQUIRE_THROWS_AS(DecisionTree::load(temp_path("missing")), std::runtime_error);
+    REQUIRE_THROWS_AS(DecisionTree::load(temp_path("missing"), false), std::runtime_error);
+}